@@ -0,0 +1,414 @@
+#include "BatchConverter.hpp"
+#include "FontBuffer.hpp"
+#include "ThreadPool.hpp"
+#include "Timing.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <iostream>
+#include <thread>
+
+namespace FontConverter {
+    using TTFParser::Clock;
+    using TTFParser::elapsedMs;
+    namespace fs = std::filesystem;
+
+    namespace {
+        bool hasWildcard(const std::string& text) {
+            return text.find_first_of("*?") != std::string::npos;
+        }
+
+        // Matches a file name against a pattern where '*' matches any run of characters and '?' one character.
+        bool matchWildcard(const std::string& pattern, const std::string& name) {
+            size_t p = 0, n = 0;
+            size_t starPattern = std::string::npos, starName = 0;
+            while (n < name.size()) {
+                if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+                    ++p;
+                    ++n;
+                }
+                else if (p < pattern.size() && pattern[p] == '*') {
+                    starPattern = p++;
+                    starName = n;
+                }
+                else if (starPattern != std::string::npos) {
+                    // Let the last '*' swallow one more character and retry
+                    p = starPattern + 1;
+                    n = ++starName;
+                }
+                else {
+                    return false;
+                }
+            }
+            while (p < pattern.size() && pattern[p] == '*') {
+                ++p;
+            }
+            return p == pattern.size();
+        }
+
+        // Expands the components [part, end) of a glob below `base`, one directory level at a time.
+        void expandGlob(const fs::path& base, fs::path::const_iterator part, fs::path::const_iterator end,
+            std::vector<fs::path>& matches) {
+            std::error_code error;
+            if (part == end) {
+                if (fs::is_regular_file(base, error)) {
+                    matches.push_back(base);
+                }
+                return;
+            }
+
+            const std::string pattern = part->string();
+            const fs::path::const_iterator next = std::next(part);
+            if (!hasWildcard(pattern)) {
+                expandGlob(base / *part, next, end, matches);
+                return;
+            }
+
+            for (fs::directory_iterator it(base.empty() ? fs::path(".") : base, error), last; !error && it != last; it.increment(error)) {
+                const std::string name = it->path().filename().string();
+                if ((name[0] == '.' && pattern[0] != '.') || !matchWildcard(pattern, name)) {
+                    continue; // Like shells, wildcards skip hidden files
+                }
+                expandGlob(base / name, next, end, matches);
+            }
+        }
+
+        bool isFontFile(const fs::path& path) {
+            std::string extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(),
+                [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return extension == ".ttf" || extension == ".otf";
+        }
+
+        // True if the decoded font's GPOS is what compactKerning makes of the original's 'kern' table.
+        bool kernReplacedExactly(TTFParser::TTFParser& original, TTFParser::TTFParser& decoded) {
+            KernCompaction kerning;
+            const TTFParser::ByteView gpos = decoded.getTableData("GPOS");
+            return compactKerning(original, kerning) && gpos.size() == kerning.gpos.size() &&
+                std::equal(gpos.begin(), gpos.end(), kerning.gpos.begin());
+        }
+
+        void addDecodeStats(TTFParser::DecodeStats& total, const TTFParser::DecodeStats& stats) {
+            total.decompressMs += stats.decompressMs;
+            total.reconstructMs += stats.reconstructMs;
+            total.totalMs += stats.totalMs;
+            total.compressedBytes += stats.compressedBytes;
+            total.decompressedBytes += stats.decompressedBytes;
+            total.sfntBytes += stats.sfntBytes;
+        }
+
+        // Decodes a written WOFF2 file and, unless it is a subset, compares it table by table with its input.
+        // The decoding times of the output are added to the job's.
+        bool verifyOutput(const std::string& inputPath, const std::string& outputPath, bool subset, bool kernToGpos,
+            BatchJob& job) {
+            TTFParser::FontBuffer woff2;
+            TTFParser::WOFF2Reader reader;
+            std::vector<uint8_t> decodedFont;
+            TTFParser::TTFParser original;
+            TTFParser::TTFParser decoded;
+            if (!woff2.readFile(outputPath) || !reader.decode(woff2.view(), decodedFont)) {
+                std::cerr << "Error: Failed to decode " << outputPath << std::endl;
+                return false;
+            }
+            ++job.decoded;
+            addDecodeStats(job.decode, reader.getStats());
+            if (!decoded.loadFromMemory(std::move(decodedFont)) || !original.loadFromFile(inputPath)) {
+                std::cerr << "Error: Failed to decode " << outputPath << std::endl;
+                return false;
+            }
+            if (subset) {
+                return true; // A subset has nothing to be compared with
+            }
+
+            std::vector<TTFParser::TableComparison> comparisons;
+            if (TTFParser::compareRoundTrip(original, decoded, comparisons)) {
+                return true;
+            }
+            bool matched = true;
+            for (const TTFParser::TableComparison& comparison : comparisons) {
+                if (comparison.match) {
+                    continue;
+                }
+                if (kernToGpos && comparison.tag == TTFParser::Tag("kern").value && comparison.decodedLength == 0 &&
+                    kernReplacedExactly(original, decoded)) {
+                    continue; // Replaced by its GPOS equivalent
+                }
+                std::cerr << "Error: Round trip mismatch in '" << TTFParser::Tag(comparison.tag).toString()
+                    << "' of " << inputPath << std::endl;
+                matched = false;
+            }
+            return matched;
+        }
+    } // namespace
+
+    BatchConverter::BatchConverter(const BatchOptions& options) : options(options) {
+        if (!options.cacheDirectory.empty()) {
+            cache.reset(new ConversionCache(options.cacheDirectory, options.cacheMaxBytes));
+            if (!cache->isOpen()) {
+                cache.reset();
+            }
+        }
+    }
+
+    bool BatchConverter::addInput(const std::string& input) {
+        std::error_code error;
+        const fs::path path(input);
+
+        if (hasWildcard(input)) {
+            std::vector<fs::path> matches;
+            expandGlob(fs::path(), path.begin(), path.end(), matches);
+            std::sort(matches.begin(), matches.end());
+            for (const fs::path& match : matches) {
+                addJob(match, fs::path());
+            }
+            if (matches.empty()) {
+                std::cerr << "Error: No files match " << input << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        if (fs::is_directory(path, error)) {
+            const size_t before = jobs.size();
+            const fs::directory_options directoryOptions = fs::directory_options::skip_permission_denied;
+            for (fs::recursive_directory_iterator it(path, directoryOptions, error), last; !error && it != last; it.increment(error)) {
+                if (isFontFile(it->path()) && it->is_regular_file(error)) {
+                    addJob(it->path(), path);
+                }
+            }
+            if (error) {
+                std::cerr << "Error: Failed to read directory " << input << ": " << error.message() << std::endl;
+                return false;
+            }
+            if (jobs.size() == before) {
+                std::cerr << "Warning: No .ttf or .otf files in " << input << std::endl;
+            }
+            return true;
+        }
+
+        if (!fs::is_regular_file(path, error)) {
+            std::cerr << "Error: No such font file or directory: " << input << std::endl;
+            return false;
+        }
+        addJob(path, fs::path());
+        return true;
+    }
+
+    bool BatchConverter::addInputList(std::istream& in) {
+        bool allAdded = true;
+        std::string line;
+        while (std::getline(in, line)) {
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                allAdded &= addInput(line);
+            }
+        }
+        return allAdded;
+    }
+
+    void BatchConverter::addJob(const fs::path& input, const fs::path& root) {
+        std::error_code error;
+        if (!inputs.insert(fs::absolute(input, error).lexically_normal().string()).second) {
+            return; // Already queued through another input
+        }
+
+        // Directory inputs keep their layout under the output directory; single files go at its top
+        fs::path output = input;
+        if (!options.outputDirectory.empty()) {
+            output = fs::path(options.outputDirectory) / (root.empty() ? input.filename() : input.lexically_relative(root));
+        }
+        output.replace_extension(".woff2");
+
+        BatchJob job;
+        job.inputPath = input.string();
+        job.outputPath = output.string();
+        const uintmax_t size = fs::file_size(input, error);
+        job.inputBytes = error ? 0 : static_cast<uint64_t>(size);
+        jobs.push_back(std::move(job));
+    }
+
+    bool BatchConverter::convertJob(FontConverter& converter, BatchJob& job) {
+        const Clock::time_point start = Clock::now();
+
+        std::error_code error;
+        const fs::path outputPath(job.outputPath);
+        if (outputPath.has_parent_path()) {
+            fs::create_directories(outputPath.parent_path(), error);
+        }
+
+        job.succeeded = converter.convertFile(job.inputPath, job.outputPath);
+        if (job.succeeded) {
+            job.inputBytes = converter.getStats().inputBytes;
+            job.outputBytes = converter.getStats().build.woff2Bytes;
+            job.cacheHit = converter.getStats().cacheHit;
+            job.kernBytes = converter.getStats().kernBytes;
+            job.gposBytes = converter.getStats().gposBytes;
+            job.succeeded = !options.verify || verifyOutput(job.inputPath, job.outputPath, options.subset, options.kernToGpos, job);
+        }
+        job.totalMs = elapsedMs(start);
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (!job.succeeded) {
+            std::cerr << "Failed: " << job.inputPath << std::endl;
+        }
+        else if (!options.quiet) {
+            std::cout << job.inputPath << " -> " << job.outputPath << " (" << job.inputBytes << " -> "
+                << job.outputBytes << " bytes, " << job.totalMs << " ms" << (job.cacheHit ? ", cached" : "") << ")" << std::endl;
+        }
+        return job.succeeded;
+    }
+
+    bool BatchConverter::sliceJob(FontSlicer& slicer, BatchJob& job) {
+        const Clock::time_point start = Clock::now();
+
+        std::error_code error;
+        const fs::path outputPath(job.outputPath);
+        if (outputPath.has_parent_path()) {
+            fs::create_directories(outputPath.parent_path(), error);
+        }
+
+        job.succeeded = slicer.sliceFile(job.inputPath, fs::path(outputPath).replace_extension().string(), options.slices);
+        job.inputBytes = slicer.getInputBytes();
+        for (const SliceResult& slice : slicer.getResults()) {
+            if (slice.written) {
+                ++job.slices;
+                job.outputBytes += slice.outputBytes;
+                if (options.verify) {
+                    job.succeeded &= verifyOutput(job.inputPath, slice.outputPath, true, false, job);
+                }
+            }
+        }
+        job.totalMs = elapsedMs(start);
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (!job.succeeded) {
+            std::cerr << "Failed: " << job.inputPath << std::endl;
+        }
+        else if (!options.quiet) {
+            std::cout << job.inputPath << " -> " << job.slices << " slices (" << job.inputBytes << " -> "
+                << job.outputBytes << " bytes, " << job.totalMs << " ms)" << std::endl;
+        }
+        return job.succeeded;
+    }
+
+    bool BatchConverter::validateJob(BatchJob& job, TTFParser::ThreadPool* pool) {
+        const Clock::time_point start = Clock::now();
+
+        TTFParser::TTFParser parser;
+        TTFParser::ChecksumReport report;
+        const bool loaded = parser.loadFromFile(job.inputPath);
+        job.succeeded = loaded && parser.validateChecksums(report, pool);
+        job.inputBytes = parser.getFontDataSize();
+        job.totalMs = elapsedMs(start);
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (!loaded) {
+            std::cerr << "Failed: " << job.inputPath << std::endl;
+            return false;
+        }
+        if (job.succeeded) {
+            if (!options.quiet) {
+                std::cout << job.inputPath << ": " << report.tables.size() << " table checksums OK" << std::endl;
+            }
+            return true;
+        }
+
+        std::cout << job.inputPath << ": checksum mismatch" << std::endl;
+        std::cout << std::hex;
+        for (const TTFParser::TableChecksum& table : report.tables) {
+            if (!table.matches()) {
+                std::cout << "  '" << TTFParser::Tag(table.tag).toString() << "': stored 0x" << table.stored
+                    << ", computed 0x" << table.computed << std::endl;
+            }
+        }
+        if (!report.adjustmentMatches()) {
+            std::cout << "  head.checkSumAdjustment: stored 0x" << report.storedAdjustment << ", expected 0x"
+                << report.expectedAdjustment << std::endl;
+        }
+        std::cout << std::dec;
+        return false;
+    }
+
+    bool BatchConverter::run() {
+        const Clock::time_point start = Clock::now();
+        summary = BatchSummary();
+        summary.fonts = jobs.size();
+        summary.cacheUsed = cache != nullptr;
+        const CacheStats cacheBefore = cache ? cache->getStats() : CacheStats();
+        if (jobs.empty()) {
+            return true;
+        }
+
+        // Largest first, so the longest conversions overlap the rest instead of running last
+        std::stable_sort(jobs.begin(), jobs.end(),
+            [](const BatchJob& a, const BatchJob& b) { return a.inputBytes > b.inputBytes; });
+
+        size_t workerCount = options.jobs ? options.jobs : std::max(1u, std::thread::hardware_concurrency());
+        workerCount = std::min(workerCount, jobs.size());
+        summary.jobs = workerCount;
+
+        // One task per worker, each pulling fonts from the shared queue in order. With a single
+        // worker the font itself is decoded (or checksummed) on every core instead.
+        TTFParser::ThreadPool pool(workerCount);
+        std::atomic<size_t> next{ 0 };
+        pool.parallelFor(workerCount, [&](size_t) {
+            if (options.validateOnly) {
+                std::unique_ptr<TTFParser::ThreadPool> tablePool(workerCount > 1 ? nullptr : new TTFParser::ThreadPool());
+                for (size_t i = next++; i < jobs.size(); i = next++) {
+                    validateJob(jobs[i], tablePool.get());
+                }
+                return;
+            }
+
+            if (!options.slices.empty()) {
+                FontSlicer slicer(options.compression, workerCount > 1 ? 1 : 0);
+                for (size_t i = next++; i < jobs.size(); i = next++) {
+                    sliceJob(slicer, jobs[i]);
+                }
+                return;
+            }
+
+            FontConverter converter(options.compression, workerCount > 1 ? 1 : 0);
+            converter.setCache(cache.get());
+            if (options.subset) {
+                converter.setSubset(options.unicodes);
+            }
+            converter.setKernCompaction(options.kernToGpos);
+            for (size_t i = next++; i < jobs.size(); i = next++) {
+                convertJob(converter, jobs[i]);
+            }
+        });
+
+        for (const BatchJob& job : jobs) {
+            if (job.succeeded) {
+                ++summary.converted;
+                summary.inputBytes += job.inputBytes;
+                summary.outputBytes += job.outputBytes;
+                summary.slices += job.slices;
+                summary.kernReplaced += job.kernBytes > 0;
+                summary.kernBytes += job.kernBytes;
+                summary.gposBytes += job.gposBytes;
+                summary.decoded += job.decoded;
+                addDecodeStats(summary.decode, job.decode);
+            }
+            else {
+                ++summary.failed;
+                summary.failures.push_back(job.inputPath);
+            }
+        }
+        if (cache) {
+            const CacheStats cacheAfter = cache->getStats();
+            summary.cache = cacheAfter;
+            summary.cache.hits -= cacheBefore.hits;
+            summary.cache.misses -= cacheBefore.misses;
+            summary.cache.stores -= cacheBefore.stores;
+            summary.cache.evictions -= cacheBefore.evictions;
+            summary.cache.evictedBytes -= cacheBefore.evictedBytes;
+        }
+        summary.wallMs = elapsedMs(start);
+        return summary.failed == 0;
+    }
+
+} // namespace FontConverter
@@ -0,0 +1,133 @@
+#ifndef BATCH_CONVERTER_HPP
+#define BATCH_CONVERTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "ConversionCache.hpp"
+#include "FontConverter.hpp"
+#include "FontSlicer.hpp"
+#include "WOFF2Builder.hpp"
+#include "WOFF2Reader.hpp"
+
+namespace FontConverter {
+
+    // Settings of a batch conversion.
+    struct BatchOptions {
+        WOFF2Builder::CompressionOptions compression;
+        size_t jobs = 0;             // Fonts converted at once; 0 uses every core.
+        std::string outputDirectory; // Empty writes each output next to its input.
+        std::string cacheDirectory;  // Conversion cache shared by all workers; empty for none.
+        uint64_t cacheMaxBytes = 0;  // Cache size limit; 0 for no limit.
+        bool subset = false;         // Keep only the glyphs needed for `unicodes`.
+        std::vector<uint32_t> unicodes;
+        std::vector<SliceSpec> slices; // Split every font into these slices instead of converting it whole.
+        bool kernToGpos = false;     // Replace 'kern' tables with equivalent, smaller GPOS tables.
+        bool verify = false;         // Decode every output and compare it with its input (subsets are only decoded).
+        bool validateOnly = false;   // Only check the checksums of every input; convert nothing.
+        bool quiet = false;          // Only report failures.
+    };
+
+    // One font of a batch.
+    struct BatchJob {
+        std::string inputPath;
+        std::string outputPath;
+        uint64_t inputBytes = 0;
+        uint64_t outputBytes = 0;
+        double totalMs = 0.0;
+        bool cacheHit = false;
+        size_t slices = 0;        // Slice files written, when slicing.
+        uint64_t kernBytes = 0;   // Size of a 'kern' table replaced by GPOS, or 0.
+        uint64_t gposBytes = 0;   // Size of the GPOS table that replaced it.
+        size_t decoded = 0;       // Outputs decoded again by `verify`.
+        TTFParser::DecodeStats decode; // Their decoding times and sizes, summed.
+        bool succeeded = false;
+    };
+
+    // Totals of the last BatchConverter::run call.
+    struct BatchSummary {
+        size_t fonts = 0;
+        size_t converted = 0;
+        size_t failed = 0;
+        uint64_t inputBytes = 0;  // Of the converted fonts.
+        uint64_t outputBytes = 0;
+        double wallMs = 0.0;
+        size_t jobs = 0;          // Fonts that were converted at once.
+        size_t slices = 0;        // Slice files written, when slicing.
+        size_t kernReplaced = 0;  // Fonts whose 'kern' table was replaced by GPOS (cache hits not counted).
+        uint64_t kernBytes = 0;   // Size of those 'kern' tables.
+        uint64_t gposBytes = 0;   // Size of the GPOS tables that replaced them.
+        size_t decoded = 0;       // Outputs decoded again by `verify`.
+        TTFParser::DecodeStats decode; // Their decoding times and sizes, summed.
+        bool cacheUsed = false;
+        CacheStats cache;         // Cache counters for this run.
+        std::vector<std::string> failures; // Input paths of the fonts that failed.
+    };
+
+    /**
+    * @class BatchConverter
+    * @brief Converts many fonts to WOFF2 on a pool of workers.
+    *
+    * Inputs are font files, directories (searched recursively for .ttf and .otf files) and
+    * glob patterns. Fonts are converted largest first, each worker taking the next font from
+    * a shared queue, so one big font does not end up last and hold up the whole batch.
+    * In validation mode the fonts' checksums are checked instead of converting them; in
+    * slicing mode every font is split into one WOFF2 file per slice.
+    */
+    class BatchConverter {
+    public:
+        explicit BatchConverter(const BatchOptions& options = BatchOptions());
+
+        /**
+         * @brief Adds a font file, every font under a directory, or every file matching a glob.
+         * Globs support '*' and '?' in any path component. Inputs already added are skipped.
+         * @return false if the input does not exist or matches nothing.
+         */
+        bool addInput(const std::string& input);
+
+        /**
+         * @brief Adds one input (as for addInput) per non-empty line of a stream.
+         * @return false if any line could not be added.
+         */
+        bool addInputList(std::istream& in);
+
+        const std::vector<BatchJob>& getJobs() const { return jobs; }
+
+        /**
+         * @brief Converts every added font.
+         * @return true if all of them were converted.
+         */
+        bool run();
+
+        const BatchSummary& getSummary() const { return summary; }
+
+    private:
+        // Queues a font; `root` is the directory input it was found under, if any.
+        void addJob(const std::filesystem::path& input, const std::filesystem::path& root);
+
+        // Converts one font (and verifies it, if asked), then reports the outcome.
+        bool convertJob(FontConverter& converter, BatchJob& job);
+
+        // Writes the slices of one font (and verifies them, if asked), then reports the outcome.
+        bool sliceJob(FontSlicer& slicer, BatchJob& job);
+
+        // Checks the table checksums of one font and reports every mismatch.
+        bool validateJob(BatchJob& job, TTFParser::ThreadPool* pool);
+
+        BatchOptions options;
+        std::unique_ptr<ConversionCache> cache;
+        std::vector<BatchJob> jobs;
+        std::unordered_set<std::string> inputs; // Input paths already queued.
+        BatchSummary summary;
+        std::mutex outputMutex; // Keeps progress lines whole.
+    };
+
+} // namespace FontConverter
+
+#endif // BATCH_CONVERTER_HPP
@@ -0,0 +1,227 @@
+#include "Benchmark.hpp"
+#include "BigEndian.hpp"
+#include "FontConverter.hpp"
+#include "TTFParser.hpp"
+#include "ThreadPool.hpp"
+#include "Timing.hpp"
+#include "WOFF2Encoding.hpp"
+#include "WOFF2Reader.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace FontConverter {
+    using TTFParser::Clock;
+    using TTFParser::elapsedMs;
+
+    namespace {
+        const double kMinBenchMs = 100.0;   // Measurements are repeated for at least this long...
+        const size_t kMinRounds = 5;        // ...and at least this many times.
+        const size_t kLookupPasses = 10000; // Passes over the table directory per lookup round.
+
+        // Decoding speed in MB/s of `bytes` bytes that took `ms` milliseconds.
+        double megabytesPerSecond(size_t bytes, double ms) {
+            return ms > 0.0 ? bytes / (ms * 1000.0) : 0.0;
+        }
+
+        volatile size_t sink = 0;
+
+        // Stores a result where the optimizer cannot drop the work that produced it.
+        void keep(size_t value) {
+            sink = value;
+        }
+
+        // Runs `task` repeatedly and returns the duration of its fastest round, in milliseconds.
+        template <typename Task>
+        double fastestMs(Task&& task) {
+            double fastest = 0.0;
+            double total = 0.0;
+            for (size_t round = 0; round < kMinRounds || total < kMinBenchMs; ++round) {
+                const Clock::time_point start = Clock::now();
+                task();
+                const double ms = elapsedMs(start);
+                fastest = round == 0 ? ms : std::min(fastest, ms);
+                total += ms;
+            }
+            return fastest;
+        }
+
+        // Table lookups: every table of the font and one it lacks, as the parsers look them up.
+        void benchTableLookup(const TTFParser::TTFParser& parser) {
+            std::vector<TTFParser::Tag> tags;
+            for (const TTFParser::TableRecord& record : parser.getTableDirectory()) {
+                tags.push_back(TTFParser::Tag(record.tag));
+            }
+            tags.push_back(TTFParser::Tag("zzzz"));
+
+            size_t found = 0;
+            const double ms = fastestMs([&]() {
+                for (size_t pass = 0; pass < kLookupPasses; ++pass) {
+                    for (TTFParser::Tag tag : tags) {
+                        found += parser.getTableData(tag).size();
+                    }
+                }
+            });
+            keep(found);
+            std::cout << "  Table lookup: " << ms * 1e6 / (kLookupPasses * tags.size()) << " ns per getTableData ("
+                << tags.size() << " tags, one missing)" << std::endl;
+        }
+
+        /**
+         * Big-endian arrays: the bulk decoders against the element-by-element loop they replaced,
+         * over the whole font, then the 'loca' and 'hmtx' parsers built on them.
+         */
+        void benchBigEndian(TTFParser::TTFParser& parser) {
+            const TTFParser::ByteView font = parser.getFontData();
+            const size_t count16 = font.size() / 2;
+            const size_t count32 = font.size() / 4;
+            std::vector<uint16_t> values16(count16);
+            std::vector<uint32_t> values32(count32);
+
+            const double bulk16Ms = fastestMs([&]() { TTFParser::decodeU16Array(font.data(), values16.data(), count16); });
+            const double bulk32Ms = fastestMs([&]() { TTFParser::decodeU32Array(font.data(), values32.data(), count32); });
+            const double scalar16Ms = fastestMs([&]() {
+                std::vector<uint16_t> values;
+                for (size_t i = 0; i < count16; ++i) {
+                    values.push_back(TTFParser::readU16(font.data() + 2 * i));
+                }
+                keep(values.back());
+            });
+            const double scalar32Ms = fastestMs([&]() {
+                std::vector<uint32_t> values;
+                for (size_t i = 0; i < count32; ++i) {
+                    values.push_back(TTFParser::readU32(font.data() + 4 * i));
+                }
+                keep(values.back());
+            });
+            keep(values16.back() + values32.back());
+            std::cout << "  Big-endian arrays: uint16 " << megabytesPerSecond(2 * count16, bulk16Ms) << " MB/s bulk, "
+                << megabytesPerSecond(2 * count16, scalar16Ms) << " MB/s scalar; uint32 "
+                << megabytesPerSecond(4 * count32, bulk32Ms) << " MB/s bulk, "
+                << megabytesPerSecond(4 * count32, scalar32Ms) << " MB/s scalar" << std::endl;
+
+            TTFParser::LocaTable loca;
+            if (parser.parseHeadTable(parser.getTableData("head")) && parser.parseMaxpTable(parser.getTableData("maxp")) &&
+                parser.parseLocaTable(parser.getTableData("loca"), loca)) {
+                const double locaMs = fastestMs([&]() { parser.parseLocaTable(parser.getTableData("loca"), loca); });
+                std::cout << "  loca: " << loca.offsets.size() << " offsets in " << locaMs * 1000.0 << " us" << std::endl;
+            }
+            TTFParser::HheaTable hhea{};
+            std::vector<TTFParser::GlyphMetrics> metrics;
+            if (parser.parseHheaTable(parser.getTableData("hhea"), hhea) &&
+                parser.parseHmtxTable(parser.getTableData("hmtx"), hhea.numOfLongHorMetrics, metrics)) {
+                const double hmtxMs = fastestMs([&]() {
+                    parser.parseHmtxTable(parser.getTableData("hmtx"), hhea.numOfLongHorMetrics, metrics);
+                });
+                std::cout << "  hmtx: " << metrics.size() << " metrics in " << hmtxMs * 1000.0 << " us" << std::endl;
+            }
+        }
+
+        // 'glyf' decoding on the calling thread against decoding in parallel chunks on `pool`; leaves the glyphs in `glyf`.
+        void benchGlyf(TTFParser::TTFParser& parser, TTFParser::ThreadPool& pool, TTFParser::GlyfTable& glyf) {
+            TTFParser::LocaTable loca;
+            const TTFParser::ByteView glyfData = parser.getTableData("glyf");
+            if (!parser.parseHeadTable(parser.getTableData("head")) || !parser.parseMaxpTable(parser.getTableData("maxp")) ||
+                !parser.parseLocaTable(parser.getTableData("loca"), loca) || !parser.parseGlyfTable(glyfData, loca, glyf)) {
+                return;
+            }
+
+            const double serialMs = fastestMs([&]() { parser.parseGlyfTable(glyfData, loca, glyf); });
+            const double parallelMs = fastestMs([&]() { parser.parseGlyfTable(glyfData, loca, glyf, &pool); });
+            std::cout << "  glyf: " << glyf.glyphs.size() << " glyphs, " << glyfData.size() << " bytes in " << serialMs
+                << " ms on 1 thread (" << megabytesPerSecond(glyfData.size(), serialMs) << " MB/s), " << parallelMs
+                << " ms on a " << pool.concurrency() << "-thread pool (" << serialMs / parallelMs << "x)" << std::endl;
+        }
+
+        // Checksums: the uint32 sum kernel over the whole font, then validating every table.
+        void benchChecksums(const TTFParser::TTFParser& parser, TTFParser::ThreadPool& pool) {
+            const TTFParser::ByteView font = parser.getFontData();
+            uint32_t sum = 0;
+            const double sumMs = fastestMs([&]() { sum += TTFParser::sumU32Array(font.data(), font.size() / 4); });
+            keep(sum);
+
+            TTFParser::ChecksumReport report;
+            const double serialMs = fastestMs([&]() { parser.validateChecksums(report); });
+            const double parallelMs = fastestMs([&]() { parser.validateChecksums(report, &pool); });
+            std::cout << "  Checksums: " << megabytesPerSecond(font.size() / 4 * 4, sumMs) << " MB/s summed; "
+                << report.tables.size() << " tables " << (report.valid() ? "valid" : "INVALID") << " in " << serialMs
+                << " ms on 1 thread, " << parallelMs << " ms on a " << pool.concurrency() << "-thread pool" << std::endl;
+        }
+
+        /**
+         * Encoding: one conversion of the font, reported with its BuildStats, and the batch
+         * 255UInt16 encoder over the coordinate deltas of its glyphs, the bulk of the values a
+         * transformed 'glyf' table holds. Leaves the WOFF2 file in `woff2`, empty if the conversion failed.
+         */
+        void benchEncoding(const TTFParser::TTFParser& parser, const TTFParser::GlyfTable& glyf, FontConverter& converter,
+            std::vector<uint8_t>& woff2) {
+            const TTFParser::ByteView font = parser.getFontData();
+            if (converter.convert(font.data(), font.size(), woff2)) {
+                const WOFF2Builder::BuildStats& build = converter.getStats().build;
+                std::cout << "  Conversion: transforms " << build.transformMs << " ms, Brotli " << build.compressMs
+                    << " ms, " << build.rawBytes << " -> " << build.woff2Bytes << " bytes" << std::endl;
+            }
+
+            std::vector<uint16_t> values(glyf.xCoordinates.size());
+            for (size_t i = 1; i < values.size(); ++i) {
+                values[i] = static_cast<uint16_t>(std::abs(glyf.xCoordinates[i] - glyf.xCoordinates[i - 1]));
+            }
+            if (values.empty()) {
+                return;
+            }
+            std::vector<uint8_t> encoded(WOFF2Builder::size255UInt16Array(values.data(), values.size()));
+            const double encodeMs = fastestMs([&]() {
+                WOFF2Builder::write255UInt16Array(encoded.data(), values.data(), values.size());
+            });
+            keep(encoded.back());
+            std::cout << "  255UInt16: " << values.size() / (encodeMs * 1000.0) << " million values/s ("
+                << values.size() << " values, " << encoded.size() << " bytes)" << std::endl;
+        }
+
+        // Decoding: the WOFF2 file back to an sfnt, as a browser does on every page load.
+        void benchDecoding(const std::vector<uint8_t>& woff2) {
+            TTFParser::WOFF2Reader reader;
+            std::vector<uint8_t> sfnt;
+            if (woff2.empty() || !reader.decode(TTFParser::ByteView(woff2.data(), woff2.size()), sfnt)) {
+                return;
+            }
+            // The reader's own timers split the fastest round into its stages
+            TTFParser::DecodeStats fastest = reader.getStats();
+            fastestMs([&]() {
+                reader.decode(TTFParser::ByteView(woff2.data(), woff2.size()), sfnt);
+                if (reader.getStats().totalMs < fastest.totalMs) {
+                    fastest = reader.getStats();
+                }
+            });
+            std::cout << "  WOFF2 decode: " << fastest.sfntBytes << " bytes in " << fastest.totalMs << " ms (Brotli "
+                << fastest.decompressMs << " ms, reconstruct " << fastest.reconstructMs << " ms, "
+                << megabytesPerSecond(fastest.sfntBytes, fastest.totalMs) << " MB/s)" << std::endl;
+        }
+    } // namespace
+
+    bool runBenchmark(const std::vector<std::string>& fonts, size_t threads, const WOFF2Builder::CompressionOptions& options) {
+        TTFParser::ThreadPool pool(threads);
+        FontConverter converter(options, threads);
+        bool loaded = true;
+        for (const std::string& path : fonts) {
+            TTFParser::TTFParser parser;
+            if (!parser.loadFromFile(path)) {
+                std::cerr << "Failed: " << path << " could not be loaded." << std::endl;
+                loaded = false;
+                continue;
+            }
+            std::cout << path << ": " << parser.getFontDataSize() << " bytes, " << parser.getTableDirectory().size()
+                << " tables" << std::endl;
+            benchTableLookup(parser);
+            benchBigEndian(parser);
+            TTFParser::GlyfTable glyf;
+            benchGlyf(parser, pool, glyf);
+            benchChecksums(parser, pool);
+            std::vector<uint8_t> woff2;
+            benchEncoding(parser, glyf, converter, woff2);
+            benchDecoding(woff2);
+        }
+        return loaded;
+    }
+
+} // namespace FontConverter
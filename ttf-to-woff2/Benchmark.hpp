@@ -0,0 +1,26 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "WOFF2Builder.hpp"
+
+namespace FontConverter {
+
+    /**
+     * @brief Times the hot paths of the converter on real fonts and prints the results.
+     *
+     * Every measurement is repeated for a while and the fastest round is reported, so the
+     * numbers reflect warm caches rather than the first touch of the font. Conversions are
+     * slow at high Brotli qualities, so each font is converted only once.
+     *
+     * @param threads Threads of the parallel measurements; 0 uses every core.
+     * @param options Brotli settings of the conversions.
+     * @return false if a font could not be loaded; the other fonts are still measured.
+     */
+    bool runBenchmark(const std::vector<std::string>& fonts, size_t threads, const WOFF2Builder::CompressionOptions& options);
+
+} // namespace FontConverter
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,202 @@
+#include "BigEndian.hpp"
+#include "CpuFeatures.hpp"
+
+#if TTF_HAS_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TTF_BE_SSE2 1
+#endif
+
+namespace TTFParser {
+    namespace {
+#if TTF_BE_SSE2
+        // Swaps the bytes of every 16-bit lane. SSE2 has no byte shuffle, so use shifts.
+        inline __m128i swap16x8(__m128i v) {
+            return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        }
+
+        // Swaps the bytes of every 32-bit lane: swap within 16-bit halves, then swap the halves.
+        inline __m128i swap32x4(__m128i v) {
+            v = swap16x8(v);
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        }
+#endif
+
+#if TTF_HAS_AVX2
+        // The AVX2 loops decode the leading whole vectors and return how many values they did;
+        // the SSE2 and scalar loops finish the rest. Only called when cpuHasAvx2().
+        TTF_AVX2_TARGET inline __m256i swap16x16(__m256i v) {
+            return _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+                1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+        }
+
+        TTF_AVX2_TARGET inline __m256i swap32x8(__m256i v) {
+            return _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+                3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+        }
+
+        TTF_AVX2_TARGET size_t decodeU16ArrayAvx2(const uint8_t* src, uint16_t* dst, size_t count) {
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                __m256i v = _mm256_loadu_si256((const __m256i*)(src + 2 * i));
+                _mm256_storeu_si256((__m256i*)(dst + i), swap16x16(v));
+            }
+            return i;
+        }
+
+        TTF_AVX2_TARGET size_t decodeU32ArrayAvx2(const uint8_t* src, uint32_t* dst, size_t count) {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m256i v = _mm256_loadu_si256((const __m256i*)(src + 4 * i));
+                _mm256_storeu_si256((__m256i*)(dst + i), swap32x8(v));
+            }
+            return i;
+        }
+
+        TTF_AVX2_TARGET size_t decodeU16ToU32ArrayAvx2(const uint8_t* src, uint32_t* dst, size_t count, unsigned shift) {
+            const __m128i shift128 = _mm_cvtsi32_si128(static_cast<int>(shift));
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                __m256i v = swap16x16(_mm256_loadu_si256((const __m256i*)(src + 2 * i)));
+                __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v));
+                __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1));
+                _mm256_storeu_si256((__m256i*)(dst + i), _mm256_sll_epi32(lo, shift128));
+                _mm256_storeu_si256((__m256i*)(dst + i + 8), _mm256_sll_epi32(hi, shift128));
+            }
+            return i;
+        }
+
+        TTF_AVX2_TARGET size_t sumU32ArrayAvx2(const uint8_t* src, size_t count, uint32_t& sum) {
+            // Two accumulators so consecutive adds do not wait on each other
+            __m256i sum0 = _mm256_setzero_si256();
+            __m256i sum1 = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                sum0 = _mm256_add_epi32(sum0, swap32x8(_mm256_loadu_si256((const __m256i*)(src + 4 * i))));
+                sum1 = _mm256_add_epi32(sum1, swap32x8(_mm256_loadu_si256((const __m256i*)(src + 4 * i + 32))));
+            }
+            const __m256i sum256 = _mm256_add_epi32(sum0, sum1);
+            __m128i lanes = _mm_add_epi32(_mm256_castsi256_si128(sum256), _mm256_extracti128_si256(sum256, 1));
+            lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(1, 0, 3, 2)));
+            lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(2, 3, 0, 1)));
+            sum += static_cast<uint32_t>(_mm_cvtsi128_si32(lanes));
+            return i;
+        }
+#endif
+    } // namespace
+
+    void decodeU16Array(const uint8_t* src, uint16_t* dst, size_t count) {
+        size_t i = 0;
+
+#if TTF_HAS_AVX2
+        if (cpuHasAvx2()) {
+            i = decodeU16ArrayAvx2(src, dst, count);
+        }
+#endif
+#if TTF_BE_SSE2
+        for (; i + 8 <= count; i += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+            _mm_storeu_si128((__m128i*)(dst + i), swap16x8(v));
+        }
+#endif
+
+        for (; i < count; ++i) {
+            dst[i] = readU16(src + 2 * i);
+        }
+    }
+
+    void decodeU32Array(const uint8_t* src, uint32_t* dst, size_t count) {
+        size_t i = 0;
+
+#if TTF_HAS_AVX2
+        if (cpuHasAvx2()) {
+            i = decodeU32ArrayAvx2(src, dst, count);
+        }
+#endif
+#if TTF_BE_SSE2
+        for (; i + 4 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+            _mm_storeu_si128((__m128i*)(dst + i), swap32x4(v));
+        }
+#endif
+
+        for (; i < count; ++i) {
+            dst[i] = readU32(src + 4 * i);
+        }
+    }
+
+    void decodeU16ToU32Array(const uint8_t* src, uint32_t* dst, size_t count, unsigned shift) {
+        size_t i = 0;
+
+#if TTF_HAS_AVX2
+        if (cpuHasAvx2()) {
+            i = decodeU16ToU32ArrayAvx2(src, dst, count, shift);
+        }
+#endif
+#if TTF_BE_SSE2
+        const __m128i shiftCount = _mm_cvtsi32_si128(static_cast<int>(shift));
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= count; i += 8) {
+            __m128i v = swap16x8(_mm_loadu_si128((const __m128i*)(src + 2 * i)));
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_sll_epi32(_mm_unpacklo_epi16(v, zero), shiftCount));
+            _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_sll_epi32(_mm_unpackhi_epi16(v, zero), shiftCount));
+        }
+#endif
+
+        for (; i < count; ++i) {
+            dst[i] = uint32_t(readU16(src + 2 * i)) << shift;
+        }
+    }
+
+    uint32_t sumU32Array(const uint8_t* src, size_t count) {
+        uint32_t sum = 0;
+        size_t i = 0;
+
+#if TTF_HAS_AVX2
+        if (cpuHasAvx2()) {
+            i = sumU32ArrayAvx2(src, count, sum);
+        }
+#endif
+#if TTF_BE_SSE2
+        __m128i sum128 = _mm_setzero_si128();
+        for (; i + 4 <= count; i += 4) {
+            sum128 = _mm_add_epi32(sum128, swap32x4(_mm_loadu_si128((const __m128i*)(src + 4 * i))));
+        }
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum += static_cast<uint32_t>(_mm_cvtsi128_si32(sum128));
+#endif
+
+        for (; i < count; ++i) {
+            sum += readU32(src + 4 * i);
+        }
+        return sum;
+    }
+
+    bool readU16Array(ByteView data, size_t offset, size_t count, std::vector<uint16_t>& out) {
+        if (count > data.size() / 2 || !data.contains(offset, 2 * count)) {
+            return false;
+        }
+
+        out.resize(count);
+        decodeU16Array(data.data() + offset, out.data(), count);
+        return true;
+    }
+
+    bool readU32Array(ByteView data, size_t offset, size_t count, std::vector<uint32_t>& out) {
+        if (count > data.size() / 4 || !data.contains(offset, 4 * count)) {
+            return false;
+        }
+
+        out.resize(count);
+        decodeU32Array(data.data() + offset, out.data(), count);
+        return true;
+    }
+
+} // namespace TTFParser
@@ -0,0 +1,54 @@
+#ifndef BIG_ENDIAN_HPP
+#define BIG_ENDIAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FontBuffer.hpp"
+
+namespace TTFParser {
+
+    /**
+    * Bulk decoding of big-endian arrays (loca offsets, hmtx metrics, cmap and post arrays).
+    *
+    * The raw decoders convert `count` consecutive big-endian values starting at `src` into
+    * native values at `dst`; they do no bounds checking, so callers validate the whole range
+    * once up front. `src` may be unaligned. Whole vectors are byte-swapped with AVX2 shuffles
+    * when the CPU has AVX2 and with SSE2 otherwise, with a scalar loop for the tail and for
+    * non-x86 targets.
+    */
+
+    // Reads one big-endian value; `data` may be unaligned.
+    inline uint16_t readU16(const uint8_t* data) {
+        return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    }
+
+    inline uint32_t readU32(const uint8_t* data) {
+        return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+    }
+
+    void decodeU16Array(const uint8_t* src, uint16_t* dst, size_t count);
+    void decodeU32Array(const uint8_t* src, uint32_t* dst, size_t count);
+
+    // Decodes big-endian uint16 values and widens them to uint32, shifted left by `shift` bits
+    // (short 'loca' offsets are stored divided by two, so they are decoded with a shift of 1).
+    void decodeU16ToU32Array(const uint8_t* src, uint32_t* dst, size_t count, unsigned shift);
+
+    // Sums `count` big-endian uint32 values modulo 2^32: the sfnt checksum of whole words.
+    uint32_t sumU32Array(const uint8_t* src, size_t count);
+
+    /**
+     * @brief Bounds-checks and decodes `count` big-endian uint16 values at `offset` into `out`.
+     * @return false, leaving `out` untouched, if the range does not lie inside `data`.
+     */
+    bool readU16Array(ByteView data, size_t offset, size_t count, std::vector<uint16_t>& out);
+
+    /**
+     * @brief Bounds-checks and decodes `count` big-endian uint32 values at `offset` into `out`.
+     * @return false, leaving `out` untouched, if the range does not lie inside `data`.
+     */
+    bool readU32Array(ByteView data, size_t offset, size_t count, std::vector<uint32_t>& out);
+
+} // namespace TTFParser
+
+#endif // BIG_ENDIAN_HPP
@@ -0,0 +1,249 @@
+#include "CmapIndex.hpp"
+#include "CpuFeatures.hpp"
+#include <algorithm>
+
+#if TTF_HAS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace TTFParser {
+    namespace {
+        const uint32_t kMaxCodepoint = 0x10FFFF;
+        const size_t kPageSize = 256;
+    } // namespace
+
+    CmapIndex::CmapIndex() : pageIndex(kPageSize + 1, 0), pages(kPageSize + 1, 0) {
+    }
+
+    void CmapIndex::build(const CmapTable& cmap, uint16_t numGlyphs) {
+        pageIndex.assign(kPageSize + 1, 0);
+        pages.assign(kPageSize, 0); // The shared empty page
+        ranges.clear();
+        mappedCount = 0;
+
+        // Only subtables serving a Unicode encoding record count; shared ones are visited once
+        std::vector<bool> isUnicode(cmap.subtables.size(), false);
+        for (const CmapEncodingRecord& record : cmap.encodingRecords) {
+            if (record.subtableIndex >= 0 && record.isUnicode()) {
+                isUnicode[record.subtableIndex] = true;
+            }
+        }
+
+        // Subtables are merged from the highest priority down, each only filling what is still unmapped
+        static const uint16_t kFormatPriority[] = { 12, 10, 4, 13 };
+        for (uint16_t format : kFormatPriority) {
+            for (size_t index = 0; index < cmap.subtables.size(); ++index) {
+                const std::unique_ptr<CmapSubtable>& subtable = cmap.subtables[index];
+                if (!isUnicode[index] || subtable->format != format) {
+                    continue;
+                }
+
+                std::vector<Range> added;
+                if (format == 12) {
+                    for (const GroupFormat12& group : static_cast<const CmapFormat12&>(*subtable).groups) {
+                        if (group.startCharCode > group.endCharCode || group.startCharCode > kMaxCodepoint ||
+                            group.startGlyphID >= numGlyphs) {
+                            continue;
+                        }
+                        // Stop where the glyph IDs run past the font
+                        const uint32_t last = std::min({ group.endCharCode, kMaxCodepoint,
+                            group.startCharCode + (numGlyphs - 1 - group.startGlyphID) });
+                        // A group starting at glyph 0 maps its first codepoint to .notdef, which is no mapping
+                        uint32_t codepoint = group.startCharCode + (group.startGlyphID == 0 ? 1 : 0);
+                        for (; codepoint <= last && codepoint < 0x10000; ++codepoint) {
+                            mapBmp(codepoint, static_cast<uint16_t>(group.startGlyphID + (codepoint - group.startCharCode)));
+                        }
+                        if (codepoint <= last) {
+                            added.push_back({ codepoint, last, static_cast<uint16_t>(group.startGlyphID + (codepoint - group.startCharCode)), false });
+                        }
+                    }
+                }
+                else if (format == 10) {
+                    const CmapFormat10& table = static_cast<const CmapFormat10&>(*subtable);
+                    for (size_t i = 0; i < table.glyphs.size(); ++i) {
+                        const uint32_t codepoint = table.startCharCode + static_cast<uint32_t>(i);
+                        const uint16_t glyph = table.glyphs[i];
+                        if (codepoint > kMaxCodepoint) {
+                            break;
+                        }
+                        if (glyph == 0 || glyph >= numGlyphs) {
+                            continue;
+                        }
+                        if (codepoint < 0x10000) {
+                            mapBmp(codepoint, glyph);
+                        }
+                        else if (!added.empty() && !added.back().sameGlyph && added.back().last + 1 == codepoint &&
+                            added.back().glyph + (codepoint - added.back().first) == glyph) {
+                            added.back().last = codepoint; // Extends a run of consecutive glyphs
+                        }
+                        else {
+                            added.push_back({ codepoint, codepoint, glyph, false });
+                        }
+                    }
+                }
+                else if (format == 4) {
+                    // glyphIndices holds every segment's glyphs back to back, in segment order
+                    const CmapFormat4& table = static_cast<const CmapFormat4&>(*subtable);
+                    size_t index = 0;
+                    for (size_t segment = 0; segment < table.startCount.size() && segment < table.endCount.size(); ++segment) {
+                        for (uint32_t codepoint = table.startCount[segment]; codepoint <= table.endCount[segment]; ++codepoint) {
+                            if (index >= table.glyphIndices.size()) {
+                                break;
+                            }
+                            const uint16_t glyph = table.glyphIndices[index++];
+                            if (glyph < numGlyphs && codepoint != 0xFFFF) {
+                                mapBmp(codepoint, glyph);
+                            }
+                        }
+                    }
+                }
+                else {
+                    for (const GroupFormat13& group : static_cast<const CmapFormat13&>(*subtable).groups) {
+                        if (group.startCharCode > group.endCharCode || group.startCharCode > kMaxCodepoint ||
+                            group.glyphID == 0 || group.glyphID >= numGlyphs) {
+                            continue;
+                        }
+                        const uint32_t last = std::min(group.endCharCode, kMaxCodepoint);
+                        uint32_t codepoint = group.startCharCode;
+                        for (; codepoint <= last && codepoint < 0x10000; ++codepoint) {
+                            mapBmp(codepoint, static_cast<uint16_t>(group.glyphID));
+                        }
+                        if (codepoint <= last) {
+                            added.push_back({ codepoint, last, static_cast<uint16_t>(group.glyphID), true });
+                        }
+                    }
+                }
+                addRanges(added);
+            }
+        }
+
+        for (const Range& range : ranges) {
+            mappedCount += range.last - range.first + 1;
+        }
+        pages.push_back(0); // Padding for the gathers
+    }
+
+    void CmapIndex::mapBmp(uint32_t codepoint, uint16_t glyph) {
+        if (glyph == 0) {
+            return;
+        }
+        uint16_t& page = pageIndex[codepoint >> 8];
+        if (page == 0) {
+            page = static_cast<uint16_t>(pages.size() / kPageSize);
+            pages.resize(pages.size() + kPageSize, 0);
+        }
+        uint16_t& slot = pages[(size_t(page) << 8) | (codepoint & 0xFF)];
+        if (slot == 0) {
+            slot = glyph;
+            ++mappedCount;
+        }
+    }
+
+    void CmapIndex::addRanges(std::vector<Range>& added) {
+        if (added.empty()) {
+            return;
+        }
+        std::sort(added.begin(), added.end(), [](const Range& a, const Range& b) { return a.first < b.first; });
+
+        // Cut out what the existing ranges, and earlier ranges of this subtable, already cover
+        std::vector<Range> pieces;
+        uint32_t coveredUntil = 0; // One past the last codepoint of the added ranges so far
+        for (const Range& range : added) {
+            uint32_t first = std::max(range.first, coveredUntil);
+            if (first > range.last) {
+                continue;
+            }
+            coveredUntil = std::max(coveredUntil, range.last + 1);
+
+            auto it = std::upper_bound(ranges.begin(), ranges.end(), first, [](uint32_t value, const Range& existing) {
+                return value < existing.first;
+            });
+            if (it != ranges.begin()) {
+                --it;
+            }
+            for (; first <= range.last; ++it) {
+                const uint32_t gapEnd = it == ranges.end() ? range.last : std::min(range.last, it->first - 1);
+                if (it == ranges.end() || first < it->first) {
+                    const uint16_t glyph = range.sameGlyph ? range.glyph : static_cast<uint16_t>(range.glyph + (first - range.first));
+                    pieces.push_back({ first, gapEnd, glyph, range.sameGlyph });
+                    first = gapEnd + 1;
+                }
+                if (it == ranges.end()) {
+                    break;
+                }
+                first = std::max(first, it->last + 1);
+            }
+        }
+
+        const size_t middle = ranges.size();
+        ranges.insert(ranges.end(), pieces.begin(), pieces.end());
+        std::inplace_merge(ranges.begin(), ranges.begin() + middle, ranges.end(),
+            [](const Range& a, const Range& b) { return a.first < b.first; });
+    }
+
+    uint16_t CmapIndex::lookupSupplementary(uint32_t codepoint) const {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), codepoint, [](uint32_t value, const Range& range) {
+            return value < range.first;
+        });
+        if (it == ranges.begin() || codepoint > (--it)->last) {
+            return 0;
+        }
+        return it->sameGlyph ? it->glyph : static_cast<uint16_t>(it->glyph + (codepoint - it->first));
+    }
+
+#if TTF_HAS_AVX2
+    TTF_AVX2_TARGET size_t CmapIndex::codepointsToGlyphsAvx2(const uint32_t* codepoints, uint16_t* glyphs, size_t count) const {
+        size_t i = 0;
+
+        // Two gathers resolve eight BMP codepoints. Each reads 32 bits at a 16-bit entry and keeps
+        // the low half; the padding entries keep the last read in bounds.
+        const int* pageIndex32 = reinterpret_cast<const int*>(pageIndex.data());
+        const int* pages32 = reinterpret_cast<const int*>(pages.data());
+        const __m256i lowByte = _mm256_set1_epi32(0xFF);
+        const __m256i lowWord = _mm256_set1_epi32(0xFFFF);
+        for (; i + 8 <= count; i += 8) {
+            __m256i codepoint = _mm256_loadu_si256((const __m256i*)(codepoints + i));
+            // Lanes beyond the BMP look up codepoint 0 and are redone below
+            const __m256i bmp = _mm256_cmpeq_epi32(_mm256_srli_epi32(codepoint, 16), _mm256_setzero_si256());
+            codepoint = _mm256_and_si256(codepoint, bmp);
+
+            const __m256i page = _mm256_and_si256(_mm256_i32gather_epi32(pageIndex32, _mm256_srli_epi32(codepoint, 8), 2), lowWord);
+            const __m256i slot = _mm256_or_si256(_mm256_slli_epi32(page, 8), _mm256_and_si256(codepoint, lowByte));
+            const __m256i glyph = _mm256_and_si256(_mm256_i32gather_epi32(pages32, slot, 2), lowWord);
+
+            // Narrow to 16 bits: the pack works per 128-bit half, so gather the halves' low quadwords
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(glyph, glyph), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i*)(glyphs + i), _mm256_castsi256_si128(packed));
+
+            const int bmpMask = _mm256_movemask_ps(_mm256_castsi256_ps(bmp));
+            if (bmpMask != 0xFF) {
+                for (size_t lane = 0; lane < 8; ++lane) {
+                    if (!(bmpMask & (1 << lane))) {
+                        glyphs[i + lane] = lookupSupplementary(codepoints[i + lane]);
+                    }
+                }
+            }
+        }
+        return i;
+    }
+#endif
+
+    void CmapIndex::codepointsToGlyphs(const uint32_t* codepoints, uint16_t* glyphs, size_t count) const {
+        size_t i = 0;
+
+#if TTF_HAS_AVX2
+        if (cpuHasAvx2()) {
+            i = codepointsToGlyphsAvx2(codepoints, glyphs, count);
+        }
+#endif
+
+        for (; i < count; ++i) {
+            glyphs[i] = codepointToGlyph(codepoints[i]);
+        }
+    }
+
+    size_t CmapIndex::getMemoryBytes() const {
+        return (pageIndex.size() + pages.size()) * sizeof(uint16_t) + ranges.size() * sizeof(Range);
+    }
+
+} // namespace TTFParser
@@ -0,0 +1,89 @@
+#ifndef CMAP_INDEX_HPP
+#define CMAP_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "TTFParser.hpp"
+
+namespace TTFParser {
+
+    /**
+    * @class CmapIndex
+    * @brief Constant-time codepoint to glyph lookup over all Unicode subtables of a font.
+    *
+    * BMP codepoints go through a two-level table: the high byte selects one of 256 pages and
+    * the low byte a glyph in it. Pages without any mapping all share page 0, which is empty,
+    * so a Latin font costs a few pages and a full CJK font at most 256 (128 KB). Supplementary
+    * codepoints live in sorted ranges (format 12 and 13 groups, format 10 arrays) found by
+    * binary search.
+    *
+    * The subtables of formats 4, 10, 12 and 13 that serve a Unicode encoding record (see
+    * CmapEncodingRecord::isUnicode) are merged; where several map a codepoint, format 12 wins
+    * over 10, then 4, then 13 (whose many-to-one ranges are last-resort fallbacks). The
+    * byte-oriented formats 0, 2, 6 and 8 hold legacy encodings and are ignored.
+    */
+    class CmapIndex {
+    public:
+        CmapIndex();
+
+        /**
+         * @brief Builds the index from a parsed cmap table.
+         * @param cmap The parsed table (see TTFParser::parseCmapTable).
+         * @param numGlyphs Glyph count of the font; mappings to glyphs beyond it are dropped.
+         */
+        void build(const CmapTable& cmap, uint16_t numGlyphs);
+
+        // Glyph mapped to a codepoint, or 0 (.notdef) if there is none.
+        uint16_t codepointToGlyph(uint32_t codepoint) const {
+            if (codepoint < 0x10000) {
+                return pages[(size_t(pageIndex[codepoint >> 8]) << 8) | (codepoint & 0xFF)];
+            }
+            return lookupSupplementary(codepoint);
+        }
+
+        /**
+         * @brief Looks up many codepoints at once.
+         *
+         * BMP codepoints are resolved eight at a time with AVX2 gathers when the CPU has AVX2;
+         * supplementary ones fall back to the binary search.
+         */
+        void codepointsToGlyphs(const uint32_t* codepoints, uint16_t* glyphs, size_t count) const;
+
+        // Number of mapped codepoints.
+        size_t getMappedCount() const { return mappedCount; }
+
+        // Bytes used by the index.
+        size_t getMemoryBytes() const;
+
+    private:
+        // A run of supplementary codepoints mapped to consecutive glyphs, or all to one glyph.
+        struct Range {
+            uint32_t first;
+            uint32_t last;
+            uint16_t glyph;      // Glyph of `first`.
+            bool sameGlyph;      // Every codepoint maps to `glyph` (format 13).
+        };
+
+        uint16_t lookupSupplementary(uint32_t codepoint) const;
+
+        // AVX2 part of codepointsToGlyphs (see CpuFeatures.hpp); returns how many codepoints it resolved.
+        size_t codepointsToGlyphsAvx2(const uint32_t* codepoints, uint16_t* glyphs, size_t count) const;
+
+        // Sets the glyph of a BMP codepoint unless a higher-priority subtable already did.
+        void mapBmp(uint32_t codepoint, uint16_t glyph);
+
+        // Adds supplementary ranges, clipped so existing (higher-priority) ranges keep their codepoints.
+        void addRanges(std::vector<Range>& added);
+
+        // High byte -> page number; one extra entry so 32-bit gathers never read past the end.
+        std::vector<uint16_t> pageIndex;
+        // 256 glyph IDs per page, page 0 being the shared empty page; plus one padding entry.
+        std::vector<uint16_t> pages;
+        std::vector<Range> ranges; // Sorted, non-overlapping.
+        size_t mappedCount = 0;
+    };
+
+} // namespace TTFParser
+
+#endif // CMAP_INDEX_HPP
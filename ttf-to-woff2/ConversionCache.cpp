@@ -0,0 +1,203 @@
+#include "ConversionCache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace FontConverter {
+    namespace fs = std::filesystem;
+
+    namespace {
+        const char kEntryExtension[] = ".woff2";
+        const char kTemporaryExtension[] = ".tmp";
+
+        // Leftover temporary files older than this belong to a writer that died.
+        const std::chrono::hours kStaleTemporaryAge(1);
+
+        bool isValidKey(const std::string& key) {
+            return key.size() >= 8 && std::all_of(key.begin(), key.end(),
+                [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+        }
+
+        // A name no other writer will pick for its temporary file.
+        std::string uniqueSuffix() {
+            thread_local std::mt19937_64 generator(std::random_device{}() ^
+                std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+            static const char kHexDigits[] = "0123456789abcdef";
+            uint64_t value = generator();
+            std::string suffix(16, '0');
+            for (char& c : suffix) {
+                c = kHexDigits[value & 15];
+                value >>= 4;
+            }
+            return suffix;
+        }
+    } // namespace
+
+    ConversionCache::ConversionCache(const std::string& directory, uint64_t maxBytes) : root(directory), maxBytes(maxBytes) {
+        std::error_code error;
+        fs::create_directories(root, error);
+        open = fs::is_directory(root, error);
+        if (!open) {
+            std::cerr << "Error: Failed to open cache directory: " << directory << std::endl;
+            return;
+        }
+
+        uint64_t total = 0;
+        for (fs::recursive_directory_iterator it(root, error), last; !error && it != last; it.increment(error)) {
+            if (it->path().extension() == kEntryExtension && it->is_regular_file(error)) {
+                total += it->file_size(error);
+            }
+        }
+        sizeBytes = total;
+    }
+
+    fs::path ConversionCache::entryPath(const std::string& key) const {
+        return root / key.substr(0, 2) / (key + kEntryExtension);
+    }
+
+    bool ConversionCache::lookup(const std::string& key, std::vector<uint8_t>& woff2) {
+        if (!open || !isValidKey(key)) {
+            ++misses;
+            return false;
+        }
+
+        const fs::path path = entryPath(key);
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            ++misses;
+            return false;
+        }
+
+        const std::streamoff size = file.tellg();
+        woff2.resize(size > 0 ? static_cast<size_t>(size) : 0);
+        file.seekg(0);
+        const bool read = size >= 4 && file.read(reinterpret_cast<char*>(woff2.data()), size);
+        file.close();
+
+        // Entries only ever appear whole, so a bad one means outside damage: drop it
+        if (!read || woff2[0] != 'w' || woff2[1] != 'O' || woff2[2] != 'F' || woff2[3] != '2') {
+            std::error_code error;
+            fs::remove(path, error);
+            woff2.clear();
+            ++misses;
+            return false;
+        }
+
+        // Mark the entry as recently used for eviction
+        std::error_code error;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+        ++hits;
+        return true;
+    }
+
+    bool ConversionCache::store(const std::string& key, const uint8_t* data, size_t size) {
+        if (!open || !isValidKey(key)) {
+            return false;
+        }
+
+        std::error_code error;
+        const fs::path path = entryPath(key);
+        fs::create_directories(path.parent_path(), error);
+
+        // Write a private temporary file, then rename it over the entry in one step
+        const fs::path temporary = path.parent_path() / (key + "." + uniqueSuffix() + kTemporaryExtension);
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file || !file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size)) || !file.flush()) {
+                file.close();
+                fs::remove(temporary, error);
+                std::cerr << "Error: Failed to write cache entry: " << temporary.string() << std::endl;
+                return false;
+            }
+        }
+
+        const uintmax_t replacedSize = fs::file_size(path, error);
+        const uint64_t replaced = error ? 0 : static_cast<uint64_t>(replacedSize);
+
+        fs::rename(temporary, path, error);
+        if (error) {
+            fs::remove(temporary, error);
+            std::cerr << "Error: Failed to store cache entry: " << path.string() << std::endl;
+            return false;
+        }
+
+        ++stores;
+        const uint64_t total = (sizeBytes += uint64_t(size) - replaced); // Wraps correctly if the entry shrank
+        if (maxBytes > 0 && total > maxBytes) {
+            evict(maxBytes - maxBytes / 10); // Leave some headroom so every store does not trigger a scan
+        }
+        return true;
+    }
+
+    void ConversionCache::evict(uint64_t targetBytes) {
+        std::unique_lock<std::mutex> lock(evictMutex, std::try_to_lock);
+        if (!open || !lock.owns_lock()) {
+            return; // Another thread is already evicting
+        }
+
+        struct Entry {
+            fs::file_time_type lastUsed;
+            uint64_t size;
+            fs::path path;
+        };
+        std::vector<Entry> entries;
+        uint64_t total = 0;
+
+        std::error_code error;
+        const fs::file_time_type now = fs::file_time_type::clock::now();
+        for (fs::recursive_directory_iterator it(root, error), last; !error && it != last; it.increment(error)) {
+            std::error_code entryError;
+            if (!it->is_regular_file(entryError)) {
+                continue;
+            }
+
+            const fs::path& path = it->path();
+            const fs::file_time_type lastUsed = it->last_write_time(entryError);
+            if (path.extension() == kTemporaryExtension) {
+                if (!entryError && now - lastUsed > kStaleTemporaryAge) {
+                    fs::remove(path, entryError);
+                }
+                continue;
+            }
+            if (path.extension() != kEntryExtension || entryError) {
+                continue;
+            }
+
+            const uint64_t size = it->file_size(entryError);
+            if (!entryError) {
+                entries.push_back({ lastUsed, size, path });
+                total += size;
+            }
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
+        for (const Entry& entry : entries) {
+            if (total <= targetBytes) {
+                break;
+            }
+            if (fs::remove(entry.path, error)) {
+                total -= entry.size;
+                ++evictions;
+                evictedBytes += entry.size;
+            }
+        }
+        sizeBytes = total;
+    }
+
+    CacheStats ConversionCache::getStats() const {
+        CacheStats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.stores = stores;
+        stats.evictions = evictions;
+        stats.evictedBytes = evictedBytes;
+        stats.sizeBytes = sizeBytes;
+        return stats;
+    }
+
+} // namespace FontConverter
@@ -0,0 +1,83 @@
+#ifndef CONVERSION_CACHE_HPP
+#define CONVERSION_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace FontConverter {
+
+    // Counters of a ConversionCache since it was opened.
+    struct CacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;       // Entries written.
+        uint64_t evictions = 0;    // Entries removed to stay under the size limit.
+        uint64_t evictedBytes = 0;
+        uint64_t sizeBytes = 0;    // Approximate size of all entries.
+    };
+
+    /**
+    * @class ConversionCache
+    * @brief A content-addressed, on-disk store of converted WOFF2 files.
+    *
+    * Entries are named by a hex key (see FontConverter::setCache) and live at
+    * <directory>/<first two digits>/<key>.woff2. Each entry is written to a temporary file
+    * and renamed into place, so any number of threads or processes can share a directory and
+    * readers never see a partial file. Reads refresh an entry's modification time, which
+    * evict() uses as its least-recently-used order.
+    *
+    * All member functions are thread-safe.
+    */
+    class ConversionCache {
+    public:
+        /**
+         * @brief Opens (creating it if needed) a cache directory.
+         * @param directory Where entries are stored.
+         * @param maxBytes Size above which old entries are evicted after a store; 0 for no limit.
+         */
+        explicit ConversionCache(const std::string& directory, uint64_t maxBytes = 0);
+
+        // Whether the directory could be created.
+        bool isOpen() const { return open; }
+
+        /**
+         * @brief Reads the entry for a key.
+         * @return true on a hit; false if there is no valid entry.
+         */
+        bool lookup(const std::string& key, std::vector<uint8_t>& woff2);
+
+        /**
+         * @brief Adds an entry, replacing any entry with the same key.
+         * @return false if it could not be written.
+         */
+        bool store(const std::string& key, const uint8_t* data, size_t size);
+
+        // Removes least recently used entries until the cache holds at most `targetBytes`.
+        void evict(uint64_t targetBytes);
+
+        CacheStats getStats() const;
+
+    private:
+        std::filesystem::path entryPath(const std::string& key) const;
+
+        std::filesystem::path root;
+        uint64_t maxBytes;
+        bool open = false;
+
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> misses{ 0 };
+        std::atomic<uint64_t> stores{ 0 };
+        std::atomic<uint64_t> evictions{ 0 };
+        std::atomic<uint64_t> evictedBytes{ 0 };
+        std::atomic<uint64_t> sizeBytes{ 0 };
+        std::mutex evictMutex; // One eviction pass at a time.
+    };
+
+} // namespace FontConverter
+
+#endif // CONVERSION_CACHE_HPP
@@ -0,0 +1,39 @@
+#include "CpuFeatures.hpp"
+
+#if TTF_HAS_AVX2 && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace TTFParser {
+    namespace {
+        bool detectAvx2() {
+#if TTF_HAS_AVX2 && defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+            // OSXSAVE and AVX, then whether the OS saves the SSE and AVX register state
+            __cpuid(info, 1);
+            const int osxsaveAndAvx = (1 << 27) | (1 << 28);
+            if ((info[2] & osxsaveAndAvx) != osxsaveAndAvx || (_xgetbv(0) & 6) != 6) {
+                return false;
+            }
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#elif TTF_HAS_AVX2
+            __builtin_cpu_init(); // May run before the constructors that normally set up the data
+            return __builtin_cpu_supports("avx2") != 0;
+#else
+            return false;
+#endif
+        }
+    } // namespace
+
+    bool cpuHasAvx2() {
+        static const bool hasAvx2 = detectAvx2();
+        return hasAvx2;
+    }
+
+} // namespace TTFParser
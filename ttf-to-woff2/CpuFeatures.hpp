@@ -0,0 +1,27 @@
+#ifndef CPU_FEATURES_HPP
+#define CPU_FEATURES_HPP
+
+/**
+* AVX2 code paths in an otherwise baseline (SSE2) x86 build.
+*
+* Functions marked TTF_AVX2_TARGET are compiled for AVX2 on their own, so the rest of the
+* program still runs on any x86-64 CPU; callers only enter them when cpuHasAvx2() is true.
+* TTF_HAS_AVX2 is defined to 1 where such functions can be built at all.
+*/
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TTF_HAS_AVX2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define TTF_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define TTF_AVX2_TARGET // MSVC compiles AVX2 intrinsics without /arch:AVX2
+#endif
+#endif
+
+namespace TTFParser {
+
+    // Whether the CPU (and the OS, which has to save the YMM registers) supports AVX2. Checked once.
+    bool cpuHasAvx2();
+
+} // namespace TTFParser
+
+#endif // CPU_FEATURES_HPP
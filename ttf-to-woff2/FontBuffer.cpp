@@ -0,0 +1,179 @@
+#include "FontBuffer.hpp"
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TTFParser {
+    FontBuffer::~FontBuffer() {
+        reset();
+    }
+
+    FontBuffer::FontBuffer(FontBuffer&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    FontBuffer& FontBuffer::operator=(FontBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+
+            // Moving a vector keeps its heap block, so `bytes` stays valid for owned data too.
+            owned = std::move(other.owned);
+            bytes = other.bytes;
+            length = other.length;
+            mapped = other.mapped;
+#ifdef _WIN32
+            fileHandle = other.fileHandle;
+            mappingHandle = other.mappingHandle;
+            other.fileHandle = nullptr;
+            other.mappingHandle = nullptr;
+#endif
+            other.bytes = nullptr;
+            other.length = 0;
+            other.mapped = false;
+        }
+        return *this;
+    }
+
+    bool FontBuffer::mapFile(const std::string& filename) {
+        reset();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            std::cerr << "Failed to open font file for mapping: " << filename << std::endl;
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            std::cerr << "Cannot map empty or unreadable font file: " << filename << std::endl;
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            std::cerr << "Failed to create file mapping: " << filename << std::endl;
+            CloseHandle(file);
+            return false;
+        }
+
+        const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            std::cerr << "Failed to map view of font file: " << filename << std::endl;
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        fileHandle = file;
+        mappingHandle = mapping;
+        bytes = static_cast<const uint8_t*>(view);
+        length = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Failed to open font file for mapping: " << filename << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            std::cerr << "Cannot map empty or unreadable font file: " << filename << std::endl;
+            close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // The mapping keeps its own reference to the file.
+        if (view == MAP_FAILED) {
+            std::cerr << "Failed to map font file: " << filename << std::endl;
+            return false;
+        }
+
+        bytes = static_cast<const uint8_t*>(view);
+        length = static_cast<size_t>(st.st_size);
+#endif
+
+        mapped = true;
+        return true;
+    }
+
+    bool FontBuffer::readFile(const std::string& filename) {
+        reset();
+
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open font file: " << filename << std::endl;
+            return false;
+        }
+
+        std::streamsize size = file.tellg();
+        if (size < 0) {
+            std::cerr << "Failed to determine size of font file: " << filename << std::endl;
+            return false;
+        }
+        file.seekg(0, std::ios::beg);
+
+        owned.resize(static_cast<size_t>(size));
+        if (!file.read((char*)owned.data(), size)) {
+            std::cerr << "Failed to read font file: " << filename << std::endl;
+            owned.clear();
+            return false;
+        }
+
+        bytes = owned.data();
+        length = owned.size();
+        return true;
+    }
+
+    void FontBuffer::borrow(const uint8_t* data, size_t size) {
+        reset();
+        bytes = data;
+        length = data ? size : 0;
+    }
+
+    void FontBuffer::adopt(std::vector<uint8_t>&& data) {
+        reset();
+        owned = std::move(data);
+        bytes = owned.data();
+        length = owned.size();
+    }
+
+    void FontBuffer::reset() {
+        if (mapped) {
+            unmap();
+        }
+
+        owned.clear();
+        owned.shrink_to_fit();
+        bytes = nullptr;
+        length = 0;
+        mapped = false;
+    }
+
+    void FontBuffer::unmap() {
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+    }
+
+} // namespace TTFParser
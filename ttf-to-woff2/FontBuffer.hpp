@@ -0,0 +1,126 @@
+#ifndef FONT_BUFFER_HPP
+#define FONT_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace TTFParser {
+
+    /**
+    * @class ByteView
+    * @brief A non-owning, read-only view over a contiguous range of font bytes.
+    */
+    class ByteView {
+    public:
+        ByteView() = default;
+        ByteView(const uint8_t* data, size_t size) : bytes(data), length(size) {}
+
+        const uint8_t* data() const { return bytes; }
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+
+        const uint8_t* begin() const { return bytes; }
+        const uint8_t* end() const { return bytes + length; }
+
+        const uint8_t& operator[](size_t index) const { return bytes[index]; }
+
+        /**
+         * @brief Checks whether [offset, offset + count) lies inside the view.
+         */
+        bool contains(size_t offset, size_t count) const {
+            return offset <= length && count <= length - offset;
+        }
+
+        /**
+         * @brief Returns a view of `count` bytes starting at `offset`, or an empty view if out of range.
+         */
+        ByteView subview(size_t offset, size_t count) const {
+            return contains(offset, count) ? ByteView(bytes + offset, count) : ByteView();
+        }
+
+        /**
+         * @brief Returns a view of everything from `offset` to the end, or an empty view if out of range.
+         */
+        ByteView subview(size_t offset) const {
+            return offset <= length ? ByteView(bytes + offset, length - offset) : ByteView();
+        }
+
+    private:
+        const uint8_t* bytes = nullptr;
+        size_t length = 0;
+    };
+
+    /**
+    * @class FontBuffer
+    * @brief Holds the raw bytes of a font: read into memory, memory-mapped from disk, or
+    * supplied by the caller (borrowed or adopted).
+    *
+    * A mapped buffer keeps the file mapping alive for as long as the buffer exists; all
+    * ByteViews handed out by the parser point straight into it, so no table is copied.
+    */
+    class FontBuffer {
+    public:
+        FontBuffer() = default;
+        ~FontBuffer();
+
+        FontBuffer(const FontBuffer&) = delete;
+        FontBuffer& operator=(const FontBuffer&) = delete;
+        FontBuffer(FontBuffer&& other) noexcept;
+        FontBuffer& operator=(FontBuffer&& other) noexcept;
+
+        /**
+         * @brief Maps a file read-only into memory.
+         * @param filename Path to the file.
+         * @return true if the file was mapped successfully, false otherwise.
+         */
+        bool mapFile(const std::string& filename);
+
+        /**
+         * @brief Reads a whole file into an owned heap buffer.
+         * @param filename Path to the file.
+         * @return true if the file was read successfully, false otherwise.
+         */
+        bool readFile(const std::string& filename);
+
+        /**
+         * @brief Wraps caller-owned bytes without copying them.
+         * The caller must keep the memory alive and unchanged for as long as the buffer is in use.
+         */
+        void borrow(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Takes ownership of a byte vector by move, without copying it.
+         */
+        void adopt(std::vector<uint8_t>&& data);
+
+        // Releases the mapping or owned storage.
+        void reset();
+
+        const uint8_t* data() const { return bytes; }
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+        bool isMapped() const { return mapped; }
+
+        const uint8_t& operator[](size_t index) const { return bytes[index]; }
+
+        ByteView view() const { return ByteView(bytes, length); }
+
+    private:
+        void unmap();
+
+        std::vector<uint8_t> owned; // Backing storage when the bytes were read or adopted.
+        const uint8_t* bytes = nullptr;
+        size_t length = 0;
+        bool mapped = false;
+
+#ifdef _WIN32
+        void* fileHandle = nullptr;    // HANDLE of the open file.
+        void* mappingHandle = nullptr; // HANDLE of the file mapping object.
+#endif
+    };
+
+} // namespace TTFParser
+
+#endif // FONT_BUFFER_HPP
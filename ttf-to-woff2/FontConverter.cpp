@@ -0,0 +1,298 @@
+#include "FontConverter.hpp"
+#include "FontBuffer.hpp"
+#include "Sha256.hpp"
+#include "Timing.hpp"
+#include "WOFF2Encoding.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace FontConverter {
+    using TTFParser::Clock;
+    using TTFParser::elapsedMs;
+
+    namespace {
+        // Passes output through to another sink and keeps a copy of it.
+        class CopyingSink : public WOFF2Builder::OutputSink {
+        public:
+            explicit CopyingSink(WOFF2Builder::OutputSink& target) : target(target) {}
+
+            bool write(const uint8_t* data, size_t size) override {
+                copy.insert(copy.end(), data, data + size);
+                return target.write(data, size);
+            }
+
+            bool canPatch() const override { return target.canPatch(); }
+
+            bool patch(size_t offset, const uint8_t* data, size_t size) override {
+                if (offset > copy.size() || size > copy.size() - offset || !target.patch(offset, data, size)) {
+                    return false;
+                }
+                std::memcpy(copy.data() + offset, data, size);
+                return true;
+            }
+
+            bool finish(bool success) override { return target.finish(success); }
+
+            const std::vector<uint8_t>& bytes() const { return copy; }
+
+        private:
+            WOFF2Builder::OutputSink& target;
+            std::vector<uint8_t> copy;
+        };
+    } // namespace
+
+    FontConverter::FontConverter(const WOFF2Builder::CompressionOptions& options, size_t threadCount)
+        : builder(options), pool(threadCount) {
+    }
+
+    void FontConverter::setSubset(const std::vector<uint32_t>& codepoints) {
+        subsetCodepoints = codepoints;
+        std::sort(subsetCodepoints.begin(), subsetCodepoints.end());
+        subsetCodepoints.erase(std::unique(subsetCodepoints.begin(), subsetCodepoints.end()), subsetCodepoints.end());
+        subsetting = true;
+    }
+
+    void FontConverter::clearSubset() {
+        subsetCodepoints.clear();
+        subsetting = false;
+    }
+
+    bool FontConverter::convertFile(const std::string& inputPath, const std::string& outputPath) {
+        const int fd = WOFF2Builder::FileDescriptorSink::openFile(outputPath.c_str());
+        if (fd < 0) {
+            return false;
+        }
+
+        bool converted = false;
+        {
+            WOFF2Builder::FileDescriptorSink sink(fd, true);
+            converted = convertFile(inputPath, sink);
+        }
+
+        if (!converted) {
+            std::remove(outputPath.c_str()); // Don't leave a truncated font behind
+        }
+        return converted;
+    }
+
+    bool FontConverter::convertFile(const std::string& inputPath, WOFF2Builder::OutputSink& sink) {
+        const Clock::time_point start = Clock::now();
+        stats = ConversionStats();
+
+        // Only map the bytes here; a cache hit never needs the parser
+        TTFParser::FontBuffer input;
+        if (!input.mapFile(inputPath) && !input.readFile(inputPath)) {
+            std::cerr << "Error: Failed to load font: " << inputPath << std::endl;
+            sink.finish(false);
+            return false;
+        }
+        stats.loadMs = elapsedMs(start);
+
+        if (!convertBytes(input.data(), input.size(), sink)) {
+            std::cerr << "Error: Failed to convert font: " << inputPath << std::endl;
+            return false;
+        }
+
+        stats.totalMs = elapsedMs(start);
+        return true;
+    }
+
+    bool FontConverter::convert(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        WOFF2Builder::VectorSink sink(out);
+        return convert(data, size, sink);
+    }
+
+    bool FontConverter::convert(const uint8_t* data, size_t size, WOFF2Builder::OutputSink& sink) {
+        const Clock::time_point start = Clock::now();
+        stats = ConversionStats();
+
+        if (!convertBytes(data, size, sink)) {
+            return false;
+        }
+
+        stats.totalMs = elapsedMs(start);
+        return true;
+    }
+
+    bool FontConverter::convertBytes(const uint8_t* data, size_t size, WOFF2Builder::OutputSink& sink) {
+        stats.inputBytes = size;
+
+        std::string key;
+        if (cache) {
+            const Clock::time_point hashStart = Clock::now();
+            key = cacheKey(data, size);
+            stats.hashMs = elapsedMs(hashStart);
+
+            std::vector<uint8_t> cached;
+            if (cache->lookup(key, cached)) {
+                const Clock::time_point writeStart = Clock::now();
+                const bool written = sink.write(cached.data(), cached.size());
+                const bool finished = sink.finish(written);
+                stats.cacheHit = true;
+                stats.build.writeMs = elapsedMs(writeStart);
+                stats.build.woff2Bytes = cached.size();
+                return written && finished;
+            }
+        }
+
+        const Clock::time_point loadStart = Clock::now();
+        TTFParser::TTFParser parser;
+        if (!parser.loadFromMemory(data, size)) {
+            sink.finish(false);
+            return false;
+        }
+        stats.loadMs += elapsedMs(loadStart);
+
+        if (!cache) {
+            return convertLoaded(parser, sink);
+        }
+
+        // Keep a copy of the output on its way to the sink and store it once the build succeeded
+        CopyingSink copyingSink(sink);
+        if (!convertLoaded(parser, copyingSink)) {
+            return false;
+        }
+        cache->store(key, copyingSink.bytes().data(), copyingSink.bytes().size()); // A failed store only costs a future miss
+        return true;
+    }
+
+    bool FontConverter::convertLoaded(TTFParser::TTFParser& parser, WOFF2Builder::OutputSink& sink) {
+        if (subsetting) {
+            return convertSubset(parser, sink);
+        }
+
+        const Clock::time_point decodeStart = Clock::now();
+        builder.reset(parser.getSfntVersion());
+
+        // glyf and loca are only transformed if every glyph decodes; otherwise they are copied as-is
+        TTFParser::GlyfTable glyf;
+        std::vector<TTFParser::GlyphMetrics> metrics;
+        TTFParser::HheaTable hhea{};
+        bool transformGlyf = false;
+        bool transformHmtx = false;
+        const TTFParser::ByteView glyfData = parser.getTableData("glyf");
+        const TTFParser::ByteView locaData = parser.getTableData("loca");
+        if (!glyfData.empty() && !locaData.empty()) {
+            TTFParser::LocaTable loca;
+            transformGlyf = parser.parseHeadTable(parser.getTableData("head")) &&
+                parser.parseMaxpTable(parser.getTableData("maxp")) &&
+                parser.parseLocaTable(locaData, loca) &&
+                parser.parseGlyfTable(glyfData, loca, glyf, &pool);
+
+            if (!transformGlyf) {
+                std::cerr << "Warning: Storing 'glyf' and 'loca' without the glyf transform." << std::endl;
+            }
+        }
+
+        const TTFParser::ByteView hheaData = parser.getTableData("hhea");
+        const TTFParser::ByteView hmtxData = parser.getTableData("hmtx");
+        if (transformGlyf && !hheaData.empty() && !hmtxData.empty()) {
+            transformHmtx = parser.parseHheaTable(hheaData, hhea) &&
+                parser.parseHmtxTable(hmtxData, hhea.numOfLongHorMetrics, metrics);
+        }
+        stats.decodeMs = elapsedMs(decodeStart);
+
+        KernCompaction kerning;
+        bool kernReplaced = false;
+        if (compactKern) {
+            const Clock::time_point kernStart = Clock::now();
+            kernReplaced = compactKerning(parser, kerning);
+            if (kernReplaced) {
+                stats.kernBytes = kerning.kernBytes;
+                stats.gposBytes = kerning.gpos.size();
+            }
+            stats.kernMs = elapsedMs(kernStart);
+        }
+
+        for (const TTFParser::TableRecord& record : parser.getTableDirectory()) {
+            if (record.tag == TTFParser::Tag("DSIG").value) {
+                continue; // The signature does not survive the transforms
+            }
+            if (kernReplaced && record.tag == TTFParser::Tag("kern").value) {
+                continue;
+            }
+            if (!builder.addTable(TTFParser::Tag(record.tag), record.data)) {
+                sink.finish(false);
+                return false;
+            }
+        }
+        if (kernReplaced && !builder.addTable(TTFParser::Tag("GPOS"), TTFParser::ByteView(kerning.gpos.data(), kerning.gpos.size()))) {
+            sink.finish(false);
+            return false;
+        }
+
+        if (transformGlyf) {
+            builder.setGlyfTable(glyf, parser.getHeadTable().indexToLocFormat);
+        }
+        if (transformHmtx) {
+            builder.setHmtxMetrics(metrics, hhea.numOfLongHorMetrics);
+        }
+
+        const bool built = builder.build(sink);
+        stats.build = builder.getStats();
+        return built;
+    }
+
+    bool FontConverter::convertSubset(TTFParser::TTFParser& parser, WOFF2Builder::OutputSink& sink) {
+        const Clock::time_point decodeStart = Clock::now();
+        FontSubsetter subsetter;
+        if (!subsetter.load(parser)) {
+            sink.finish(false);
+            return false;
+        }
+        stats.decodeMs = elapsedMs(decodeStart);
+
+        const Clock::time_point subsetStart = Clock::now();
+        SubsetFont subset;
+        if (!subsetter.subset(subsetCodepoints, subset)) {
+            sink.finish(false);
+            return false;
+        }
+        stats.subsetMs = elapsedMs(subsetStart);
+        stats.subsetGlyphs = subset.glyphs.size();
+
+        builder.reset(parser.getSfntVersion());
+        if (!subset.addTo(builder)) {
+            sink.finish(false);
+            return false;
+        }
+
+        const bool built = builder.build(sink);
+        stats.build = builder.getStats();
+        return built;
+    }
+
+    std::string FontConverter::cacheKey(const uint8_t* data, size_t size) const {
+        // Bump whenever the converter's output changes, so entries written by older versions stop matching
+        static const char kOutputFormat[] = "ttf-to-woff2 woff2 output v1";
+
+        const WOFF2Builder::CompressionOptions& options = builder.getCompressionOptions();
+        const uint8_t settings[3] = {
+            static_cast<uint8_t>(options.quality), static_cast<uint8_t>(options.windowBits), static_cast<uint8_t>(options.fontMode)
+        };
+
+        Sha256 hash;
+        hash.update(kOutputFormat, sizeof(kOutputFormat));
+        hash.update(settings, sizeof(settings));
+        if (compactKern && !subsetting) {
+            static const char kKernToGpos[] = "kern-to-gpos";
+            hash.update(kKernToGpos, sizeof(kKernToGpos));
+        }
+        if (subsetting) {
+            // Whole-font keys stay as they were; subsets add their codepoints
+            static const char kSubset[] = "subset";
+            hash.update(kSubset, sizeof(kSubset));
+            std::vector<uint8_t> codepoints(4 * subsetCodepoints.size() + 4);
+            uint8_t* p = WOFF2Builder::writeU32(codepoints.data(), static_cast<uint32_t>(subsetCodepoints.size()));
+            for (uint32_t codepoint : subsetCodepoints) {
+                p = WOFF2Builder::writeU32(p, codepoint);
+            }
+            hash.update(codepoints.data(), codepoints.size());
+        }
+        hash.update(data, size);
+        return hash.finishHex();
+    }
+
+} // namespace FontConverter
@@ -0,0 +1,133 @@
+#ifndef FONT_CONVERTER_HPP
+#define FONT_CONVERTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ConversionCache.hpp"
+#include "FontSubsetter.hpp"
+#include "KernCompactor.hpp"
+#include "ThreadPool.hpp"
+#include "TTFParser.hpp"
+#include "WOFF2Builder.hpp"
+
+namespace FontConverter {
+
+    // Timings and byte counts of the last conversion.
+    struct ConversionStats {
+        double loadMs = 0.0;   // Reading the input and its table directory.
+        double hashMs = 0.0;   // Computing the cache key.
+        double decodeMs = 0.0; // Parsing head, maxp, loca, glyf, hhea and hmtx (and cmap and post when subsetting).
+        double subsetMs = 0.0; // Cutting the subset, when one is set.
+        size_t subsetGlyphs = 0; // Glyphs kept by the subset.
+        double kernMs = 0.0;   // Rewriting 'kern' as GPOS, when enabled.
+        size_t kernBytes = 0;  // Size of a 'kern' table replaced by GPOS, or 0.
+        size_t gposBytes = 0;  // Size of the GPOS table that replaced it.
+        double totalMs = 0.0;
+        size_t inputBytes = 0; // Size of the input font.
+        bool cacheHit = false; // The output came from the cache; nothing was parsed or built.
+        WOFF2Builder::BuildStats build; // Transform, compression and output stages.
+    };
+
+    /**
+    * @class FontConverter
+    * @brief Converts TrueType fonts to WOFF2.
+    *
+    * The glyf and loca tables are stored transformed when the glyphs decode cleanly, and
+    * as-is otherwise; hmtx is transformed along with them when that makes it smaller. Every
+    * other table is stored as-is, except 'DSIG', which the transforms would invalidate. A
+    * converter keeps its thread pool between conversions.
+    */
+    class FontConverter {
+    public:
+        /**
+         * @param options Brotli settings.
+         * @param threadCount Threads used to decode glyphs; 0 uses every core.
+         */
+        explicit FontConverter(const WOFF2Builder::CompressionOptions& options = WOFF2Builder::CompressionOptions(),
+            size_t threadCount = 0);
+
+        /**
+         * @brief Converts a TTF file and writes the WOFF2 file.
+         *
+         * Compressed data is streamed into the file as it is produced; a partial file is
+         * removed if the conversion fails.
+         *
+         * @return true if the output was written successfully, false otherwise.
+         */
+        bool convertFile(const std::string& inputPath, const std::string& outputPath);
+
+        /**
+         * @brief Converts a TTF file and writes the WOFF2 file to a sink.
+         * @return true if the output was written successfully, false otherwise.
+         */
+        bool convertFile(const std::string& inputPath, WOFF2Builder::OutputSink& sink);
+
+        /**
+         * @brief Converts a font held in memory.
+         * @param data The TTF bytes; only read during the call.
+         * @param out Receives the WOFF2 file.
+         * @return true if the font was converted successfully, false otherwise.
+         */
+        bool convert(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+        // Converts a font held in memory and writes the WOFF2 file to a sink.
+        bool convert(const uint8_t* data, size_t size, WOFF2Builder::OutputSink& sink);
+
+        /**
+         * @brief Shares a conversion cache, or stops using one if null. Not owned.
+         *
+         * Each input is then keyed by the SHA-256 of its bytes, the compression options and
+         * the converter's output format version, and a cached WOFF2 file is returned without
+         * parsing the font. Misses are converted as usual and stored.
+         */
+        void setCache(ConversionCache* conversionCache) { cache = conversionCache; }
+
+        /**
+         * @brief Keeps only the glyphs needed for a set of codepoints (see FontSubsetter).
+         *
+         * Applies to every following conversion, until clearSubset(). The codepoints are part
+         * of the cache key.
+         */
+        void setSubset(const std::vector<uint32_t>& codepoints);
+
+        // Converts whole fonts again.
+        void clearSubset();
+
+        /**
+         * @brief Replaces 'kern' tables with equivalent, smaller GPOS tables (see compactKerning).
+         *
+         * Fonts that already have GPOS, or whose kerning GPOS cannot express exactly, keep their
+         * 'kern' table. Subsets drop 'kern' anyway. The setting is part of the cache key.
+         */
+        void setKernCompaction(bool enabled) { compactKern = enabled; }
+
+        // Timings and byte counts of the last conversion.
+        const ConversionStats& getStats() const { return stats; }
+
+    private:
+        // Converts the font in `data`, going through the cache if there is one.
+        bool convertBytes(const uint8_t* data, size_t size, WOFF2Builder::OutputSink& sink);
+
+        // Converts the font loaded in `parser`.
+        bool convertLoaded(TTFParser::TTFParser& parser, WOFF2Builder::OutputSink& sink);
+
+        // Converts the subset of the font loaded in `parser`.
+        bool convertSubset(TTFParser::TTFParser& parser, WOFF2Builder::OutputSink& sink);
+
+        // Cache key of a font converted with the current options.
+        std::string cacheKey(const uint8_t* data, size_t size) const;
+
+        WOFF2Builder::WOFF2Builder builder;
+        TTFParser::ThreadPool pool;
+        ConversionCache* cache = nullptr;
+        bool subsetting = false;
+        bool compactKern = false;
+        std::vector<uint32_t> subsetCodepoints; // Sorted, without duplicates.
+        ConversionStats stats;
+    };
+
+} // namespace FontConverter
+
+#endif // FONT_CONVERTER_HPP
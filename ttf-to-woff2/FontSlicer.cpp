@@ -0,0 +1,137 @@
+#include "FontSlicer.hpp"
+#include "OutputSink.hpp"
+#include "Timing.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+namespace FontConverter {
+    using TTFParser::Clock;
+    using TTFParser::elapsedMs;
+
+    namespace {
+        bool isValidSliceName(const std::string& name) {
+            return !name.empty() && std::all_of(name.begin(), name.end(), [](char c) {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '_' || c == '-';
+            });
+        }
+    } // namespace
+
+    bool readSliceSpec(const std::string& path, std::vector<SliceSpec>& slices) {
+        slices.clear();
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "Error: Failed to open slicing spec: " << path << std::endl;
+            return false;
+        }
+
+        std::unordered_set<std::string> names;
+        std::string line;
+        for (size_t lineNumber = 1; std::getline(file, line); ++lineNumber) {
+            line = line.substr(0, line.find('#'));
+            const size_t nameStart = line.find_first_not_of(" \t\r");
+            if (nameStart == std::string::npos) {
+                continue;
+            }
+
+            const size_t nameEnd = std::min(line.find_first_of(" \t\r", nameStart), line.size());
+            SliceSpec slice;
+            slice.name = line.substr(nameStart, nameEnd - nameStart);
+            if (!isValidSliceName(slice.name) || !names.insert(slice.name).second) {
+                std::cerr << "Error: Invalid or duplicate slice name on line " << lineNumber << " of " << path << std::endl;
+                return false;
+            }
+            if (!parseUnicodeRanges(line.substr(nameEnd), slice.codepoints)) {
+                std::cerr << "Error: Invalid codepoints on line " << lineNumber << " of " << path << std::endl;
+                return false;
+            }
+            slices.push_back(std::move(slice));
+        }
+
+        if (slices.empty()) {
+            std::cerr << "Error: No slices in " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    FontSlicer::FontSlicer(const WOFF2Builder::CompressionOptions& options, size_t threadCount)
+        : compression(options), pool(threadCount) {
+    }
+
+    bool FontSlicer::sliceFile(const std::string& inputPath, const std::string& outputStem, const std::vector<SliceSpec>& slices) {
+        const Clock::time_point start = Clock::now();
+        results.assign(slices.size(), SliceResult());
+        inputBytes = 0;
+
+        // Everything the slices share is read here, once
+        TTFParser::TTFParser parser;
+        FontSubsetter subsetter;
+        if (!parser.loadFromFile(inputPath) || !subsetter.load(parser)) {
+            std::cerr << "Error: Failed to load font: " << inputPath << std::endl;
+            return false;
+        }
+        inputBytes = parser.getFontDataSize();
+        if (!subsetter.decodeGlyphs(&pool)) {
+            std::cerr << "Warning: Slices of " << inputPath << " decode their own glyphs." << std::endl;
+        }
+        loadMs = elapsedMs(start);
+
+        for (size_t i = 0; i < slices.size(); ++i) {
+            results[i].outputPath = outputStem + "." + slices[i].name + ".woff2";
+        }
+
+        const uint32_t flavor = parser.getSfntVersion();
+        pool.parallelFor(slices.size(), [&](size_t i) {
+            buildSlice(subsetter, slices[i], flavor, results[i]);
+        });
+
+        return std::all_of(results.begin(), results.end(), [](const SliceResult& result) { return result.succeeded; });
+    }
+
+    void FontSlicer::buildSlice(const FontSubsetter& subsetter, const SliceSpec& slice, uint32_t flavor, SliceResult& result) const {
+        const Clock::time_point start = Clock::now();
+
+        SubsetFont subset;
+        if (!subsetter.subset(slice.codepoints, subset)) {
+            std::cerr << "Error: Failed to subset slice '" << slice.name << "'" << std::endl;
+            return;
+        }
+        result.glyphs = subset.glyphs.size();
+        result.mappedCodepoints = subset.mappedCodepoints;
+        if (subset.mappedCodepoints == 0) {
+            result.succeeded = true; // Nothing of this slice is in the font
+            return;
+        }
+
+        // Slices run concurrently, so each builds with its own builder
+        WOFF2Builder::WOFF2Builder builder(compression);
+        builder.reset(flavor);
+        const int fd = WOFF2Builder::FileDescriptorSink::openFile(result.outputPath.c_str());
+        if (fd < 0) {
+            return;
+        }
+        {
+            WOFF2Builder::FileDescriptorSink sink(fd, true);
+            if (!subset.addTo(builder)) {
+                sink.finish(false);
+            }
+            else {
+                result.succeeded = builder.build(sink);
+            }
+        }
+
+        if (!result.succeeded) {
+            std::remove(result.outputPath.c_str()); // Don't leave a truncated slice behind
+            std::cerr << "Error: Failed to build slice '" << slice.name << "'" << std::endl;
+            return;
+        }
+        result.written = true;
+        result.outputBytes = builder.getStats().woff2Bytes;
+        result.totalMs = elapsedMs(start);
+    }
+
+} // namespace FontConverter
@@ -0,0 +1,95 @@
+#ifndef FONT_SLICER_HPP
+#define FONT_SLICER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FontSubsetter.hpp"
+#include "ThreadPool.hpp"
+#include "WOFF2Builder.hpp"
+
+namespace FontConverter {
+
+    // One slice of a slicing spec: a name for its output file and the codepoints it covers.
+    struct SliceSpec {
+        std::string name;
+        std::vector<uint32_t> codepoints; // Sorted, without duplicates.
+    };
+
+    /**
+     * @brief Reads a slicing spec file.
+     *
+     * Each non-empty line holds a slice name followed by its codepoints in the syntax of
+     * parseUnicodeRanges, e.g. "latin U+0000-00FF, U+0131". Text after '#' is a comment. Names
+     * may use letters, digits, '.', '_' and '-', and must be unique.
+     *
+     * @return false if the file cannot be read or a line is malformed.
+     */
+    bool readSliceSpec(const std::string& path, std::vector<SliceSpec>& slices);
+
+    // Outcome of one slice of a FontSlicer::sliceFile call.
+    struct SliceResult {
+        std::string outputPath;
+        size_t glyphs = 0;           // Glyphs in the slice, .notdef and components included.
+        size_t mappedCodepoints = 0; // Codepoints of the spec the font has glyphs for.
+        uint64_t outputBytes = 0;
+        double totalMs = 0.0;        // Subsetting and building this slice.
+        bool written = false;        // False for slices the font has no glyphs for, and for failures.
+        bool succeeded = false;
+    };
+
+    /**
+    * @class FontSlicer
+    * @brief Splits a font into one WOFF2 file per slice of a spec, for CSS unicode-range delivery.
+    *
+    * The font is read, parsed and its glyphs decoded once; every slice then only reads that
+    * shared state (see FontSubsetter), so the slices are cut and compressed in parallel and
+    * each costs time proportional to its own glyphs. Slices that cover none of the font's
+    * codepoints are skipped.
+    */
+    class FontSlicer {
+    public:
+        /**
+         * @param options Brotli settings.
+         * @param threadCount Threads that build slices; 0 uses every core.
+         */
+        explicit FontSlicer(const WOFF2Builder::CompressionOptions& options = WOFF2Builder::CompressionOptions(),
+            size_t threadCount = 0);
+
+        /**
+         * @brief Writes the slices of a font.
+         *
+         * Slice i goes to `<outputStem>.<name>.woff2`, where outputStem is the output path
+         * without its extension.
+         *
+         * @param inputPath The TTF file.
+         * @param outputStem Path prefix of the outputs.
+         * @param slices The slicing spec.
+         * @return true if the font loaded and every slice it covers was written.
+         */
+        bool sliceFile(const std::string& inputPath, const std::string& outputStem, const std::vector<SliceSpec>& slices);
+
+        // Per-slice outcomes of the last sliceFile call, in spec order.
+        const std::vector<SliceResult>& getResults() const { return results; }
+
+        // Time spent loading, parsing and decoding the font in the last sliceFile call.
+        double getLoadMs() const { return loadMs; }
+
+        // Size of the input of the last sliceFile call.
+        size_t getInputBytes() const { return inputBytes; }
+
+    private:
+        // Cuts, builds and writes one slice.
+        void buildSlice(const FontSubsetter& subsetter, const SliceSpec& slice, uint32_t flavor, SliceResult& result) const;
+
+        WOFF2Builder::CompressionOptions compression;
+        TTFParser::ThreadPool pool;
+        std::vector<SliceResult> results;
+        double loadMs = 0.0;
+        size_t inputBytes = 0;
+    };
+
+} // namespace FontConverter
+
+#endif // FONT_SLICER_HPP
@@ -0,0 +1,625 @@
+#include "FontSubsetter.hpp"
+#include "BigEndian.hpp"
+#include "WOFF2Encoding.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace FontConverter {
+    using TTFParser::readU16;
+    typedef TTFParser::TTFParser Parser;
+
+    namespace {
+        const uint32_t kMaxCodepoint = 0x10FFFF;
+        const size_t kStandardGlyphNames = 258; // Glyph names built into 'post' (the Macintosh set).
+
+        inline size_t padded4(size_t size) {
+            return (size + 3) & ~size_t(3);
+        }
+
+        // Copies a table so it can be patched; empty if it is shorter than `minSize`.
+        std::vector<uint8_t> copyTable(TTFParser::ByteView data, size_t minSize) {
+            if (data.size() < minSize) {
+                return std::vector<uint8_t>();
+            }
+            return std::vector<uint8_t>(data.begin(), data.end());
+        }
+
+        // Parses hex digits, where each '?' stands for 0 in `low` and F in `high`.
+        bool parseHexPattern(const std::string& text, uint32_t& low, uint32_t& high) {
+            if (text.empty() || text.size() > 6) {
+                return false;
+            }
+            low = high = 0;
+            for (char c : text) {
+                const int digit = std::isdigit(static_cast<unsigned char>(c)) ? c - '0' :
+                    (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+                if (c == '?') {
+                    low = low << 4;
+                    high = (high << 4) | 0xF;
+                }
+                else if (digit >= 0) {
+                    low = (low << 4) | uint32_t(digit);
+                    high = (high << 4) | uint32_t(digit);
+                }
+                else {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Parses one item of a unicode-range list: a codepoint, a range or a wildcard pattern.
+        bool parseUnicodeItem(std::string item, uint32_t& first, uint32_t& last) {
+            if (item.size() >= 2 && (item[0] == 'U' || item[0] == 'u') && item[1] == '+') {
+                item.erase(0, 2);
+            }
+
+            const size_t dash = item.find('-');
+            if (dash == std::string::npos) {
+                return parseHexPattern(item, first, last);
+            }
+
+            std::string second = item.substr(dash + 1);
+            if (second.size() >= 2 && (second[0] == 'U' || second[0] == 'u') && second[1] == '+') {
+                second.erase(0, 2);
+            }
+            uint32_t unused;
+            return item.find('?') == std::string::npos && parseHexPattern(item.substr(0, dash), first, unused) &&
+                parseHexPattern(second, unused, last) && unused == last;
+        }
+
+        // Writes a format 4 subtable for the BMP part of `mapping`; false if it would not fit in one.
+        bool writeCmapFormat4(const std::vector<std::pair<uint32_t, uint16_t>>& mapping, std::vector<uint8_t>& out) {
+            struct Segment {
+                uint16_t start, end;
+                uint16_t delta;
+                int32_t arrayStart; // Index into glyphIdArray, or -1 for a delta segment.
+            };
+            std::vector<Segment> segments;
+            std::vector<uint16_t> glyphIdArray;
+
+            size_t i = 0;
+            while (i < mapping.size() && mapping[i].first < 0xFFFF) {
+                // A run of consecutive codepoints...
+                size_t runEnd = i + 1;
+                size_t deltaRuns = 1;
+                while (runEnd < mapping.size() && mapping[runEnd].first < 0xFFFF &&
+                    mapping[runEnd].first == mapping[runEnd - 1].first + 1) {
+                    deltaRuns += mapping[runEnd].second != mapping[runEnd - 1].second + 1;
+                    ++runEnd;
+                }
+
+                // ...becomes one segment per stretch of consecutive glyphs, or a single segment
+                // with its glyphs listed in glyphIdArray when that is smaller
+                const size_t runLength = runEnd - i;
+                if (deltaRuns > 1 && 8 * deltaRuns > 8 + 2 * runLength) {
+                    segments.push_back({ uint16_t(mapping[i].first), uint16_t(mapping[runEnd - 1].first), 0,
+                        int32_t(glyphIdArray.size()) });
+                    for (size_t k = i; k < runEnd; ++k) {
+                        glyphIdArray.push_back(mapping[k].second);
+                    }
+                }
+                else {
+                    for (size_t k = i; k < runEnd;) {
+                        size_t end = k + 1;
+                        while (end < runEnd && mapping[end].second == mapping[end - 1].second + 1) {
+                            ++end;
+                        }
+                        segments.push_back({ uint16_t(mapping[k].first), uint16_t(mapping[end - 1].first),
+                            uint16_t(mapping[k].second - mapping[k].first), -1 });
+                        k = end;
+                    }
+                }
+                i = runEnd;
+            }
+            segments.push_back({ 0xFFFF, 0xFFFF, 1, -1 }); // Required final segment
+
+            const size_t segCount = segments.size();
+            const size_t length = 16 + 8 * segCount + 2 * glyphIdArray.size();
+            if (length > 0xFFFF) {
+                return false;
+            }
+
+            uint16_t entrySelector = 0;
+            while ((size_t(2) << entrySelector) <= segCount) {
+                ++entrySelector;
+            }
+            const uint16_t searchRange = static_cast<uint16_t>(2u << entrySelector);
+
+            out.resize(length);
+            uint8_t* p = out.data();
+            p = WOFF2Builder::writeU16(p, 4);
+            p = WOFF2Builder::writeU16(p, static_cast<uint16_t>(length));
+            p = WOFF2Builder::writeU16(p, 0); // language
+            p = WOFF2Builder::writeU16(p, static_cast<uint16_t>(2 * segCount));
+            p = WOFF2Builder::writeU16(p, searchRange);
+            p = WOFF2Builder::writeU16(p, entrySelector);
+            p = WOFF2Builder::writeU16(p, static_cast<uint16_t>(2 * segCount - searchRange));
+            for (const Segment& segment : segments) {
+                p = WOFF2Builder::writeU16(p, segment.end);
+            }
+            p = WOFF2Builder::writeU16(p, 0); // reservedPad
+            for (const Segment& segment : segments) {
+                p = WOFF2Builder::writeU16(p, segment.start);
+            }
+            for (const Segment& segment : segments) {
+                p = WOFF2Builder::writeU16(p, segment.delta);
+            }
+            for (size_t s = 0; s < segCount; ++s) {
+                // idRangeOffset counts bytes from its own position to the segment's first glyph ID
+                const int32_t arrayStart = segments[s].arrayStart;
+                p = WOFF2Builder::writeU16(p, arrayStart < 0 ? 0 : static_cast<uint16_t>(2 * (segCount - s + arrayStart)));
+            }
+            for (uint16_t glyph : glyphIdArray) {
+                p = WOFF2Builder::writeU16(p, glyph);
+            }
+            return true;
+        }
+
+        // Writes a format 12 subtable covering all of `mapping`.
+        void writeCmapFormat12(const std::vector<std::pair<uint32_t, uint16_t>>& mapping, std::vector<uint8_t>& out) {
+            std::vector<size_t> groupStarts;
+            for (size_t i = 0; i < mapping.size(); ++i) {
+                if (i == 0 || mapping[i].first != mapping[i - 1].first + 1 || mapping[i].second != mapping[i - 1].second + 1) {
+                    groupStarts.push_back(i);
+                }
+            }
+
+            const size_t length = 16 + 12 * groupStarts.size();
+            out.resize(length);
+            uint8_t* p = out.data();
+            p = WOFF2Builder::writeU16(p, 12);
+            p = WOFF2Builder::writeU16(p, 0); // reserved
+            p = WOFF2Builder::writeU32(p, static_cast<uint32_t>(length));
+            p = WOFF2Builder::writeU32(p, 0); // language
+            p = WOFF2Builder::writeU32(p, static_cast<uint32_t>(groupStarts.size()));
+            for (size_t g = 0; g < groupStarts.size(); ++g) {
+                const size_t first = groupStarts[g];
+                const size_t last = (g + 1 < groupStarts.size() ? groupStarts[g + 1] : mapping.size()) - 1;
+                p = WOFF2Builder::writeU32(p, mapping[first].first);
+                p = WOFF2Builder::writeU32(p, mapping[last].first);
+                p = WOFF2Builder::writeU32(p, mapping[first].second);
+            }
+        }
+    } // namespace
+
+    bool parseUnicodeRanges(const std::string& text, std::vector<uint32_t>& codepoints) {
+        codepoints.clear();
+
+        size_t position = 0;
+        while (position < text.size()) {
+            const size_t end = text.find_first_of(", \t\r\n", position);
+            const std::string item = text.substr(position, end == std::string::npos ? std::string::npos : end - position);
+            position = (end == std::string::npos) ? text.size() : end + 1;
+            if (item.empty()) {
+                continue;
+            }
+
+            uint32_t first = 0, last = 0;
+            if (!parseUnicodeItem(item, first, last) || first > last || last > kMaxCodepoint) {
+                std::cerr << "Error: Invalid unicode range: " << item << std::endl;
+                return false;
+            }
+            for (uint32_t codepoint = first; codepoint <= last; ++codepoint) {
+                codepoints.push_back(codepoint);
+            }
+        }
+
+        std::sort(codepoints.begin(), codepoints.end());
+        codepoints.erase(std::unique(codepoints.begin(), codepoints.end()), codepoints.end());
+        return true;
+    }
+
+    bool SubsetFont::addTo(WOFF2Builder::WOFF2Builder& builder) const {
+        for (const std::pair<TTFParser::Tag, TTFParser::ByteView>& table : tables) {
+            if (!builder.addTable(table.first, table.second)) {
+                return false;
+            }
+        }
+        builder.setGlyfTable(glyf, indexToLocFormat);
+        builder.setHmtxMetrics(metrics, numberOfHMetrics);
+        return true;
+    }
+
+    bool FontSubsetter::load(TTFParser::TTFParser& font) {
+        parser = &font;
+        hasGlyphNames = false;
+        decodedGlyf = TTFParser::GlyfTable();
+        glyphsDecoded = false;
+
+        glyfData = font.getTableData("glyf");
+        const TTFParser::ByteView locaData = font.getTableData("loca");
+        if (glyfData.empty() || locaData.empty()) {
+            std::cerr << "Error: Only fonts with TrueType outlines can be subset." << std::endl;
+            return false;
+        }
+
+        TTFParser::HheaTable hhea{};
+        TTFParser::CmapTable cmap;
+        if (!font.parseHeadTable(font.getTableData("head")) || !font.parseMaxpTable(font.getTableData("maxp")) ||
+            !font.parseLocaTable(locaData, loca) || !font.parseHheaTable(font.getTableData("hhea"), hhea) ||
+            !font.parseHmtxTable(font.getTableData("hmtx"), hhea.numOfLongHorMetrics, metrics) ||
+            !font.parseCmapTable(font.getTableData("cmap"), cmap)) {
+            return false;
+        }
+        numGlyphs = font.getNumGlyphs();
+        if (numGlyphs == 0 || loca.offsets.back() > glyfData.size()) {
+            std::cerr << "Error: 'loca' offsets do not fit the 'glyf' table." << std::endl;
+            return false;
+        }
+
+        cmapIndex.build(cmap, numGlyphs);
+
+        // Glyph names survive as a format 2 table; without them the subset gets a format 3 'post'
+        post = TTFParser::PostTable();
+        const TTFParser::ByteView postData = font.getTableData("post");
+        if (!postData.empty() && font.parsePostTable(postData, post)) {
+            hasGlyphNames = post.format == 1.0f || (post.format == 2.0f && post.glyphNameIndex.size() == numGlyphs);
+        }
+        return true;
+    }
+
+    bool FontSubsetter::decodeGlyphs(TTFParser::ThreadPool* pool) {
+        glyphsDecoded = parser && parser->parseGlyfTable(glyfData, loca, decodedGlyf, pool);
+        if (!glyphsDecoded) {
+            decodedGlyf = TTFParser::GlyfTable();
+        }
+        return glyphsDecoded;
+    }
+
+
+    bool FontSubsetter::closeOverComponents(std::vector<uint16_t>& glyphs) const {
+        TTFParser::CompoundGlyph compound;
+        std::vector<uint16_t> pending = glyphs;
+        std::vector<uint16_t> found;
+
+        // Each round parses the glyphs added by the previous one, so every glyph is read once
+        while (!pending.empty()) {
+            found.clear();
+            for (uint16_t glyph : pending) {
+                const uint32_t start = loca.offsets[glyph];
+                const TTFParser::ByteView data = glyfData.subview(start, loca.offsets[glyph + 1] - start);
+                if (data.size() < 10 || static_cast<int16_t>(readU16(data.data())) >= 0) {
+                    continue;
+                }
+
+                compound.components.clear();
+                compound.instructions.clear();
+                uint32_t offset = 10; // Past numberOfContours and the bounding box
+                if (!parser->parseCompoundGlyph(data, offset, compound)) {
+                    std::cerr << "Error: Failed to parse compound glyph " << glyph << std::endl;
+                    return false;
+                }
+                for (const TTFParser::CompoundComponent& component : compound.components) {
+                    if (component.glyphIndex >= numGlyphs) {
+                        std::cerr << "Error: Compound glyph " << glyph << " refers to a missing glyph." << std::endl;
+                        return false;
+                    }
+                    if (!std::binary_search(glyphs.begin(), glyphs.end(), component.glyphIndex)) {
+                        found.push_back(component.glyphIndex);
+                    }
+                }
+            }
+
+            std::sort(found.begin(), found.end());
+            found.erase(std::unique(found.begin(), found.end()), found.end());
+            const size_t middle = glyphs.size();
+            glyphs.insert(glyphs.end(), found.begin(), found.end());
+            std::inplace_merge(glyphs.begin(), glyphs.begin() + middle, glyphs.end());
+            pending.swap(found);
+        }
+        return true;
+    }
+
+    bool FontSubsetter::subset(const std::vector<uint32_t>& codepoints, SubsetFont& out) const {
+        out = SubsetFont();
+        if (!parser) {
+            return false;
+        }
+
+        // Requested codepoints the font maps, with their original glyphs
+        std::vector<uint16_t> found(codepoints.size());
+        cmapIndex.codepointsToGlyphs(codepoints.data(), found.data(), codepoints.size());
+        std::vector<std::pair<uint32_t, uint16_t>> mapping;
+        out.glyphs.push_back(0); // .notdef
+        for (size_t i = 0; i < codepoints.size(); ++i) {
+            if (found[i] != 0) {
+                mapping.emplace_back(codepoints[i], found[i]);
+                out.glyphs.push_back(found[i]);
+            }
+        }
+        std::sort(mapping.begin(), mapping.end());
+        mapping.erase(std::unique(mapping.begin(), mapping.end()), mapping.end());
+        out.mappedCodepoints = mapping.size();
+
+        std::sort(out.glyphs.begin(), out.glyphs.end());
+        out.glyphs.erase(std::unique(out.glyphs.begin(), out.glyphs.end()), out.glyphs.end());
+        if (!closeOverComponents(out.glyphs)) {
+            return false;
+        }
+
+        // Glyphs keep their relative order, so a glyph's new ID is its position in the sorted set
+        for (std::pair<uint32_t, uint16_t>& entry : mapping) {
+            entry.second = static_cast<uint16_t>(std::lower_bound(out.glyphs.begin(), out.glyphs.end(), entry.second) - out.glyphs.begin());
+        }
+
+        if (!writeGlyf(out)) {
+            return false;
+        }
+        writeHmtx(out);
+        writeCmap(mapping, out);
+        writePost(out);
+
+        // Tables whose counts and ranges depend on the glyph set
+        out.headData = copyTable(parser->getTableData("head"), 54);
+        out.hheaData = copyTable(parser->getTableData("hhea"), 36);
+        out.maxpData = copyTable(parser->getTableData("maxp"), 6);
+        out.os2Data = copyTable(parser->getTableData("OS/2"), 68);
+        if (out.headData.empty() || out.hheaData.empty() || out.maxpData.empty()) {
+            std::cerr << "Error: 'head', 'hhea' or 'maxp' table is too short." << std::endl;
+            return false;
+        }
+
+        uint16_t advanceWidthMax = 0;
+        for (const TTFParser::GlyphMetrics& metric : out.metrics) {
+            advanceWidthMax = std::max(advanceWidthMax, metric.advanceWidth);
+        }
+        WOFF2Builder::writeU16(&out.headData[50], static_cast<uint16_t>(out.indexToLocFormat));
+        WOFF2Builder::writeU16(&out.hheaData[10], advanceWidthMax);
+        WOFF2Builder::writeU16(&out.hheaData[34], out.numberOfHMetrics);
+        WOFF2Builder::writeU16(&out.maxpData[4], static_cast<uint16_t>(out.glyphs.size()));
+        if (!out.os2Data.empty() && !mapping.empty()) {
+            // usFirstCharIndex and usLastCharIndex, clamped to the BMP
+            WOFF2Builder::writeU16(&out.os2Data[64], static_cast<uint16_t>(std::min<uint32_t>(mapping.front().first, 0xFFFF)));
+            WOFF2Builder::writeU16(&out.os2Data[66], static_cast<uint16_t>(std::min<uint32_t>(mapping.back().first, 0xFFFF)));
+        }
+
+        // Keep the source font's table order; tables that refer to glyph IDs are left out
+        for (const TTFParser::TableRecord& record : parser->getTableDirectory()) {
+            const TTFParser::Tag tag(record.tag);
+            const std::vector<uint8_t>* rewritten =
+                tag == TTFParser::Tag("glyf") ? &out.glyfData : tag == TTFParser::Tag("loca") ? &out.locaData :
+                tag == TTFParser::Tag("hmtx") ? &out.hmtxData : tag == TTFParser::Tag("cmap") ? &out.cmapData :
+                tag == TTFParser::Tag("post") ? &out.postData : tag == TTFParser::Tag("head") ? &out.headData :
+                tag == TTFParser::Tag("hhea") ? &out.hheaData : tag == TTFParser::Tag("maxp") ? &out.maxpData :
+                tag == TTFParser::Tag("OS/2") ? &out.os2Data : nullptr;
+
+            if (rewritten) {
+                if (!rewritten->empty()) {
+                    out.tables.emplace_back(tag, TTFParser::ByteView(rewritten->data(), rewritten->size()));
+                }
+            }
+            else if (tag == TTFParser::Tag("name") || tag == TTFParser::Tag("cvt ") || tag == TTFParser::Tag("fpgm") ||
+                tag == TTFParser::Tag("prep") || tag == TTFParser::Tag("gasp")) {
+                out.tables.emplace_back(tag, record.data);
+            }
+        }
+        return true;
+    }
+
+    bool FontSubsetter::writeGlyf(SubsetFont& out) const {
+        const size_t count = out.glyphs.size();
+        TTFParser::LocaTable subsetLoca;
+        subsetLoca.offsets.resize(count + 1);
+
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const uint16_t glyph = out.glyphs[i];
+            subsetLoca.offsets[i] = static_cast<uint32_t>(total);
+            total += padded4(loca.offsets[glyph + 1] - loca.offsets[glyph]);
+        }
+        subsetLoca.offsets[count] = static_cast<uint32_t>(total);
+        out.glyfData.assign(total, 0);
+
+        for (size_t i = 0; i < count; ++i) {
+            const uint16_t glyph = out.glyphs[i];
+            const uint32_t size = loca.offsets[glyph + 1] - loca.offsets[glyph];
+            uint8_t* data = out.glyfData.data() + subsetLoca.offsets[i];
+            if (size == 0) {
+                continue;
+            }
+            std::memcpy(data, glyfData.data() + loca.offsets[glyph], size);
+            if (size < 10 || static_cast<int16_t>(readU16(data)) >= 0) {
+                continue;
+            }
+
+            // Renumber the components; closeOverComponents already parsed this glyph
+            uint32_t offset = 10;
+            uint16_t flags = Parser::MORE_COMPONENTS;
+            while ((flags & Parser::MORE_COMPONENTS) && offset + 4 <= size) {
+                flags = readU16(data + offset);
+                const uint16_t component = readU16(data + offset + 2);
+                const auto it = std::lower_bound(out.glyphs.begin(), out.glyphs.end(), component);
+                WOFF2Builder::writeU16(data + offset + 2, static_cast<uint16_t>(it - out.glyphs.begin()));
+
+                offset += (flags & Parser::ARG_1_AND_2_ARE_WORDS) ? 8 : 6;
+                offset += (flags & Parser::WE_HAVE_A_SCALE) ? 2 : (flags & Parser::WE_HAVE_AN_X_AND_Y_SCALE) ? 4 :
+                    (flags & Parser::WE_HAVE_A_TWO_BY_TWO) ? 8 : 0;
+            }
+        }
+
+        // Glyphs are 4-byte aligned, so short offsets work whenever the table is small enough
+        out.indexToLocFormat = total <= 0x1FFFE ? 0 : 1;
+        const size_t entrySize = out.indexToLocFormat == 0 ? 2 : 4;
+        out.locaData.resize((count + 1) * entrySize);
+        uint8_t* p = out.locaData.data();
+        for (uint32_t offset : subsetLoca.offsets) {
+            p = out.indexToLocFormat == 0 ? WOFF2Builder::writeU16(p, static_cast<uint16_t>(offset / 2)) : WOFF2Builder::writeU32(p, offset);
+        }
+
+        if (glyphsDecoded) {
+            copyDecodedGlyphs(out);
+            return true;
+        }
+        return parser->parseGlyfTable(TTFParser::ByteView(out.glyfData.data(), out.glyfData.size()), subsetLoca, out.glyf);
+    }
+
+    void FontSubsetter::copyDecodedGlyphs(SubsetFont& out) const {
+        TTFParser::GlyfTable& glyf = out.glyf;
+        glyf = TTFParser::GlyfTable();
+
+        // Size the arrays first so each one is allocated once
+        size_t contours = 0, points = 0, instructions = 0, components = 0;
+        for (uint16_t glyph : out.glyphs) {
+            const TTFParser::GlyphRecord& record = decodedGlyf.glyphs[glyph];
+            contours += record.numberOfContours > 0 ? record.numberOfContours : 0;
+            points += record.numPoints;
+            instructions += record.instructionLength;
+            components += record.numComponents;
+        }
+        glyf.glyphs.reserve(out.glyphs.size());
+        glyf.endPointOfContours.reserve(contours);
+        glyf.xCoordinates.reserve(points);
+        glyf.yCoordinates.reserve(points);
+        glyf.onCurve.assign((points + 63) / 64, 0);
+        glyf.instructions.reserve(instructions);
+        glyf.components.reserve(components);
+
+        for (uint16_t glyph : out.glyphs) {
+            const TTFParser::GlyphRecord& source = decodedGlyf.glyphs[glyph];
+            TTFParser::GlyphRecord record = source;
+            record.firstContour = static_cast<uint32_t>(glyf.endPointOfContours.size());
+            record.firstPoint = static_cast<uint32_t>(glyf.xCoordinates.size());
+            record.firstInstruction = static_cast<uint32_t>(glyf.instructions.size());
+            record.firstComponent = static_cast<uint32_t>(glyf.components.size());
+
+            if (source.numberOfContours > 0) {
+                const auto contourStart = decodedGlyf.endPointOfContours.begin() + source.firstContour;
+                glyf.endPointOfContours.insert(glyf.endPointOfContours.end(), contourStart, contourStart + source.numberOfContours);
+            }
+            const auto xStart = decodedGlyf.xCoordinates.begin() + source.firstPoint;
+            const auto yStart = decodedGlyf.yCoordinates.begin() + source.firstPoint;
+            glyf.xCoordinates.insert(glyf.xCoordinates.end(), xStart, xStart + source.numPoints);
+            glyf.yCoordinates.insert(glyf.yCoordinates.end(), yStart, yStart + source.numPoints);
+            for (uint32_t point = 0; point < source.numPoints; ++point) {
+                const size_t target = record.firstPoint + point;
+                glyf.onCurve[target >> 6] |= uint64_t(decodedGlyf.isOnCurve(source.firstPoint + point)) << (target & 63);
+            }
+
+            const auto instructionStart = decodedGlyf.instructions.begin() + source.firstInstruction;
+            glyf.instructions.insert(glyf.instructions.end(), instructionStart, instructionStart + source.instructionLength);
+            for (uint32_t i = 0; i < source.numComponents; ++i) {
+                TTFParser::CompoundComponent component = decodedGlyf.components[source.firstComponent + i];
+                component.glyphIndex = static_cast<uint16_t>(
+                    std::lower_bound(out.glyphs.begin(), out.glyphs.end(), component.glyphIndex) - out.glyphs.begin());
+                glyf.components.push_back(component);
+            }
+            glyf.glyphs.push_back(record);
+        }
+    }
+
+    void FontSubsetter::writeHmtx(SubsetFont& out) const {
+        out.metrics.resize(out.glyphs.size());
+        for (size_t i = 0; i < out.glyphs.size(); ++i) {
+            out.metrics[i] = metrics[out.glyphs[i]];
+        }
+
+        // Glyphs at the end sharing the last advance width only store their left side bearing
+        size_t numberOfHMetrics = out.metrics.size();
+        while (numberOfHMetrics > 1 && out.metrics[numberOfHMetrics - 2].advanceWidth == out.metrics[numberOfHMetrics - 1].advanceWidth) {
+            --numberOfHMetrics;
+        }
+        out.numberOfHMetrics = static_cast<uint16_t>(numberOfHMetrics);
+
+        out.hmtxData.resize(4 * numberOfHMetrics + 2 * (out.metrics.size() - numberOfHMetrics));
+        uint8_t* p = out.hmtxData.data();
+        for (size_t i = 0; i < out.metrics.size(); ++i) {
+            if (i < numberOfHMetrics) {
+                p = WOFF2Builder::writeU16(p, out.metrics[i].advanceWidth);
+            }
+            p = WOFF2Builder::writeU16(p, static_cast<uint16_t>(out.metrics[i].lsb));
+        }
+    }
+
+    void FontSubsetter::writeCmap(const std::vector<std::pair<uint32_t, uint16_t>>& mapping, SubsetFont& out) const {
+        // A BMP subtable for (0, 3) and (3, 1), plus a full-range one for (0, 4) and (3, 10) when
+        // codepoints beyond the BMP are kept or the BMP subtable would be too large
+        std::vector<uint8_t> format4, format12;
+        const bool hasFormat4 = writeCmapFormat4(mapping, format4);
+        if (!hasFormat4 || (!mapping.empty() && mapping.back().first > 0xFFFF)) {
+            writeCmapFormat12(mapping, format12);
+        }
+
+        struct Record {
+            uint16_t platformID, encodingID;
+            const std::vector<uint8_t>* subtable;
+        };
+        std::vector<Record> records;
+        if (hasFormat4) {
+            records.push_back({ 0, 3, &format4 });
+        }
+        if (!format12.empty()) {
+            records.push_back({ 0, 4, &format12 });
+        }
+        if (hasFormat4) {
+            records.push_back({ 3, 1, &format4 });
+        }
+        if (!format12.empty()) {
+            records.push_back({ 3, 10, &format12 });
+        }
+
+        const size_t headerSize = 4 + 8 * records.size();
+        const uint32_t format4Offset = static_cast<uint32_t>(headerSize);
+        const uint32_t format12Offset = static_cast<uint32_t>(headerSize + format4.size());
+        out.cmapData.resize(headerSize + format4.size() + format12.size());
+        uint8_t* p = out.cmapData.data();
+        p = WOFF2Builder::writeU16(p, 0); // version
+        p = WOFF2Builder::writeU16(p, static_cast<uint16_t>(records.size()));
+        for (const Record& record : records) {
+            p = WOFF2Builder::writeU16(p, record.platformID);
+            p = WOFF2Builder::writeU16(p, record.encodingID);
+            p = WOFF2Builder::writeU32(p, record.subtable == &format4 ? format4Offset : format12Offset);
+        }
+        std::copy(format4.begin(), format4.end(), p);
+        std::copy(format12.begin(), format12.end(), p + format4.size());
+    }
+
+    void FontSubsetter::writePost(SubsetFont& out) const {
+        const TTFParser::ByteView source = parser->getTableData("post");
+        if (source.size() < 32) {
+            return; // No 'post' table to rewrite
+        }
+
+        out.postData.assign(source.data(), source.data() + 32);
+        if (!hasGlyphNames) {
+            WOFF2Builder::writeU32(out.postData.data(), 0x00030000);
+            return;
+        }
+
+        // Format 2: standard names keep their index, custom names are renumbered in order of use
+        WOFF2Builder::writeU32(out.postData.data(), 0x00020000);
+        const size_t count = out.glyphs.size();
+        out.postData.resize(34 + 2 * count);
+        uint8_t* p = WOFF2Builder::writeU16(&out.postData[32], static_cast<uint16_t>(count));
+
+        std::unordered_map<uint16_t, uint16_t> customNames; // Old name index -> new name index.
+        std::vector<uint16_t> usedNames;
+        for (uint16_t glyph : out.glyphs) {
+            // Format 1 names glyphs 0-257 with the standard names, in order
+            uint16_t nameIndex = post.format == 1.0f ? (glyph < kStandardGlyphNames ? glyph : 0) : post.glyphNameIndex[glyph];
+            if (nameIndex >= kStandardGlyphNames) {
+                if (nameIndex - kStandardGlyphNames >= post.names.size()) {
+                    nameIndex = 0; // Missing name; fall back to .notdef
+                }
+                else {
+                    const auto inserted = customNames.emplace(nameIndex, static_cast<uint16_t>(kStandardGlyphNames + usedNames.size()));
+                    if (inserted.second) {
+                        usedNames.push_back(nameIndex);
+                    }
+                    nameIndex = inserted.first->second;
+                }
+            }
+            p = WOFF2Builder::writeU16(p, nameIndex);
+        }
+
+        for (uint16_t nameIndex : usedNames) {
+            const std::string& name = post.names[nameIndex - kStandardGlyphNames];
+            out.postData.push_back(static_cast<uint8_t>(name.size()));
+            out.postData.insert(out.postData.end(), name.begin(), name.end());
+        }
+    }
+
+} // namespace FontConverter
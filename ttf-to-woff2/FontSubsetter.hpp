@@ -0,0 +1,125 @@
+#ifndef FONT_SUBSETTER_HPP
+#define FONT_SUBSETTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "CmapIndex.hpp"
+#include "ThreadPool.hpp"
+#include "TTFParser.hpp"
+#include "WOFF2Builder.hpp"
+
+namespace FontConverter {
+
+    /**
+     * @brief Parses a list of codepoints and ranges such as "U+0000-00FF, U+20AC, 41-5A".
+     *
+     * Items are separated by commas or whitespace; each is a hex codepoint, optionally prefixed
+     * with "U+", or a range of two of them joined by '-'. "U+4??" style wildcards stand for
+     * every digit.
+     *
+     * @param text The list.
+     * @param codepoints Receives the codepoints, sorted and without duplicates.
+     * @return false if an item is malformed or beyond U+10FFFF.
+     */
+    bool parseUnicodeRanges(const std::string& text, std::vector<uint32_t>& codepoints);
+
+    // One subset of a font, as produced by FontSubsetter::subset.
+    struct SubsetFont {
+        std::vector<uint16_t> glyphs;     // Original glyph ID of each new glyph ID; .notdef stays first.
+        size_t mappedCodepoints = 0;      // Requested codepoints the font has a glyph for.
+        TTFParser::GlyfTable glyf;        // The subset glyphs, decoded for the glyf transform.
+        int16_t indexToLocFormat = 0;
+        std::vector<TTFParser::GlyphMetrics> metrics; // Horizontal metrics of the subset glyphs.
+        uint16_t numberOfHMetrics = 0;
+
+        // Tables in font order. Rewritten tables point into the buffers below, the others into
+        // the source font, so the subsetter's font must outlive them.
+        std::vector<std::pair<TTFParser::Tag, TTFParser::ByteView>> tables;
+        std::vector<uint8_t> glyfData, locaData, hmtxData, cmapData, postData;
+        std::vector<uint8_t> headData, hheaData, maxpData, os2Data;
+
+        /**
+         * @brief Registers the tables, glyphs and metrics with a builder (after its reset()).
+         * The builder keeps views of this subset, so it must stay alive until build() returns.
+         * @return false if the builder rejected a table.
+         */
+        bool addTo(WOFF2Builder::WOFF2Builder& builder) const;
+    };
+
+    /**
+    * @class FontSubsetter
+    * @brief Cuts TrueType fonts down to the glyphs needed for a set of codepoints.
+    *
+    * The codepoints are mapped through the font's Unicode cmap subtables (see CmapIndex) and
+    * the glyph set is closed over compound glyph components. The kept glyphs are renumbered in their original
+    * order, so .notdef stays glyph 0, and glyf, loca, hmtx, cmap and post are rewritten for the
+    * new numbering; head, hhea, maxp and OS/2 are patched to match. The hinting tables
+    * (cvt, fpgm, prep, gasp) and name are kept as-is. Every other table refers to glyph IDs
+    * (layout, kerning, device metrics, variations) and is dropped.
+    *
+    * load() reads the font-wide state once: the codepoint index, loca, metrics and glyph names.
+    * After that subset() only reads it, so any number of subsets may be cut concurrently,
+    * each costing time proportional to its own glyphs. Each subset decodes its own glyphs
+    * unless decodeGlyphs() decoded the whole font up front, which pays off when many subsets
+    * share one font.
+    */
+    class FontSubsetter {
+    public:
+        /**
+         * @brief Reads what subsetting needs from a loaded font.
+         * @param parser The font; must stay loaded, unchanged, for as long as the subsetter is used.
+         * @return false if the font has no TrueType outlines or a required table is malformed.
+         */
+        bool load(TTFParser::TTFParser& parser);
+
+        /**
+         * @brief Decodes every glyph once, so subsets copy decoded glyphs instead of decoding their own.
+         * @param pool Pool to decode on, or nullptr to decode on the calling thread.
+         * @return false if a glyph is malformed; subsets then decode their own glyphs.
+         */
+        bool decodeGlyphs(TTFParser::ThreadPool* pool = nullptr);
+
+        /**
+         * @brief Cuts the subset for a set of codepoints. Thread-safe once load() succeeded.
+         * @param codepoints The codepoints to keep; ones the font does not map are ignored.
+         * @param out Receives the subset font.
+         * @return false if a kept glyph is malformed.
+         */
+        bool subset(const std::vector<uint32_t>& codepoints, SubsetFont& out) const;
+
+        // Glyph mapped to a codepoint, or 0 if the font has none.
+        uint16_t lookupGlyph(uint32_t codepoint) const { return cmapIndex.codepointToGlyph(codepoint); }
+
+        uint16_t getGlyphCount() const { return numGlyphs; }
+
+    private:
+        // Adds the components of every compound glyph in `glyphs` (sorted), recursively.
+        bool closeOverComponents(std::vector<uint16_t>& glyphs) const;
+
+        // Copies the kept glyphs with their component glyph IDs renumbered, and builds loca.
+        bool writeGlyf(SubsetFont& out) const;
+
+        // Fills out.glyf from the glyphs decoded by decodeGlyphs, renumbering components.
+        void copyDecodedGlyphs(SubsetFont& out) const;
+        void writeHmtx(SubsetFont& out) const;
+        void writeCmap(const std::vector<std::pair<uint32_t, uint16_t>>& mapping, SubsetFont& out) const;
+        void writePost(SubsetFont& out) const;
+
+        const TTFParser::TTFParser* parser = nullptr;
+        uint16_t numGlyphs = 0;
+        TTFParser::ByteView glyfData;
+        TTFParser::LocaTable loca;
+        TTFParser::GlyfTable decodedGlyf; // Every glyph, once decodeGlyphs succeeded.
+        bool glyphsDecoded = false;
+        std::vector<TTFParser::GlyphMetrics> metrics;
+        TTFParser::CmapIndex cmapIndex;
+        TTFParser::PostTable post;
+        bool hasGlyphNames = false; // post is format 1 or 2, so names are carried over.
+    };
+
+} // namespace FontConverter
+
+#endif // FONT_SUBSETTER_HPP
@@ -0,0 +1,990 @@
+#include "GposTable.hpp"
+#include "BigEndian.hpp"
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+namespace TTFParser {
+    namespace {
+        const uint16_t kExtensionLookup = 9;
+        const uint16_t kUseMarkFilteringSet = 0x0010;
+
+        // Bytes of a ValueRecord: one 16-bit field per bit of the value format.
+        inline uint32_t valueRecordSize(uint16_t valueFormat) {
+            uint32_t size = 0;
+            for (uint16_t bits = valueFormat & 0x00FF; bits != 0; bits &= bits - 1) {
+                size += 2;
+            }
+            return size;
+        }
+    } // namespace
+
+    // Walks the table once, appending to the arrays of a GposTable.
+    class GposTable::Decoder {
+    public:
+        Decoder(GposTable& out, ByteView table) : out(out), table(table) {}
+
+        bool decode() {
+            uint16_t majorVersion = 0, minorVersion = 0, scriptList = 0, featureList = 0, lookupList = 0;
+            if (!u16(0, majorVersion) || !u16(2, minorVersion) || !u16(4, scriptList) || !u16(6, featureList) || !u16(8, lookupList)) {
+                return fail("header");
+            }
+            if (majorVersion != 1 || minorVersion > 1) {
+                std::cerr << "Error: Unsupported GPOS version " << majorVersion << "." << minorVersion << std::endl;
+                return false;
+            }
+            return (scriptList == 0 || decodeScriptList(scriptList)) &&
+                (featureList == 0 || decodeFeatureList(featureList)) &&
+                (lookupList == 0 || decodeLookupList(lookupList));
+        }
+
+    private:
+        bool fail(const char* what) {
+            std::cerr << "Error: Malformed GPOS " << what << "." << std::endl;
+            return false;
+        }
+
+        bool u16(size_t offset, uint16_t& value) const {
+            if (!table.contains(offset, 2)) {
+                return false;
+            }
+            value = readU16(table.data() + offset);
+            return true;
+        }
+
+        bool u32(size_t offset, uint32_t& value) const {
+            if (!table.contains(offset, 4)) {
+                return false;
+            }
+            value = readU32(table.data() + offset);
+            return true;
+        }
+
+        // Reads a 16-bit offset at `at`, relative to `base`; null offsets stay 0.
+        bool offset16(size_t at, uint32_t base, uint32_t& offset) const {
+            uint16_t relative = 0;
+            if (!u16(at, relative)) {
+                return false;
+            }
+            offset = relative != 0 ? base + relative : 0;
+            return true;
+        }
+
+        bool decodeScriptList(uint32_t listOffset) {
+            uint16_t scriptCount = 0;
+            if (!u16(listOffset, scriptCount) || !table.contains(listOffset + 2, 6 * size_t(scriptCount))) {
+                return fail("ScriptList");
+            }
+            out.scripts.reserve(scriptCount);
+            for (uint16_t i = 0; i < scriptCount; ++i) {
+                const size_t record = listOffset + 2 + 6 * size_t(i);
+                GposScript script;
+                uint32_t scriptOffset = 0, defaultLangSys = 0;
+                uint16_t langSysCount = 0;
+                script.tag = readU32(table.data() + record);
+                if (!offset16(record + 4, listOffset, scriptOffset) || scriptOffset == 0 ||
+                    !offset16(scriptOffset, scriptOffset, defaultLangSys) || !u16(scriptOffset + 2, langSysCount) ||
+                    !table.contains(scriptOffset + 4, 6 * size_t(langSysCount))) {
+                    return fail("Script table");
+                }
+                script.hasDefaultLangSys = defaultLangSys != 0;
+                script.langSysStart = static_cast<uint32_t>(out.langSystems.size());
+                if (script.hasDefaultLangSys && !decodeLangSys(0, defaultLangSys)) {
+                    return false;
+                }
+                for (uint16_t j = 0; j < langSysCount; ++j) {
+                    const size_t langSysRecord = scriptOffset + 4 + 6 * size_t(j);
+                    uint32_t langSysOffset = 0;
+                    if (!offset16(langSysRecord + 4, scriptOffset, langSysOffset) || langSysOffset == 0 ||
+                        !decodeLangSys(readU32(table.data() + langSysRecord), langSysOffset)) {
+                        return fail("LangSys table");
+                    }
+                }
+                script.langSysCount = static_cast<uint32_t>(out.langSystems.size()) - script.langSysStart;
+                out.scripts.push_back(script);
+            }
+            return true;
+        }
+
+        bool decodeLangSys(uint32_t tag, uint32_t offset) {
+            GposLangSys langSys;
+            uint16_t featureCount = 0;
+            langSys.tag = tag;
+            langSys.featureStart = static_cast<uint32_t>(out.langSysFeatures.size());
+            if (!u16(offset + 2, langSys.requiredFeature) || !u16(offset + 4, featureCount) ||
+                !table.contains(offset + 6, 2 * size_t(featureCount))) {
+                return fail("LangSys table");
+            }
+            for (uint16_t i = 0; i < featureCount; ++i) {
+                out.langSysFeatures.push_back(readU16(table.data() + offset + 6 + 2 * size_t(i)));
+            }
+            langSys.featureCount = featureCount;
+            out.langSystems.push_back(langSys);
+            return true;
+        }
+
+        bool decodeFeatureList(uint32_t listOffset) {
+            uint16_t featureCount = 0;
+            if (!u16(listOffset, featureCount) || !table.contains(listOffset + 2, 6 * size_t(featureCount))) {
+                return fail("FeatureList");
+            }
+            out.features.reserve(featureCount);
+            for (uint16_t i = 0; i < featureCount; ++i) {
+                const size_t record = listOffset + 2 + 6 * size_t(i);
+                GposFeature feature;
+                uint32_t featureOffset = 0;
+                uint16_t lookupCount = 0;
+                feature.tag = readU32(table.data() + record);
+                if (!offset16(record + 4, listOffset, featureOffset) || featureOffset == 0 ||
+                    !u16(featureOffset + 2, lookupCount) || !table.contains(featureOffset + 4, 2 * size_t(lookupCount))) {
+                    return fail("Feature table");
+                }
+                feature.lookupStart = static_cast<uint32_t>(out.featureLookups.size());
+                feature.lookupCount = lookupCount;
+                for (uint16_t j = 0; j < lookupCount; ++j) {
+                    out.featureLookups.push_back(readU16(table.data() + featureOffset + 4 + 2 * size_t(j)));
+                }
+                out.features.push_back(feature);
+            }
+            return true;
+        }
+
+        bool decodeLookupList(uint32_t listOffset) {
+            uint16_t lookupCount = 0;
+            if (!u16(listOffset, lookupCount) || !table.contains(listOffset + 2, 2 * size_t(lookupCount))) {
+                return fail("LookupList");
+            }
+            out.lookups.reserve(lookupCount);
+            for (uint16_t i = 0; i < lookupCount; ++i) {
+                GposLookup lookup;
+                uint16_t subtableCount = 0;
+                if (!offset16(listOffset + 2 + 2 * size_t(i), listOffset, lookup.offset) || lookup.offset == 0 ||
+                    !u16(lookup.offset, lookup.type) || !u16(lookup.offset + 2, lookup.flag) ||
+                    !u16(lookup.offset + 4, subtableCount) || !table.contains(lookup.offset + 6, 2 * size_t(subtableCount))) {
+                    return fail("Lookup table");
+                }
+                if ((lookup.flag & kUseMarkFilteringSet) && !u16(lookup.offset + 6 + 2 * size_t(subtableCount), lookup.markFilteringSet)) {
+                    return fail("Lookup table");
+                }
+
+                lookup.extension = lookup.type == kExtensionLookup;
+                lookup.subtableStart = static_cast<uint32_t>(out.subtables.size());
+                for (uint16_t j = 0; j < subtableCount; ++j) {
+                    uint32_t subtableOffset = 0;
+                    if (!offset16(lookup.offset + 6 + 2 * size_t(j), lookup.offset, subtableOffset) || subtableOffset == 0) {
+                        return fail("Lookup table");
+                    }
+                    uint16_t type = lookup.type;
+                    if (lookup.extension && !resolveExtension(subtableOffset, type)) {
+                        return false;
+                    }
+                    if (lookup.extension && j == 0) {
+                        lookup.type = type;
+                    }
+                    else if (type != lookup.type) {
+                        return fail("Extension subtable (lookup type differs between subtables)");
+                    }
+                    if (!decodeSubtable(type, subtableOffset)) {
+                        return false;
+                    }
+                }
+                lookup.subtableCount = static_cast<uint32_t>(out.subtables.size()) - lookup.subtableStart;
+                out.lookups.push_back(lookup);
+            }
+            return true;
+        }
+
+        // Follows an Extension subtable to the subtable it wraps.
+        bool resolveExtension(uint32_t& offset, uint16_t& type) {
+            uint16_t format = 0;
+            uint32_t extensionOffset = 0;
+            if (!u16(offset, format) || format != 1 || !u16(offset + 2, type) || !u32(offset + 4, extensionOffset) ||
+                type == kExtensionLookup || extensionOffset == 0 || extensionOffset > table.size() - offset) {
+                return fail("Extension subtable");
+            }
+            offset += extensionOffset;
+            return true;
+        }
+
+        bool decodeSubtable(uint16_t type, uint32_t offset) {
+            GposSubtable subtable;
+            subtable.type = type;
+            subtable.offset = offset;
+            if (!u16(offset, subtable.format)) {
+                return fail("subtable");
+            }
+
+            bool decoded = false;
+            switch (type) {
+            case 1: decoded = decodeSinglePos(subtable); break;
+            case 2: decoded = decodePairPos(subtable); break;
+            case 3: decoded = decodeCursivePos(subtable); break;
+            case 4:
+            case 5:
+            case 6: decoded = decodeMarkAttachment(subtable); break;
+            case 7: decoded = decodeContextPos(subtable, false); break;
+            case 8: decoded = decodeContextPos(subtable, true); break;
+            default:
+                std::cerr << "Error: Unknown GPOS lookup type " << type << "." << std::endl;
+                return false;
+            }
+            if (!decoded) {
+                std::cerr << "Error: Malformed GPOS lookup type " << type << " format " << subtable.format
+                    << " subtable at offset " << offset << "." << std::endl;
+                return false;
+            }
+            out.subtables.push_back(subtable);
+            return true;
+        }
+
+        bool decodeSinglePos(GposSubtable& subtable) {
+            const uint32_t offset = subtable.offset;
+            if (!coverageAt(offset + 2, offset, subtable.coverage) || !u16(offset + 4, subtable.valueFormat1)) {
+                return false;
+            }
+            if (subtable.format == 1) {
+                subtable.count = 1;
+                return valueAt(offset + 6, subtable.valueFormat1, offset, subtable.first);
+            }
+            uint16_t valueCount = 0;
+            const uint32_t size = valueRecordSize(subtable.valueFormat1);
+            if (subtable.format != 2 || !u16(offset + 6, valueCount) || !table.contains(offset + 8, size_t(size) * valueCount)) {
+                return false;
+            }
+            // Values are addressed by coverage index, so even empty ones get a slot
+            subtable.first = static_cast<uint32_t>(out.values.size());
+            subtable.count = valueCount;
+            for (uint16_t i = 0; i < valueCount; ++i) {
+                GposValue value;
+                readValue(offset + 8 + size * i, subtable.valueFormat1, offset, value);
+                out.values.push_back(value);
+            }
+            return true;
+        }
+
+        bool decodePairPos(GposSubtable& subtable) {
+            const uint32_t offset = subtable.offset;
+            if (!coverageAt(offset + 2, offset, subtable.coverage) || !u16(offset + 4, subtable.valueFormat1) ||
+                !u16(offset + 6, subtable.valueFormat2)) {
+                return false;
+            }
+            const uint32_t size1 = valueRecordSize(subtable.valueFormat1);
+            const uint32_t size2 = valueRecordSize(subtable.valueFormat2);
+
+            if (subtable.format == 1) {
+                uint16_t pairSetCount = 0;
+                if (!u16(offset + 8, pairSetCount) || !table.contains(offset + 10, 2 * size_t(pairSetCount))) {
+                    return false;
+                }
+                subtable.first = static_cast<uint32_t>(out.rows.size());
+                subtable.count = pairSetCount;
+                for (uint16_t i = 0; i < pairSetCount; ++i) {
+                    out.rows.push_back(static_cast<uint32_t>(out.pairGlyphs.size()));
+                    uint32_t pairSet = 0;
+                    uint16_t pairCount = 0;
+                    if (!offset16(offset + 10 + 2 * size_t(i), offset, pairSet)) {
+                        return false;
+                    }
+                    if (pairSet == 0) {
+                        continue;
+                    }
+                    const uint32_t recordSize = 2 + size1 + size2;
+                    if (!u16(pairSet, pairCount) || !table.contains(pairSet + 2, size_t(recordSize) * pairCount)) {
+                        return false;
+                    }
+                    const size_t setStart = out.pairGlyphs.size();
+                    for (uint16_t j = 0; j < pairCount; ++j) {
+                        const uint32_t record = pairSet + 2 + recordSize * j;
+                        GposPairValue value;
+                        // Device offsets of pair values are relative to the PairPos subtable
+                        if (!valueAt(record + 2, subtable.valueFormat1, offset, value.value1) ||
+                            !valueAt(record + 2 + size1, subtable.valueFormat2, offset, value.value2)) {
+                            return false;
+                        }
+                        out.pairGlyphs.push_back(readU16(table.data() + record));
+                        out.pairGlyphValues.push_back(value);
+                    }
+                    if (!std::is_sorted(out.pairGlyphs.begin() + setStart, out.pairGlyphs.end())) {
+                        return false; // Pair sets are searched by second glyph
+                    }
+                }
+                out.rows.push_back(static_cast<uint32_t>(out.pairGlyphs.size()));
+                return true;
+            }
+
+            if (subtable.format != 2 || !classDefAt(offset + 8, offset, subtable.classDef1) ||
+                !classDefAt(offset + 10, offset, subtable.classDef2) ||
+                !u16(offset + 12, subtable.class1Count) || !u16(offset + 14, subtable.class2Count)) {
+                return false;
+            }
+            const size_t cells = size_t(subtable.class1Count) * subtable.class2Count;
+            if (!table.contains(offset + 16, cells * (size1 + size2))) {
+                return false;
+            }
+            subtable.first = static_cast<uint32_t>(out.pairClassValues.size());
+            subtable.count = static_cast<uint32_t>(cells);
+            out.pairClassValues.resize(out.pairClassValues.size() + cells);
+            for (size_t i = 0; i < cells; ++i) {
+                const uint32_t record = static_cast<uint32_t>(offset + 16 + i * (size1 + size2));
+                GposPairValue& cell = out.pairClassValues[subtable.first + i];
+                if (!valueAt(record, subtable.valueFormat1, offset, cell.value1) ||
+                    !valueAt(record + size1, subtable.valueFormat2, offset, cell.value2)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool decodeCursivePos(GposSubtable& subtable) {
+            const uint32_t offset = subtable.offset;
+            uint16_t entryExitCount = 0;
+            if (subtable.format != 1 || !coverageAt(offset + 2, offset, subtable.coverage) ||
+                !u16(offset + 4, entryExitCount) || !table.contains(offset + 6, 4 * size_t(entryExitCount))) {
+                return false;
+            }
+            subtable.first = static_cast<uint32_t>(out.anchorRefs.size());
+            subtable.count = entryExitCount;
+            for (size_t i = 0; i < 2 * size_t(entryExitCount); ++i) {
+                uint32_t anchor = 0;
+                if (!anchorAt(offset + 6 + 2 * i, offset, anchor)) {
+                    return false;
+                }
+                out.anchorRefs.push_back(anchor);
+            }
+            return true;
+        }
+
+        // Mark-to-base, mark-to-ligature and mark-to-mark share their layout up to the base array.
+        bool decodeMarkAttachment(GposSubtable& subtable) {
+            const uint32_t offset = subtable.offset;
+            uint32_t markArray = 0, baseArray = 0;
+            uint16_t markCount = 0, baseCount = 0;
+            if (subtable.format != 1 || !coverageAt(offset + 2, offset, subtable.coverage) ||
+                !coverageAt(offset + 4, offset, subtable.coverage2) || !u16(offset + 6, subtable.class1Count) ||
+                !offset16(offset + 8, offset, markArray) || !offset16(offset + 10, offset, baseArray) ||
+                markArray == 0 || baseArray == 0 ||
+                !u16(markArray, markCount) || !table.contains(markArray + 2, 4 * size_t(markCount)) ||
+                !u16(baseArray, baseCount)) {
+                return false;
+            }
+
+            const uint16_t classCount = subtable.class1Count;
+            subtable.first = static_cast<uint32_t>(out.marks.size());
+            subtable.count = markCount;
+            for (uint16_t i = 0; i < markCount; ++i) {
+                const uint32_t record = markArray + 2 + 4 * i;
+                GposMark mark;
+                mark.markClass = readU16(table.data() + record);
+                if (mark.markClass >= classCount || !anchorAt(record + 2, markArray, mark.anchor)) {
+                    return false;
+                }
+                out.marks.push_back(mark);
+            }
+
+            subtable.count2 = baseCount;
+            if (subtable.type != 5) {
+                // BaseArray and Mark2Array: one row of anchors per base (mark2) glyph
+                const size_t anchorCount = size_t(baseCount) * classCount;
+                if (!table.contains(baseArray + 2, 2 * anchorCount)) {
+                    return false;
+                }
+                subtable.first2 = static_cast<uint32_t>(out.anchorRefs.size());
+                for (size_t i = 0; i < anchorCount; ++i) {
+                    uint32_t anchor = 0;
+                    if (!anchorAt(baseArray + 2 + 2 * i, baseArray, anchor)) {
+                        return false;
+                    }
+                    out.anchorRefs.push_back(anchor);
+                }
+                return true;
+            }
+
+            // LigatureArray: one LigatureAttach per ligature, with a row of anchors per component
+            if (!table.contains(baseArray + 2, 2 * size_t(baseCount))) {
+                return false;
+            }
+            subtable.first2 = static_cast<uint32_t>(out.rows.size());
+            for (uint16_t i = 0; i < baseCount; ++i) {
+                out.rows.push_back(static_cast<uint32_t>(out.anchorRefs.size()));
+                uint32_t ligatureAttach = 0;
+                uint16_t componentCount = 0;
+                if (!offset16(baseArray + 2 + 2 * size_t(i), baseArray, ligatureAttach)) {
+                    return false;
+                }
+                if (ligatureAttach == 0) {
+                    continue;
+                }
+                if (!u16(ligatureAttach, componentCount)) {
+                    return false;
+                }
+                const size_t anchorCount = size_t(componentCount) * classCount;
+                if (!table.contains(ligatureAttach + 2, 2 * anchorCount)) {
+                    return false;
+                }
+                for (size_t j = 0; j < anchorCount; ++j) {
+                    uint32_t anchor = 0;
+                    if (!anchorAt(ligatureAttach + 2 + 2 * j, ligatureAttach, anchor)) {
+                        return false;
+                    }
+                    out.anchorRefs.push_back(anchor);
+                }
+            }
+            out.rows.push_back(static_cast<uint32_t>(out.anchorRefs.size()));
+            return true;
+        }
+
+        bool decodeContextPos(GposSubtable& subtable, bool chained) {
+            const uint32_t offset = subtable.offset;
+            if (subtable.format == 3) {
+                return decodeCoverageRule(subtable, chained);
+            }
+
+            uint16_t setCount = 0;
+            uint32_t setsAt = offset + 6;
+            if (!coverageAt(offset + 2, offset, subtable.coverage)) {
+                return false;
+            }
+            if (subtable.format == 2) {
+                const bool read = chained ?
+                    classDefAt(offset + 4, offset, subtable.classDef1) && classDefAt(offset + 6, offset, subtable.classDef2) &&
+                        classDefAt(offset + 8, offset, subtable.classDef3) :
+                    classDefAt(offset + 4, offset, subtable.classDef2);
+                if (!read) {
+                    return false;
+                }
+                setsAt = chained ? offset + 12 : offset + 8;
+            }
+            else if (subtable.format != 1) {
+                return false;
+            }
+            if (!u16(setsAt - 2, setCount) || !table.contains(setsAt, 2 * size_t(setCount))) {
+                return false;
+            }
+
+            subtable.first = static_cast<uint32_t>(out.rows.size());
+            subtable.count = setCount;
+            for (uint16_t i = 0; i < setCount; ++i) {
+                out.rows.push_back(static_cast<uint32_t>(out.rules.size()));
+                uint32_t ruleSet = 0;
+                uint16_t ruleCount = 0;
+                if (!offset16(setsAt + 2 * size_t(i), offset, ruleSet)) {
+                    return false;
+                }
+                if (ruleSet == 0) {
+                    continue;
+                }
+                if (!u16(ruleSet, ruleCount) || !table.contains(ruleSet + 2, 2 * size_t(ruleCount))) {
+                    return false;
+                }
+                for (uint16_t j = 0; j < ruleCount; ++j) {
+                    uint32_t rule = 0;
+                    if (!offset16(ruleSet + 2 + 2 * size_t(j), ruleSet, rule) || rule == 0 ||
+                        !(chained ? decodeChainedRule(rule) : decodeRule(rule))) {
+                        return false;
+                    }
+                }
+            }
+            out.rows.push_back(static_cast<uint32_t>(out.rules.size()));
+            return true;
+        }
+
+        // Appends `count` 16-bit glyph IDs or classes starting at `at` to the sequences.
+        bool readSequence(uint32_t at, uint16_t count) {
+            if (!table.contains(at, 2 * size_t(count))) {
+                return false;
+            }
+            for (uint16_t i = 0; i < count; ++i) {
+                out.sequences.push_back(readU16(table.data() + at + 2 * size_t(i)));
+            }
+            return true;
+        }
+
+        bool readLookupRecords(uint32_t at, GposRule& rule) {
+            if (!table.contains(at, 4 * size_t(rule.recordCount))) {
+                return false;
+            }
+            rule.recordStart = static_cast<uint32_t>(out.lookupRecords.size());
+            for (uint16_t i = 0; i < rule.recordCount; ++i) {
+                const uint8_t* record = table.data() + at + 4 * size_t(i);
+                out.lookupRecords.push_back({ readU16(record), readU16(record + 2) });
+            }
+            out.rules.push_back(rule);
+            return true;
+        }
+
+        // SequenceRule and ClassSequenceRule.
+        bool decodeRule(uint32_t offset) {
+            GposRule rule = {};
+            uint16_t glyphCount = 0;
+            if (!u16(offset, glyphCount) || glyphCount == 0 || !u16(offset + 2, rule.recordCount)) {
+                return false;
+            }
+            rule.sequenceStart = static_cast<uint32_t>(out.sequences.size());
+            rule.inputCount = glyphCount - 1;
+            return readSequence(offset + 4, rule.inputCount) &&
+                readLookupRecords(offset + 4 + 2 * uint32_t(rule.inputCount), rule);
+        }
+
+        // ChainedSequenceRule and ChainedClassSequenceRule.
+        bool decodeChainedRule(uint32_t offset) {
+            GposRule rule = {};
+            uint16_t inputGlyphCount = 0;
+            uint32_t at = offset;
+            rule.sequenceStart = static_cast<uint32_t>(out.sequences.size());
+            if (!u16(at, rule.backtrackCount) || !readSequence(at + 2, rule.backtrackCount)) {
+                return false;
+            }
+            at += 2 + 2 * uint32_t(rule.backtrackCount);
+            if (!u16(at, inputGlyphCount) || inputGlyphCount == 0) {
+                return false;
+            }
+            rule.inputCount = inputGlyphCount - 1;
+            if (!readSequence(at + 2, rule.inputCount)) {
+                return false;
+            }
+            at += 2 + 2 * uint32_t(rule.inputCount);
+            if (!u16(at, rule.lookaheadCount) || !readSequence(at + 2, rule.lookaheadCount)) {
+                return false;
+            }
+            at += 2 + 2 * uint32_t(rule.lookaheadCount);
+            return u16(at, rule.recordCount) && readLookupRecords(at + 2, rule);
+        }
+
+        // Appends the coverages of `count` offsets at `at`, relative to `base`, to the sequences.
+        bool readCoverageSequence(uint32_t at, uint16_t count, uint32_t base) {
+            if (!table.contains(at, 2 * size_t(count))) {
+                return false;
+            }
+            for (uint16_t i = 0; i < count; ++i) {
+                uint32_t coverage = 0;
+                if (!coverageAt(at + 2 * i, base, coverage)) {
+                    return false;
+                }
+                out.sequences.push_back(coverage);
+            }
+            return true;
+        }
+
+        // Format 3 of (chained) contextual positioning: a single rule of coverages.
+        bool decodeCoverageRule(GposSubtable& subtable, bool chained) {
+            const uint32_t offset = subtable.offset;
+            GposRule rule = {};
+            rule.sequenceStart = static_cast<uint32_t>(out.sequences.size());
+            subtable.first = static_cast<uint32_t>(out.rules.size());
+            subtable.count = 1;
+            if (!chained) {
+                return u16(offset + 2, rule.inputCount) && rule.inputCount != 0 && u16(offset + 4, rule.recordCount) &&
+                    readCoverageSequence(offset + 6, rule.inputCount, offset) &&
+                    readLookupRecords(offset + 6 + 2 * uint32_t(rule.inputCount), rule);
+            }
+            uint32_t at = offset + 2;
+            if (!u16(at, rule.backtrackCount) || !readCoverageSequence(at + 2, rule.backtrackCount, offset)) {
+                return false;
+            }
+            at += 2 + 2 * uint32_t(rule.backtrackCount);
+            if (!u16(at, rule.inputCount) || rule.inputCount == 0 || !readCoverageSequence(at + 2, rule.inputCount, offset)) {
+                return false;
+            }
+            at += 2 + 2 * uint32_t(rule.inputCount);
+            if (!u16(at, rule.lookaheadCount) || !readCoverageSequence(at + 2, rule.lookaheadCount, offset)) {
+                return false;
+            }
+            at += 2 + 2 * uint32_t(rule.lookaheadCount);
+            return u16(at, rule.recordCount) && readLookupRecords(at + 2, rule);
+        }
+
+        // Decodes the ValueRecord at `at`, whose size the caller has checked; `base` is what its
+        // device offsets are relative to. Device offsets go to out.devices.
+        void readValue(uint32_t at, uint16_t valueFormat, uint32_t base, GposValue& value) {
+            int16_t fields[4] = {};
+            uint32_t deviceOffsets[4] = {};
+            const uint8_t* p = table.data() + at;
+            for (int bit = 0; bit < 8; ++bit) {
+                if (!(valueFormat & (1 << bit))) {
+                    continue;
+                }
+                const uint16_t field = readU16(p);
+                p += 2;
+                if (bit < 4) {
+                    fields[bit] = static_cast<int16_t>(field);
+                }
+                else if (field != 0) {
+                    deviceOffsets[bit - 4] = base + field;
+                }
+            }
+            value.xPlacement = fields[0];
+            value.yPlacement = fields[1];
+            value.xAdvance = fields[2];
+            value.yAdvance = fields[3];
+            if (deviceOffsets[0] | deviceOffsets[1] | deviceOffsets[2] | deviceOffsets[3]) {
+                value.devices = static_cast<uint32_t>(out.devices.size());
+                out.devices.push_back({ deviceOffsets[0], deviceOffsets[1], deviceOffsets[2], deviceOffsets[3] });
+            }
+        }
+
+        // Decodes the ValueRecord at `at` into out.values; records without adjustments share index 0.
+        bool valueAt(uint32_t at, uint16_t valueFormat, uint32_t base, uint32_t& index) {
+            index = 0;
+            if (!table.contains(at, valueRecordSize(valueFormat))) {
+                return false;
+            }
+            GposValue value;
+            readValue(at, valueFormat, base, value);
+            if (value.devices != 0) {
+                index = static_cast<uint32_t>(out.values.size());
+                out.values.push_back(value);
+                return true;
+            }
+            // Kerning repeats a few hundred distinct values over thousands of pairs, so share them
+            const uint64_t key = (uint64_t(uint16_t(value.xPlacement)) << 48) | (uint64_t(uint16_t(value.yPlacement)) << 32) |
+                (uint64_t(uint16_t(value.xAdvance)) << 16) | uint16_t(value.yAdvance);
+            if (key == 0) {
+                return true;
+            }
+            const auto known = valueIndex.emplace(key, static_cast<uint32_t>(out.values.size()));
+            if (known.second) {
+                out.values.push_back(value);
+            }
+            index = known.first->second;
+            return true;
+        }
+
+        bool coverageAt(uint32_t at, uint32_t base, uint32_t& index) {
+            uint32_t offset = 0;
+            if (!offset16(at, base, offset)) {
+                return false;
+            }
+            index = 0;
+            if (offset == 0) {
+                return true;
+            }
+            const auto known = coverageIndex.find(offset);
+            if (known != coverageIndex.end()) {
+                index = known->second;
+                return true;
+            }
+
+            uint16_t format = 0, count = 0;
+            if (!u16(offset, format) || !u16(offset + 2, count)) {
+                return false;
+            }
+            GposCoverage coverage;
+            coverage.start = static_cast<uint32_t>(out.coverageGlyphs.size());
+            if (format == 1) {
+                if (!table.contains(offset + 4, 2 * size_t(count))) {
+                    return false;
+                }
+                for (uint16_t i = 0; i < count; ++i) {
+                    out.coverageGlyphs.push_back(readU16(table.data() + offset + 4 + 2 * size_t(i)));
+                }
+            }
+            else if (format == 2) {
+                // Ranges must be sorted and disjoint, which also bounds the glyphs they expand to
+                if (!table.contains(offset + 4, 6 * size_t(count))) {
+                    return false;
+                }
+                int32_t previousEnd = -1;
+                for (uint16_t i = 0; i < count; ++i) {
+                    const uint8_t* range = table.data() + offset + 4 + 6 * size_t(i);
+                    const uint16_t startGlyph = readU16(range), endGlyph = readU16(range + 2);
+                    if (int32_t(startGlyph) <= previousEnd || endGlyph < startGlyph) {
+                        return false;
+                    }
+                    for (uint32_t glyph = startGlyph; glyph <= endGlyph; ++glyph) {
+                        out.coverageGlyphs.push_back(static_cast<uint16_t>(glyph));
+                    }
+                    previousEnd = endGlyph;
+                }
+            }
+            else {
+                return false;
+            }
+            coverage.count = static_cast<uint32_t>(out.coverageGlyphs.size()) - coverage.start;
+
+            index = static_cast<uint32_t>(out.coverages.size());
+            out.coverages.push_back(coverage);
+            coverageIndex.emplace(offset, index);
+            return true;
+        }
+
+        bool classDefAt(uint32_t at, uint32_t base, uint32_t& index) {
+            uint32_t offset = 0;
+            if (!offset16(at, base, offset)) {
+                return false;
+            }
+            index = 0;
+            if (offset == 0) {
+                return true;
+            }
+            const auto known = classDefIndex.find(offset);
+            if (known != classDefIndex.end()) {
+                index = known->second;
+                return true;
+            }
+
+            uint16_t format = 0;
+            std::vector<GposClassRange> ranges;
+            if (!u16(offset, format)) {
+                return false;
+            }
+            if (format == 1) {
+                // A class per glyph: fold runs of one class into ranges
+                uint16_t startGlyph = 0, glyphCount = 0;
+                if (!u16(offset + 2, startGlyph) || !u16(offset + 4, glyphCount) ||
+                    !table.contains(offset + 6, 2 * size_t(glyphCount)) || size_t(startGlyph) + glyphCount > 0x10000) {
+                    return false;
+                }
+                for (uint16_t i = 0; i < glyphCount; ++i) {
+                    const uint16_t glyph = static_cast<uint16_t>(startGlyph + i);
+                    const uint16_t glyphClass = readU16(table.data() + offset + 6 + 2 * size_t(i));
+                    if (glyphClass == 0) {
+                        continue;
+                    }
+                    if (!ranges.empty() && ranges.back().glyphClass == glyphClass && ranges.back().last + 1 == glyph) {
+                        ranges.back().last = glyph;
+                    }
+                    else {
+                        ranges.push_back({ glyph, glyph, glyphClass });
+                    }
+                }
+            }
+            else if (format == 2) {
+                uint16_t rangeCount = 0;
+                if (!u16(offset + 2, rangeCount) || !table.contains(offset + 4, 6 * size_t(rangeCount))) {
+                    return false;
+                }
+                bool ordered = true;
+                for (uint16_t i = 0; i < rangeCount; ++i) {
+                    const uint8_t* record = table.data() + offset + 4 + 6 * size_t(i);
+                    const GposClassRange range = { readU16(record), readU16(record + 2), readU16(record + 4) };
+                    if (range.last < range.first) {
+                        return false;
+                    }
+                    if (range.glyphClass == 0) {
+                        continue;
+                    }
+                    ordered = ordered && (ranges.empty() || range.first > ranges.back().last);
+                    ranges.push_back(range);
+                }
+                if (!ordered) {
+                    ranges = reorderRanges(ranges);
+                }
+            }
+            else {
+                return false;
+            }
+
+            GposClassDef classDef;
+            classDef.start = static_cast<uint32_t>(out.classRanges.size());
+            classDef.count = static_cast<uint32_t>(ranges.size());
+            out.classRanges.insert(out.classRanges.end(), ranges.begin(), ranges.end());
+
+            index = static_cast<uint32_t>(out.classDefs.size());
+            out.classDefs.push_back(classDef);
+            classDefIndex.emplace(offset, index);
+            return true;
+        }
+
+        // Sorts overlapping or unordered class ranges by expanding them, later ranges winning.
+        static std::vector<GposClassRange> reorderRanges(const std::vector<GposClassRange>& ranges) {
+            std::vector<uint16_t> classes(0x10000, 0);
+            for (const GposClassRange& range : ranges) {
+                std::fill(classes.begin() + range.first, classes.begin() + range.last + 1, range.glyphClass);
+            }
+            std::vector<GposClassRange> sorted;
+            for (uint32_t glyph = 0; glyph < classes.size(); ++glyph) {
+                if (classes[glyph] == 0) {
+                    continue;
+                }
+                if (!sorted.empty() && sorted.back().glyphClass == classes[glyph] && sorted.back().last + 1u == glyph) {
+                    sorted.back().last = static_cast<uint16_t>(glyph);
+                }
+                else {
+                    sorted.push_back({ static_cast<uint16_t>(glyph), static_cast<uint16_t>(glyph), classes[glyph] });
+                }
+            }
+            return sorted;
+        }
+
+        bool anchorAt(uint32_t at, uint32_t base, uint32_t& index) {
+            uint32_t offset = 0;
+            if (!offset16(at, base, offset)) {
+                return false;
+            }
+            index = 0;
+            if (offset == 0) {
+                return true;
+            }
+            const auto known = anchorIndex.find(offset);
+            if (known != anchorIndex.end()) {
+                index = known->second;
+                return true;
+            }
+
+            GposAnchor anchor;
+            uint16_t x = 0, y = 0;
+            if (!u16(offset, anchor.format) || !u16(offset + 2, x) || !u16(offset + 4, y)) {
+                return false;
+            }
+            anchor.x = static_cast<int16_t>(x);
+            anchor.y = static_cast<int16_t>(y);
+            if (anchor.format == 2) {
+                if (!u16(offset + 6, anchor.anchorPoint)) {
+                    return false;
+                }
+            }
+            else if (anchor.format == 3) {
+                if (!offset16(offset + 6, offset, anchor.xDevice) || !offset16(offset + 8, offset, anchor.yDevice)) {
+                    return false;
+                }
+            }
+            else if (anchor.format != 1) {
+                return false;
+            }
+
+            index = static_cast<uint32_t>(out.anchors.size());
+            out.anchors.push_back(anchor);
+            anchorIndex.emplace(offset, index);
+            return true;
+        }
+
+        GposTable& out;
+        ByteView table;
+        // Shared tables already decoded, by offset from the start of GPOS
+        std::unordered_map<uint32_t, uint32_t> coverageIndex;
+        std::unordered_map<uint32_t, uint32_t> classDefIndex;
+        std::unordered_map<uint32_t, uint32_t> anchorIndex;
+        // Values without device tables already decoded, by their packed fields
+        std::unordered_map<uint64_t, uint32_t> valueIndex;
+    };
+
+    GposTable::GposTable() {
+        clear();
+    }
+
+    void GposTable::clear() {
+        scripts.clear();
+        langSystems.clear();
+        langSysFeatures.clear();
+        features.clear();
+        featureLookups.clear();
+        lookups.clear();
+        subtables.clear();
+        coverageGlyphs.clear();
+        classRanges.clear();
+        anchorRefs.clear();
+        marks.clear();
+        rows.clear();
+        pairGlyphs.clear();
+        pairGlyphValues.clear();
+        pairClassValues.clear();
+        rules.clear();
+        sequences.clear();
+        lookupRecords.clear();
+
+        // Index 0 stands for a null offset
+        coverages.assign(1, GposCoverage());
+        classDefs.assign(1, GposClassDef());
+        values.assign(1, GposValue());
+        devices.assign(1, GposDevices());
+        anchors.assign(1, GposAnchor());
+    }
+
+    bool GposTable::decode(ByteView table) {
+        clear();
+        Decoder decoder(*this, table);
+        if (!decoder.decode()) {
+            clear();
+            return false;
+        }
+        shrinkToFit();
+        return true;
+    }
+
+    void GposTable::shrinkToFit() {
+        scripts.shrink_to_fit();
+        langSystems.shrink_to_fit();
+        langSysFeatures.shrink_to_fit();
+        features.shrink_to_fit();
+        featureLookups.shrink_to_fit();
+        lookups.shrink_to_fit();
+        subtables.shrink_to_fit();
+        coverages.shrink_to_fit();
+        coverageGlyphs.shrink_to_fit();
+        classDefs.shrink_to_fit();
+        classRanges.shrink_to_fit();
+        values.shrink_to_fit();
+        devices.shrink_to_fit();
+        anchors.shrink_to_fit();
+        anchorRefs.shrink_to_fit();
+        marks.shrink_to_fit();
+        rows.shrink_to_fit();
+        pairGlyphs.shrink_to_fit();
+        pairGlyphValues.shrink_to_fit();
+        pairClassValues.shrink_to_fit();
+        rules.shrink_to_fit();
+        sequences.shrink_to_fit();
+        lookupRecords.shrink_to_fit();
+    }
+
+    int32_t GposTable::getCoverageIndex(uint32_t coverage, uint16_t glyph) const {
+        const GposCoverage& range = coverages[coverage];
+        const uint16_t* first = coverageGlyphs.data() + range.start;
+        const uint16_t* last = first + range.count;
+        const uint16_t* it = std::lower_bound(first, last, glyph);
+        return (it != last && *it == glyph) ? static_cast<int32_t>(it - first) : -1;
+    }
+
+    uint16_t GposTable::getGlyphClass(uint32_t classDef, uint16_t glyph) const {
+        const GposClassDef& definition = classDefs[classDef];
+        const GposClassRange* first = classRanges.data() + definition.start;
+        const GposClassRange* last = first + definition.count;
+        // The first range ending at or after the glyph is the only one that can hold it
+        const GposClassRange* it = std::lower_bound(first, last, glyph,
+            [](const GposClassRange& range, uint16_t value) { return range.last < value; });
+        return (it != last && it->first <= glyph) ? it->glyphClass : 0;
+    }
+
+    bool GposTable::getPairValue(const GposSubtable& subtable, uint16_t first, uint16_t second, GposPairValue& value) const {
+        const int32_t coverageIndex = getCoverageIndex(subtable.coverage, first);
+        if (subtable.type != 2 || coverageIndex < 0) {
+            return false;
+        }
+        if (subtable.format == 1) {
+            if (uint32_t(coverageIndex) >= subtable.count) {
+                return false;
+            }
+            const uint16_t* begin = pairGlyphs.data() + rows[subtable.first + coverageIndex];
+            const uint16_t* end = pairGlyphs.data() + rows[subtable.first + coverageIndex + 1];
+            const uint16_t* it = std::lower_bound(begin, end, second);
+            if (it == end || *it != second) {
+                return false;
+            }
+            value = pairGlyphValues[it - pairGlyphs.data()];
+            return true;
+        }
+        const uint16_t class1 = getGlyphClass(subtable.classDef1, first);
+        const uint16_t class2 = getGlyphClass(subtable.classDef2, second);
+        if (class1 >= subtable.class1Count || class2 >= subtable.class2Count) {
+            return false;
+        }
+        value = pairClassValues[subtable.first + size_t(class1) * subtable.class2Count + class2];
+        return true;
+    }
+
+    size_t GposTable::getMemoryBytes() const {
+        return scripts.capacity() * sizeof(GposScript) + langSystems.capacity() * sizeof(GposLangSys) +
+            langSysFeatures.capacity() * sizeof(uint16_t) + features.capacity() * sizeof(GposFeature) +
+            featureLookups.capacity() * sizeof(uint16_t) + lookups.capacity() * sizeof(GposLookup) +
+            subtables.capacity() * sizeof(GposSubtable) + coverages.capacity() * sizeof(GposCoverage) +
+            coverageGlyphs.capacity() * sizeof(uint16_t) + classDefs.capacity() * sizeof(GposClassDef) +
+            classRanges.capacity() * sizeof(GposClassRange) + values.capacity() * sizeof(GposValue) +
+            devices.capacity() * sizeof(GposDevices) + anchors.capacity() * sizeof(GposAnchor) +
+            anchorRefs.capacity() * sizeof(uint32_t) + marks.capacity() * sizeof(GposMark) +
+            rows.capacity() * sizeof(uint32_t) + pairGlyphs.capacity() * sizeof(uint16_t) +
+            pairGlyphValues.capacity() * sizeof(GposPairValue) + pairClassValues.capacity() * sizeof(GposPairValue) +
+            rules.capacity() * sizeof(GposRule) + sequences.capacity() * sizeof(uint32_t) +
+            lookupRecords.capacity() * sizeof(GposLookupRecord);
+    }
+
+} // namespace TTFParser
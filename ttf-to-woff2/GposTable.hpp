@@ -0,0 +1,267 @@
+#ifndef GPOS_TABLE_HPP
+#define GPOS_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FontBuffer.hpp"
+
+namespace TTFParser {
+
+    // Positioning adjustments of a ValueRecord; fields absent from its value format are 0.
+    struct GposValue {
+        int16_t xPlacement = 0;
+        int16_t yPlacement = 0;
+        int16_t xAdvance = 0;
+        int16_t yAdvance = 0;
+        uint32_t devices = 0;       // Index into GposTable::getDevices(), or 0 if the record has no device tables.
+    };
+
+    // Device or VariationIndex tables of a ValueRecord, as offsets from the start of GPOS (0 for none).
+    struct GposDevices {
+        uint32_t xPlacement = 0;
+        uint32_t yPlacement = 0;
+        uint32_t xAdvance = 0;
+        uint32_t yAdvance = 0;
+    };
+
+    // An attachment point of a cursive or mark attachment lookup.
+    struct GposAnchor {
+        uint16_t format = 0;        // 1, 2 or 3; 0 for the placeholder at index 0.
+        int16_t x = 0;
+        int16_t y = 0;
+        uint16_t anchorPoint = 0;   // Contour point of format 2.
+        uint32_t xDevice = 0;       // Device tables of format 3, as offsets from the start of GPOS (0 for none).
+        uint32_t yDevice = 0;
+    };
+
+    // Glyphs of a Coverage table, sorted, at getCoverageGlyphs()[start, start + count); a glyph's position is its coverage index.
+    struct GposCoverage {
+        uint32_t start = 0;
+        uint32_t count = 0;
+    };
+
+    // A run of glyphs of one class; ClassDef ranges are sorted and never hold class 0.
+    struct GposClassRange {
+        uint16_t first;
+        uint16_t last;
+        uint16_t glyphClass;
+    };
+
+    // Ranges of a ClassDef table at getClassRanges()[start, start + count).
+    struct GposClassDef {
+        uint32_t start = 0;
+        uint32_t count = 0;
+    };
+
+    // The values of a pair: indices into GposTable::getValues(), 0 being the empty value.
+    struct GposPairValue {
+        uint32_t value1 = 0;
+        uint32_t value2 = 0;
+    };
+
+    // A mark of a MarkArray.
+    struct GposMark {
+        uint16_t markClass;
+        uint32_t anchor;            // Index into getAnchors(), or 0 if there is none.
+    };
+
+    // A (chained) contextual positioning rule.
+    struct GposRule {
+        uint32_t sequenceStart;     // The backtrack, input and lookahead sequences follow each other in getSequences().
+        uint16_t backtrackCount;
+        uint16_t inputCount;        // Formats 1 and 2 leave out the first input glyph, matched by the rule set.
+        uint16_t lookaheadCount;
+        uint16_t recordCount;
+        uint32_t recordStart;       // Index into getLookupRecords().
+    };
+
+    // A SequenceLookupRecord: apply a lookup at a position of the input sequence.
+    struct GposLookupRecord {
+        uint16_t sequenceIndex;
+        uint16_t lookupIndex;
+    };
+
+    /**
+     * A decoded subtable. The entries of a subtable live in the flat arrays of GposTable, at
+     * `first` for `count` entries; how they are indexed depends on the lookup type:
+     *
+     * 1 Single:     format 1 has one value at values[first]; format 2 has the value of
+     *               coverage index i at values[first + i].
+     * 2 Pair:       format 1 keeps the pair set of coverage index i at
+     *               pairGlyphs/pairGlyphValues[rows[first + i], rows[first + i + 1]), sorted by
+     *               second glyph; format 2 keeps the values of a class pair at
+     *               pairClassValues[first + class1 * class2Count + class2].
+     * 3 Cursive:    the entry and exit anchors of coverage index i are at anchorRefs[first + 2i]
+     *               and anchorRefs[first + 2i + 1].
+     * 4, 5, 6 Mark: the marks of `coverage` are at marks[first + i]. For mark-to-base and
+     *               mark-to-mark the anchors of base (mark2) index j are at
+     *               anchorRefs[first2 + j * class1Count + markClass]. For mark-to-ligature,
+     *               component c of ligature j has them at
+     *               anchorRefs[rows[first2 + j] + c * class1Count + markClass], and the
+     *               ligature's components end at rows[first2 + j + 1].
+     * 7, 8 Context: formats 1 and 2 keep the rule set of coverage index (format 1) or input
+     *               class (format 2) i at rules[rows[first + i], rows[first + i + 1]); format 3
+     *               has one rule at rules[first], whose sequences hold coverage indices rather
+     *               than glyphs or classes.
+     */
+    struct GposSubtable {
+        uint16_t type = 0;          // Lookup type, never 9: Extension subtables are replaced by the subtable they point to.
+        uint16_t format = 0;
+        uint32_t offset = 0;        // From the start of GPOS.
+        uint32_t coverage = 0;      // Index into getCoverages(): the (mark) coverage; 0 for context format 3.
+        uint32_t coverage2 = 0;     // Base, ligature or mark2 coverage of mark attachment.
+        uint32_t classDef1 = 0;     // Indices into getClassDefs(): first and second glyph classes of pair format 2;
+        uint32_t classDef2 = 0;     // backtrack, input and lookahead classes of context format 2 (input only
+        uint32_t classDef3 = 0;     // in classDef2 for type 7).
+        uint16_t valueFormat1 = 0;
+        uint16_t valueFormat2 = 0;
+        uint16_t class1Count = 0;   // Pair format 2 class counts; mark class count of mark attachment.
+        uint16_t class2Count = 0;
+        uint32_t first = 0;
+        uint32_t count = 0;
+        uint32_t first2 = 0;        // Base, ligature or mark2 entries of mark attachment.
+        uint32_t count2 = 0;
+    };
+
+    // A lookup and the range of its subtables in getSubtables().
+    struct GposLookup {
+        uint16_t type = 0;          // As GposSubtable::type; the type the Extension subtables point to.
+        uint16_t flag = 0;
+        uint16_t markFilteringSet = 0; // Only meaningful if `flag` has UseMarkFilteringSet (0x0010).
+        bool extension = false;     // The subtables were stored behind Extension subtables.
+        uint32_t offset = 0;        // From the start of GPOS.
+        uint32_t subtableStart = 0;
+        uint32_t subtableCount = 0;
+    };
+
+    // A feature and its lookup indices at getFeatureLookups()[lookupStart, lookupStart + lookupCount).
+    struct GposFeature {
+        uint32_t tag;
+        uint32_t lookupStart;
+        uint32_t lookupCount;
+    };
+
+    // A language system and its feature indices at getLangSysFeatures()[featureStart, featureStart + featureCount).
+    struct GposLangSys {
+        uint32_t tag;               // 0 for a script's default language system.
+        uint16_t requiredFeature;   // 0xFFFF if there is none.
+        uint32_t featureStart;
+        uint32_t featureCount;
+    };
+
+    // A script and its language systems at getLangSystems()[langSysStart, langSysStart + langSysCount), the default one first.
+    struct GposScript {
+        uint32_t tag;
+        bool hasDefaultLangSys;
+        uint32_t langSysStart;
+        uint32_t langSysCount;
+    };
+
+    /**
+    * @class GposTable
+    * @brief A GPOS table decoded into flat arrays, for code that walks lookups repeatedly.
+    *
+    * Every lookup type is decoded, with Extension subtables resolved to the subtables they
+    * point to. Coverage, ClassDef and Anchor tables are decoded once per offset and shared by
+    * every subtable that refers to them, and value records, pair sets, marks and rules are
+    * stored back to back in typed arrays, so walking a lookup never touches the big-endian
+    * table again. Value records without device tables are shared by content. Index 0 of the
+    * coverage, class definition, value, device and anchor arrays is an empty placeholder that
+    * stands for a null offset.
+    *
+    * Feature variations (GPOS 1.1) are not decoded.
+    */
+    class GposTable {
+    public:
+        GposTable();
+
+        /**
+         * @brief Decodes a GPOS table.
+         * @param table The whole table.
+         * @return false, leaving the object empty, if the table is malformed or of an unknown version.
+         */
+        bool decode(ByteView table);
+
+        void clear();
+
+        // Coverage index of a glyph, or -1 if the coverage does not list it.
+        int32_t getCoverageIndex(uint32_t coverage, uint16_t glyph) const;
+
+        // Class of a glyph in a class definition; 0 if it has none.
+        uint16_t getGlyphClass(uint32_t classDef, uint16_t glyph) const;
+
+        /**
+         * @brief Looks a glyph pair up in a PairPos subtable.
+         * @param subtable A subtable of lookup type 2.
+         * @param value Receives the values of the pair if the subtable covers it.
+         * @return true if the subtable applies to the pair (with zero values possibly).
+         */
+        bool getPairValue(const GposSubtable& subtable, uint16_t first, uint16_t second, GposPairValue& value) const;
+
+        const std::vector<GposScript>& getScripts() const { return scripts; }
+        const std::vector<GposLangSys>& getLangSystems() const { return langSystems; }
+        const std::vector<uint16_t>& getLangSysFeatures() const { return langSysFeatures; }
+        const std::vector<GposFeature>& getFeatures() const { return features; }
+        const std::vector<uint16_t>& getFeatureLookups() const { return featureLookups; }
+        const std::vector<GposLookup>& getLookups() const { return lookups; }
+        const std::vector<GposSubtable>& getSubtables() const { return subtables; }
+
+        const std::vector<GposCoverage>& getCoverages() const { return coverages; }
+        const std::vector<uint16_t>& getCoverageGlyphs() const { return coverageGlyphs; }
+        const std::vector<GposClassDef>& getClassDefs() const { return classDefs; }
+        const std::vector<GposClassRange>& getClassRanges() const { return classRanges; }
+        const std::vector<GposValue>& getValues() const { return values; }
+        const std::vector<GposDevices>& getDevices() const { return devices; }
+        const std::vector<GposAnchor>& getAnchors() const { return anchors; }
+        const std::vector<uint32_t>& getAnchorRefs() const { return anchorRefs; }
+        const std::vector<GposMark>& getMarks() const { return marks; }
+        const std::vector<uint32_t>& getRows() const { return rows; }
+        const std::vector<uint16_t>& getPairGlyphs() const { return pairGlyphs; }
+        const std::vector<GposPairValue>& getPairGlyphValues() const { return pairGlyphValues; }
+        const std::vector<GposPairValue>& getPairClassValues() const { return pairClassValues; }
+        const std::vector<GposRule>& getRules() const { return rules; }
+        const std::vector<uint32_t>& getSequences() const { return sequences; }
+        const std::vector<GposLookupRecord>& getLookupRecords() const { return lookupRecords; }
+
+        // Number of glyphs a coverage lists.
+        uint32_t getCoverageGlyphCount(uint32_t coverage) const { return coverages[coverage].count; }
+
+        // Bytes used by the decoded table.
+        size_t getMemoryBytes() const;
+
+    private:
+        class Decoder;
+
+        // Releases the spare capacity left by decoding.
+        void shrinkToFit();
+
+        std::vector<GposScript> scripts;
+        std::vector<GposLangSys> langSystems;
+        std::vector<uint16_t> langSysFeatures;
+        std::vector<GposFeature> features;
+        std::vector<uint16_t> featureLookups;
+        std::vector<GposLookup> lookups;
+        std::vector<GposSubtable> subtables;
+
+        std::vector<GposCoverage> coverages;
+        std::vector<uint16_t> coverageGlyphs;
+        std::vector<GposClassDef> classDefs;
+        std::vector<GposClassRange> classRanges;
+        std::vector<GposValue> values;
+        std::vector<GposDevices> devices;
+        std::vector<GposAnchor> anchors;
+        std::vector<uint32_t> anchorRefs;   // Indices into anchors, 0 for a null anchor.
+        std::vector<GposMark> marks;
+        std::vector<uint32_t> rows;         // Start of each pair set, ligature or rule set, plus an end entry per subtable.
+        std::vector<uint16_t> pairGlyphs;   // Second glyphs of pair format 1.
+        std::vector<GposPairValue> pairGlyphValues; // Values of pairGlyphs.
+        std::vector<GposPairValue> pairClassValues; // Class pair matrices of pair format 2.
+        std::vector<GposRule> rules;
+        std::vector<uint32_t> sequences;
+        std::vector<GposLookupRecord> lookupRecords;
+    };
+
+} // namespace TTFParser
+
+#endif // GPOS_TABLE_HPP
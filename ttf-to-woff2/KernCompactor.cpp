@@ -0,0 +1,586 @@
+#include "KernCompactor.hpp"
+#include "KernIndex.hpp"
+#include "WOFF2Encoding.hpp"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace FontConverter {
+    using WOFF2Builder::appendU16;
+    using WOFF2Builder::appendU32;
+
+    namespace {
+        const uint16_t kXAdvance = 0x0004;       // ValueFormat bit of an x advance adjustment.
+        const uint16_t kIgnoreMarks = 0x0008;    // LookupFlag bit.
+        const uint16_t kPairPosLookup = 2;
+        const uint16_t kExtensionLookup = 9;
+        const size_t kMaxOffset = 0xFFFF;        // Subtables reach their coverage and class definitions with 16-bit offsets.
+        const size_t kSubtableOverhead = 16 + 3 * 4 + 2; // Header, coverage and class definition headers, and the lookup's offset.
+
+        // First glyphs with identical kerning rows.
+        struct FirstClass {
+            std::vector<uint16_t> glyphs;
+            std::vector<std::pair<uint32_t, int16_t>> cells; // (second class, value) of every kerned second class.
+        };
+
+        // First classes that share one PairPos subtable.
+        struct Cluster {
+            std::vector<uint32_t> firstClasses;
+            std::vector<bool> hasSecond;  // Second classes kerned by any first class of the cluster.
+            size_t secondClasses = 0;
+            size_t firstGlyphs = 0;
+            size_t secondGlyphs = 0;
+        };
+
+        // One PairPos format 2 subtable, before serialization.
+        struct PairPosSubtable {
+            std::vector<std::pair<uint16_t, uint16_t>> firstGlyphs;  // (glyph, class), sorted by glyph.
+            std::vector<std::pair<uint16_t, uint16_t>> secondGlyphs; // (glyph, class), class 0 left out, sorted by glyph.
+            uint16_t class1Count = 0;
+            uint16_t class2Count = 0;
+            std::vector<int16_t> matrix; // class1Count rows of class2Count x advances.
+        };
+
+        inline uint64_t hashMix(uint64_t hash, uint32_t value) {
+            // FNV-1a over the value's bytes
+            for (int shift = 0; shift < 32; shift += 8) {
+                hash = (hash ^ ((value >> shift) & 0xFF)) * 1099511628211ull;
+            }
+            return hash;
+        }
+
+        /**
+         * Numbers the distinct items of a list, given a hash of each and an equality test.
+         * Classes are numbered in order of their first item. Returns the class count.
+         */
+        template <typename Equal>
+        uint32_t groupIdentical(const std::vector<uint64_t>& hashes, Equal equal, std::vector<uint32_t>& classOf) {
+            std::vector<uint32_t> order(hashes.size());
+            for (uint32_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return hashes[a] != hashes[b] ? hashes[a] < hashes[b] : a < b;
+            });
+
+            // Within a run of equal hashes, compare against the first item of each class found so far
+            const uint32_t kUnassigned = UINT32_MAX;
+            classOf.assign(hashes.size(), kUnassigned);
+            std::vector<uint32_t> representatives;
+            for (size_t start = 0, end = 0; start < order.size(); start = end) {
+                for (end = start; end < order.size() && hashes[order[end]] == hashes[order[start]]; ++end) {
+                }
+                representatives.clear();
+                for (size_t i = start; i < end; ++i) {
+                    const uint32_t item = order[i];
+                    for (uint32_t representative : representatives) {
+                        if (equal(representative, item)) {
+                            classOf[item] = classOf[representative];
+                            break;
+                        }
+                    }
+                    if (classOf[item] == kUnassigned) {
+                        classOf[item] = item; // Provisionally the class of its first item
+                        representatives.push_back(item);
+                    }
+                }
+            }
+
+            // Renumber by first item
+            std::vector<uint32_t> number(hashes.size(), kUnassigned);
+            uint32_t count = 0;
+            for (uint32_t& id : classOf) {
+                if (number[id] == kUnassigned) {
+                    number[id] = count++;
+                }
+                id = number[id];
+            }
+            return count;
+        }
+
+        // Coverage table of sorted glyphs, in whichever format is smaller.
+        void writeCoverage(const std::vector<uint16_t>& glyphs, std::vector<uint8_t>& out) {
+            size_t ranges = 0;
+            for (size_t i = 0; i < glyphs.size(); ++i) {
+                ranges += (i == 0 || glyphs[i] != glyphs[i - 1] + 1);
+            }
+            if (6 * ranges < 2 * glyphs.size()) {
+                appendU16(out, 2);
+                appendU16(out, static_cast<uint16_t>(ranges));
+                for (size_t start = 0, end = 0; start < glyphs.size(); start = end) {
+                    for (end = start + 1; end < glyphs.size() && glyphs[end] == glyphs[end - 1] + 1; ++end) {
+                    }
+                    appendU16(out, glyphs[start]);
+                    appendU16(out, glyphs[end - 1]);
+                    appendU16(out, static_cast<uint16_t>(start));
+                }
+                return;
+            }
+            appendU16(out, 1);
+            appendU16(out, static_cast<uint16_t>(glyphs.size()));
+            for (uint16_t glyph : glyphs) {
+                appendU16(out, glyph);
+            }
+        }
+
+        // Class definition table of sorted (glyph, class) entries without class 0, in whichever format is smaller.
+        void writeClassDef(const std::vector<std::pair<uint16_t, uint16_t>>& entries, std::vector<uint8_t>& out) {
+            size_t ranges = 0;
+            for (size_t i = 0; i < entries.size(); ++i) {
+                ranges += (i == 0 || entries[i].first != entries[i - 1].first + 1 || entries[i].second != entries[i - 1].second);
+            }
+            const size_t span = entries.empty() ? 0 : size_t(entries.back().first) - entries.front().first + 1;
+            if (entries.empty() || 6 * ranges <= 2 + 2 * span) {
+                appendU16(out, 2);
+                appendU16(out, static_cast<uint16_t>(ranges));
+                for (size_t start = 0, end = 0; start < entries.size(); start = end) {
+                    for (end = start + 1; end < entries.size() && entries[end].first == entries[end - 1].first + 1 &&
+                        entries[end].second == entries[start].second; ++end) {
+                    }
+                    appendU16(out, entries[start].first);
+                    appendU16(out, entries[end - 1].first);
+                    appendU16(out, entries[start].second);
+                }
+                return;
+            }
+            appendU16(out, 1);
+            appendU16(out, entries.front().first);
+            appendU16(out, static_cast<uint16_t>(span));
+            size_t next = 0;
+            for (uint32_t glyph = entries.front().first; glyph <= entries.back().first; ++glyph) {
+                const bool listed = entries[next].first == glyph;
+                appendU16(out, listed ? entries[next].second : 0);
+                next += listed;
+            }
+        }
+
+        // Serializes a subtable; false if its class definitions lie beyond 16-bit offsets.
+        bool writePairPos(const PairPosSubtable& subtable, std::vector<uint8_t>& out) {
+            std::vector<uint16_t> coverageGlyphs(subtable.firstGlyphs.size());
+            std::vector<std::pair<uint16_t, uint16_t>> classDef1;
+            for (size_t i = 0; i < subtable.firstGlyphs.size(); ++i) {
+                coverageGlyphs[i] = subtable.firstGlyphs[i].first;
+                if (subtable.firstGlyphs[i].second != 0) {
+                    classDef1.push_back(subtable.firstGlyphs[i]);
+                }
+            }
+            std::vector<uint8_t> coverage, firstClasses, secondClasses;
+            writeCoverage(coverageGlyphs, coverage);
+            writeClassDef(classDef1, firstClasses);
+            writeClassDef(subtable.secondGlyphs, secondClasses);
+
+            const size_t coverageOffset = 16 + 2 * subtable.matrix.size();
+            const size_t classDef1Offset = coverageOffset + coverage.size();
+            const size_t classDef2Offset = classDef1Offset + firstClasses.size();
+            if (classDef2Offset > kMaxOffset) {
+                return false;
+            }
+
+            out.clear();
+            out.reserve(classDef2Offset + secondClasses.size());
+            appendU16(out, 2); // posFormat
+            appendU16(out, static_cast<uint16_t>(coverageOffset));
+            appendU16(out, kXAdvance); // valueFormat1
+            appendU16(out, 0);         // valueFormat2
+            appendU16(out, static_cast<uint16_t>(classDef1Offset));
+            appendU16(out, static_cast<uint16_t>(classDef2Offset));
+            appendU16(out, subtable.class1Count);
+            appendU16(out, subtable.class2Count);
+            for (int16_t value : subtable.matrix) {
+                appendU16(out, static_cast<uint16_t>(value));
+            }
+            out.insert(out.end(), coverage.begin(), coverage.end());
+            out.insert(out.end(), firstClasses.begin(), firstClasses.end());
+            out.insert(out.end(), secondClasses.begin(), secondClasses.end());
+            return true;
+        }
+
+        // GPOS with a DFLT script whose default language system has one 'kern' feature of one lookup.
+        void writeGpos(const std::vector<std::vector<uint8_t>>& subtables, std::vector<uint8_t>& out) {
+            const size_t count = subtables.size();
+            size_t directSize = 6 + 2 * count;
+            for (size_t i = 0; i + 1 < count; ++i) {
+                directSize += subtables[i].size();
+            }
+            // Without room for 16-bit offsets to every subtable, they go through Extension subtables
+            const bool extension = directSize > kMaxOffset;
+
+            out.clear();
+            appendU32(out, 0x00010000); // version 1.0
+            appendU16(out, 10);         // scriptListOffset
+            appendU16(out, 10 + 20);    // featureListOffset
+            appendU16(out, 10 + 20 + 14); // lookupListOffset
+
+            // ScriptList, Script and LangSys
+            appendU16(out, 1);
+            appendU32(out, TTFParser::Tag("DFLT").value);
+            appendU16(out, 8);      // Script offset
+            appendU16(out, 4);      // defaultLangSysOffset
+            appendU16(out, 0);      // langSysCount
+            appendU16(out, 0);      // lookupOrderOffset
+            appendU16(out, 0xFFFF); // requiredFeatureIndex
+            appendU16(out, 1);      // featureIndexCount
+            appendU16(out, 0);
+
+            // FeatureList and Feature
+            appendU16(out, 1);
+            appendU32(out, TTFParser::Tag("kern").value);
+            appendU16(out, 8);      // Feature offset
+            appendU16(out, 0);      // featureParamsOffset
+            appendU16(out, 1);      // lookupIndexCount
+            appendU16(out, 0);
+
+            // LookupList and Lookup
+            appendU16(out, 1);
+            appendU16(out, 4);
+            appendU16(out, extension ? kExtensionLookup : kPairPosLookup);
+            appendU16(out, kIgnoreMarks);
+            appendU16(out, static_cast<uint16_t>(count));
+            size_t offset = 6 + 2 * count + (extension ? 8 * count : 0);
+            for (size_t i = 0; i < count; ++i) {
+                if (extension) {
+                    appendU16(out, static_cast<uint16_t>(6 + 2 * count + 8 * i));
+                }
+                else {
+                    appendU16(out, static_cast<uint16_t>(offset));
+                    offset += subtables[i].size();
+                }
+            }
+            if (extension) {
+                for (size_t i = 0; i < count; ++i) {
+                    appendU16(out, 1); // posFormat
+                    appendU16(out, kPairPosLookup);
+                    appendU32(out, static_cast<uint32_t>(offset - (6 + 2 * count + 8 * i))); // From this Extension subtable
+                    offset += subtables[i].size();
+                }
+            }
+            for (const std::vector<uint8_t>& subtable : subtables) {
+                out.insert(out.end(), subtable.begin(), subtable.end());
+            }
+        }
+
+        // Size bound of a cluster's subtable, and the estimate that clustering minimizes.
+        inline size_t subtableBound(size_t rows, size_t columns, size_t firstGlyphs, size_t secondGlyphs) {
+            return kSubtableOverhead + 2 * rows * (columns + 1) + 8 * firstGlyphs + 6 * secondGlyphs;
+        }
+
+        inline size_t subtableEstimate(size_t rows, size_t columns, size_t firstGlyphs, size_t secondGlyphs) {
+            return kSubtableOverhead + 2 * rows * (columns + 1) + 4 * firstGlyphs + 2 * secondGlyphs;
+        }
+    } // namespace
+
+    bool compactKerning(TTFParser::TTFParser& parser, KernCompaction& out) {
+        out = KernCompaction();
+        const TTFParser::ByteView kernData = parser.getTableData("kern");
+        if (kernData.empty() || parser.getTableDirectory().contains("GPOS") ||
+            !parser.parseMaxpTable(parser.getTableData("maxp"))) {
+            return false;
+        }
+        out.kernBytes = kernData.size();
+
+        TTFParser::KernTable kern;
+        if (!parser.parseKernTable(kernData, kern)) {
+            return false;
+        }
+        for (const TTFParser::KernSubtable& subtable : kern.subtables) {
+            if (!TTFParser::KernIndex::isIndexed(subtable)) {
+                return false; // Vertical, cross-stream or minimum kerning has no exact GPOS equivalent here
+            }
+        }
+        TTFParser::KernIndex index;
+        index.build(kern);
+        const std::vector<uint32_t>& keys = index.getKeys();
+        const std::vector<int16_t>& values = index.getValues();
+        const uint32_t numGlyphs = parser.getNumGlyphs();
+        if (keys.empty() || (keys.back() >> 16) >= numGlyphs ||
+            std::any_of(keys.begin(), keys.end(), [&](uint32_t key) { return (key & 0xFFFF) >= numGlyphs; })) {
+            return false;
+        }
+        out.pairs = keys.size();
+
+        // Rows: the pairs of each first glyph are contiguous in the index
+        std::vector<uint16_t> firstGlyphs;
+        std::vector<uint32_t> rowStart;
+        for (uint32_t i = 0; i < keys.size(); ++i) {
+            if (i == 0 || (keys[i] >> 16) != (keys[i - 1] >> 16)) {
+                firstGlyphs.push_back(static_cast<uint16_t>(keys[i] >> 16));
+                rowStart.push_back(i);
+            }
+        }
+        rowStart.push_back(static_cast<uint32_t>(keys.size()));
+
+        // First classes: identical rows
+        std::vector<uint64_t> hashes(firstGlyphs.size());
+        for (size_t row = 0; row < firstGlyphs.size(); ++row) {
+            uint64_t hash = 14695981039346656037ull;
+            for (uint32_t i = rowStart[row]; i < rowStart[row + 1]; ++i) {
+                hash = hashMix(hashMix(hash, keys[i] & 0xFFFF), static_cast<uint16_t>(values[i]));
+            }
+            hashes[row] = hash;
+        }
+        std::vector<uint32_t> firstClassOfRow;
+        const uint32_t firstClassCount = groupIdentical(hashes, [&](uint32_t a, uint32_t b) {
+            const uint32_t length = rowStart[a + 1] - rowStart[a];
+            if (length != rowStart[b + 1] - rowStart[b]) {
+                return false;
+            }
+            for (uint32_t i = 0; i < length; ++i) {
+                if ((keys[rowStart[a] + i] & 0xFFFF) != (keys[rowStart[b] + i] & 0xFFFF) || values[rowStart[a] + i] != values[rowStart[b] + i]) {
+                    return false;
+                }
+            }
+            return true;
+        }, firstClassOfRow);
+
+        std::vector<FirstClass> firstClasses(firstClassCount);
+        std::vector<uint32_t> classRow(firstClassCount); // One row of each class
+        for (size_t row = 0; row < firstGlyphs.size(); ++row) {
+            if (firstClasses[firstClassOfRow[row]].glyphs.empty()) {
+                classRow[firstClassOfRow[row]] = static_cast<uint32_t>(row);
+            }
+            firstClasses[firstClassOfRow[row]].glyphs.push_back(firstGlyphs[row]);
+        }
+
+        // Second classes: identical columns over the first classes. Columns are built in first class
+        // order, so equal columns list the same cells in the same order.
+        std::vector<uint32_t> columnStart(numGlyphs + 1, 0);
+        for (uint32_t firstClass = 0; firstClass < firstClassCount; ++firstClass) {
+            for (uint32_t i = rowStart[classRow[firstClass]]; i < rowStart[classRow[firstClass] + 1]; ++i) {
+                ++columnStart[(keys[i] & 0xFFFF) + 1];
+            }
+        }
+        for (uint32_t glyph = 0; glyph < numGlyphs; ++glyph) {
+            columnStart[glyph + 1] += columnStart[glyph];
+        }
+        std::vector<std::pair<uint32_t, int16_t>> columnCells(columnStart[numGlyphs]);
+        std::vector<uint32_t> columnFill(columnStart.begin(), columnStart.end() - 1);
+        for (uint32_t firstClass = 0; firstClass < firstClassCount; ++firstClass) {
+            for (uint32_t i = rowStart[classRow[firstClass]]; i < rowStart[classRow[firstClass] + 1]; ++i) {
+                columnCells[columnFill[keys[i] & 0xFFFF]++] = std::make_pair(firstClass, values[i]);
+            }
+        }
+
+        std::vector<uint16_t> secondGlyphs;
+        for (uint32_t glyph = 0; glyph < numGlyphs; ++glyph) {
+            if (columnStart[glyph + 1] != columnStart[glyph]) {
+                secondGlyphs.push_back(static_cast<uint16_t>(glyph));
+            }
+        }
+        hashes.assign(secondGlyphs.size(), 0);
+        for (size_t i = 0; i < secondGlyphs.size(); ++i) {
+            uint64_t hash = 14695981039346656037ull;
+            for (uint32_t cell = columnStart[secondGlyphs[i]]; cell < columnStart[secondGlyphs[i] + 1]; ++cell) {
+                hash = hashMix(hashMix(hash, columnCells[cell].first), static_cast<uint16_t>(columnCells[cell].second));
+            }
+            hashes[i] = hash;
+        }
+        std::vector<uint32_t> secondClassOf;
+        const uint32_t secondClassCount = groupIdentical(hashes, [&](uint32_t a, uint32_t b) {
+            const uint32_t first = columnStart[secondGlyphs[a]], other = columnStart[secondGlyphs[b]];
+            const uint32_t length = columnStart[secondGlyphs[a] + 1] - first;
+            return length == columnStart[secondGlyphs[b] + 1] - other &&
+                std::equal(columnCells.begin() + first, columnCells.begin() + first + length, columnCells.begin() + other);
+        }, secondClassOf);
+
+        std::vector<std::vector<uint16_t>> secondClassGlyphs(secondClassCount);
+        std::vector<uint32_t> secondClassOfGlyph(numGlyphs, UINT32_MAX);
+        for (size_t i = 0; i < secondGlyphs.size(); ++i) {
+            secondClassGlyphs[secondClassOf[i]].push_back(secondGlyphs[i]);
+            secondClassOfGlyph[secondGlyphs[i]] = secondClassOf[i];
+        }
+        for (uint32_t firstClass = 0; firstClass < firstClassCount; ++firstClass) {
+            std::vector<std::pair<uint32_t, int16_t>>& cells = firstClasses[firstClass].cells;
+            for (uint32_t i = rowStart[classRow[firstClass]]; i < rowStart[classRow[firstClass] + 1]; ++i) {
+                cells.emplace_back(secondClassOfGlyph[keys[i] & 0xFFFF], values[i]);
+            }
+            // Every glyph of a second class kerns the same, so one cell per class remains
+            std::sort(cells.begin(), cells.end());
+            cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+        }
+
+        // Clusters: first classes go, widest rows first, wherever they grow the estimated size least
+        std::vector<uint32_t> order(firstClassCount);
+        for (uint32_t i = 0; i < firstClassCount; ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return firstClasses[a].cells.size() > firstClasses[b].cells.size();
+        });
+
+        std::vector<Cluster> clusters;
+        for (uint32_t firstClass : order) {
+            const FirstClass& candidate = firstClasses[firstClass];
+            size_t candidateGlyphs = 0;
+            for (const std::pair<uint32_t, int16_t>& cell : candidate.cells) {
+                candidateGlyphs += secondClassGlyphs[cell.first].size();
+            }
+            if (subtableBound(1, candidate.cells.size(), candidate.glyphs.size(), candidateGlyphs) > kMaxOffset) {
+                return false; // Too wide for any subtable
+            }
+
+            size_t bestCost = subtableEstimate(1, candidate.cells.size(), candidate.glyphs.size(), candidateGlyphs);
+            Cluster* best = nullptr;
+            for (Cluster& cluster : clusters) {
+                size_t newClasses = 0, newGlyphs = 0;
+                for (const std::pair<uint32_t, int16_t>& cell : candidate.cells) {
+                    if (!cluster.hasSecond[cell.first]) {
+                        ++newClasses;
+                        newGlyphs += secondClassGlyphs[cell.first].size();
+                    }
+                }
+                const size_t rows = cluster.firstClasses.size();
+                const size_t columns = cluster.secondClasses + newClasses;
+                const size_t firstCount = cluster.firstGlyphs + candidate.glyphs.size();
+                const size_t secondCount = cluster.secondGlyphs + newGlyphs;
+                if (subtableBound(rows + 1, columns, firstCount, secondCount) > kMaxOffset) {
+                    continue;
+                }
+                const size_t cost = subtableEstimate(rows + 1, columns, firstCount, secondCount) -
+                    subtableEstimate(rows, cluster.secondClasses, cluster.firstGlyphs, cluster.secondGlyphs);
+                if (cost <= bestCost) {
+                    bestCost = cost;
+                    best = &cluster;
+                }
+            }
+
+            if (!best) {
+                clusters.emplace_back();
+                best = &clusters.back();
+                best->hasSecond.assign(secondClassCount, false);
+            }
+            best->firstClasses.push_back(firstClass);
+            best->firstGlyphs += candidate.glyphs.size();
+            for (const std::pair<uint32_t, int16_t>& cell : candidate.cells) {
+                if (!best->hasSecond[cell.first]) {
+                    best->hasSecond[cell.first] = true;
+                    ++best->secondClasses;
+                    best->secondGlyphs += secondClassGlyphs[cell.first].size();
+                }
+            }
+        }
+
+        // Subtables: within a cluster, second classes whose columns agree on its rows merge too
+        std::vector<PairPosSubtable> subtables(clusters.size());
+        std::vector<int32_t> columnOf(secondClassCount, -1);
+        for (size_t c = 0; c < clusters.size(); ++c) {
+            Cluster& cluster = clusters[c];
+            PairPosSubtable& subtable = subtables[c];
+
+            // The class with the most glyphs becomes class 0, which the class definition leaves out
+            std::sort(cluster.firstClasses.begin(), cluster.firstClasses.end());
+            const auto widest = std::max_element(cluster.firstClasses.begin(), cluster.firstClasses.end(), [&](uint32_t a, uint32_t b) {
+                return firstClasses[a].glyphs.size() < firstClasses[b].glyphs.size();
+            });
+            std::rotate(cluster.firstClasses.begin(), widest, widest + 1);
+
+            std::vector<uint32_t> columns;
+            for (uint32_t secondClass = 0; secondClass < secondClassCount; ++secondClass) {
+                if (cluster.hasSecond[secondClass]) {
+                    columnOf[secondClass] = static_cast<int32_t>(columns.size());
+                    columns.push_back(secondClass);
+                }
+            }
+            const size_t rows = cluster.firstClasses.size();
+            std::vector<int16_t> signatures(columns.size() * rows, 0);
+            for (size_t row = 0; row < rows; ++row) {
+                for (const std::pair<uint32_t, int16_t>& cell : firstClasses[cluster.firstClasses[row]].cells) {
+                    signatures[columnOf[cell.first] * rows + row] = cell.second;
+                }
+            }
+            for (uint32_t secondClass : columns) {
+                columnOf[secondClass] = -1;
+            }
+
+            hashes.assign(columns.size(), 0);
+            for (size_t column = 0; column < columns.size(); ++column) {
+                uint64_t hash = 14695981039346656037ull;
+                for (size_t row = 0; row < rows; ++row) {
+                    hash = hashMix(hash, static_cast<uint16_t>(signatures[column * rows + row]));
+                }
+                hashes[column] = hash;
+            }
+            std::vector<uint32_t> localClassOf;
+            const uint32_t localClasses = groupIdentical(hashes, [&](uint32_t a, uint32_t b) {
+                return std::equal(signatures.begin() + a * rows, signatures.begin() + (a + 1) * rows, signatures.begin() + b * rows);
+            }, localClassOf);
+
+            subtable.class1Count = static_cast<uint16_t>(rows);
+            subtable.class2Count = static_cast<uint16_t>(localClasses + 1);
+            subtable.matrix.assign(rows * subtable.class2Count, 0);
+            for (size_t column = 0; column < columns.size(); ++column) {
+                const uint16_t secondClass = static_cast<uint16_t>(localClassOf[column] + 1);
+                for (size_t row = 0; row < rows; ++row) {
+                    subtable.matrix[row * subtable.class2Count + secondClass] = signatures[column * rows + row];
+                }
+                for (uint16_t glyph : secondClassGlyphs[columns[column]]) {
+                    subtable.secondGlyphs.emplace_back(glyph, secondClass);
+                }
+            }
+            for (size_t row = 0; row < rows; ++row) {
+                for (uint16_t glyph : firstClasses[cluster.firstClasses[row]].glyphs) {
+                    subtable.firstGlyphs.emplace_back(glyph, static_cast<uint16_t>(row));
+                }
+            }
+            std::sort(subtable.firstGlyphs.begin(), subtable.firstGlyphs.end());
+            std::sort(subtable.secondGlyphs.begin(), subtable.secondGlyphs.end());
+            out.firstClasses += subtable.class1Count;
+            out.secondClasses += subtable.class2Count;
+        }
+
+        // Check equivalence: every pair has its value, and per first glyph no other second glyph is kerned
+        std::vector<int32_t> subtableOf(numGlyphs, -1);
+        std::vector<uint16_t> firstClassOf(numGlyphs, 0);
+        for (size_t s = 0; s < subtables.size(); ++s) {
+            for (const std::pair<uint16_t, uint16_t>& entry : subtables[s].firstGlyphs) {
+                subtableOf[entry.first] = static_cast<int32_t>(s);
+                firstClassOf[entry.first] = entry.second;
+            }
+        }
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const uint16_t first = static_cast<uint16_t>(keys[i] >> 16), second = static_cast<uint16_t>(keys[i]);
+            if (subtableOf[first] < 0) {
+                return false;
+            }
+            const PairPosSubtable& subtable = subtables[subtableOf[first]];
+            const auto it = std::lower_bound(subtable.secondGlyphs.begin(), subtable.secondGlyphs.end(), std::make_pair(second, uint16_t(0)));
+            const uint16_t secondClass = (it != subtable.secondGlyphs.end() && it->first == second) ? it->second : 0;
+            if (subtable.matrix[size_t(firstClassOf[first]) * subtable.class2Count + secondClass] != values[i]) {
+                std::cerr << "Error: Kerning of glyphs " << first << " and " << second << " changed in GPOS." << std::endl;
+                return false;
+            }
+        }
+        for (const PairPosSubtable& subtable : subtables) {
+            std::vector<size_t> classGlyphs(subtable.class2Count, 0);
+            for (const std::pair<uint16_t, uint16_t>& entry : subtable.secondGlyphs) {
+                ++classGlyphs[entry.second];
+            }
+            for (size_t row = 0; row < subtable.class1Count; ++row) {
+                if (subtable.matrix[row * subtable.class2Count] != 0) {
+                    return false; // Unlisted second glyphs must stay unkerned
+                }
+            }
+            for (const std::pair<uint16_t, uint16_t>& entry : subtable.firstGlyphs) {
+                size_t kerned = 0;
+                for (size_t secondClass = 1; secondClass < subtable.class2Count; ++secondClass) {
+                    kerned += subtable.matrix[size_t(entry.second) * subtable.class2Count + secondClass] != 0 ? classGlyphs[secondClass] : 0;
+                }
+                const auto row = std::lower_bound(firstGlyphs.begin(), firstGlyphs.end(), entry.first) - firstGlyphs.begin();
+                if (kerned != rowStart[row + 1] - rowStart[row]) {
+                    std::cerr << "Error: Kerning of glyph " << entry.first << " changed in GPOS." << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        std::vector<std::vector<uint8_t>> serialized(subtables.size());
+        for (size_t s = 0; s < subtables.size(); ++s) {
+            if (!writePairPos(subtables[s], serialized[s])) {
+                return false;
+            }
+        }
+        writeGpos(serialized, out.gpos);
+        out.subtables = subtables.size();
+        return out.gpos.size() < out.kernBytes;
+    }
+
+} // namespace FontConverter
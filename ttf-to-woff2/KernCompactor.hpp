@@ -0,0 +1,41 @@
+#ifndef KERN_COMPACTOR_HPP
+#define KERN_COMPACTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "TTFParser.hpp"
+
+namespace FontConverter {
+
+    // A 'kern' table rewritten as GPOS, as produced by compactKerning.
+    struct KernCompaction {
+        std::vector<uint8_t> gpos;  // The GPOS table replacing 'kern'.
+        size_t kernBytes = 0;       // Size of the replaced 'kern' table.
+        size_t pairs = 0;           // Kerned pairs, after combining the 'kern' subtables.
+        size_t subtables = 0;       // PairPos format 2 subtables in the lookup.
+        size_t firstClasses = 0;    // Classes of first glyphs, over all subtables.
+        size_t secondClasses = 0;   // Classes of second glyphs, over all subtables.
+    };
+
+    /**
+     * @brief Rewrites the 'kern' table of a font as an equivalent, smaller GPOS 'kern' feature.
+     *
+     * First glyphs with identical kerning rows share a class, as do second glyphs with
+     * identical columns, and the class matrices are split over PairPos format 2 subtables so
+     * that sparse kerning does not pay for empty cells. The lookup ignores marks, as shaping
+     * engines do when applying 'kern'. Before returning, every pair of the 'kern' table is
+     * looked up in the result, and every other pair is checked to be unkerned.
+     *
+     * Only fonts without a GPOS table qualify, since a shaper would otherwise ignore their
+     * 'kern' table; and only horizontal format 0 kerning, which GPOS can express exactly.
+     *
+     * @param parser The loaded font.
+     * @param out Receives the GPOS table.
+     * @return true if out holds a GPOS table exactly equivalent to 'kern' and smaller than it.
+     */
+    bool compactKerning(TTFParser::TTFParser& parser, KernCompaction& out);
+
+} // namespace FontConverter
+
+#endif // KERN_COMPACTOR_HPP
@@ -0,0 +1,104 @@
+#include "KernIndex.hpp"
+#include <algorithm>
+
+namespace TTFParser {
+    namespace {
+        // Coverage bits of a version 0 'kern' subtable; the format is in the high byte
+        const uint16_t kKernHorizontal = 0x0001;
+        const uint16_t kKernMinimum = 0x0002;
+        const uint16_t kKernCrossStream = 0x0004;
+        const uint16_t kKernOverride = 0x0008;
+
+        struct PendingPair {
+            uint32_t key;
+            uint32_t order; // Subtable order, then pair order within it
+            int16_t value;
+            bool override;
+        };
+    } // namespace
+
+    void KernIndex::build(const KernTable& kern) {
+        keys.clear();
+        values.clear();
+        rowStart.clear();
+
+        std::vector<PendingPair> pending;
+        for (const KernSubtable& subtable : kern.subtables) {
+            if (!isIndexed(subtable)) {
+                continue;
+            }
+            const bool override = (subtable.coverage & kKernOverride) != 0;
+            for (const KerningPair& pair : subtable.kerningPairs) {
+                pending.push_back({ (uint32_t(pair.left) << 16) | pair.right, static_cast<uint32_t>(pending.size()), pair.value, override });
+            }
+        }
+        std::sort(pending.begin(), pending.end(), [](const PendingPair& a, const PendingPair& b) {
+            return a.key != b.key ? a.key < b.key : a.order < b.order;
+        });
+
+        // Fold every pair's entries in subtable order; pairs that end up at 0 need no entry
+        keys.reserve(pending.size());
+        values.reserve(pending.size());
+        for (size_t i = 0; i < pending.size();) {
+            const uint32_t key = pending[i].key;
+            int32_t value = 0;
+            for (; i < pending.size() && pending[i].key == key; ++i) {
+                value = pending[i].override ? pending[i].value : value + pending[i].value;
+            }
+            value = std::min<int32_t>(std::max<int32_t>(value, INT16_MIN), INT16_MAX);
+            if (value != 0) {
+                keys.push_back(key);
+                values.push_back(static_cast<int16_t>(value));
+            }
+        }
+        keys.shrink_to_fit();
+        values.shrink_to_fit();
+
+        if (keys.empty()) {
+            return;
+        }
+        const uint32_t rows = (keys.back() >> 16) + 1;
+        rowStart.assign(rows + 1, 0);
+        for (uint32_t key : keys) {
+            ++rowStart[(key >> 16) + 1];
+        }
+        for (uint32_t row = 0; row < rows; ++row) {
+            rowStart[row + 1] += rowStart[row];
+        }
+    }
+
+    bool KernIndex::isIndexed(const KernSubtable& subtable) {
+        return (subtable.coverage >> 8) == 0 &&
+            (subtable.coverage & (kKernHorizontal | kKernMinimum | kKernCrossStream)) == kKernHorizontal;
+    }
+
+    int16_t KernIndex::findInRow(uint32_t first, uint32_t last, uint32_t key) const {
+        // Branchless binary search: kerned text hits unpredictable rows, so avoid mispredicted branches
+        const uint32_t* base = keys.data() + first;
+        uint32_t length = last - first;
+        if (length == 0) {
+            return 0;
+        }
+        while (length > 1) {
+            const uint32_t half = length / 2;
+            base = (base[half] <= key) ? base + half : base;
+            length -= half;
+        }
+        return (*base == key) ? values[base - keys.data()] : 0;
+    }
+
+    void KernIndex::kernGlyphs(const uint16_t* glyphs, size_t count, int16_t* adjustments) const {
+        if (count == 0) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < count; ++i) {
+            adjustments[i] = getKerning(glyphs[i], glyphs[i + 1]);
+        }
+        adjustments[count - 1] = 0;
+    }
+
+    size_t KernIndex::getMemoryBytes() const {
+        return keys.size() * sizeof(uint32_t) + values.size() * sizeof(int16_t) + rowStart.size() * sizeof(uint32_t);
+    }
+
+} // namespace TTFParser
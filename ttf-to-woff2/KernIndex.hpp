@@ -0,0 +1,66 @@
+#ifndef KERN_INDEX_HPP
+#define KERN_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "TTFParser.hpp"
+
+namespace TTFParser {
+
+    /**
+    * @class KernIndex
+    * @brief Fast glyph pair kerning lookup over the format 0 subtables of a 'kern' table.
+    *
+    * Pairs are packed into 32-bit keys (left glyph in the high half) and stored sorted, with
+    * their values in a parallel array. A per-left-glyph row index narrows each lookup to the
+    * pairs of one left glyph, so a lookup is a short binary search within a few cache lines.
+    *
+    * Only horizontal, non-minimum, non-cross-stream subtables apply. Values of subtables that
+    * kern the same pair add up, unless a later subtable has the override bit set.
+    */
+    class KernIndex {
+    public:
+        // Builds the index from a parsed table (see TTFParser::parseKernTable).
+        void build(const KernTable& kern);
+
+        // True for the subtables the index uses: format 0, horizontal, neither minimum nor cross-stream.
+        static bool isIndexed(const KernSubtable& subtable);
+
+        // Kerning between two glyphs in font units, or 0 if the pair is not kerned.
+        int16_t getKerning(uint16_t left, uint16_t right) const {
+            if (size_t(left) + 1 >= rowStart.size()) {
+                return 0;
+            }
+            return findInRow(rowStart[left], rowStart[left + 1], (uint32_t(left) << 16) | right);
+        }
+
+        /**
+         * @brief Kerns a glyph run.
+         * @param glyphs The glyphs, in logical order.
+         * @param count Number of glyphs.
+         * @param adjustments Receives `count` values: the kerning between glyph i and i + 1, and 0 last.
+         */
+        void kernGlyphs(const uint16_t* glyphs, size_t count, int16_t* adjustments) const;
+
+        // Kerned pairs as (left << 16) | right keys, sorted, and their values.
+        const std::vector<uint32_t>& getKeys() const { return keys; }
+        const std::vector<int16_t>& getValues() const { return values; }
+
+        size_t getPairCount() const { return keys.size(); }
+        bool empty() const { return keys.empty(); }
+
+        // Bytes used by the index.
+        size_t getMemoryBytes() const;
+
+    private:
+        int16_t findInRow(uint32_t first, uint32_t last, uint32_t key) const;
+
+        std::vector<uint32_t> keys;     // (left << 16) | right, sorted.
+        std::vector<int16_t> values;    // Kerning of keys[i].
+        std::vector<uint32_t> rowStart; // Index of the first key of each left glyph, plus an end entry.
+    };
+
+} // namespace TTFParser
+
+#endif // KERN_INDEX_HPP
@@ -0,0 +1,206 @@
+#include "OutlineResolver.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace TTFParser {
+    namespace {
+        inline int16_t clampToInt16(double value) {
+            const double rounded = std::floor(value + 0.5);
+            return static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, rounded)));
+        }
+
+        void computeBounds(FlatOutline& outline) {
+            if (outline.empty()) {
+                outline.xMin = outline.yMin = outline.xMax = outline.yMax = 0;
+                return;
+            }
+
+            const auto xRange = std::minmax_element(outline.xCoordinates.begin(), outline.xCoordinates.end());
+            const auto yRange = std::minmax_element(outline.yCoordinates.begin(), outline.yCoordinates.end());
+            outline.xMin = *xRange.first;
+            outline.xMax = *xRange.second;
+            outline.yMin = *yRange.first;
+            outline.yMax = *yRange.second;
+        }
+    } // namespace
+
+    OutlineResolver::OutlineResolver(const GlyfTable& glyf, size_t maxDepth)
+        : glyf(glyf), maxDepth(maxDepth), states(glyf.glyphs.size(), State::Unresolved), outlines(glyf.glyphs.size()),
+        nestings(glyf.glyphs.size(), 0) {
+    }
+
+    const FlatOutline* OutlineResolver::resolve(uint16_t glyphIndex) {
+        const Result result = resolveGlyph(glyphIndex, 0);
+        if (result == Result::TooDeep) {
+            // Too deep from the top means the glyph itself nests too deeply
+            std::cerr << "Error: Compound glyph " << glyphIndex << " is nested more than " << maxDepth << " levels deep." << std::endl;
+            states[glyphIndex] = State::Failed;
+        }
+        if (result != Result::Resolved) {
+            return nullptr;
+        }
+        return &outlines[glyphIndex];
+    }
+
+    void OutlineResolver::clear() {
+        std::fill(states.begin(), states.end(), State::Unresolved);
+        for (FlatOutline& outline : outlines) {
+            outline = FlatOutline();
+        }
+        resolvedCount = 0;
+    }
+
+    OutlineResolver::Result OutlineResolver::resolveGlyph(uint16_t glyphIndex, size_t depth) {
+        if (glyphIndex >= states.size()) {
+            std::cerr << "Error: Component glyph index " << glyphIndex << " is out of range." << std::endl;
+            return Result::Failed;
+        }
+
+        switch (states[glyphIndex]) {
+        case State::Resolved:
+            return Result::Resolved;
+        case State::Failed:
+            return Result::Failed;
+        case State::InProgress:
+            std::cerr << "Error: Compound glyph " << glyphIndex << " contains itself." << std::endl;
+            return Result::Failed;
+        case State::Unresolved:
+            break;
+        }
+
+        if (depth > maxDepth) {
+            return Result::TooDeep; // The glyph at the top nests too deeply; this one may still resolve on its own
+        }
+
+        const GlyphRecord& record = glyf.glyphs[glyphIndex];
+        FlatOutline outline;
+        size_t nesting = 0;
+        Result result = Result::Resolved;
+
+        if (record.numberOfContours > 0) {
+            flattenSimple(record, outline);
+        }
+        else if (record.numberOfContours < 0) {
+            states[glyphIndex] = State::InProgress;
+            result = flattenCompound(glyphIndex, record, depth, outline, nesting);
+            if (result == Result::Resolved && nesting > maxDepth) {
+                std::cerr << "Error: Compound glyph " << glyphIndex << " is nested more than " << maxDepth << " levels deep." << std::endl;
+                result = Result::Failed;
+            }
+        }
+
+        if (result != Result::Resolved) {
+            // Only failures of the glyph itself are cached; TooDeep depends on the path it was reached by
+            states[glyphIndex] = result == Result::Failed ? State::Failed : State::Unresolved;
+            return result;
+        }
+
+        computeBounds(outline);
+        outlines[glyphIndex] = std::move(outline);
+        nestings[glyphIndex] = nesting;
+        states[glyphIndex] = State::Resolved;
+        ++resolvedCount;
+        return Result::Resolved;
+    }
+
+    void OutlineResolver::flattenSimple(const GlyphRecord& record, FlatOutline& outline) const {
+        const auto contours = glyf.endPointOfContours.begin() + record.firstContour;
+        outline.endPointOfContours.assign(contours, contours + record.numberOfContours);
+
+        const auto xs = glyf.xCoordinates.begin() + record.firstPoint;
+        const auto ys = glyf.yCoordinates.begin() + record.firstPoint;
+        outline.xCoordinates.assign(xs, xs + record.numPoints);
+        outline.yCoordinates.assign(ys, ys + record.numPoints);
+
+        outline.onCurve.resize(record.numPoints);
+        for (uint32_t i = 0; i < record.numPoints; ++i) {
+            outline.onCurve[i] = glyf.isOnCurve(record.firstPoint + i) ? 1 : 0;
+        }
+    }
+
+    OutlineResolver::Result OutlineResolver::flattenCompound(uint16_t glyphIndex, const GlyphRecord& record, size_t depth,
+        FlatOutline& outline, size_t& nesting) {
+        nesting = 1;
+        for (uint32_t c = 0; c < record.numComponents; ++c) {
+            const CompoundComponent& component = glyf.components[record.firstComponent + c];
+
+            const Result result = resolveGlyph(component.glyphIndex, depth + 1);
+            if (result == Result::TooDeep) {
+                return result;
+            }
+            if (result != Result::Resolved) {
+                std::cerr << "Error: Failed to resolve component " << c << " of compound glyph " << glyphIndex << "." << std::endl;
+                return result;
+            }
+            nesting = std::max(nesting, nestings[component.glyphIndex] + 1);
+
+            // Note: `outlines` never reallocates, so the child reference stays valid while we append
+            const FlatOutline& child = outlines[component.glyphIndex];
+            const size_t base = outline.numPoints();
+            if (base + child.numPoints() > 0xFFFF) {
+                std::cerr << "Error: Compound glyph " << glyphIndex << " has too many points." << std::endl;
+                return Result::Failed;
+            }
+
+            for (uint16_t endPoint : child.endPointOfContours) {
+                outline.endPointOfContours.push_back(static_cast<uint16_t>(base + endPoint));
+            }
+            outline.onCurve.insert(outline.onCurve.end(), child.onCurve.begin(), child.onCurve.end());
+
+            // Transform the component's points
+            const double xScale = component.xScale / 16384.0;
+            const double scale01 = component.scale01 / 16384.0;
+            const double scale10 = component.scale10 / 16384.0;
+            const double yScale = component.yScale / 16384.0;
+            const bool transformed = component.hasTransform();
+
+            outline.xCoordinates.resize(base + child.numPoints());
+            outline.yCoordinates.resize(base + child.numPoints());
+            for (size_t i = 0; i < child.numPoints(); ++i) {
+                const int16_t x = child.xCoordinates[i];
+                const int16_t y = child.yCoordinates[i];
+                outline.xCoordinates[base + i] = transformed ? clampToInt16(xScale * x + scale10 * y) : x;
+                outline.yCoordinates[base + i] = transformed ? clampToInt16(scale01 * x + yScale * y) : y;
+            }
+
+            // Work out the offset: either given directly or by matching a parent point to a child point
+            int32_t dx = 0;
+            int32_t dy = 0;
+            if (component.flags & TTFParser::ARGS_ARE_XY_VALUES) {
+                dx = component.arg1;
+                dy = component.arg2;
+
+                const bool scaledOffset = (component.flags & TTFParser::SCALED_COMPONENT_OFFSET) &&
+                    !(component.flags & TTFParser::UNSCALED_COMPONENT_OFFSET);
+                if (scaledOffset && transformed) {
+                    const double ox = dx;
+                    const double oy = dy;
+                    dx = clampToInt16(xScale * ox + scale10 * oy);
+                    dy = clampToInt16(scale01 * ox + yScale * oy);
+                }
+            }
+            else {
+                const size_t parentPoint = static_cast<uint32_t>(component.arg1);
+                const size_t childPoint = static_cast<uint32_t>(component.arg2);
+                if (parentPoint >= base || childPoint >= child.numPoints()) {
+                    std::cerr << "Error: Point-matching arguments of compound glyph " << glyphIndex << " are out of range." << std::endl;
+                    return Result::Failed;
+                }
+
+                dx = outline.xCoordinates[parentPoint] - outline.xCoordinates[base + childPoint];
+                dy = outline.yCoordinates[parentPoint] - outline.yCoordinates[base + childPoint];
+            }
+
+            if (dx != 0 || dy != 0) {
+                for (size_t i = base; i < outline.numPoints(); ++i) {
+                    outline.xCoordinates[i] = clampToInt16(double(outline.xCoordinates[i]) + dx);
+                    outline.yCoordinates[i] = clampToInt16(double(outline.yCoordinates[i]) + dy);
+                }
+            }
+        }
+
+        return Result::Resolved;
+    }
+
+} // namespace TTFParser
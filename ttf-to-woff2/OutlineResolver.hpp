@@ -0,0 +1,88 @@
+#ifndef OUTLINE_RESOLVER_HPP
+#define OUTLINE_RESOLVER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "TTFParser.hpp"
+
+namespace TTFParser {
+
+    // A glyph outline in absolute font units, with every compound glyph flattened into points.
+    struct FlatOutline {
+        std::vector<uint16_t> endPointOfContours; // Endpoints for each contour.
+        std::vector<int16_t> xCoordinates;        // X-coordinate of each point.
+        std::vector<int16_t> yCoordinates;        // Y-coordinate of each point.
+        std::vector<uint8_t> onCurve;             // 1 if the point is on the curve, 0 if off.
+        int16_t xMin = 0, yMin = 0;               // Bounding box computed from the points
+        int16_t xMax = 0, yMax = 0;               // (all zero for an empty outline).
+
+        size_t numPoints() const { return xCoordinates.size(); }
+        bool empty() const { return xCoordinates.empty(); }
+    };
+
+    /**
+    * @class OutlineResolver
+    * @brief Flattens glyphs of a GlyfTable into absolute outlines, resolving compound glyphs recursively.
+    *
+    * Each glyph is resolved at most once and cached, so components shared by many compound
+    * glyphs (accent bases, for example) are only transformed once per use rather than
+    * re-resolved. Component cycles, excessive nesting, out-of-range glyph indices and bad
+    * point-matching arguments make the affected glyphs fail to resolve. Nesting is measured
+    * per glyph (its longest chain of components), so whether a glyph resolves does not depend
+    * on which glyphs were resolved before it.
+    *
+    * A resolver is not thread-safe; use one per thread.
+    */
+    class OutlineResolver {
+    public:
+        static const size_t kDefaultMaxDepth = 16; // Real fonts rarely nest more than a few levels.
+
+        /**
+         * @param glyf Decoded glyphs; must outlive the resolver.
+         * @param maxDepth Maximum nesting of compound glyphs: a compound glyph of simple glyphs has depth 1.
+         */
+        explicit OutlineResolver(const GlyfTable& glyf, size_t maxDepth = kDefaultMaxDepth);
+
+        /**
+         * @brief Returns the flattened outline of a glyph.
+         * @return Pointer to the cached outline (valid until clear() or destruction), or nullptr
+         *         if the glyph could not be resolved.
+         */
+        const FlatOutline* resolve(uint16_t glyphIndex);
+
+        // Drops all cached outlines.
+        void clear();
+
+        // Number of glyphs currently resolved and cached.
+        size_t cachedCount() const { return resolvedCount; }
+
+    private:
+        enum class State : uint8_t {
+            Unresolved,
+            InProgress, // On the current resolution path; seeing it again means a cycle.
+            Resolved,
+            Failed
+        };
+
+        enum class Result {
+            Resolved,
+            Failed,
+            TooDeep // Reached below maxDepth on the current path; says nothing about the glyph itself.
+        };
+
+        Result resolveGlyph(uint16_t glyphIndex, size_t depth);
+        void flattenSimple(const GlyphRecord& record, FlatOutline& outline) const;
+        Result flattenCompound(uint16_t glyphIndex, const GlyphRecord& record, size_t depth, FlatOutline& outline, size_t& nesting);
+
+        const GlyfTable& glyf;
+        size_t maxDepth;
+        std::vector<State> states;          // Per glyph.
+        std::vector<FlatOutline> outlines;  // Per glyph; filled when Resolved.
+        std::vector<size_t> nestings;       // Per glyph; its compound nesting depth, when Resolved.
+        size_t resolvedCount = 0;
+    };
+
+} // namespace TTFParser
+
+#endif // OUTLINE_RESOLVER_HPP
@@ -0,0 +1,175 @@
+#include "OutputSink.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace WOFF2Builder {
+    namespace {
+        // Writes everything, retrying short writes and interrupted calls.
+        bool writeAll(int fd, const uint8_t* data, size_t size) {
+            while (size > 0) {
+#ifdef _WIN32
+                const int chunk = static_cast<int>(std::min<size_t>(size, 1u << 30));
+                const int written = _write(fd, data, static_cast<unsigned int>(chunk));
+#else
+                const ssize_t written = ::write(fd, data, size);
+#endif
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+    } // namespace
+
+    bool VectorSink::write(const uint8_t* data, size_t size) {
+        out.insert(out.end(), data, data + size);
+        return true;
+    }
+
+    bool VectorSink::patch(size_t offset, const uint8_t* data, size_t size) {
+        if (offset > out.size() || size > out.size() - offset) {
+            return false;
+        }
+        std::memcpy(out.data() + offset, data, size);
+        return true;
+    }
+
+    FileDescriptorSink::FileDescriptorSink(int fd, bool closeWhenDone) : fd(fd), closeWhenDone(closeWhenDone) {
+#ifdef _WIN32
+        startOffset = _lseeki64(fd, 0, SEEK_CUR);
+#else
+        startOffset = lseek(fd, 0, SEEK_CUR); // Fails with ESPIPE on pipes and sockets
+#endif
+        if (startOffset < 0) {
+            startOffset = -1;
+        }
+    }
+
+    FileDescriptorSink::~FileDescriptorSink() {
+        if (closeWhenDone && fd >= 0) {
+#ifdef _WIN32
+            _close(fd);
+#else
+            close(fd);
+#endif
+        }
+    }
+
+    int FileDescriptorSink::openFile(const char* path) {
+#ifdef _WIN32
+        int fd = -1;
+        _sopen_s(&fd, path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _SH_DENYWR, _S_IREAD | _S_IWRITE);
+#else
+        const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        if (fd < 0) {
+            std::cerr << "Error: Failed to open output file: " << path << std::endl;
+        }
+        return fd;
+    }
+
+    bool FileDescriptorSink::write(const uint8_t* data, size_t size) {
+        return writeAll(fd, data, size);
+    }
+
+    bool FileDescriptorSink::patch(size_t offset, const uint8_t* data, size_t size) {
+        if (startOffset < 0) {
+            return false;
+        }
+#ifdef _WIN32
+        // No positioned write: seek back, write, then return to the end
+        const int64_t end = _lseeki64(fd, 0, SEEK_CUR);
+        if (end < 0 || _lseeki64(fd, startOffset + static_cast<int64_t>(offset), SEEK_SET) < 0) {
+            return false;
+        }
+        const bool written = writeAll(fd, data, size);
+        return _lseeki64(fd, end, SEEK_SET) >= 0 && written;
+#else
+        while (size > 0) {
+            const ssize_t written = pwrite(fd, data, size, static_cast<off_t>(startOffset + offset));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<size_t>(written);
+        }
+        return true;
+#endif
+    }
+
+    RingBufferSink::RingBufferSink(size_t capacity) : buffer(std::max<size_t>(capacity, 1)) {
+    }
+
+    bool RingBufferSink::write(const uint8_t* data, size_t size) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (size > 0) {
+            notFull.wait(lock, [this] { return count < buffer.size() || cancelled; });
+            if (cancelled || finished) {
+                return false;
+            }
+
+            // Copy as much as fits before the wrap-around point
+            const size_t tail = (head + count) % buffer.size();
+            const size_t chunk = std::min(size, std::min(buffer.size() - count, buffer.size() - tail));
+            std::memcpy(buffer.data() + tail, data, chunk);
+            count += chunk;
+            data += chunk;
+            size -= chunk;
+            notEmpty.notify_one();
+        }
+        return true;
+    }
+
+    bool RingBufferSink::finish(bool succeeded) {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        success = succeeded && !cancelled;
+        notEmpty.notify_all();
+        return success;
+    }
+
+    size_t RingBufferSink::read(uint8_t* data, size_t maxSize) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return count > 0 || finished; });
+
+        const size_t chunk = std::min(maxSize, std::min(count, buffer.size() - head));
+        std::memcpy(data, buffer.data() + head, chunk);
+        head = (head + chunk) % buffer.size();
+        count -= chunk;
+        notFull.notify_one();
+        return chunk;
+    }
+
+    bool RingBufferSink::succeeded() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return finished && success;
+    }
+
+    void RingBufferSink::cancel() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+        notFull.notify_all();
+    }
+
+} // namespace WOFF2Builder
@@ -0,0 +1,145 @@
+#ifndef OUTPUT_SINK_HPP
+#define OUTPUT_SINK_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace WOFF2Builder {
+
+    /**
+    * @class OutputSink
+    * @brief Destination of an encoded font, written front to back.
+    *
+    * Sinks that can overwrite bytes they have already received (canPatch) let WOFF2Builder
+    * stream compressed data as Brotli produces it and fix up the header at the end. Other
+    * sinks get the whole file in order once the compressed size is known.
+    */
+    class OutputSink {
+    public:
+        virtual ~OutputSink() = default;
+
+        // Appends bytes. Returns false if they could not be written.
+        virtual bool write(const uint8_t* data, size_t size) = 0;
+
+        // Whether patch() is supported.
+        virtual bool canPatch() const { return false; }
+
+        // Overwrites bytes at `offset` from the start of the output, inside what was already written.
+        virtual bool patch(size_t /*offset*/, const uint8_t* /*data*/, size_t /*size*/) { return false; }
+
+        /**
+         * @brief Called once after the last write.
+         * @param success false if the output is incomplete and should be discarded.
+         * @return false if the output could not be completed.
+         */
+        virtual bool finish(bool success) { return success; }
+    };
+
+    // Collects the output in a vector (replacing its contents).
+    class VectorSink : public OutputSink {
+    public:
+        explicit VectorSink(std::vector<uint8_t>& out) : out(out) { out.clear(); }
+
+        bool write(const uint8_t* data, size_t size) override;
+        bool canPatch() const override { return true; }
+        bool patch(size_t offset, const uint8_t* data, size_t size) override;
+
+    private:
+        std::vector<uint8_t>& out;
+    };
+
+    /**
+    * @class FileDescriptorSink
+    * @brief Writes to a file descriptor: a file, pipe or socket.
+    *
+    * Patching is supported when the descriptor is seekable (regular files); offsets are
+    * relative to the descriptor's position when the sink was created.
+    */
+    class FileDescriptorSink : public OutputSink {
+    public:
+        /**
+         * @param fd An open, writable descriptor.
+         * @param closeWhenDone Close the descriptor in the destructor.
+         */
+        explicit FileDescriptorSink(int fd, bool closeWhenDone = false);
+        ~FileDescriptorSink() override;
+
+        FileDescriptorSink(const FileDescriptorSink&) = delete;
+        FileDescriptorSink& operator=(const FileDescriptorSink&) = delete;
+
+        /**
+         * @brief Creates (or truncates) a file and returns its descriptor.
+         * @return The descriptor, or -1 if the file could not be opened.
+         */
+        static int openFile(const char* path);
+
+        bool write(const uint8_t* data, size_t size) override;
+        bool canPatch() const override { return startOffset >= 0; }
+        bool patch(size_t offset, const uint8_t* data, size_t size) override;
+
+    private:
+        int fd;
+        bool closeWhenDone;
+        int64_t startOffset; // Position at creation, or -1 if the descriptor cannot seek.
+    };
+
+    // Hands every chunk of output to a callback as soon as it is produced.
+    class CallbackSink : public OutputSink {
+    public:
+        // The callback returns false to abort the conversion.
+        typedef std::function<bool(const uint8_t* data, size_t size)> Callback;
+
+        explicit CallbackSink(Callback callback) : callback(std::move(callback)) {}
+
+        bool write(const uint8_t* data, size_t size) override { return callback(data, size); }
+
+    private:
+        Callback callback;
+    };
+
+    /**
+    * @class RingBufferSink
+    * @brief A fixed-size buffer between the converter and a consumer thread.
+    *
+    * The converter blocks while the buffer is full and the consumer blocks in read() while it
+    * is empty, so memory stays bounded however large the font is. Meant for one producer and
+    * one consumer.
+    */
+    class RingBufferSink : public OutputSink {
+    public:
+        explicit RingBufferSink(size_t capacity = 64 * 1024);
+
+        bool write(const uint8_t* data, size_t size) override;
+        bool finish(bool success) override;
+
+        /**
+         * @brief Takes up to `maxSize` bytes out of the buffer, waiting until some are available.
+         * @return Number of bytes read; 0 once the output is finished and fully read.
+         */
+        size_t read(uint8_t* data, size_t maxSize);
+
+        // After read() returned 0: whether the producer finished successfully.
+        bool succeeded() const;
+
+        // Makes further writes fail, e.g. when the consumer gives up.
+        void cancel();
+
+    private:
+        std::vector<uint8_t> buffer;
+        size_t head = 0;  // Next byte to read.
+        size_t count = 0; // Bytes stored.
+        bool finished = false;
+        bool success = false;
+        bool cancelled = false;
+        mutable std::mutex mutex;
+        std::condition_variable notFull;
+        std::condition_variable notEmpty;
+    };
+
+} // namespace WOFF2Builder
+
+#endif // OUTPUT_SINK_HPP
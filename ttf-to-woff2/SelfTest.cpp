@@ -0,0 +1,258 @@
+#include "SelfTest.hpp"
+#include "OutlineResolver.hpp"
+#include "TTFParser.hpp"
+#include "ThreadPool.hpp"
+#include "WOFF2Encoding.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace FontConverter {
+    using WOFF2Builder::appendU16;
+    typedef TTFParser::TTFParser Parser;
+
+    namespace {
+        const size_t kConcurrentRounds = 4; // Times each font is parsed in the concurrent phase.
+
+        // The parsed tables the self-test compares.
+        struct ParsedFont {
+            TTFParser::LocaTable loca;
+            std::vector<TTFParser::GlyphMetrics> metrics;
+            TTFParser::GlyfTable glyf;
+        };
+
+        // Parses a font's glyphs (and metrics, if it has them), decoding 'glyf' on `pool` if there is one.
+        bool parseFont(const std::string& path, TTFParser::ThreadPool* pool, ParsedFont& font) {
+            TTFParser::TTFParser parser;
+            if (!parser.loadFromFile(path) || !parser.parseHeadTable(parser.getTableData("head")) ||
+                !parser.parseMaxpTable(parser.getTableData("maxp")) ||
+                !parser.parseLocaTable(parser.getTableData("loca"), font.loca) ||
+                !parser.parseGlyfTable(parser.getTableData("glyf"), font.loca, font.glyf, pool)) {
+                return false;
+            }
+
+            const TTFParser::ByteView hheaData = parser.getTableData("hhea");
+            const TTFParser::ByteView hmtxData = parser.getTableData("hmtx");
+            if (hheaData.empty() || hmtxData.empty()) {
+                return true;
+            }
+            TTFParser::HheaTable hhea{};
+            return parser.parseHheaTable(hheaData, hhea) &&
+                parser.parseHmtxTable(hmtxData, hhea.numOfLongHorMetrics, font.metrics);
+        }
+
+        bool sameMetrics(const TTFParser::GlyphMetrics& a, const TTFParser::GlyphMetrics& b) {
+            return a.advanceWidth == b.advanceWidth && a.lsb == b.lsb;
+        }
+
+        bool sameRecord(const TTFParser::GlyphRecord& a, const TTFParser::GlyphRecord& b) {
+            return a.numberOfContours == b.numberOfContours && a.xMin == b.xMin && a.yMin == b.yMin &&
+                a.xMax == b.xMax && a.yMax == b.yMax && a.overlapSimple == b.overlapSimple &&
+                a.firstContour == b.firstContour && a.firstPoint == b.firstPoint && a.numPoints == b.numPoints &&
+                a.firstInstruction == b.firstInstruction && a.instructionLength == b.instructionLength &&
+                a.firstComponent == b.firstComponent && a.numComponents == b.numComponents;
+        }
+
+        bool sameComponent(const TTFParser::CompoundComponent& a, const TTFParser::CompoundComponent& b) {
+            return a.flags == b.flags && a.glyphIndex == b.glyphIndex && a.arg1 == b.arg1 && a.arg2 == b.arg2 &&
+                a.xScale == b.xScale && a.scale01 == b.scale01 && a.scale10 == b.scale10 && a.yScale == b.yScale;
+        }
+
+        // Name of the first part that differs between two parses of a font, or nullptr if they are equal.
+        const char* firstDifference(const ParsedFont& a, const ParsedFont& b) {
+            if (a.loca.offsets != b.loca.offsets) {
+                return "loca offsets";
+            }
+            if (!std::equal(a.metrics.begin(), a.metrics.end(), b.metrics.begin(), b.metrics.end(), sameMetrics)) {
+                return "hmtx metrics";
+            }
+            if (!std::equal(a.glyf.glyphs.begin(), a.glyf.glyphs.end(), b.glyf.glyphs.begin(), b.glyf.glyphs.end(), sameRecord)) {
+                return "glyph records";
+            }
+            if (a.glyf.endPointOfContours != b.glyf.endPointOfContours) {
+                return "contour end points";
+            }
+            if (a.glyf.xCoordinates != b.glyf.xCoordinates || a.glyf.yCoordinates != b.glyf.yCoordinates) {
+                return "coordinates";
+            }
+            if (a.glyf.onCurve != b.glyf.onCurve) {
+                return "on-curve flags";
+            }
+            if (a.glyf.instructions != b.glyf.instructions) {
+                return "instructions";
+            }
+            if (!std::equal(a.glyf.components.begin(), a.glyf.components.end(),
+                b.glyf.components.begin(), b.glyf.components.end(), sameComponent)) {
+                return "components";
+            }
+            return nullptr;
+        }
+
+        // Appends a simple glyph of one contour of on-curve points, each `dx`, `dy` units from the previous one.
+        void appendSimpleGlyph(std::vector<uint8_t>& glyf, uint16_t points, uint8_t dx, uint8_t dy) {
+            const uint8_t kShortPositiveOnCurve = 0x37; // ON_CURVE_POINT, X/Y_SHORT_VECTOR and both positive
+            appendU16(glyf, 1);                         // numberOfContours
+            for (int i = 0; i < 4; ++i) {
+                appendU16(glyf, 0);                     // Bounding box, not checked
+            }
+            appendU16(glyf, static_cast<uint16_t>(points - 1));
+            appendU16(glyf, 0);                         // instructionLength
+            glyf.insert(glyf.end(), points, kShortPositiveOnCurve);
+            glyf.insert(glyf.end(), points, dx);
+            glyf.insert(glyf.end(), points, dy);
+        }
+
+        // Byte point numbers are unsigned: a component placed by matching parent point 129 must
+        // land on that point rather than fail on a sign-extended -127.
+        bool checkPointMatching() {
+            std::vector<uint8_t> glyf;
+            TTFParser::LocaTable loca;
+            loca.offsets.push_back(0);
+            appendSimpleGlyph(glyf, 130, 1, 2); // Glyph 0: point i at (i + 1, 2i + 2)
+            loca.offsets.push_back(static_cast<uint32_t>(glyf.size()));
+            appendSimpleGlyph(glyf, 1, 5, 7);   // Glyph 1: one point at (5, 7)
+            loca.offsets.push_back(static_cast<uint32_t>(glyf.size()));
+
+            // Glyph 2: glyph 0 as is, then glyph 1 with its point 0 on glyph 0's point 129
+            appendU16(glyf, static_cast<uint16_t>(-1));
+            for (int i = 0; i < 4; ++i) {
+                appendU16(glyf, 0);
+            }
+            appendU16(glyf, Parser::ARGS_ARE_XY_VALUES | Parser::MORE_COMPONENTS);
+            appendU16(glyf, 0);
+            glyf.push_back(0);
+            glyf.push_back(0);
+            appendU16(glyf, 0);
+            appendU16(glyf, 1);
+            glyf.push_back(129);
+            glyf.push_back(0);
+            loca.offsets.push_back(static_cast<uint32_t>(glyf.size()));
+
+            Parser parser;
+            TTFParser::GlyfTable table;
+            if (!parser.parseGlyfTable(TTFParser::ByteView(glyf.data(), glyf.size()), loca, table) ||
+                table.components.size() != 2 || table.components[1].arg1 != 129) {
+                std::cerr << "Mismatch: point number 129 of a compound glyph component was not decoded as 129." << std::endl;
+                return false;
+            }
+            TTFParser::OutlineResolver resolver(table);
+            const TTFParser::FlatOutline* outline = resolver.resolve(2);
+            if (!outline || outline->numPoints() != 131 || outline->xCoordinates[130] != 130 || outline->yCoordinates[130] != 260) {
+                std::cerr << "Mismatch: a component placed on point 129 of its parent did not land on it." << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // Whether a glyph is nested too deeply must not depend on the glyphs resolved before it.
+        bool checkNestingLimit() {
+            // Glyph 0 is a single point; glyph i (1-5) is a compound glyph of glyph i - 1, so it nests i levels
+            std::vector<uint8_t> glyf;
+            TTFParser::LocaTable loca;
+            loca.offsets.push_back(0);
+            appendSimpleGlyph(glyf, 1, 5, 7);
+            for (uint16_t glyph = 1; glyph <= 5; ++glyph) {
+                loca.offsets.push_back(static_cast<uint32_t>(glyf.size()));
+                appendU16(glyf, static_cast<uint16_t>(-1));
+                for (int i = 0; i < 4; ++i) {
+                    appendU16(glyf, 0);
+                }
+                appendU16(glyf, Parser::ARGS_ARE_XY_VALUES);
+                appendU16(glyf, static_cast<uint16_t>(glyph - 1));
+                glyf.push_back(0);
+                glyf.push_back(0);
+            }
+            loca.offsets.push_back(static_cast<uint32_t>(glyf.size()));
+
+            Parser parser;
+            TTFParser::GlyfTable table;
+            if (!parser.parseGlyfTable(TTFParser::ByteView(glyf.data(), glyf.size()), loca, table)) {
+                std::cerr << "Mismatch: nested compound glyphs could not be parsed." << std::endl;
+                return false;
+            }
+
+            // With a limit of 3 levels, glyphs 0-3 resolve and 4-5 do not, in either order
+            const uint16_t orders[2][3] = { { 5, 3, 4 }, { 3, 5, 4 } };
+            for (const uint16_t* order : orders) {
+                TTFParser::OutlineResolver resolver(table, 3);
+                for (int i = 0; i < 3; ++i) {
+                    std::ostringstream expectedErrors; // Keep the resolver's reports of the deep glyphs out of the output
+                    std::streambuf* const errors = std::cerr.rdbuf(expectedErrors.rdbuf());
+                    const bool resolved = resolver.resolve(order[i]) != nullptr;
+                    std::cerr.rdbuf(errors);
+                    if (resolved != (order[i] <= 3)) {
+                        std::cerr << "Mismatch: glyph " << order[i] << " nested " << order[i] << " levels deep "
+                            << (resolved ? "resolved" : "failed to resolve") << " with a limit of 3 levels." << std::endl;
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    } // namespace
+
+    bool runSelfTest(const std::vector<std::string>& fonts, size_t threads) {
+        if (threads == 0) {
+            threads = std::max<size_t>(4, std::thread::hardware_concurrency());
+        }
+
+        bool passed = checkPointMatching();
+        passed &= checkNestingLimit();
+
+        // Reference: one parser, decoding on the calling thread
+        std::vector<ParsedFont> reference(fonts.size());
+        std::vector<bool> parsed(fonts.size());
+        for (size_t i = 0; i < fonts.size(); ++i) {
+            parsed[i] = parseFont(fonts[i], nullptr, reference[i]);
+            if (!parsed[i]) {
+                std::cerr << "Failed: " << fonts[i] << " could not be parsed." << std::endl;
+                passed = false;
+            }
+        }
+
+        // 'glyf' decoded in parallel chunks, one font at a time
+        TTFParser::ThreadPool pool(threads);
+        for (size_t i = 0; i < fonts.size(); ++i) {
+            ParsedFont font;
+            const char* difference = nullptr;
+            if (parsed[i] && (!parseFont(fonts[i], &pool, font) || (difference = firstDifference(reference[i], font)) != nullptr)) {
+                std::cerr << "Mismatch: " << fonts[i] << ": " << (difference ? difference : "parsing failed")
+                    << " with the glyf decoding split over " << pool.concurrency() << " threads." << std::endl;
+                passed = false;
+            }
+        }
+
+        // Independent parsers running at once, each on its own thread
+        std::atomic<size_t> nextTask{ 0 };
+        std::atomic<bool> concurrentPassed{ true };
+        std::mutex outputMutex;
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                for (size_t task = nextTask++; task < fonts.size() * kConcurrentRounds; task = nextTask++) {
+                    const size_t i = task % fonts.size();
+                    ParsedFont font;
+                    const char* difference = nullptr;
+                    if (parsed[i] && (!parseFont(fonts[i], nullptr, font) || (difference = firstDifference(reference[i], font)) != nullptr)) {
+                        std::lock_guard<std::mutex> lock(outputMutex);
+                        std::cerr << "Mismatch: " << fonts[i] << ": " << (difference ? difference : "parsing failed")
+                            << " with " << threads << " parsers running at once." << std::endl;
+                        concurrentPassed = false;
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        passed &= concurrentPassed.load();
+
+        std::cout << "Self-test " << (passed ? "passed" : "FAILED") << ": " << fonts.size() << " fonts, serial parsing compared with "
+            << pool.concurrency() << "-thread glyf decoding and " << threads << " concurrent parsers." << std::endl;
+        return passed;
+    }
+
+} // namespace FontConverter
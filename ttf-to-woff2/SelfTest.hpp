@@ -0,0 +1,27 @@
+#ifndef SELF_TEST_HPP
+#define SELF_TEST_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace FontConverter {
+
+    /**
+     * @brief Checks that parsing gives the same result however it is spread over threads.
+     *
+     * Every font is first parsed on the calling thread as the reference. Its 'glyf' table is then
+     * decoded again in parallel chunks on a pool of `threads` threads, and all fonts are parsed
+     * once more by `threads` independent parsers running at once. Every result must equal the
+     * reference: loca offsets, hmtx metrics and every array of the decoded GlyfTable. A few
+     * synthetic glyphs check compound glyph corner cases first.
+     *
+     * @param threads Threads to run on; 0 uses every core, but at least 4 so the parallel paths
+     *        are exercised on small machines too.
+     * @return true if every font parsed and every result matched; mismatches are reported.
+     */
+    bool runSelfTest(const std::vector<std::string>& fonts, size_t threads);
+
+} // namespace FontConverter
+
+#endif // SELF_TEST_HPP
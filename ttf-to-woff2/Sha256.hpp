@@ -0,0 +1,43 @@
+#ifndef SHA256_HPP
+#define SHA256_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace FontConverter {
+
+    /**
+    * @class Sha256
+    * @brief Incremental SHA-256 (FIPS 180-4), used to name conversion cache entries.
+    */
+    class Sha256 {
+    public:
+        static const size_t kDigestSize = 32;
+
+        Sha256() { reset(); }
+
+        // Starts a new hash.
+        void reset();
+
+        // Hashes more bytes.
+        void update(const void* data, size_t size);
+
+        // Completes the hash; call reset() before hashing anything else.
+        void finish(uint8_t digest[kDigestSize]);
+
+        // Completes the hash and returns it as 64 lowercase hex digits.
+        std::string finishHex();
+
+    private:
+        void processBlock(const uint8_t* block);
+
+        uint32_t state[8];
+        uint8_t buffer[64];
+        size_t bufferSize;
+        uint64_t totalBytes;
+    };
+
+} // namespace FontConverter
+
+#endif // SHA256_HPP
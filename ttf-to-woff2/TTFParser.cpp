@@ -1,89 +1,96 @@
 #include "TTFParser.hpp"
-#include <fstream>
+#include "BigEndian.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <unordered_map>
+#include <utility>
 
 namespace TTFParser {
-    bool TTFParser::parseHeadTable(uint32_t offset) {
+    bool TTFParser::parseHeadTable(ByteView table) {
         // Ensure that there is enough data for the 'head' table (total 54 bytes worth of data)
-        if (fontData.size() < offset + 54) {
+        if (table.size() < 54) {
             std::cerr << "Error: not enough data for 'head' headTable." << std::endl;
             return false;
         }
 
         // Parse version and check if it's supported in this parser
-        headTable.version = fixedToFloat(swapEndian32(*(int32_t*)&fontData[offset]));
+        headTable.version = fixedToFloat(swapEndian32(*(int32_t*)&table[0]));
         if (headTable.version != 1.0f) {
             std::cerr << "Error: Unsupported 'head' headTable version." << std::endl;
             return false;
         }
 
-        headTable.fontRevision = fixedToFloat(swapEndian32(*(int32_t*)&fontData[offset + 4]));
-        headTable.checkSumAdjustment = swapEndian32(*(uint32_t*)&fontData[offset + 8]);
-        headTable.magicNumber = swapEndian32(*(uint32_t*)&fontData[offset + 12]);
+        headTable.fontRevision = fixedToFloat(swapEndian32(*(int32_t*)&table[4]));
+        headTable.checkSumAdjustment = swapEndian32(*(uint32_t*)&table[8]);
+        headTable.magicNumber = swapEndian32(*(uint32_t*)&table[12]);
 
         if (headTable.magicNumber != 0x5F0F3CF5) { // https://learn.microsoft.com/en-us/typography/opentype/spec/head
             std::cerr << "Error: Invalid magic number in 'head' headTable." << std::endl;
             return false;
         }
 
-        headTable.flags = swapEndian16(*(uint16_t*)&fontData[offset + 16]);
-        headTable.unitsPerEm = swapEndian16(*(uint16_t*)&fontData[offset + 18]);
-        headTable.created = swapEndian64(*(int64_t*)&fontData[offset + 20]);
-        headTable.modified = swapEndian64(*(int64_t*)&fontData[offset + 28]);
-        headTable.xMin = swapEndian16(*(int16_t*)&fontData[offset + 36]);
-        headTable.yMin = swapEndian16(*(int16_t*)&fontData[offset + 38]);
-        headTable.xMax = swapEndian16(*(int16_t*)&fontData[offset + 40]);
-        headTable.yMax = swapEndian16(*(int16_t*)&fontData[offset + 42]);
-        headTable.macStyle = swapEndian16(*(uint16_t*)&fontData[offset + 44]);
-        headTable.lowestRecPPEM = swapEndian16(*(uint16_t*)&fontData[offset + 46]);
-        headTable.fontDirectionHint = swapEndian16(*(int16_t*)&fontData[offset + 48]);
-        headTable.indexToLocFormat = swapEndian16(*(int16_t*)&fontData[offset + 50]);
-        headTable.glyphDataFormat = swapEndian16(*(int16_t*)&fontData[offset + 52]);
+        headTable.flags = swapEndian16(*(uint16_t*)&table[16]);
+        headTable.unitsPerEm = swapEndian16(*(uint16_t*)&table[18]);
+        headTable.created = swapEndian64(*(int64_t*)&table[20]);
+        headTable.modified = swapEndian64(*(int64_t*)&table[28]);
+        headTable.xMin = swapEndian16(*(int16_t*)&table[36]);
+        headTable.yMin = swapEndian16(*(int16_t*)&table[38]);
+        headTable.xMax = swapEndian16(*(int16_t*)&table[40]);
+        headTable.yMax = swapEndian16(*(int16_t*)&table[42]);
+        headTable.macStyle = swapEndian16(*(uint16_t*)&table[44]);
+        headTable.lowestRecPPEM = swapEndian16(*(uint16_t*)&table[46]);
+        headTable.fontDirectionHint = swapEndian16(*(int16_t*)&table[48]);
+        headTable.indexToLocFormat = swapEndian16(*(int16_t*)&table[50]);
+        headTable.glyphDataFormat = swapEndian16(*(int16_t*)&table[52]);
 
         return true;
     }
 
-    bool TTFParser::parseNameTable(uint32_t offset, NameTable& table) {
-        if (fontData.size() < offset + 6) { // 6 bytes for the header
+    bool TTFParser::parseNameTable(ByteView data, NameTable& table) {
+        uint32_t offset = 0;
+        if (data.size() < offset + 6) { // 6 bytes for the header
             std::cerr << "Error: Not enough data for 'name' table header." << std::endl;
             return false;
         }
 
-        table.format = swapEndian16(*(uint16_t*)&fontData[offset]);
-        table.count = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
-        table.stringOffset = swapEndian16(*(uint16_t*)&fontData[offset + 4]);
+        table.format = swapEndian16(*(uint16_t*)&data[offset]);
+        table.count = swapEndian16(*(uint16_t*)&data[offset + 2]);
+        table.stringOffset = swapEndian16(*(uint16_t*)&data[offset + 4]);
 
         offset += 6; // Move past the header
 
         for (uint16_t i = 0; i < table.count; ++i) {
-            if (fontData.size() < offset + 12) { // 12 bytes for each name record
+            if (data.size() < offset + 12) { // 12 bytes for each name record
                 std::cerr << "Error: Not enough data for name record " << i << "." << std::endl;
                 return false;
             }
 
             NameRecord record;
-            record.platformID = swapEndian16(*(uint16_t*)&fontData[offset]);
-            record.encodingID = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
-            record.languageID = swapEndian16(*(uint16_t*)&fontData[offset + 4]);
-            record.nameID = swapEndian16(*(uint16_t*)&fontData[offset + 6]);
-            record.length = swapEndian16(*(uint16_t*)&fontData[offset + 8]);
-            record.offset = swapEndian16(*(uint16_t*)&fontData[offset + 10]);
+            record.platformID = swapEndian16(*(uint16_t*)&data[offset]);
+            record.encodingID = swapEndian16(*(uint16_t*)&data[offset + 2]);
+            record.languageID = swapEndian16(*(uint16_t*)&data[offset + 4]);
+            record.nameID = swapEndian16(*(uint16_t*)&data[offset + 6]);
+            record.length = swapEndian16(*(uint16_t*)&data[offset + 8]);
+            record.offset = swapEndian16(*(uint16_t*)&data[offset + 10]);
 
             // Navigate to the string in the string storage and read it
-            uint32_t stringStart = offset + table.stringOffset + record.offset;
-            if (fontData.size() < stringStart + record.length) {
+            uint32_t stringStart = table.stringOffset + record.offset;
+            if (!data.contains(stringStart, record.length)) {
                 std::cerr << "Error: Not enough data for name string of record " << i << "." << std::endl;
                 return false;
             }
 
             if (record.encodingID == 0 || record.encodingID == 1) { // ASCII or UTF-16
                 for (uint16_t j = 0; j < record.length; ++j) {
-                    record.nameString += fontData[stringStart + j];
+                    record.nameString += data[stringStart + j];
                 }
             }
             else if (record.encodingID == 2) { // UTF-16
                 for (uint16_t j = 0; j < record.length; j += 2) {
-                    char16_t ch = swapEndian16(*(char16_t*)&fontData[stringStart + j]);
+                    char16_t ch = swapEndian16(*(char16_t*)&data[stringStart + j]);
                     record.nameString += std::string((char*)&ch, 2);
                 }
             }
@@ -98,51 +105,52 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseHheaTable(uint32_t offset, HheaTable& table) {
-        if (fontData.size() < offset + 36) { // The 'hhea' table should be at least 36 bytes
+    bool TTFParser::parseHheaTable(ByteView data, HheaTable& table) {
+        uint32_t offset = 0;
+        if (data.size() < offset + 36) { // The 'hhea' table should be at least 36 bytes
             std::cerr << "Error: not enough data for 'hhea' table." << std::endl;
             return false;
         }
 
-        table.version = fixedToFloat(swapEndian32(*(int32_t*)&fontData[offset]));
+        table.version = fixedToFloat(swapEndian32(*(int32_t*)&data[offset]));
         offset += 4;
 
-        table.ascent = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.ascent = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
-        table.descent = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.descent = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
-        table.lineGap = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.lineGap = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
-        table.advanceWidthMax = swapEndian16(*(uint16_t*)&fontData[offset]);
+        table.advanceWidthMax = swapEndian16(*(uint16_t*)&data[offset]);
         offset += 2;
 
-        table.minLeftSideBearing = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.minLeftSideBearing = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
-        table.minRightSideBearing = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.minRightSideBearing = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
-        table.xMaxExtent = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.xMaxExtent = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
-        table.caretSlopeRise = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.caretSlopeRise = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
-        table.caretSlopeRun = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.caretSlopeRun = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
-        table.caretOffset = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.caretOffset = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
         for (int i = 0; i < 4; ++i) {
-            table.reserved[i] = swapEndian16(*(int16_t*)&fontData[offset]);
+            table.reserved[i] = swapEndian16(*(int16_t*)&data[offset]);
             offset += 2;
         }
 
-        table.metricDataFormat = swapEndian16(*(int16_t*)&fontData[offset]);
+        table.metricDataFormat = swapEndian16(*(int16_t*)&data[offset]);
         offset += 2;
 
         if (table.metricDataFormat != 0) {
@@ -150,62 +158,55 @@ namespace TTFParser {
             return false;
         }
 
-        table.numOfLongHorMetrics = swapEndian16(*(uint16_t*)&fontData[offset]);
+        table.numOfLongHorMetrics = swapEndian16(*(uint16_t*)&data[offset]);
 
         return true;
     }
 
-    bool TTFParser::parseHmtxTable(uint32_t offset, uint16_t numOfLongHorMetrics, std::vector<GlyphMetrics>& metrics) {
-        if (fontData.size() < offset + numOfLongHorMetrics * 4 + (numGlyphs - numOfLongHorMetrics) * 2) {
+    bool TTFParser::parseHmtxTable(ByteView table, uint16_t numOfLongHorMetrics, std::vector<GlyphMetrics>& metrics) {
+        static_assert(sizeof(GlyphMetrics) == 4, "GlyphMetrics must match the 4-byte longHorMetric layout");
+
+        if (numOfLongHorMetrics > numGlyphs) {
+            std::cerr << "Error: numOfLongHorMetrics exceeds the number of glyphs." << std::endl;
+            return false;
+        }
+
+        const size_t numLeftSideBearings = numGlyphs - numOfLongHorMetrics;
+        if (table.size() < numOfLongHorMetrics * 4u + numLeftSideBearings * 2) {
             std::cerr << "Error: not enough data for 'hmtx' table." << std::endl;
             return false;
         }
 
         metrics.resize(numGlyphs);
 
-        std::cout << "numGlyphs: " << numGlyphs << std::endl;
-        std::cout << "numOfLongHorMetrics: " << numOfLongHorMetrics << std::endl;
-
-        for (uint16_t i = 0; i < numOfLongHorMetrics; ++i) {
-            if (offset + 4 > fontData.size()) {
-                std::cerr << "Error: Exceeded font data while reading 'hmtx' metrics." << std::endl;
-                return false;
-            }
-
-            std::cout << "Accessing metrics[" << i << "]" << std::endl;
-
-            metrics[i].advanceWidth = swapEndian16(*(uint16_t*)&fontData[offset]);
-            metrics[i].lsb = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
+        // longHorMetric records are pairs of 16-bit values, so decode them straight into the structs
+        decodeU16Array(table.data(), reinterpret_cast<uint16_t*>(metrics.data()), 2 * static_cast<size_t>(numOfLongHorMetrics));
 
-            offset += 4;
-
-            // Optional Diagnostic print - might produce a lot of output for fonts with many glyphs.
-             std::cout << "Metric " << i << ": Advance Width = " << metrics[i].advanceWidth
-                 << ", Left Side Bearing = " << metrics[i].lsb << std::endl;
-        }
-
-        // If there are more glyphs than numOfLongHorMetrics, the remaining glyphs will use the last advanceWidth from the above loop
+        // The remaining glyphs only store a left side bearing and reuse the last advanceWidth
         uint16_t lastAdvanceWidth = (numOfLongHorMetrics > 0) ? metrics[numOfLongHorMetrics - 1].advanceWidth : 0;
+        std::vector<uint16_t> leftSideBearings(numLeftSideBearings);
+        decodeU16Array(table.data() + numOfLongHorMetrics * 4u, leftSideBearings.data(), numLeftSideBearings);
 
-        for (uint16_t i = numOfLongHorMetrics; i < numGlyphs; ++i) {
-            metrics[i].advanceWidth = lastAdvanceWidth;
-            metrics[i].lsb = swapEndian16(*(int16_t*)&fontData[offset]);
-            offset += 2;
+        for (size_t i = 0; i < numLeftSideBearings; ++i) {
+            metrics[numOfLongHorMetrics + i].advanceWidth = lastAdvanceWidth;
+            metrics[numOfLongHorMetrics + i].lsb = static_cast<int16_t>(leftSideBearings[i]);
         }
 
         return true;
     }
 
-    bool TTFParser::parseCmapFormat0(uint32_t offset, CmapFormat0& table) {
+    bool TTFParser::parseCmapFormat0(ByteView data, CmapFormat0& table) {
+        uint32_t offset = 6; // Skip format, length and language
+
         // Check boundaries
-        if (offset + 256 > fontData.size()) {
+        if (offset + 256 > data.size()) {
             std::cerr << "Error: cmap format 0 table is shorter than expected." << std::endl;
             return false;
         }
 
         // Read the glyphIdArray
         for (int i = 0; i < 256; ++i) {
-            table.glyphIdArray[i] = fontData[offset + i];
+            table.glyphIdArray[i] = data[offset + i];
 
             // Optional: Check if the glyph index is in range
             if (table.glyphIdArray[i] >= numGlyphs) {
@@ -217,20 +218,20 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseCmapFormat2(uint32_t offset, CmapFormat2& table) {
+    bool TTFParser::parseCmapFormat2(ByteView data, CmapFormat2& table) {
         // Check initial boundaries
-        if (offset + 512 > fontData.size()) { // 2 bytes for format, length, and language + 256 for subHeaderKeys
+        if (6 + 256 > data.size()) { // 2 bytes each for format, length, and language + 256 for subHeaderKeys
             std::cerr << "Error: cmap format 2 table is too short for initial data." << std::endl;
             return false;
         }
 
-        table.length = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
-        table.language = swapEndian16(*(uint16_t*)&fontData[offset + 4]);
+        table.length = swapEndian16(*(uint16_t*)&data[2]);
+        table.language = swapEndian16(*(uint16_t*)&data[4]);
 
-        offset += 6;
+        uint32_t offset = 6;
 
         for (int i = 0; i < 256; ++i) {
-            table.subHeaderKeys[i] = fontData[offset + i];
+            table.subHeaderKeys[i] = data[offset + i];
         }
         offset += 256;
 
@@ -244,16 +245,16 @@ namespace TTFParser {
         }
 
         for (uint16_t i = 0; i <= maxSubHeaderIndex; ++i) {
-            if (offset + 8 > fontData.size()) {
+            if (offset + 8 > data.size()) {
                 std::cerr << "Error: cmap format 2 table is too short for subHeaders." << std::endl;
                 return false;
             }
 
             SubHeader sh;
-            sh.firstCode = swapEndian16(*(uint16_t*)&fontData[offset]);
-            sh.entryCount = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
-            sh.idDelta = swapEndian16(*(uint16_t*)&fontData[offset + 4]);
-            sh.idRangeOffset = swapEndian16(*(uint16_t*)&fontData[offset + 6]);
+            sh.firstCode = swapEndian16(*(uint16_t*)&data[offset]);
+            sh.entryCount = swapEndian16(*(uint16_t*)&data[offset + 2]);
+            sh.idDelta = swapEndian16(*(uint16_t*)&data[offset + 4]);
+            sh.idRangeOffset = swapEndian16(*(uint16_t*)&data[offset + 6]);
 
             table.subHeaders.push_back(sh);
 
@@ -265,8 +266,13 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseCmapFormat4(uint32_t offset, CmapFormat4& table) {
-        table.segCountX2 = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
+    bool TTFParser::parseCmapFormat4(ByteView data, CmapFormat4& table) {
+        if (data.size() < 14) {
+            std::cerr << "Error: cmap format 4 table is too short for its header." << std::endl;
+            return false;
+        }
+
+        table.segCountX2 = swapEndian16(*(uint16_t*)&data[6]);
 
         if (table.segCountX2 % 2 != 0) {
             std::cerr << "Error: segCountX2 is not an even number." << std::endl;
@@ -275,51 +281,52 @@ namespace TTFParser {
 
         uint16_t segCount = table.segCountX2 / 2;
 
-        if (fontData.size() < offset + 14 + 8 * segCount) {
+        if (!data.contains(0, 16 + 8 * size_t(segCount))) {
             std::cerr << "Error: cmap format 4 table is shorter than expected." << std::endl;
             return false;
         }
 
-        // Skip 6 bytes to reach endCount array
-        offset += 14;
-        for (uint16_t i = 0; i < segCount; ++i) {
-            table.endCount.push_back(swapEndian16(*(uint16_t*)&fontData[offset]));
-            offset += 2;
-        }
-
-        // Skip reservedPad
-        offset += 2;
-
-        for (uint16_t i = 0; i < segCount; ++i) {
-            table.startCount.push_back(swapEndian16(*(uint16_t*)&fontData[offset]));
-            offset += 2;
-        }
+        // Skip format, length, language, segCountX2, searchRange, entrySelector and rangeShift to reach endCount array.
+        // The four segment arrays follow each other (with reservedPad after endCount) and were bounds-checked above.
+        const uint32_t endCountStart = 14;
+        const uint32_t startCountStart = endCountStart + table.segCountX2 + 2;
+        const uint32_t idDeltaStart = startCountStart + table.segCountX2;
+        const uint32_t idRangeOffsetStart = idDeltaStart + table.segCountX2;
 
-        for (uint16_t i = 0; i < segCount; ++i) {
-            table.idDelta.push_back(swapEndian16(*(uint16_t*)&fontData[offset]));
-            offset += 2;
-        }
+        table.endCount.resize(segCount);
+        table.startCount.resize(segCount);
+        table.idDelta.resize(segCount);
+        table.idRangeOffset.resize(segCount);
+        decodeU16Array(&data[endCountStart], table.endCount.data(), segCount);
+        decodeU16Array(&data[startCountStart], table.startCount.data(), segCount);
+        decodeU16Array(&data[idDeltaStart], table.idDelta.data(), segCount);
+        decodeU16Array(&data[idRangeOffsetStart], table.idRangeOffset.data(), segCount);
 
         for (uint16_t i = 0; i < segCount; ++i) {
-            table.idRangeOffset.push_back(swapEndian16(*(uint16_t*)&fontData[offset]));
-            offset += 2;
+            if (table.startCount[i] > table.endCount[i]) {
+                std::cerr << "Error: startCount is greater than endCount for segment " << i << std::endl;
+                return false;
+            }
         }
 
         // Calculate the glyph indices
         for (uint16_t i = 0; i < segCount; ++i) {
-            for (uint16_t charCode = table.startCount[i]; charCode <= table.endCount[i]; ++charCode) {
+            for (uint32_t charCode = table.startCount[i]; charCode <= table.endCount[i]; ++charCode) {
                 uint16_t glyphIndex;
                 if (table.idRangeOffset[i] == 0) {
                     glyphIndex = (charCode + table.idDelta[i]) % 65536; // Use modulo to ensure the result wraps around in a 16-bit integer.
                 }
                 else {
-                    uint16_t offset = (charCode - table.startCount[i]) * 2 + table.idRangeOffset[i];
-                    uint32_t indexPosition = offset + 2 * i + 14 + 6 * segCount;
-                    if (indexPosition >= fontData.size()) {
+                    // idRangeOffset is relative to its own position in the idRangeOffset array
+                    uint32_t indexPosition = idRangeOffsetStart + 2 * i + table.idRangeOffset[i] + (charCode - table.startCount[i]) * 2;
+                    if (!data.contains(indexPosition, 2)) {
                         std::cerr << "Error: Calculated position for glyph index exceeds font data size." << std::endl;
                         return false;
                     }
-                    glyphIndex = swapEndian16(*(uint16_t*)&fontData[offset]);
+                    glyphIndex = swapEndian16(*(uint16_t*)&data[indexPosition]);
+                    if (glyphIndex != 0) {
+                        glyphIndex = (glyphIndex + table.idDelta[i]) % 65536;
+                    }
                 }
 
                 if (glyphIndex >= numGlyphs) { // Assuming you've already parsed the 'maxp' table and stored the number of glyphs in a member called `numGlyphs`.
@@ -332,71 +339,73 @@ namespace TTFParser {
             }
         }
 
-        for (uint16_t i = 0; i < segCount; ++i) {
-            if (table.startCount[i] > table.endCount[i]) {
-                std::cerr << "Error: startCount is greater than endCount for segment " << i << std::endl;
-                return false;
-            }
-        }
-
         return true;
     }
 
-    bool TTFParser::parseCmapFormat6(uint32_t offset, CmapFormat6& table) {
-        table.firstCode = swapEndian16(*(uint16_t*)&fontData[offset]);
-        table.entryCount = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
-
-        if (fontData.size() < offset + 4 + 2 * table.entryCount) {
-            std::cerr << "Error: cmap format 6 table is shorter than expected." << std::endl;
+    bool TTFParser::parseCmapFormat6(ByteView data, CmapFormat6& table) {
+        if (data.size() < 10) {
+            std::cerr << "Error: cmap format 6 table is too short for its header." << std::endl;
             return false;
         }
 
-        offset += 4;
-        for (uint16_t i = 0; i < table.entryCount; ++i) {
-            table.glyphIdArray.push_back(swapEndian16(*(uint16_t*)&fontData[offset]));
-            offset += 2;
+        table.length = swapEndian16(*(uint16_t*)&data[2]);
+        table.language = swapEndian16(*(uint16_t*)&data[4]);
+        table.firstCode = swapEndian16(*(uint16_t*)&data[6]);
+        table.entryCount = swapEndian16(*(uint16_t*)&data[8]);
+
+        if (!readU16Array(data, 10, table.entryCount, table.glyphIdArray)) {
+            std::cerr << "Error: cmap format 6 table is shorter than expected." << std::endl;
+            return false;
         }
 
         return true;
     }
 
-    bool TTFParser::parseCmapFormat8(uint32_t offset, CmapFormat8& table) {
+    bool TTFParser::parseCmapFormat8(ByteView data, CmapFormat8& table) {
         // TODO: Implement the parsing for format 8 if needed.
         return true;
     }
 
-    bool TTFParser::parseCmapFormat10(uint32_t offset, CmapFormat10& table) {
-        table.startCharCode = swapEndian32(*(uint32_t*)&fontData[offset]);
-        table.numChars = swapEndian32(*(uint32_t*)&fontData[offset + 4]);
-
-        if (fontData.size() < offset + 8 + 2 * table.numChars) {
-            std::cerr << "Error: cmap format 10 table is shorter than expected." << std::endl;
+    bool TTFParser::parseCmapFormat10(ByteView data, CmapFormat10& table) {
+        if (data.size() < 20) {
+            std::cerr << "Error: cmap format 10 table is too short for its header." << std::endl;
             return false;
         }
 
-        offset += 8;
-        for (uint32_t i = 0; i < table.numChars; ++i) {
-            table.glyphs.push_back(swapEndian16(*(uint16_t*)&fontData[offset]));
-            offset += 2;
+        table.length = swapEndian32(*(uint32_t*)&data[4]);
+        table.language = swapEndian32(*(uint32_t*)&data[8]);
+        table.startCharCode = swapEndian32(*(uint32_t*)&data[12]);
+        table.numChars = swapEndian32(*(uint32_t*)&data[16]);
+
+        if (!readU16Array(data, 20, table.numChars, table.glyphs)) {
+            std::cerr << "Error: cmap format 10 table is shorter than expected." << std::endl;
+            return false;
         }
 
         return true;
     }
 
-    bool TTFParser::parseCmapFormat12(uint32_t offset, CmapFormat12& table) {
-        table.numGroups = swapEndian32(*(uint32_t*)&fontData[offset]);
+    bool TTFParser::parseCmapFormat12(ByteView data, CmapFormat12& table) {
+        if (data.size() < 16) {
+            std::cerr << "Error: cmap format 12 table is too short for its header." << std::endl;
+            return false;
+        }
 
-        if (fontData.size() < offset + 4 + 12 * table.numGroups) {
+        table.length = swapEndian32(*(uint32_t*)&data[4]);
+        table.language = swapEndian32(*(uint32_t*)&data[8]);
+        table.numGroups = swapEndian32(*(uint32_t*)&data[12]);
+
+        if (!data.contains(16, 12 * static_cast<size_t>(table.numGroups))) {
             std::cerr << "Error: cmap format 12 table is shorter than expected." << std::endl;
             return false;
         }
 
-        offset += 4;
+        uint32_t offset = 16;
         for (uint32_t i = 0; i < table.numGroups; ++i) {
             GroupFormat12 group;
-            group.startCharCode = swapEndian32(*(uint32_t*)&fontData[offset]);
-            group.endCharCode = swapEndian32(*(uint32_t*)&fontData[offset + 4]);
-            group.startGlyphID = swapEndian32(*(uint32_t*)&fontData[offset + 8]);
+            group.startCharCode = swapEndian32(*(uint32_t*)&data[offset]);
+            group.endCharCode = swapEndian32(*(uint32_t*)&data[offset + 4]);
+            group.startGlyphID = swapEndian32(*(uint32_t*)&data[offset + 8]);
             table.groups.push_back(group);
             offset += 12;
         }
@@ -404,20 +413,27 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseCmapFormat13(uint32_t offset, CmapFormat13& table) {
-        table.numGroups = swapEndian32(*(uint32_t*)&fontData[offset]);
+    bool TTFParser::parseCmapFormat13(ByteView data, CmapFormat13& table) {
+        if (data.size() < 16) {
+            std::cerr << "Error: cmap format 13 table is too short for its header." << std::endl;
+            return false;
+        }
+
+        table.length = swapEndian32(*(uint32_t*)&data[4]);
+        table.language = swapEndian32(*(uint32_t*)&data[8]);
+        table.numGroups = swapEndian32(*(uint32_t*)&data[12]);
 
-        if (fontData.size() < offset + 4 + 12 * table.numGroups) {
+        if (!data.contains(16, 12 * static_cast<size_t>(table.numGroups))) {
             std::cerr << "Error: cmap format 13 table is shorter than expected." << std::endl;
             return false;
         }
 
-        offset += 4;
+        uint32_t offset = 16;
         for (uint32_t i = 0; i < table.numGroups; ++i) {
             GroupFormat13 group;
-            group.startCharCode = swapEndian32(*(uint32_t*)&fontData[offset]);
-            group.endCharCode = swapEndian32(*(uint32_t*)&fontData[offset + 4]);
-            group.glyphID = swapEndian32(*(uint32_t*)&fontData[offset + 8]);
+            group.startCharCode = swapEndian32(*(uint32_t*)&data[offset]);
+            group.endCharCode = swapEndian32(*(uint32_t*)&data[offset + 4]);
+            group.glyphID = swapEndian32(*(uint32_t*)&data[offset + 8]);
             table.groups.push_back(group);
             offset += 12;
         }
@@ -425,43 +441,53 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseCmapFormat14(uint32_t offset, CmapFormat14& table) {
-        table.format = swapEndian16(*(uint16_t*)&fontData[offset]);
-        table.length = swapEndian32(*(uint32_t*)&fontData[offset + 2]);
-        table.numVarSelectorRecords = swapEndian32(*(uint32_t*)&fontData[offset + 6]);
+    bool TTFParser::parseCmapFormat14(ByteView data, CmapFormat14& table) {
+        if (data.size() < 10) {
+            std::cerr << "Error: cmap format 14 table is too short for its header." << std::endl;
+            return false;
+        }
+
+        table.format = swapEndian16(*(uint16_t*)&data[0]);
+        table.length = swapEndian32(*(uint32_t*)&data[2]);
+        table.numVarSelectorRecords = swapEndian32(*(uint32_t*)&data[6]);
+
+        if (!data.contains(10, 11 * static_cast<size_t>(table.numVarSelectorRecords))) {
+            std::cerr << "Error: cmap format 14 variation selector records exceed table size." << std::endl;
+            return false;
+        }
 
-        uint32_t currentOffset = offset + 10; // Start of the varSelector array
+        uint32_t currentOffset = 10; // Start of the varSelector array
 
         for (uint32_t i = 0; i < table.numVarSelectorRecords; ++i) {
             VarSelectorRecord record;
-            record.varSelector = (fontData[currentOffset] << 16) | (fontData[currentOffset + 1] << 8) | fontData[currentOffset + 2];
-            record.defaultUVSOffset = swapEndian32(*(uint32_t*)&fontData[currentOffset + 3]);
-            record.nonDefaultUVSOffset = swapEndian32(*(uint32_t*)&fontData[currentOffset + 7]);
+            record.varSelector = (data[currentOffset] << 16) | (data[currentOffset + 1] << 8) | data[currentOffset + 2];
+            record.defaultUVSOffset = swapEndian32(*(uint32_t*)&data[currentOffset + 3]);
+            record.nonDefaultUVSOffset = swapEndian32(*(uint32_t*)&data[currentOffset + 7]);
             table.varSelectors.push_back(record);
             currentOffset += 11; // Move to the next VarSelectorRecord
         }
 
         for (auto& selectorRecord : table.varSelectors) {
-            // Parse default UVS table if present
+            // Parse default UVS table if present (offsets are from the start of the subtable)
             if (selectorRecord.defaultUVSOffset) {
-                uint32_t uvsOffset = offset + selectorRecord.defaultUVSOffset;
-                if (uvsOffset + 4 > fontData.size()) {
+                size_t uvsOffset = selectorRecord.defaultUVSOffset;
+                if (!data.contains(uvsOffset, 4)) {
                     std::cerr << "Error: Default UVS table offset exceeds font data size." << std::endl;
                     return false;
                 }
 
-                uint32_t numUnicodeValueRanges = swapEndian32(*(uint32_t*)&fontData[uvsOffset]);
+                uint32_t numUnicodeValueRanges = swapEndian32(*(uint32_t*)&data[uvsOffset]);
                 uvsOffset += 4;
 
                 for (uint32_t j = 0; j < numUnicodeValueRanges; ++j) {
-                    if (uvsOffset + 4 > fontData.size()) {
+                    if (!data.contains(uvsOffset, 4)) {
                         std::cerr << "Error: Unicode value range exceeds font data size." << std::endl;
                         return false;
                     }
 
                     UnicodeValueRange range;
-                    range.startUnicodeValue = (fontData[uvsOffset] << 16) | (fontData[uvsOffset + 1] << 8) | fontData[uvsOffset + 2];
-                    range.additionalCount = fontData[uvsOffset + 3];
+                    range.startUnicodeValue = (data[uvsOffset] << 16) | (data[uvsOffset + 1] << 8) | data[uvsOffset + 2];
+                    range.additionalCount = data[uvsOffset + 3];
                     selectorRecord.defaultUVSTable.push_back(range);
                     uvsOffset += 4; // Move to next UnicodeValueRange
                 }
@@ -469,24 +495,24 @@ namespace TTFParser {
 
             // Parse non-default UVS table if present
             if (selectorRecord.nonDefaultUVSOffset) {
-                uint32_t uvsOffset = offset + selectorRecord.nonDefaultUVSOffset;
-                if (uvsOffset + 4 > fontData.size()) {
+                size_t uvsOffset = selectorRecord.nonDefaultUVSOffset;
+                if (!data.contains(uvsOffset, 4)) {
                     std::cerr << "Error: Non-default UVS table offset exceeds font data size." << std::endl;
                     return false;
                 }
 
-                uint32_t numUVSMappings = swapEndian32(*(uint32_t*)&fontData[uvsOffset]);
+                uint32_t numUVSMappings = swapEndian32(*(uint32_t*)&data[uvsOffset]);
                 uvsOffset += 4;
 
                 for (uint32_t j = 0; j < numUVSMappings; ++j) {
-                    if (uvsOffset + 5 > fontData.size()) {
+                    if (!data.contains(uvsOffset, 5)) {
                         std::cerr << "Error: UVS mapping exceeds font data size." << std::endl;
                         return false;
                     }
 
                     UVSMapping mapping;
-                    mapping.unicodeValue = (fontData[uvsOffset] << 16) | (fontData[uvsOffset + 1] << 8) | fontData[uvsOffset + 2];
-                    mapping.glyphID = swapEndian16(*(uint16_t*)&fontData[uvsOffset + 3]);
+                    mapping.unicodeValue = (data[uvsOffset] << 16) | (data[uvsOffset + 1] << 8) | data[uvsOffset + 2];
+                    mapping.glyphID = swapEndian16(*(uint16_t*)&data[uvsOffset + 3]);
                     selectorRecord.nonDefaultUVSTable.push_back(mapping);
 
                     uvsOffset += 5; // Move to next UVSMapping
@@ -497,19 +523,25 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::loadFromFile(const std::string& filename) {
-        // Load the entire TTF file into memory
-        std::ifstream file(filename, std::ios::binary | std::ios::ate);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open TTF file: " << filename << std::endl;
-            return false;
-        }
+    void TTFParser::clearParsedState() {
+        tableDirectory.clear();
+        offsetTable.tableDirectoryEntries.clear();
+        headTable = HeadTable{};
+        numGlyphs = 0;
+    }
+
+    bool TTFParser::loadFromFile(const std::string& filename, LoadMode mode) {
+        clearParsedState();
 
-        std::streamsize size = file.tellg();
-        file.seekg(0, std::ios::beg);
+        bool loaded = false;
+        if (mode == LoadMode::Mapped) {
+            loaded = fontData.mapFile(filename);
+            if (!loaded) {
+                std::cerr << "Falling back to buffered read for: " << filename << std::endl;
+            }
+        }
 
-        fontData.resize(size);
-        if (!file.read((char*)fontData.data(), size)) {
+        if (!loaded && !fontData.readFile(filename)) {
             std::cerr << "Failed to read TTF file: " << filename << std::endl;
             return false;
         }
@@ -518,9 +550,23 @@ namespace TTFParser {
         return readOffsetTable();
     }
 
+    bool TTFParser::loadFromMemory(const uint8_t* data, size_t size) {
+        clearParsedState();
+
+        fontData.borrow(data, size);
+        return readOffsetTable();
+    }
+
+    bool TTFParser::loadFromMemory(std::vector<uint8_t>&& data) {
+        clearParsedState();
+
+        fontData.adopt(std::move(data));
+        return readOffsetTable();
+    }
+
     bool TTFParser::readOffsetTable() {
-        // Check font data size
-        if (fontData.size() < sizeof(OffsetTable)) {
+        // Check font data size (sfntVersion, numTables, searchRange, entrySelector, rangeShift)
+        if (fontData.size() < 12) {
             std::cerr << "Invalid TTF file: insufficient data for offset table" << std::endl;
             return false;
         }
@@ -533,9 +579,11 @@ namespace TTFParser {
         offsetTable.entrySelector = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
         offsetTable.rangeShift = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
 
+        const ByteView font = fontData.view();
+
         // Read table directory entries
         for (uint16_t i = 0; i < offsetTable.numTables; ++i) {
-            if (fontData.size() < offset + sizeof(TableDirectoryEntry)) {
+            if (!font.contains(offset, sizeof(TableDirectoryEntry))) {
                 std::cerr << "Invalid TTF file: insufficient data for table directory entry" << std::endl;
                 return false;
             }
@@ -548,73 +596,70 @@ namespace TTFParser {
 
             offsetTable.tableDirectoryEntries.push_back(entry);
 
-            // Load the table data for this entry
-            if (fontData.size() < entry.offset + entry.length) {
+            // Record a view of the table data for this entry; nothing is copied
+            if (!font.contains(entry.offset, entry.length)) {
                 std::cerr << "Invalid TTF file: insufficient data for table content" << std::endl;
                 return false;
             }
-            std::vector<uint8_t> table(fontData.begin() + entry.offset, fontData.begin() + entry.offset + entry.length);
 
-            char tagStr[5];
-            std::memcpy(tagStr, &entry.tag, 4);
-            tagStr[4] = '\0';
-            tableData[tagStr] = table;
+            if (!tableDirectory.add(swapEndian32(entry.tag), entry.checkSum, font.subview(entry.offset, entry.length))) {
+                std::cerr << "Invalid TTF file: duplicate table or too many tables" << std::endl;
+                return false;
+            }
         }
 
         return true;
     }
 
-    const std::vector<uint8_t>& TTFParser::getTableData(const std::string& tag) const {
-        static std::vector<uint8_t> empty;
-        auto it = tableData.find(tag);
-        return (it != tableData.end()) ? it->second : empty;
-    }
+    bool TTFParser::parseFVarTable(ByteView table, FVarTable& fvar) {
+        // Helper functions you've already defined: swapEndian32, swapEndian16, fixedToFloat
 
-    uint32_t TTFParser::getTableLength(const std::string& tableName) {
-        uint32_t tag = *(uint32_t*)tableName.c_str();  // Convert the string to its uint32_t representation
-        for (const auto& entry : offsetTable.tableDirectoryEntries) {
-            if (entry.tag == tag) {
-                return entry.length;
-            }
+        if (table.size() < 16) {
+            std::cerr << "Error: not enough data for 'fvar' table header." << std::endl;
+            return false;
         }
-        return 0;  // Return 0 if table not found
-    }
-
-    bool TTFParser::parseFVarTable(uint32_t offset, FVarTable& fvar) {
-        // Helper functions you've already defined: swapEndian32, swapEndian16, fixedToFloat
 
         std::cout << "Raw 'fvar' data (first 100 bytes):" << std::endl;
-        for (int i = 0; i < 100; ++i) {
-            printf("%02X ", (uint8_t)fontData[offset + i]);
+        for (size_t i = 0; i < 100 && i < table.size(); ++i) {
+            printf("%02X ", (uint8_t)table[i]);
             if (i % 16 == 15) printf("\n");
         }
         printf("\n");
 
         // Parsing the header
-        uint16_t majorVersion = swapEndian16(*(uint16_t*)&fontData[offset]);
-        uint16_t minorVersion = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
-        uint16_t axesArrayOffset = swapEndian16(*(uint16_t*)&fontData[offset + 4]);
-        uint16_t reserved = swapEndian16(*(uint16_t*)&fontData[offset + 6]);
-        uint16_t axisCount = swapEndian16(*(uint16_t*)&fontData[offset + 8]);
-        uint16_t axisSize = swapEndian16(*(uint16_t*)&fontData[offset + 10]);
-        uint16_t instanceCount = swapEndian16(*(uint16_t*)&fontData[offset + 12]);
-        uint16_t instanceSize = swapEndian16(*(uint16_t*)&fontData[offset + 14]);
-
-
-        uint32_t currentOffset = offset + axesArrayOffset;
+        uint16_t majorVersion = swapEndian16(*(uint16_t*)&table[0]);
+        uint16_t minorVersion = swapEndian16(*(uint16_t*)&table[2]);
+        uint16_t axesArrayOffset = swapEndian16(*(uint16_t*)&table[4]);
+        uint16_t reserved = swapEndian16(*(uint16_t*)&table[6]);
+        uint16_t axisCount = swapEndian16(*(uint16_t*)&table[8]);
+        uint16_t axisSize = swapEndian16(*(uint16_t*)&table[10]);
+        uint16_t instanceCount = swapEndian16(*(uint16_t*)&table[12]);
+        uint16_t instanceSize = swapEndian16(*(uint16_t*)&table[14]);
+
+
+        uint32_t currentOffset = axesArrayOffset;
+
+        // Every axis record is 20 bytes; each instance record is instanceSize bytes
+        if (!table.contains(currentOffset, 20 * static_cast<size_t>(axisCount) + static_cast<size_t>(instanceSize) * instanceCount) ||
+            instanceSize < axisCount * sizeof(float) + 4) {
+            std::cerr << "Error: 'fvar' axis or instance records exceed table size." << std::endl;
+            return false;
+        }
 
-        std::cout << "Raw axis values (before fixedToFloat):" << std::endl;
-        printf("Min: %08X\n", swapEndian32(*(int32_t*)&fontData[currentOffset + 4]));
-        printf("Default: %08X\n", swapEndian32(*(int32_t*)&fontData[currentOffset + 8]));
-        printf("Max: %08X\n", swapEndian32(*(int32_t*)&fontData[currentOffset + 12]));
+        if (axisCount > 0) {
+            std::cout << "Raw axis values (before fixedToFloat):" << std::endl;
+            printf("Min: %08X\n", swapEndian32(*(int32_t*)&table[currentOffset + 4]));
+            printf("Default: %08X\n", swapEndian32(*(int32_t*)&table[currentOffset + 8]));
+            printf("Max: %08X\n", swapEndian32(*(int32_t*)&table[currentOffset + 12]));
+        }
 
 
         // Parsing the VariationAxisRecord array
         for (uint16_t i = 0; i < axisCount; ++i) {
-            uint32_t axisTag = swapEndian32(*(uint32_t*)&fontData[currentOffset]);
-            float minValue = fixedToFloat(swapEndian32(*(int32_t*)&fontData[currentOffset + 4]));
-            float defaultValue = fixedToFloat(swapEndian32(*(int32_t*)&fontData[currentOffset + 8]));
-            float maxValue = fixedToFloat(swapEndian32(*(int32_t*)&fontData[currentOffset + 12]));
+            uint32_t axisTag = swapEndian32(*(uint32_t*)&table[currentOffset]);
+            float minValue = fixedToFloat(swapEndian32(*(int32_t*)&table[currentOffset + 4]));
+            float defaultValue = fixedToFloat(swapEndian32(*(int32_t*)&table[currentOffset + 8]));
+            float maxValue = fixedToFloat(swapEndian32(*(int32_t*)&table[currentOffset + 12]));
 
             // Check if values are in the expected range
             if (minValue > defaultValue || defaultValue > maxValue) {
@@ -632,13 +677,13 @@ namespace TTFParser {
         // Parsing the InstanceRecord array
         for (uint16_t i = 0; i < instanceCount; ++i) {
             // Only reading the necessary fields for demonstration
-            uint16_t subfamilyNameID = swapEndian16(*(uint16_t*)&fontData[currentOffset]);
-            uint16_t flags = swapEndian16(*(uint16_t*)&fontData[currentOffset + 2]);
+            uint16_t subfamilyNameID = swapEndian16(*(uint16_t*)&table[currentOffset]);
+            uint16_t flags = swapEndian16(*(uint16_t*)&table[currentOffset + 2]);
 
             // Skipping to coordinates
             currentOffset += 4; // The first two fields of the InstanceRecord take up 4 bytes total
             for (uint16_t j = 0; j < axisCount; ++j) {
-                float coordinate = fixedToFloat(swapEndian32(*(int32_t*)&fontData[currentOffset]));
+                float coordinate = fixedToFloat(swapEndian32(*(int32_t*)&table[currentOffset]));
                 currentOffset += sizeof(float); // Since a coordinate is a float (Fixed type)
             }
             // If postScriptNameID is present, it can be parsed here.
@@ -649,482 +694,855 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseGlyph(uint32_t glyphOffset, SimpleGlyph& glyph) {
-        static int compoundGlyphCount = 0;
+    bool TTFParser::parseGlyph(ByteView glyphData, SimpleGlyph& glyph) {
+        glyph = SimpleGlyph();
 
-        if (glyphOffset >= fontData.size()) {
-            return false; // Offset out of range
+        // Glyphs without outlines (e.g., space character) have no data at all in 'glyf'
+        if (glyphData.empty()) {
+            return true;
         }
 
-        uint32_t offset = glyphOffset;
+        uint32_t offset = 0;
 
         // Check for sufficient data for header
-        if (offset + 10 > fontData.size()) {
+        if (offset + 10 > glyphData.size()) {
             return false;
         }
 
         // Read the glyph header
-        int16_t numberOfContours = swapEndian16(*(int16_t*)&fontData[offset]);
-        offset += 2;
+        int16_t numberOfContours = swapEndian16(*(int16_t*)&glyphData[offset]);
+        glyph.xMin = swapEndian16(*(int16_t*)&glyphData[offset + 2]);
+        glyph.yMin = swapEndian16(*(int16_t*)&glyphData[offset + 4]);
+        glyph.xMax = swapEndian16(*(int16_t*)&glyphData[offset + 6]);
+        glyph.yMax = swapEndian16(*(int16_t*)&glyphData[offset + 8]);
+        offset += 10;
 
-        // Bounding box values which we'll skip for now
-        offset += 8;
+        glyph.numberOfContours = numberOfContours;
 
         // If numberOfContours is positive, the glyph is simple
         if (numberOfContours > 0) {
-            glyph.numberOfContours = numberOfContours;
-
-            // Check for sufficient data for end points of contours
-            if (offset + 2 * numberOfContours > fontData.size()) {
+            // Read the end points of each contour
+            if (!readU16Array(glyphData, offset, numberOfContours, glyph.endPointOfContours)) {
                 return false;
             }
+            offset += 2 * numberOfContours;
 
-            // Read the end points of each contour
-            for (int i = 0; i < numberOfContours; ++i) {
-                uint16_t endPoint = swapEndian16(*(uint16_t*)&fontData[offset]);
-                glyph.endPointOfContours.push_back(endPoint);
-                offset += 2;
+            for (int i = 1; i < numberOfContours; ++i) {
+                if (glyph.endPointOfContours[i] <= glyph.endPointOfContours[i - 1]) {
+                    std::cerr << "Error: Contour end points are not in ascending order." << std::endl;
+                    return false;
+                }
             }
 
             // Check for sufficient data for instruction length
-            if (offset + 2 > fontData.size()) {
+            if (offset + 2 > glyphData.size()) {
                 return false;
             }
 
             // Read the instruction length
-            glyph.instructionLength = swapEndian16(*(uint16_t*)&fontData[offset]);
+            glyph.instructionLength = swapEndian16(*(uint16_t*)&glyphData[offset]);
             offset += 2;
 
             // Check for sufficient data for instructions
-            if (offset + glyph.instructionLength > fontData.size()) {
+            if (offset + glyph.instructionLength > glyphData.size()) {
                 return false;
             }
 
             // Read the instructions
             glyph.instructions.resize(glyph.instructionLength);
-            std::memcpy(glyph.instructions.data(), &fontData[offset], glyph.instructionLength);
+            std::memcpy(glyph.instructions.data(), &glyphData[offset], glyph.instructionLength);
             offset += glyph.instructionLength;
 
-            // TODO: Read the flags and points for the glyph
+            // Read the flags and points for the glyph
+            const size_t numPoints = static_cast<size_t>(glyph.endPointOfContours.back()) + 1;
+            if (numPoints > 0xFFFF) {
+                std::cerr << "Error: Simple glyph has too many points." << std::endl;
+                return false;
+            }
+
+            thread_local std::vector<uint8_t> flags; // Scratch space, reused across glyphs
+            flags.resize(numPoints);
+            glyph.numPoints = static_cast<uint16_t>(numPoints);
+            glyph.xCoordinates.resize(numPoints);
+            glyph.yCoordinates.resize(numPoints);
 
+            if (!decodeSimpleGlyphPoints(glyphData, offset, numPoints, flags.data(), glyph.xCoordinates.data(), glyph.yCoordinates.data())) {
+                std::cerr << "Error: Simple glyph flags or coordinates exceed glyph data." << std::endl;
+                return false;
+            }
+
+            glyph.onCurve.resize((numPoints + 63) / 64);
+            packOnCurveBits(flags.data(), numPoints, glyph.onCurve.data());
+            glyph.overlapSimple = (flags[0] & OVERLAP_SIMPLE) != 0;
         }
 
         else if (numberOfContours == -1) {
             CompoundGlyph compoundGlyph;
-            if (!parseCompoundGlyph(offset, compoundGlyph)) {
-                std::cerr << "Failed to parse compound glyph at offset " << glyphOffset << "." << std::endl;
+            if (!parseCompoundGlyph(glyphData, offset, compoundGlyph)) {
+                std::cerr << "Failed to parse compound glyph." << std::endl;
                 return false;
             }
+        }
+
+        return true;
+    }
+
+    // Byte size of one coordinate, indexed by (isShort | isSameOrPositive << 1):
+    // a 16-bit delta, a negative byte, no data (same as previous), or a positive byte.
+    static const uint8_t kCoordinateSize[4] = { 2, 1, 0, 1 };
 
-            compoundGlyphCount++;
-            std::cout << "Successfully parsed compound glyph #" << compoundGlyphCount
-                << " at offset " << glyphOffset << "." << std::endl;
+    // Decodes one axis of coordinate deltas into `out` and turns them into absolute values.
+    // The caller has already checked that [pos, end) holds exactly the bytes the flags ask for.
+    static void decodeCoordinateAxis(const uint8_t* data, size_t pos, size_t end, const uint8_t* flags, size_t numPoints,
+        unsigned shortShift, unsigned sameShift, int16_t* out) {
+        for (size_t i = 0; i < numPoints; ++i) {
+            const unsigned kind = ((flags[i] >> shortShift) & 1) | (((flags[i] >> sameShift) & 1) << 1);
+
+            // Load both candidate bytes unconditionally (clamped to the range) and select, so
+            // the loop body compiles to conditional moves rather than a three-way branch.
+            const int32_t b0 = pos < end ? data[pos] : 0;
+            const int32_t b1 = pos + 1 < end ? data[pos + 1] : 0;
+            const int32_t wordDelta = static_cast<int16_t>((b0 << 8) | b1);
+            const int32_t byteDelta = (kind & 2) ? b0 : -b0;
+            const int32_t delta = (kind & 1) ? byteDelta : ((kind & 2) ? 0 : wordDelta);
+
+            out[i] = static_cast<int16_t>(delta);
+            pos += kCoordinateSize[kind];
         }
 
-        else {
-            compoundGlyphCount++;
+        // Deltas -> absolute coordinates (16-bit wrap-around, as TrueType rasterizers do)
+        uint16_t value = 0;
+        for (size_t i = 0; i < numPoints; ++i) {
+            value = static_cast<uint16_t>(value + static_cast<uint16_t>(out[i]));
+            out[i] = static_cast<int16_t>(value);
+        }
+    }
 
-            std::cout << "This glyph is empty (e.g., space character), glyph #" << compoundGlyphCount
-                << " at offset " << glyphOffset << "." << std::endl;
+    bool TTFParser::decodeSimpleGlyphPoints(ByteView glyphData, uint32_t& offset, size_t numPoints,
+        uint8_t* flags, int16_t* x, int16_t* y) {
+        // Expand the flag runs, totalling the coordinate bytes as we go
+        size_t pos = offset;
+        size_t flagCount = 0;
+        size_t xBytes = 0;
+        size_t yBytes = 0;
+        while (flagCount < numPoints) {
+            if (pos >= glyphData.size()) {
+                return false;
+            }
 
-            // The glyph is empty (e.g., space character)
+            const uint8_t flag = glyphData[pos++];
+            size_t run = 1;
+            if (flag & REPEAT_FLAG) {
+                if (pos >= glyphData.size()) {
+                    return false;
+                }
+                run += glyphData[pos++];
+            }
+
+            if (run > numPoints - flagCount) {
+                return false; // Repeat count runs past the last point
+            }
+
+            std::memset(flags + flagCount, flag, run);
+            xBytes += kCoordinateSize[((flag >> 1) & 1) | ((flag >> 3) & 2)] * run;
+            yBytes += kCoordinateSize[((flag >> 2) & 1) | ((flag >> 4) & 2)] * run;
+            flagCount += run;
         }
 
+        // One bounds check covers every coordinate read below
+        const size_t xStart = pos;
+        const size_t yStart = xStart + xBytes;
+        const size_t yEnd = yStart + yBytes;
+        if (yEnd > glyphData.size()) {
+            return false;
+        }
+
+        decodeCoordinateAxis(glyphData.data(), xStart, yStart, flags, numPoints, 1, 4, x);
+        decodeCoordinateAxis(glyphData.data(), yStart, yEnd, flags, numPoints, 2, 5, y);
+
+        offset = static_cast<uint32_t>(yEnd);
         return true;
     }
 
-    bool TTFParser::parseCompoundGlyph(uint32_t& offset, CompoundGlyph& glyph) {
+    void TTFParser::packOnCurveBits(const uint8_t* flags, size_t numPoints, uint64_t* words) {
+        const size_t numWords = (numPoints + 63) / 64;
+        for (size_t w = 0; w < numWords; ++w) {
+            const size_t first = w * 64;
+            const size_t last = (first + 64 < numPoints) ? first + 64 : numPoints;
+
+            uint64_t bits = 0;
+            for (size_t i = first; i < last; ++i) {
+                bits |= static_cast<uint64_t>(flags[i] & ON_CURVE_POINT) << (i - first);
+            }
+            words[w] = bits;
+        }
+    }
+
+    bool TTFParser::parseCompoundGlyph(ByteView glyphData, uint32_t& offset, CompoundGlyph& glyph) const {
         bool continueParsing = true;
+        bool haveInstructions = false;
         uint16_t flags;
 
         while (continueParsing) {
             // Ensure there's enough data for the flags and glyph index
-            if (offset + 4 > fontData.size()) {
+            if (offset + 4 > glyphData.size()) {
                 return false;
             }
 
-            flags = swapEndian16(*(uint16_t*)&fontData[offset]);
+            flags = swapEndian16(*(uint16_t*)&glyphData[offset]);
             offset += 2;
 
-            uint16_t glyphIndex = swapEndian16(*(uint16_t*)&fontData[offset]);
+            uint16_t glyphIndex = swapEndian16(*(uint16_t*)&glyphData[offset]);
             offset += 2;
 
-            glyph.components.push_back(CompoundComponent{ glyphIndex }); // Store the glyph index
-
-            std::cout << "Parsed compound glyph. Flags: " << flags
-                << ", Glyph Index: " << glyphIndex << std::endl;
+            CompoundComponent component{ glyphIndex };
+            component.flags = flags;
 
             // Handle ARG_1_AND_2_ARE_WORDS flag
-            int arg1, arg2;
-            if (flags & ARG_1_AND_2_ARE_WORDS) {
-                arg1 = swapEndian16(*(int16_t*)&fontData[offset]);
-                offset += 2;
-                arg2 = swapEndian16(*(int16_t*)&fontData[offset]);
-                offset += 2;
+            if (offset + ((flags & ARG_1_AND_2_ARE_WORDS) ? 4 : 2) > glyphData.size()) {
+                return false;
+            }
 
-                std::cout << "Arguments are words. Arg1: " << arg1
-                    << ", Arg2: " << arg2 << std::endl;
+            // Offsets are signed; point numbers are unsigned
+            const bool xyValues = (flags & ARGS_ARE_XY_VALUES) != 0;
+            if (flags & ARG_1_AND_2_ARE_WORDS) {
+                const uint16_t word1 = swapEndian16(*(uint16_t*)&glyphData[offset]);
+                const uint16_t word2 = swapEndian16(*(uint16_t*)&glyphData[offset + 2]);
+                component.arg1 = xyValues ? int(int16_t(word1)) : int(word1);
+                component.arg2 = xyValues ? int(int16_t(word2)) : int(word2);
+                offset += 4;
             }
             else {
-                arg1 = (int8_t)fontData[offset++];
-                arg2 = (int8_t)fontData[offset++];
-
-                std::cout << "Arguments are bytes. Arg1: " << arg1
-                    << ", Arg2: " << arg2 << std::endl;
+                const uint8_t byte1 = glyphData[offset++];
+                const uint8_t byte2 = glyphData[offset++];
+                component.arg1 = xyValues ? int(int8_t(byte1)) : int(byte1);
+                component.arg2 = xyValues ? int(int8_t(byte2)) : int(byte2);
             }
 
+            // Read the scale or 2x2 transform, kept as raw F2Dot14 values
             if (flags & WE_HAVE_A_SCALE) {
-                if (offset + 2 > fontData.size()) {
+                if (offset + 2 > glyphData.size()) {
                     return false;
                 }
 
-                float scale = f2Dot14ToFloat(swapEndian16(*(int16_t*)&fontData[offset]));
+                component.xScale = (int16_t)swapEndian16(*(uint16_t*)&glyphData[offset]);
+                component.yScale = component.xScale;
                 offset += 2;
-
-                std::cout << "Single scale: " << scale << std::endl;
             }
             else if (flags & WE_HAVE_AN_X_AND_Y_SCALE) {
-                if (offset + 4 > fontData.size()) {
+                if (offset + 4 > glyphData.size()) {
                     return false;
                 }
 
-                float scaleX = f2Dot14ToFloat(swapEndian16(*(int16_t*)&fontData[offset]));
-                offset += 2;
-                float scaleY = f2Dot14ToFloat(swapEndian16(*(int16_t*)&fontData[offset]));
-                offset += 2;
-
-                std::cout << "Scale X: " << scaleX << ", Scale Y: " << scaleY << std::endl;
+                component.xScale = (int16_t)swapEndian16(*(uint16_t*)&glyphData[offset]);
+                component.yScale = (int16_t)swapEndian16(*(uint16_t*)&glyphData[offset + 2]);
+                offset += 4;
             }
             else if (flags & WE_HAVE_A_TWO_BY_TWO) {
-                if (offset + 8 > fontData.size()) {
+                if (offset + 8 > glyphData.size()) {
                     return false;
                 }
 
-                float scaleX = f2Dot14ToFloat(swapEndian16(*(int16_t*)&fontData[offset]));
-                offset += 2;
-                float skew0 = f2Dot14ToFloat(swapEndian16(*(int16_t*)&fontData[offset]));
-                offset += 2;
-                float skew1 = f2Dot14ToFloat(swapEndian16(*(int16_t*)&fontData[offset]));
-                offset += 2;
-                float scaleY = f2Dot14ToFloat(swapEndian16(*(int16_t*)&fontData[offset]));
-                offset += 2;
-
-                std::cout << "2x2 Matrix - Scale X: " << scaleX << ", Skew 0: " << skew0
-                    << ", Skew 1: " << skew1 << ", Scale Y: " << scaleY << std::endl;
+                component.xScale = (int16_t)swapEndian16(*(uint16_t*)&glyphData[offset]);
+                component.scale01 = (int16_t)swapEndian16(*(uint16_t*)&glyphData[offset + 2]);
+                component.scale10 = (int16_t)swapEndian16(*(uint16_t*)&glyphData[offset + 4]);
+                component.yScale = (int16_t)swapEndian16(*(uint16_t*)&glyphData[offset + 6]);
+                offset += 8;
             }
 
+            glyph.components.push_back(component);
+            haveInstructions |= (flags & WE_HAVE_INSTRUCTIONS) != 0;
+
             // Check if there are more components to read
             continueParsing = (flags & MORE_COMPONENTS) != 0;
         }
 
         // Handle the WE_HAVE_INSTRUCTIONS flag after all components are parsed
-        if (flags & WE_HAVE_INSTRUCTIONS) {
-            if (offset + 2 > fontData.size()) {
+        // (it belongs on the last component, but is honoured on any of them, as WOFF2 does)
+        if (haveInstructions) {
+            if (offset + 2 > glyphData.size()) {
                 return false; // Insufficient data for instruction length
             }
 
-            uint16_t instructionLength = swapEndian16(*(uint16_t*)&fontData[offset]);
+            uint16_t instructionLength = swapEndian16(*(uint16_t*)&glyphData[offset]);
             offset += 2;
 
-            if (offset + instructionLength > fontData.size()) {
+            if (offset + instructionLength > glyphData.size()) {
                 return false; // Insufficient data for instructions
             }
 
-            // For now, we'll just skip the instructions.
+            glyph.instructions.assign(&glyphData[offset], &glyphData[offset] + instructionLength);
             offset += instructionLength;
-
-            std::cout << "Parsed instructions of length: " << instructionLength << std::endl;
         }
 
         return true;
     }
     
-    bool TTFParser::parseCmapTable(uint32_t offset, CmapTable& cmap) {
-        cmap.version = swapEndian16(*(uint16_t*)&fontData[offset]);
-        cmap.numTables = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
-
-        uint32_t currentOffset = offset + 4; // After version and numTables
+    struct TTFParser::GlyfArena {
+        size_t firstGlyph = 0; // Glyph range [firstGlyph, endGlyph) of the chunk.
+        size_t endGlyph = 0;
+        size_t failedGlyph = SIZE_MAX; // First glyph that failed to decode, if any.
+
+        std::vector<GlyphRecord> glyphs;
+        std::vector<uint16_t> endPointOfContours;
+        std::vector<int16_t> xCoordinates;
+        std::vector<int16_t> yCoordinates;
+        std::vector<uint8_t> flags; // Expanded flags; only the on-curve bits survive the merge.
+        std::vector<uint8_t> instructions;
+        std::vector<CompoundComponent> components;
+
+        CompoundGlyph compound; // Scratch space for compound glyphs.
+    };
+
+    bool TTFParser::decodeGlyphInto(ByteView glyphData, GlyfArena& arena) const {
+        GlyphRecord record;
+        record.firstContour = static_cast<uint32_t>(arena.endPointOfContours.size());
+        record.firstPoint = static_cast<uint32_t>(arena.xCoordinates.size());
+        record.firstInstruction = static_cast<uint32_t>(arena.instructions.size());
+        record.firstComponent = static_cast<uint32_t>(arena.components.size());
+
+        // Glyphs without outlines have no data at all
+        if (glyphData.empty()) {
+            arena.glyphs.push_back(record);
+            return true;
+        }
 
-        for (int i = 0; i < cmap.numTables; ++i) {
-            uint16_t platformID = swapEndian16(*(uint16_t*)&fontData[currentOffset]);
-            uint16_t encodingID = swapEndian16(*(uint16_t*)&fontData[currentOffset + 2]);
-            uint32_t subtableOffset = offset + swapEndian32(*(uint32_t*)&fontData[currentOffset + 4]);
+        if (glyphData.size() < 10) {
+            return false;
+        }
 
-            uint16_t format = swapEndian16(*(uint16_t*)&fontData[subtableOffset]);
-            std::cout << "Subtable format after swapping: " << format << std::endl;
+        record.numberOfContours = swapEndian16(*(int16_t*)&glyphData[0]);
+        record.xMin = swapEndian16(*(int16_t*)&glyphData[2]);
+        record.yMin = swapEndian16(*(int16_t*)&glyphData[4]);
+        record.xMax = swapEndian16(*(int16_t*)&glyphData[6]);
+        record.yMax = swapEndian16(*(int16_t*)&glyphData[8]);
+        uint32_t offset = 10;
 
-            std::cout << "Raw bytes at subtableOffset: ";
-            for (int j = 0; j < 4; ++j) {
-                printf("%02X ", (uint8_t)fontData[subtableOffset + j]);
+        if (record.numberOfContours > 0) {
+            const size_t numberOfContours = static_cast<size_t>(record.numberOfContours);
+            if (!glyphData.contains(offset, 2 * numberOfContours + 2)) {
+                return false;
             }
-            printf("\n");
 
-            switch (format) {
-            case 0:
-            {
-                CmapFormat0 subtable;
-                subtable.format = format;
+            arena.endPointOfContours.resize(record.firstContour + numberOfContours);
+            uint16_t* endPoints = &arena.endPointOfContours[record.firstContour];
+            decodeU16Array(&glyphData[offset], endPoints, numberOfContours);
+            offset += static_cast<uint32_t>(2 * numberOfContours);
 
-                if (!parseCmapFormat0(subtableOffset + 2, subtable)) {
-                    std::cout << "Failure at format 0" << std::endl;
+            for (size_t i = 1; i < numberOfContours; ++i) {
+                if (endPoints[i] <= endPoints[i - 1]) {
                     return false;
                 }
+            }
 
-                cmap.subtables.push_back(std::make_unique<CmapFormat0>(subtable));
-                break;
+            record.instructionLength = swapEndian16(*(uint16_t*)&glyphData[offset]);
+            offset += 2;
+            if (!glyphData.contains(offset, record.instructionLength)) {
+                return false;
             }
-            case 2:
-            {
-                CmapFormat2 subtable;
-                subtable.format = format;
+            arena.instructions.insert(arena.instructions.end(), &glyphData[offset], &glyphData[offset] + record.instructionLength);
+            offset += record.instructionLength;
 
-                if (!parseCmapFormat2(subtableOffset + 2, subtable)) {
-                    std::cout << "Failure at format 2" << std::endl;
-                    return false;
+            const size_t numPoints = static_cast<size_t>(endPoints[numberOfContours - 1]) + 1;
+            arena.xCoordinates.resize(record.firstPoint + numPoints);
+            arena.yCoordinates.resize(record.firstPoint + numPoints);
+            arena.flags.resize(record.firstPoint + numPoints);
+
+            if (!decodeSimpleGlyphPoints(glyphData, offset, numPoints, &arena.flags[record.firstPoint],
+                &arena.xCoordinates[record.firstPoint], &arena.yCoordinates[record.firstPoint])) {
+                return false;
+            }
+
+            record.numPoints = static_cast<uint32_t>(numPoints);
+            record.overlapSimple = (arena.flags[record.firstPoint] & OVERLAP_SIMPLE) != 0;
+        }
+
+        else if (record.numberOfContours < 0) {
+            arena.compound.components.clear();
+            arena.compound.instructions.clear();
+            if (!parseCompoundGlyph(glyphData, offset, arena.compound)) {
+                return false;
+            }
+
+            record.numComponents = static_cast<uint32_t>(arena.compound.components.size());
+            record.instructionLength = static_cast<uint32_t>(arena.compound.instructions.size());
+            arena.components.insert(arena.components.end(), arena.compound.components.begin(), arena.compound.components.end());
+            arena.instructions.insert(arena.instructions.end(), arena.compound.instructions.begin(), arena.compound.instructions.end());
+        }
+
+        arena.glyphs.push_back(record);
+        return true;
+    }
+
+    bool TTFParser::parseGlyfTable(ByteView glyfData, const LocaTable& loca, GlyfTable& table, ThreadPool* pool) const {
+        table = GlyfTable();
+
+        if (loca.offsets.empty() || loca.offsets.back() > glyfData.size()) {
+            std::cerr << "Error: 'loca' offsets do not fit the 'glyf' table." << std::endl;
+            return false;
+        }
+
+        const size_t glyphCount = loca.offsets.size() - 1;
+        auto runParallel = [pool](size_t count, const std::function<void(size_t)>& task) {
+            if (pool) {
+                pool->parallelFor(count, task);
+            }
+            else {
+                for (size_t i = 0; i < count; ++i) {
+                    task(i);
                 }
+            }
+        };
+
+        // Split the glyphs into chunks of similar byte size. A fixed per-glyph cost keeps long
+        // runs of empty glyphs from piling into one chunk; several chunks per thread leave the
+        // pool room to balance.
+        const uint64_t kGlyphCost = 16;
+        const uint64_t kMinChunkCost = 16 * 1024;
+        const size_t threads = pool ? pool->concurrency() : 1;
+        const uint64_t totalCost = loca.offsets.back() + glyphCount * kGlyphCost;
+        const uint64_t chunkCost = (threads > 1) ? std::max<uint64_t>(totalCost / (threads * 8), kMinChunkCost) : totalCost;
+
+        std::vector<GlyfArena> arenas;
+        size_t chunkStart = 0;
+        uint64_t cost = 0;
+        for (size_t glyph = 0; glyph < glyphCount; ++glyph) {
+            if (loca.offsets[glyph + 1] < loca.offsets[glyph]) {
+                std::cerr << "Error: 'loca' table offsets are not in ascending order." << std::endl;
+                return false;
+            }
 
-                cmap.subtables.push_back(std::make_unique<CmapFormat2>(subtable));
-                break;
+            cost += (loca.offsets[glyph + 1] - loca.offsets[glyph]) + kGlyphCost;
+            if (cost >= chunkCost || glyph + 1 == glyphCount) {
+                arenas.emplace_back();
+                arenas.back().firstGlyph = chunkStart;
+                arenas.back().endGlyph = glyph + 1;
+                chunkStart = glyph + 1;
+                cost = 0;
             }
-            case 4:
-            {
-                CmapFormat4 subtable;
-                subtable.format = format;
+        }
 
-                if (!parseCmapFormat4(subtableOffset + 2, subtable)) {
-                    std::cout << "Failure at format 4" << std::endl;
-                    return false;
+        // Decode each chunk into its own arena
+        runParallel(arenas.size(), [&](size_t chunk) {
+            GlyfArena& arena = arenas[chunk];
+            arena.glyphs.reserve(arena.endGlyph - arena.firstGlyph);
+
+            for (size_t glyph = arena.firstGlyph; glyph < arena.endGlyph; ++glyph) {
+                ByteView glyphData = glyfData.subview(loca.offsets[glyph], loca.offsets[glyph + 1] - loca.offsets[glyph]);
+                if (!decodeGlyphInto(glyphData, arena)) {
+                    arena.failedGlyph = glyph;
+                    return;
                 }
+            }
+        });
+
+        // Work out where each arena lands in the merged arrays
+        struct ArenaBase { size_t contour, point, instruction, component; };
+        std::vector<ArenaBase> bases(arenas.size());
+        ArenaBase total{ 0, 0, 0, 0 };
+        for (size_t chunk = 0; chunk < arenas.size(); ++chunk) {
+            const GlyfArena& arena = arenas[chunk];
+            if (arena.failedGlyph != SIZE_MAX) {
+                std::cerr << "Error: Failed to decode glyph " << arena.failedGlyph << " in 'glyf' table." << std::endl;
+                return false;
+            }
+
+            bases[chunk] = total;
+            total.contour += arena.endPointOfContours.size();
+            total.point += arena.xCoordinates.size();
+            total.instruction += arena.instructions.size();
+            total.component += arena.components.size();
+        }
+
+        if (total.point > UINT32_MAX || total.instruction > UINT32_MAX) {
+            std::cerr << "Error: 'glyf' table is too large to decode." << std::endl;
+            return false;
+        }
+
+        table.glyphs.resize(glyphCount);
+        table.endPointOfContours.resize(total.contour);
+        table.xCoordinates.resize(total.point);
+        table.yCoordinates.resize(total.point);
+        table.instructions.resize(total.instruction);
+        table.components.resize(total.component);
+        std::vector<uint8_t> flags(total.point);
+
+        // Merge in glyph order, rebasing each record onto the shared arrays
+        runParallel(arenas.size(), [&](size_t chunk) {
+            GlyfArena& arena = arenas[chunk];
+            const ArenaBase& base = bases[chunk];
+
+            for (size_t i = 0; i < arena.glyphs.size(); ++i) {
+                GlyphRecord record = arena.glyphs[i];
+                record.firstContour += static_cast<uint32_t>(base.contour);
+                record.firstPoint += static_cast<uint32_t>(base.point);
+                record.firstInstruction += static_cast<uint32_t>(base.instruction);
+                record.firstComponent += static_cast<uint32_t>(base.component);
+                table.glyphs[arena.firstGlyph + i] = record;
+            }
+
+            std::copy(arena.endPointOfContours.begin(), arena.endPointOfContours.end(), table.endPointOfContours.begin() + base.contour);
+            std::copy(arena.xCoordinates.begin(), arena.xCoordinates.end(), table.xCoordinates.begin() + base.point);
+            std::copy(arena.yCoordinates.begin(), arena.yCoordinates.end(), table.yCoordinates.begin() + base.point);
+            std::copy(arena.flags.begin(), arena.flags.end(), flags.begin() + base.point);
+            std::copy(arena.instructions.begin(), arena.instructions.end(), table.instructions.begin() + base.instruction);
+            std::copy(arena.components.begin(), arena.components.end(), table.components.begin() + base.component);
+
+            arena = GlyfArena(); // Release the arena as soon as it is merged
+        });
+
+        // Pack the on-curve bits, in blocks of whole words so blocks never share a word
+        const size_t kWordsPerBlock = 4096;
+        table.onCurve.resize((total.point + 63) / 64);
+        const size_t blockCount = (table.onCurve.size() + kWordsPerBlock - 1) / kWordsPerBlock;
+        runParallel(blockCount, [&](size_t block) {
+            const size_t firstPoint = block * kWordsPerBlock * 64;
+            const size_t numPoints = std::min(kWordsPerBlock * 64, total.point - firstPoint);
+            packOnCurveBits(&flags[firstPoint], numPoints, &table.onCurve[block * kWordsPerBlock]);
+        });
+
+        return true;
+    }
+
+    bool TTFParser::validateChecksums(ChecksumReport& report, ThreadPool* pool) const {
+        report = ChecksumReport();
+
+        const ByteView font = fontData.view();
+        const size_t kSliceSize = 1 << 20; // Multiple of 4, so slice sums add up to the font sum
+        const size_t tableCount = tableDirectory.size();
+        const size_t sliceCount = (font.size() + kSliceSize - 1) / kSliceSize;
+
+        // One task per table and one per slice of the whole font
+        report.tables.resize(tableCount);
+        std::vector<uint32_t> sliceSums(sliceCount, 0);
+        const TableRecord* records = tableDirectory.begin();
+        const std::function<void(size_t)> task = [&](size_t index) {
+            if (index < tableCount) {
+                const TableRecord& record = records[index];
+                report.tables[index].tag = record.tag;
+                report.tables[index].stored = record.checkSum;
+                report.tables[index].computed = calculateTableChecksum(Tag(record.tag), record.data);
+            }
+            else {
+                const size_t slice = index - tableCount;
+                sliceSums[slice] = calculateTableChecksum(font.subview(slice * kSliceSize, std::min(kSliceSize, font.size() - slice * kSliceSize)));
+            }
+        };
+        if (pool) {
+            pool->parallelFor(tableCount + sliceCount, task);
+        }
+        else {
+            for (size_t i = 0; i < tableCount + sliceCount; ++i) {
+                task(i);
+            }
+        }
+
+        const TableRecord* head = tableDirectory.find("head");
+        if (head && head->data.size() >= 12) {
+            uint32_t fontSum = 0;
+            for (uint32_t sum : sliceSums) {
+                fontSum += sum;
+            }
 
-                cmap.subtables.push_back(std::make_unique<CmapFormat4>(subtable));
+            // Take the stored adjustment back out of the font sum, byte by byte in case 'head' is not 4-byte aligned
+            const size_t adjustmentOffset = static_cast<size_t>(head->data.data() - font.data()) + 8;
+            for (size_t i = 0; i < 4; ++i) {
+                fontSum -= uint32_t(font[adjustmentOffset + i]) << (24 - 8 * ((adjustmentOffset + i) & 3));
+            }
+
+            report.hasHead = true;
+            report.storedAdjustment = (uint32_t(head->data[8]) << 24) | (uint32_t(head->data[9]) << 16) |
+                (uint32_t(head->data[10]) << 8) | head->data[11];
+            report.expectedAdjustment = kFontChecksumMagic - fontSum;
+        }
+        return report.valid();
+    }
+
+    bool TTFParser::parseCmapTable(ByteView table, CmapTable& cmap) {
+        cmap.encodingRecords.clear();
+        cmap.subtables.clear();
+        if (table.size() < 4) {
+            std::cerr << "Error: not enough data for 'cmap' table header." << std::endl;
+            return false;
+        }
+
+        cmap.version = swapEndian16(*(uint16_t*)&table[0]);
+        cmap.numTables = swapEndian16(*(uint16_t*)&table[2]);
+        if (!table.contains(4, 8 * static_cast<size_t>(cmap.numTables))) {
+            std::cerr << "Error: 'cmap' encoding records exceed table size." << std::endl;
+            return false;
+        }
+
+        // Fonts commonly point several records (Unicode, Windows BMP, ...) at one subtable
+        std::unordered_map<uint32_t, int32_t> subtableIndices;
+        cmap.encodingRecords.reserve(cmap.numTables);
+
+        for (uint32_t i = 0, currentOffset = 4; i < cmap.numTables; ++i, currentOffset += 8) {
+            CmapEncodingRecord record;
+            record.platformID = swapEndian16(*(uint16_t*)&table[currentOffset]);
+            record.encodingID = swapEndian16(*(uint16_t*)&table[currentOffset + 2]);
+            record.subtableOffset = swapEndian32(*(uint32_t*)&table[currentOffset + 4]);
+
+            const auto known = subtableIndices.find(record.subtableOffset);
+            if (known != subtableIndices.end()) {
+                record.subtableIndex = known->second;
+                cmap.encodingRecords.push_back(record);
+                continue;
+            }
+
+            // Each subtable parser receives the subtable starting at its format field
+            ByteView subtableData = table.subview(record.subtableOffset);
+            if (subtableData.size() < 4) {
+                std::cerr << "Error: 'cmap' subtable offset exceeds table size." << std::endl;
+                return false;
+            }
+
+            uint16_t format = swapEndian16(*(uint16_t*)&subtableData[0]);
+            std::unique_ptr<CmapSubtable> decoded;
+            bool parsed = false;
+
+            switch (format) {
+            case 0:
+            {
+                auto subtable = std::make_unique<CmapFormat0>();
+                parsed = parseCmapFormat0(subtableData, *subtable);
+                decoded = std::move(subtable);
+                break;
+            }
+            case 2:
+            {
+                auto subtable = std::make_unique<CmapFormat2>();
+                parsed = parseCmapFormat2(subtableData, *subtable);
+                decoded = std::move(subtable);
+                break;
+            }
+            case 4:
+            {
+                auto subtable = std::make_unique<CmapFormat4>();
+                parsed = parseCmapFormat4(subtableData, *subtable);
+                decoded = std::move(subtable);
                 break;
             }
             case 6:
             {
-                CmapFormat6 subtable;
-                subtable.format = format;
-
-                if (!parseCmapFormat6(subtableOffset + 2, subtable)) {
-                    std::cout << "Failure at format 6" << std::endl;
-                    return false;
-                }
-
-                cmap.subtables.push_back(std::make_unique<CmapFormat6>(subtable));
+                auto subtable = std::make_unique<CmapFormat6>();
+                parsed = parseCmapFormat6(subtableData, *subtable);
+                decoded = std::move(subtable);
                 break;
             }
             case 8:
             {
-                CmapFormat8 subtable;
-                subtable.format = format;
-
-                if (!parseCmapFormat8(subtableOffset + 2, subtable)) {
-                    std::cout << "Failure at format 8" << std::endl;
-                    return false;
-                }
-
-                cmap.subtables.push_back(std::make_unique<CmapFormat8>(subtable));
+                auto subtable = std::make_unique<CmapFormat8>();
+                parsed = parseCmapFormat8(subtableData, *subtable);
+                decoded = std::move(subtable);
                 break;
             }
             case 10:
             {
-                CmapFormat10 subtable;
-                subtable.format = format;
-
-                if (!parseCmapFormat10(subtableOffset + 2, subtable)) {
-                    std::cout << "Failure at format 10" << std::endl;
-                    return false;
-                }
-
-                cmap.subtables.push_back(std::make_unique<CmapFormat10>(subtable));
+                auto subtable = std::make_unique<CmapFormat10>();
+                parsed = parseCmapFormat10(subtableData, *subtable);
+                decoded = std::move(subtable);
                 break;
             }
             case 12:
             {
-                CmapFormat12 subtable;
-                subtable.format = format;
-
-                if (!parseCmapFormat12(subtableOffset + 2, subtable)) {
-                    std::cout << "Failure at format 12" << std::endl;
-                    return false;
-                }
-
-                cmap.subtables.push_back(std::make_unique<CmapFormat12>(subtable));
+                auto subtable = std::make_unique<CmapFormat12>();
+                parsed = parseCmapFormat12(subtableData, *subtable);
+                decoded = std::move(subtable);
+                break;
+            }
+            case 13:
+            {
+                auto subtable = std::make_unique<CmapFormat13>();
+                parsed = parseCmapFormat13(subtableData, *subtable);
+                decoded = std::move(subtable);
                 break;
             }
             case 14:
             {
-                CmapFormat14 subtable;
-                subtable.format = format;
-
-                if (!parseCmapFormat14(subtableOffset + 2, subtable)) {
-                    std::cout << "Failure at format 14" << std::endl;
-                    return false;
-                }
-
-                cmap.subtables.push_back(std::make_unique<CmapFormat14>(subtable));
+                auto subtable = std::make_unique<CmapFormat14>();
+                parsed = parseCmapFormat14(subtableData, *subtable);
+                decoded = std::move(subtable);
                 break;
             }
-
-
             default:
-                std::cout << "Unknown or unhandled format: " << format << std::endl;
+                // Unknown formats are skipped; their records keep no subtable
                 break;
             }
 
+            if (decoded && !parsed) {
+                std::cerr << "Error: Failed to parse 'cmap' format " << format << " subtable." << std::endl;
+                return false;
+            }
 
-            currentOffset += 8; // Move to the next encoding record
-
-            return true;
+            record.subtableIndex = -1;
+            if (decoded) {
+                decoded->format = format;
+                record.subtableIndex = static_cast<int32_t>(cmap.subtables.size());
+                cmap.subtables.push_back(std::move(decoded));
+            }
+            subtableIndices.emplace(record.subtableOffset, record.subtableIndex);
+            cmap.encodingRecords.push_back(record);
         }
+
+        return true;
     }
 
-    bool TTFParser::parseMaxpTable(uint32_t offset) {
-        if (fontData.size() < offset + 6) { // 6 bytes is the minimum size to get version and numGlyphs
+    bool TTFParser::parseMaxpTable(ByteView table) {
+        if (table.size() < 6) { // 6 bytes is the minimum size to get version and numGlyphs
             std::cerr << "Error: not enough data for 'maxp' table." << std::endl;
             return false;
         }
 
         // The version of the 'maxp' table (could be 0.5 or 1.0). 
         // We'll read it but won't use it for now.
-        float version = fixedToFloat(swapEndian32(*(int32_t*)&fontData[offset]));
-        offset += 4;
+        float version = fixedToFloat(swapEndian32(*(int32_t*)&table[0]));
 
-        numGlyphs = swapEndian16(*(uint16_t*)&fontData[offset]);
+        numGlyphs = swapEndian16(*(uint16_t*)&table[4]);
 
         return true;
     }
 
-    bool TTFParser::parseOS2Table(uint32_t offset, OS2Table& os2) {
+    bool TTFParser::parseOS2Table(ByteView table, OS2Table& os2) {
         // Base size check for version 0
-        if (fontData.size() < offset + 78) {
+        if (table.size() < 78) {
             std::cerr << "Error: not enough data for 'OS/2' table." << std::endl;
             return false;
         }
 
-        os2.version = swapEndian16(*(uint16_t*)&fontData[offset]);
+        os2.version = swapEndian16(*(uint16_t*)&table[0]);
 
-        if (os2.version > 4) {
+        if (os2.version > 5) {
             std::cerr << "Error: Unsupported 'OS/2' table version." << std::endl;
             return false;
         }
 
         // Fields common for all versions
-        os2.xAvgCharWidth = swapEndian16(*(int16_t*)&fontData[offset + 2]);
-        os2.usWeightClass = swapEndian16(*(uint16_t*)&fontData[offset + 4]);
-        os2.usWidthClass = swapEndian16(*(uint16_t*)&fontData[offset + 6]);
-        os2.fsType = swapEndian16(*(uint16_t*)&fontData[offset + 8]);
-        os2.ySubscriptXSize = swapEndian16(*(int16_t*)&fontData[offset + 10]);
-        os2.ySubscriptYSize = swapEndian16(*(int16_t*)&fontData[offset + 12]);
-        os2.ySubscriptXOffset = swapEndian16(*(int16_t*)&fontData[offset + 14]);
-        os2.ySubscriptYOffset = swapEndian16(*(int16_t*)&fontData[offset + 16]);
-        os2.ySuperscriptXSize = swapEndian16(*(int16_t*)&fontData[offset + 18]);
-        os2.ySuperscriptYSize = swapEndian16(*(int16_t*)&fontData[offset + 20]);
-        os2.ySuperscriptXOffset = swapEndian16(*(int16_t*)&fontData[offset + 22]);
-        os2.ySuperscriptYOffset = swapEndian16(*(int16_t*)&fontData[offset + 24]);
-        os2.yStrikeoutSize = swapEndian16(*(int16_t*)&fontData[offset + 26]);
-        os2.yStrikeoutPosition = swapEndian16(*(int16_t*)&fontData[offset + 28]);
-        os2.sFamilyClass = swapEndian16(*(int16_t*)&fontData[offset + 30]);
-        std::memcpy(os2.panose, &fontData[offset + 32], 10);
-        os2.ulUnicodeRange1 = swapEndian32(*(uint32_t*)&fontData[offset + 42]);
-        os2.ulUnicodeRange2 = swapEndian32(*(uint32_t*)&fontData[offset + 46]);
-        os2.ulUnicodeRange3 = swapEndian32(*(uint32_t*)&fontData[offset + 50]);
-        os2.ulUnicodeRange4 = swapEndian32(*(uint32_t*)&fontData[offset + 54]);
-        std::memcpy(os2.achVendID, &fontData[offset + 58], 4);
-        os2.fsSelection = swapEndian16(*(uint16_t*)&fontData[offset + 62]);
-        os2.usFirstCharIndex = swapEndian16(*(uint16_t*)&fontData[offset + 64]);
-        os2.usLastCharIndex = swapEndian16(*(uint16_t*)&fontData[offset + 66]);
-        os2.sTypoAscender = swapEndian16(*(int16_t*)&fontData[offset + 68]);
-        os2.sTypoDescender = swapEndian16(*(int16_t*)&fontData[offset + 70]);
-        os2.sTypoLineGap = swapEndian16(*(int16_t*)&fontData[offset + 72]);
-        os2.usWinAscent = swapEndian16(*(uint16_t*)&fontData[offset + 74]);
-        os2.usWinDescent = swapEndian16(*(uint16_t*)&fontData[offset + 76]);
+        os2.xAvgCharWidth = swapEndian16(*(int16_t*)&table[2]);
+        os2.usWeightClass = swapEndian16(*(uint16_t*)&table[4]);
+        os2.usWidthClass = swapEndian16(*(uint16_t*)&table[6]);
+        os2.fsType = swapEndian16(*(uint16_t*)&table[8]);
+        os2.ySubscriptXSize = swapEndian16(*(int16_t*)&table[10]);
+        os2.ySubscriptYSize = swapEndian16(*(int16_t*)&table[12]);
+        os2.ySubscriptXOffset = swapEndian16(*(int16_t*)&table[14]);
+        os2.ySubscriptYOffset = swapEndian16(*(int16_t*)&table[16]);
+        os2.ySuperscriptXSize = swapEndian16(*(int16_t*)&table[18]);
+        os2.ySuperscriptYSize = swapEndian16(*(int16_t*)&table[20]);
+        os2.ySuperscriptXOffset = swapEndian16(*(int16_t*)&table[22]);
+        os2.ySuperscriptYOffset = swapEndian16(*(int16_t*)&table[24]);
+        os2.yStrikeoutSize = swapEndian16(*(int16_t*)&table[26]);
+        os2.yStrikeoutPosition = swapEndian16(*(int16_t*)&table[28]);
+        os2.sFamilyClass = swapEndian16(*(int16_t*)&table[30]);
+        std::memcpy(os2.panose, &table[32], 10);
+        os2.ulUnicodeRange1 = swapEndian32(*(uint32_t*)&table[42]);
+        os2.ulUnicodeRange2 = swapEndian32(*(uint32_t*)&table[46]);
+        os2.ulUnicodeRange3 = swapEndian32(*(uint32_t*)&table[50]);
+        os2.ulUnicodeRange4 = swapEndian32(*(uint32_t*)&table[54]);
+        std::memcpy(os2.achVendID, &table[58], 4);
+        os2.fsSelection = swapEndian16(*(uint16_t*)&table[62]);
+        os2.usFirstCharIndex = swapEndian16(*(uint16_t*)&table[64]);
+        os2.usLastCharIndex = swapEndian16(*(uint16_t*)&table[66]);
+        os2.sTypoAscender = swapEndian16(*(int16_t*)&table[68]);
+        os2.sTypoDescender = swapEndian16(*(int16_t*)&table[70]);
+        os2.sTypoLineGap = swapEndian16(*(int16_t*)&table[72]);
+        os2.usWinAscent = swapEndian16(*(uint16_t*)&table[74]);
+        os2.usWinDescent = swapEndian16(*(uint16_t*)&table[76]);
 
         // Version 1 specific fields
         if (os2.version >= 1) {
-            if (fontData.size() < offset + 80) {  // Check for two additional bytes for version 1
+            if (table.size() < 86) {  // Check for the code page ranges added in version 1
                 std::cerr << "Error: not enough data for 'OS/2' table version 1." << std::endl;
                 return false;
             }
 
-            os2.usBreakChar = swapEndian16(*(uint16_t*)&fontData[offset + 78]);
-            os2.usDefaultChar = swapEndian16(*(uint16_t*)&fontData[offset + 80]);
+            os2.ulCodePageRange1 = swapEndian32(*(uint32_t*)&table[78]);
+            os2.ulCodePageRange2 = swapEndian32(*(uint32_t*)&table[82]);
         }
 
         if (os2.version >= 2) {
-            if (fontData.size() < offset + 102) {  // Check for version 2 additional bytes
+            if (table.size() < 96) {  // Check for version 2 additional bytes
                 std::cerr << "Error: not enough data for 'OS/2' table version 2." << std::endl;
                 return false;
             }
 
-            os2.sCapHeight = swapEndian16(*(int16_t*)&fontData[offset + 88]);
-            os2.usMaxContext = swapEndian16(*(uint16_t*)&fontData[offset + 90]);
-            os2.ulCodePageRange1 = swapEndian32(*(uint32_t*)&fontData[offset + 94]);
-            os2.sxHeight = swapEndian16(*(int16_t*)&fontData[offset + 96]);
-            os2.ulCodePageRange2 = swapEndian32(*(uint32_t*)&fontData[offset + 98]);
+            os2.sxHeight = swapEndian16(*(int16_t*)&table[86]);
+            os2.sCapHeight = swapEndian16(*(int16_t*)&table[88]);
+            os2.usDefaultChar = swapEndian16(*(uint16_t*)&table[90]);
+            os2.usBreakChar = swapEndian16(*(uint16_t*)&table[92]);
+            os2.usMaxContext = swapEndian16(*(uint16_t*)&table[94]);
         }
 
-        if (os2.version >= 3) {
-            if (fontData.size() < offset + 104) {  // Check for version 3 additional bytes
-                std::cerr << "Error: not enough data for 'OS/2' table version 3." << std::endl;
+        if (os2.version >= 5) {
+            if (table.size() < 100) {  // Check for version 5 additional bytes
+                std::cerr << "Error: not enough data for 'OS/2' table version 5." << std::endl;
                 return false;
             }
 
-            os2.usLowerOpticalPointSize = swapEndian16(*(uint16_t*)&fontData[offset + 100]);
-            os2.usUpperOpticalPointSize = swapEndian16(*(uint16_t*)&fontData[offset + 102]);
+            os2.usLowerOpticalPointSize = swapEndian16(*(uint16_t*)&table[96]);
+            os2.usUpperOpticalPointSize = swapEndian16(*(uint16_t*)&table[98]);
         }
 
         return true;
     }
 
-    bool TTFParser::parsePostTable(uint32_t offset, PostTable& post) {
-        if (fontData.size() < offset + 32) { // Base size for the common fields.
+    bool TTFParser::parsePostTable(ByteView table, PostTable& post) {
+        if (table.size() < 32) { // Base size for the common fields.
             std::cerr << "Error: not enough data for 'post' table." << std::endl;
             return false;
         }
 
-        post.format = readFixed(offset);
-        post.italicAngle = readFixed(offset + 4);
-        post.underlinePosition = swapEndian16(*(int16_t*)&fontData[offset + 8]);
-        post.underlineThickness = swapEndian16(*(int16_t*)&fontData[offset + 10]);
-        post.isFixedPitch = swapEndian32(*(uint32_t*)&fontData[offset + 12]);
-        post.minMemType42 = swapEndian32(*(uint32_t*)&fontData[offset + 16]);
-        post.maxMemType42 = swapEndian32(*(uint32_t*)&fontData[offset + 20]);
-        post.minMemType1 = swapEndian32(*(uint32_t*)&fontData[offset + 24]);
-        post.maxMemType1 = swapEndian32(*(uint32_t*)&fontData[offset + 28]);
+        post.format = readFixed(table, 0);
+        post.italicAngle = readFixed(table, 4);
+        post.underlinePosition = swapEndian16(*(int16_t*)&table[8]);
+        post.underlineThickness = swapEndian16(*(int16_t*)&table[10]);
+        post.isFixedPitch = swapEndian32(*(uint32_t*)&table[12]);
+        post.minMemType42 = swapEndian32(*(uint32_t*)&table[16]);
+        post.maxMemType42 = swapEndian32(*(uint32_t*)&table[20]);
+        post.minMemType1 = swapEndian32(*(uint32_t*)&table[24]);
+        post.maxMemType1 = swapEndian32(*(uint32_t*)&table[28]);
 
         // Now, based on the format, we'll parse additional fields.
         if (post.format == 2.0) {
             // Parsing code for format 2.0
-            post.numberOfGlyphs = swapEndian16(*(uint16_t*)&fontData[offset + 32]);
-
-            if (fontData.size() < offset + 34 + 2 * post.numberOfGlyphs) {
+            if (table.size() < 34) {
                 std::cerr << "Error: not enough data for 'post' table format 2.0." << std::endl;
                 return false;
             }
 
-            for (uint16_t i = 0; i < post.numberOfGlyphs; i++) {
-                post.glyphNameIndex.push_back(swapEndian16(*(uint16_t*)&fontData[offset + 34 + i * 2]));
+            post.numberOfGlyphs = swapEndian16(*(uint16_t*)&table[32]);
+
+            if (!readU16Array(table, 34, post.numberOfGlyphs, post.glyphNameIndex)) {
+                std::cerr << "Error: not enough data for 'post' table format 2.0." << std::endl;
+                return false;
             }
 
-            uint32_t nameOffset = offset + 34 + 2 * post.numberOfGlyphs;
-            while (nameOffset < fontData.size()) {
-                uint8_t nameLength = fontData[nameOffset];
-                post.names.push_back(std::string((char*)&fontData[nameOffset + 1], nameLength));
+            uint32_t nameOffset = 34 + 2 * post.numberOfGlyphs;
+            while (nameOffset < table.size()) {
+                uint8_t nameLength = table[nameOffset];
+                if (!table.contains(nameOffset + 1, nameLength)) {
+                    std::cerr << "Error: 'post' glyph name exceeds table size." << std::endl;
+                    return false;
+                }
+
+                post.names.push_back(std::string((char*)&table[nameOffset + 1], nameLength));
                 nameOffset += nameLength + 1;
             }
         }
         else if (post.format == 2.5) {
             // Parsing code for format 2.5
-            post.numberOfGlyphs = swapEndian16(*(uint16_t*)&fontData[offset + 32]);
-
-            if (fontData.size() < offset + 34 + post.numberOfGlyphs) {
+            if (table.size() < 34) {
                 std::cerr << "Error: not enough data for 'post' table format 2.5." << std::endl;
                 return false;
             }
 
-            for (uint16_t i = 0; i < post.numberOfGlyphs; i++) {
-                post.offset.push_back((int8_t)fontData[offset + 34 + i]);
+            post.numberOfGlyphs = swapEndian16(*(uint16_t*)&table[32]);
+
+            if (table.size() < 34u + post.numberOfGlyphs) {
+                std::cerr << "Error: not enough data for 'post' table format 2.5." << std::endl;
+                return false;
             }
+
+            post.offset.assign((const int8_t*)&table[34], (const int8_t*)&table[34] + post.numberOfGlyphs);
         }
 
         else if (post.format == 3.0) {
@@ -1139,64 +1557,52 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseLocaTable(uint32_t locaOffset, LocaTable& loca) {
-        if (locaOffset == 0) {
+    bool TTFParser::parseLocaTable(ByteView table, LocaTable& loca) {
+        if (table.empty()) {
             std::cerr << "Error: 'loca' table not found." << std::endl;
             return false;
         }
 
-        uint32_t offset = locaOffset;
-        uint32_t previousOffset = 0;
+        const size_t count = static_cast<size_t>(numGlyphs) + 1;
 
-        if (headTable.indexToLocFormat == 0) { // Short format
-            for (size_t i = 0; i <= numGlyphs; ++i) {
-                if (offset + 2 > fontData.size()) {
-                    std::cerr << "Error: Unexpected end of data while parsing 'loca' table." << std::endl;
-                    return false;
-                }
-
-                uint16_t shortOffset = swapEndian16(*(uint16_t*)&fontData[offset]);
-                uint32_t actualOffset = static_cast<uint32_t>(shortOffset) * 2;
-
-                if (actualOffset < previousOffset) {
-                    std::cerr << "Error: 'loca' table offsets are not in ascending order." << std::endl;
-                    return false;
-                }
-
-                loca.offsets.push_back(actualOffset);
-                previousOffset = actualOffset;
-                offset += 2;
+        if (headTable.indexToLocFormat == 0) { // Short format, offsets stored divided by two
+            if (table.size() < count * 2) {
+                std::cerr << "Error: Unexpected end of data while parsing 'loca' table." << std::endl;
+                return false;
             }
+
+            loca.offsets.resize(count);
+            decodeU16ToU32Array(table.data(), loca.offsets.data(), count, 1);
         }
 
         else if (headTable.indexToLocFormat == 1) { // Long format
-            for (size_t i = 0; i <= numGlyphs; ++i) {
-                if (offset + 4 > fontData.size()) {
-                    std::cerr << "Error: Unexpected end of data while parsing 'loca' table." << std::endl;
-                    return false;
-                }
-
-                uint32_t longOffset = swapEndian32(*(uint32_t*)&fontData[offset]);
-
-                if (longOffset < previousOffset) {
-                    std::cerr << "Error: 'loca' table offsets are not in ascending order." << std::endl;
-                    return false;
-                }
-
-                loca.offsets.push_back(longOffset);
-                previousOffset = longOffset;
-                offset += 4;
+            if (table.size() < count * 4) {
+                std::cerr << "Error: Unexpected end of data while parsing 'loca' table." << std::endl;
+                return false;
             }
+
+            loca.offsets.resize(count);
+            decodeU32Array(table.data(), loca.offsets.data(), count);
         }
         else {
             std::cerr << "Error: Invalid 'indexToLocFormat' in 'head' table." << std::endl;
             return false;
         }
 
+        // Offsets must never decrease; check all of them in one branch-free pass
+        bool descending = false;
+        for (size_t i = 1; i < count; ++i) {
+            descending |= loca.offsets[i] < loca.offsets[i - 1];
+        }
+
+        if (descending) {
+            std::cerr << "Error: 'loca' table offsets are not in ascending order." << std::endl;
+            return false;
+        }
+
         // Ensure the last offset does not exceed the 'glyf' table length
-        uint32_t glyfOffset = getTableOffset("glyf");
         uint32_t glyfLength = getTableLength("glyf");
-        if (glyfOffset == 0 || glyfLength == 0) {
+        if (glyfLength == 0) {
             std::cerr << "Error: 'glyf' table not found or has zero length." << std::endl;
             return false;
         }
@@ -1209,121 +1615,142 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseKernTable(uint32_t offset, KernTable& table) {
-        if (offset + 4 > fontData.size()) {
+    bool TTFParser::parseKernTable(ByteView data, KernTable& table) {
+        table.subtables.clear();
+        uint32_t offset = 0;
+
+        if (offset + 4 > data.size()) {
             return false;
         }
 
-        table.version = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
-        uint16_t nTables = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
+        table.version = swapEndian16(*(uint16_t*)&data[offset]); offset += 2;
+        if (table.version != 0) {
+            std::cerr << "Error: Only version 0 'kern' tables are supported." << std::endl;
+            return false;
+        }
+        uint16_t nTables = swapEndian16(*(uint16_t*)&data[offset]); offset += 2;
 
         for (uint16_t i = 0; i < nTables; ++i) {
             KernSubtable subtable;
+            const uint32_t subtableStart = offset;
 
-            if (offset + 6 > fontData.size()) {
+            if (offset + 6 > data.size()) {
                 return false;
             }
 
-            subtable.version = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
-            subtable.length = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
-            subtable.coverage = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
+            subtable.version = swapEndian16(*(uint16_t*)&data[offset]); offset += 2;
+            subtable.length = swapEndian16(*(uint16_t*)&data[offset]); offset += 2;
+            subtable.coverage = swapEndian16(*(uint16_t*)&data[offset]); offset += 2;
 
-            if ((subtable.coverage & 0xFF) == 0) { // Format 0
-                if (offset + 8 > fontData.size()) {
+            if ((subtable.coverage >> 8) == 0) { // Format 0; the low byte holds the flags
+                if (offset + 8 > data.size()) {
                     return false;
                 }
 
-                uint16_t nPairs = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
+                uint16_t nPairs = swapEndian16(*(uint16_t*)&data[offset]); offset += 2;
                 offset += 6;  // Skip searchRange, entrySelector, rangeShift
 
-                for (uint16_t j = 0; j < nPairs; ++j) {
-                    if (offset + 6 > fontData.size()) {
-                        return false;
-                    }
-
-                    KerningPair pair;
-                    pair.left = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
-                    pair.right = swapEndian16(*(uint16_t*)&fontData[offset]); offset += 2;
-                    pair.value = swapEndian16(*(int16_t*)&fontData[offset]); offset += 2;
+                if (!data.contains(offset, 6 * static_cast<size_t>(nPairs))) {
+                    return false;
+                }
 
-                    subtable.kerningPairs.push_back(pair);
+                subtable.kerningPairs.resize(nPairs);
+                for (KerningPair& pair : subtable.kerningPairs) {
+                    pair.left = swapEndian16(*(uint16_t*)&data[offset]); offset += 2;
+                    pair.right = swapEndian16(*(uint16_t*)&data[offset]); offset += 2;
+                    pair.value = swapEndian16(*(int16_t*)&data[offset]); offset += 2;
                 }
+                // Large format 0 subtables overflow their 16-bit length, so the pair count decides where they end
             }
             else {
                 // Skip over the subtable if the format is not 0
-                offset += subtable.length - 6;  // Subtract the 6 bytes we already read
+                if (subtable.length < 6) {
+                    return false;
+                }
+                offset = subtableStart + subtable.length;
             }
 
-            table.subtables.push_back(subtable);
+            table.subtables.push_back(std::move(subtable));
         }
 
         return true;
     }
 
-    bool TTFParser::parseGPOSHeader(uint32_t offset, GPOSHeader& header) {
+    bool TTFParser::parseGPOSHeader(ByteView table, GPOSHeader& header) {
+        uint32_t offset = 0;
+
         // Ensure we have enough data for the header
-        if (offset + 12 > fontData.size()) {
+        if (offset + 12 > table.size()) {
             std::cerr << "Failed to read GPOS header: insufficient data." << std::endl;
             return false;
         }
 
         // Read version
-        header.version = swapEndian32(*(uint32_t*)&fontData[offset]);
+        header.version = swapEndian32(*(uint32_t*)&table[offset]);
         offset += 4;
 
         // Read ScriptList offset
-        header.scriptListOffset = swapEndian16(*(uint16_t*)&fontData[offset]);
+        header.scriptListOffset = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
         // Read FeatureList offset
-        header.featureListOffset = swapEndian16(*(uint16_t*)&fontData[offset]);
+        header.featureListOffset = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
         // Read LookupList offset
-        header.lookupListOffset = swapEndian16(*(uint16_t*)&fontData[offset]);
+        header.lookupListOffset = swapEndian16(*(uint16_t*)&table[offset]);
 
         std::cout << "Parsed GPOS Header: Version " << header.version << std::endl;
 
         return true;
     }
 
-    bool TTFParser::parseLookupList(uint32_t offset, std::vector<LookupTable>& lookups) {
+    bool TTFParser::parseLookupList(ByteView table, std::vector<LookupTable>& lookups) {
+        uint32_t offset = 0;
+
         // Ensure we have enough data for lookupCount
-        if (offset + 2 > fontData.size()) {
+        if (offset + 2 > table.size()) {
             std::cerr << "Failed to read lookupCount: insufficient data." << std::endl;
             return false;
         }
 
-        uint16_t lookupCount = swapEndian16(*(uint16_t*)&fontData[offset]);
+        uint16_t lookupCount = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
         for (uint16_t i = 0; i < lookupCount; ++i) {
             LookupTable lookup;
 
-            // Ensure we have enough data for lookup table
-            if (offset + 6 > fontData.size()) {
-                std::cerr << "Failed to read LookupTable: insufficient data." << std::endl;
+            // The list holds offsets to the Lookup tables, relative to the start of the LookupList
+            if (offset + 2 > table.size()) {
+                std::cerr << "Failed to read lookupOffset: insufficient data." << std::endl;
                 return false;
             }
 
-            lookup.lookupType = swapEndian16(*(uint16_t*)&fontData[offset]);
+            uint16_t lookupOffset = swapEndian16(*(uint16_t*)&table[offset]);
             offset += 2;
 
-            lookup.lookupFlag = swapEndian16(*(uint16_t*)&fontData[offset]);
-            offset += 2;
+            // Ensure we have enough data for lookup table
+            ByteView lookupData = table.subview(lookupOffset);
+            if (lookupData.size() < 6) {
+                std::cerr << "Failed to read LookupTable: insufficient data." << std::endl;
+                return false;
+            }
 
-            lookup.subTableCount = swapEndian16(*(uint16_t*)&fontData[offset]);
-            offset += 2;
+            lookup.lookupOffset = lookupOffset;
+            lookup.lookupType = swapEndian16(*(uint16_t*)&lookupData[0]);
+            lookup.lookupFlag = swapEndian16(*(uint16_t*)&lookupData[2]);
+            lookup.subTableCount = swapEndian16(*(uint16_t*)&lookupData[4]);
 
             // Read offsets for each subtable
+            uint32_t subTableOffsetPos = 6;
             for (uint16_t j = 0; j < lookup.subTableCount; ++j) {
-                if (offset + 2 > fontData.size()) {
+                if (subTableOffsetPos + 2 > lookupData.size()) {
                     std::cerr << "Failed to read subTableOffset: insufficient data." << std::endl;
                     return false;
                 }
-                uint16_t subTableOffset = swapEndian16(*(uint16_t*)&fontData[offset]);
+                uint16_t subTableOffset = swapEndian16(*(uint16_t*)&lookupData[subTableOffsetPos]);
                 lookup.subTableOffsets.push_back(subTableOffset);
-                offset += 2;
+                subTableOffsetPos += 2;
             }
 
             lookups.push_back(lookup);
@@ -1332,29 +1759,31 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseScriptList(uint32_t offset, std::vector<ScriptRecord>& scripts) {
+    bool TTFParser::parseScriptList(ByteView table, std::vector<ScriptRecord>& scripts) {
+        uint32_t offset = 0;
+
         // Ensure we have enough data for scriptCount
-        if (offset + 2 > fontData.size()) {
+        if (offset + 2 > table.size()) {
             std::cerr << "Failed to read scriptCount: insufficient data." << std::endl;
             return false;
         }
 
-        uint16_t scriptCount = swapEndian16(*(uint16_t*)&fontData[offset]);
+        uint16_t scriptCount = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
         for (uint16_t i = 0; i < scriptCount; ++i) {
             ScriptRecord script;
 
             // Ensure we have enough data for ScriptRecord
-            if (offset + 6 > fontData.size()) {
+            if (offset + 6 > table.size()) {
                 std::cerr << "Failed to read ScriptRecord: insufficient data." << std::endl;
                 return false;
             }
 
-            script.scriptTag = swapEndian32(*(uint32_t*)&fontData[offset]);
+            script.scriptTag = swapEndian32(*(uint32_t*)&table[offset]);
             offset += 4;
 
-            script.scriptOffset = swapEndian16(*(uint16_t*)&fontData[offset]);
+            script.scriptOffset = swapEndian16(*(uint16_t*)&table[offset]);
             offset += 2;
 
             scripts.push_back(script);
@@ -1363,29 +1792,31 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseScriptTable(uint32_t offset, ScriptTable& scriptTable) {
-        if (offset + 4 > fontData.size()) {
+    bool TTFParser::parseScriptTable(ByteView table, ScriptTable& scriptTable) {
+        uint32_t offset = 0;
+
+        if (offset + 4 > table.size()) {
             std::cerr << "Failed to read ScriptTable: insufficient data." << std::endl;
             return false;
         }
 
-        scriptTable.defaultLangSys = swapEndian16(*(uint16_t*)&fontData[offset]);
+        scriptTable.defaultLangSys = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
-        scriptTable.langSysCount = swapEndian16(*(uint16_t*)&fontData[offset]);
+        scriptTable.langSysCount = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
         for (uint16_t i = 0; i < scriptTable.langSysCount; ++i) {
-            if (offset + 6 > fontData.size()) {
+            if (offset + 6 > table.size()) {
                 std::cerr << "Failed to read LangSysRecord: insufficient data." << std::endl;
                 return false;
             }
 
             LangSysRecord langSysRecord;
-            langSysRecord.langSysTag = swapEndian32(*(uint32_t*)&fontData[offset]);
+            langSysRecord.langSysTag = swapEndian32(*(uint32_t*)&table[offset]);
             offset += 4;
 
-            langSysRecord.langSysOffset = swapEndian16(*(uint16_t*)&fontData[offset]);
+            langSysRecord.langSysOffset = swapEndian16(*(uint16_t*)&table[offset]);
             offset += 2;
 
             scriptTable.langSystems.push_back(langSysRecord);
@@ -1394,29 +1825,31 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseFeatureList(uint32_t offset, std::vector<FeatureRecord>& features) {
+    bool TTFParser::parseFeatureList(ByteView table, std::vector<FeatureRecord>& features) {
+        uint32_t offset = 0;
+
         // Ensure we have enough data for featureCount
-        if (offset + 2 > fontData.size()) {
+        if (offset + 2 > table.size()) {
             std::cerr << "Failed to read featureCount: insufficient data." << std::endl;
             return false;
         }
 
-        uint16_t featureCount = swapEndian16(*(uint16_t*)&fontData[offset]);
+        uint16_t featureCount = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
         for (uint16_t i = 0; i < featureCount; ++i) {
             FeatureRecord feature;
 
             // Ensure we have enough data for FeatureRecord
-            if (offset + 6 > fontData.size()) {
+            if (offset + 6 > table.size()) {
                 std::cerr << "Failed to read FeatureRecord: insufficient data." << std::endl;
                 return false;
             }
 
-            feature.featureTag = swapEndian32(*(uint32_t*)&fontData[offset]);
+            feature.featureTag = swapEndian32(*(uint32_t*)&table[offset]);
             offset += 4;
 
-            feature.featureOffset = swapEndian16(*(uint16_t*)&fontData[offset]);
+            feature.featureOffset = swapEndian16(*(uint16_t*)&table[offset]);
             offset += 2;
 
             features.push_back(feature);
@@ -1425,28 +1858,31 @@ namespace TTFParser {
         return true;
     }
 
-    bool TTFParser::parseValueRecord(uint32_t& offset, uint16_t valueFormat, ValueRecord& value) {
+    bool TTFParser::parseValueRecord(ByteView table, uint32_t& offset, uint16_t valueFormat, ValueRecord& value) {
         if (valueFormat & 0x0001) { // XPlacement
-            if (offset + 2 > fontData.size()) return false;
-            value.xPlacement = swapEndian16(*(int16_t*)&fontData[offset]);
+            if (offset + 2 > table.size()) return false;
+            value.xPlacement = swapEndian16(*(int16_t*)&table[offset]);
             offset += 2;
         }
         if (valueFormat & 0x0002) { // YPlacement
-            if (offset + 2 > fontData.size()) return false;
-            value.yPlacement = swapEndian16(*(int16_t*)&fontData[offset]);
+            if (offset + 2 > table.size()) return false;
+            value.yPlacement = swapEndian16(*(int16_t*)&table[offset]);
             offset += 2;
         }
         if (valueFormat & 0x0004) { // XAdvance
-            if (offset + 2 > fontData.size()) return false;
-            value.xAdvance = swapEndian16(*(int16_t*)&fontData[offset]);
+            if (offset + 2 > table.size()) return false;
+            value.xAdvance = swapEndian16(*(int16_t*)&table[offset]);
             offset += 2;
         }
         if (valueFormat & 0x0008) { // YAdvance
-            if (offset + 2 > fontData.size()) return false;
-            value.yAdvance = swapEndian16(*(int16_t*)&fontData[offset]);
+            if (offset + 2 > table.size()) return false;
+            value.yAdvance = swapEndian16(*(int16_t*)&table[offset]);
             offset += 2;
         }
-        // ... Continue this pattern for other bits in valueFormat
+        // Skip the device table offsets (XPlaDevice to YAdvDevice), so the next record starts at the right place
+        const uint32_t deviceBytes = getValueRecordSize(valueFormat & 0x00F0);
+        if (offset + deviceBytes > table.size()) return false;
+        offset += deviceBytes;
         return true;
     }
 
@@ -1456,47 +1892,65 @@ namespace TTFParser {
         if (valueFormat & 0x0002) size += 2; // YPlacement
         if (valueFormat & 0x0004) size += 2; // XAdvance
         if (valueFormat & 0x0008) size += 2; // YAdvance
-
-        // ... Continue this pattern for other bits in valueFormat
+        if (valueFormat & 0x0010) size += 2; // XPlaDevice
+        if (valueFormat & 0x0020) size += 2; // YPlaDevice
+        if (valueFormat & 0x0040) size += 2; // XAdvDevice
+        if (valueFormat & 0x0080) size += 2; // YAdvDevice
         return size;
     }
 
-    uint16_t TTFParser::getCoverageGlyphCount(uint32_t offset) {
-        if (offset + 2 > fontData.size()) {
+    uint16_t TTFParser::getCoverageGlyphCount(ByteView table) {
+        uint32_t offset = 0;
+
+        if (offset + 2 > table.size()) {
             std::cerr << "Failed to read Coverage format: insufficient data." << std::endl;
             return 0;
         }
 
-        uint16_t format = swapEndian16(*(uint16_t*)&fontData[offset]);
+        uint16_t format = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;  // Increment offset after reading format
 
         if (format == 1) {
-            if (offset + 2 > fontData.size()) {  // Only need 2 bytes for glyph count
+            if (offset + 2 > table.size()) {  // Only need 2 bytes for glyph count
                 std::cerr << "Failed to read Coverage format 1 glyph count: insufficient data." << std::endl;
                 return 0;
             }
 
-            uint16_t glyphCount = swapEndian16(*(uint16_t*)&fontData[offset]);
+            uint16_t glyphCount = swapEndian16(*(uint16_t*)&table[offset]);
 
             return glyphCount;
         }
 
         else if (format == 2) {
-            if (offset + 2 > fontData.size()) {  // Only need 2 bytes for range count
+            if (offset + 2 > table.size()) {  // Only need 2 bytes for range count
                 std::cerr << "Failed to read Coverage format 2 range count: insufficient data." << std::endl;
                 return 0;
             }
-            uint16_t rangeCount = swapEndian16(*(uint16_t*)&fontData[offset]);
+            uint16_t rangeCount = swapEndian16(*(uint16_t*)&table[offset]);
+            offset += 2;
+            if (offset + 6 * uint32_t(rangeCount) > table.size()) {
+                std::cerr << "Failed to read Coverage format 2 ranges: insufficient data." << std::endl;
+                return 0;
+            }
 
-            return rangeCount;  // Note: This is not the total glyph count but the range count.
+            // Each RangeRecord covers startGlyphID..endGlyphID
+            uint32_t glyphCount = 0;
+            for (uint16_t i = 0; i < rangeCount; ++i, offset += 6) {
+                uint16_t startGlyph = swapEndian16(*(uint16_t*)&table[offset]);
+                uint16_t endGlyph = swapEndian16(*(uint16_t*)&table[offset + 2]);
+                if (endGlyph >= startGlyph) {
+                    glyphCount += endGlyph - startGlyph + 1u;
+                }
+            }
+            return static_cast<uint16_t>(std::min<uint32_t>(glyphCount, 0xFFFF));
         }
 
         else {
             std::cerr << "Unknown Coverage format: " << format << " at offset: " << offset - 2 << std::endl;
             
             std::cerr << "Data around unknown format (" << format << ") at offset " << offset << ": ";
-            for (int i = -10; i <= 10; i++) {
-                std::cerr << std::hex << (int)fontData[offset + i] << " ";
+            for (size_t i = 0; i < 20 && i < table.size(); i++) {
+                std::cerr << std::hex << (int)table[i] << " ";
             }
 
             std::cerr << std::endl;
@@ -1505,36 +1959,49 @@ namespace TTFParser {
         }
     }
 
-    bool TTFParser::parseSingleAdjustmentSubtable(uint32_t offset, SingleAdjustmentSubtable& subtable) {
+    bool TTFParser::parseSingleAdjustmentSubtable(ByteView table, SingleAdjustmentSubtable& subtable) {
+        uint32_t offset = 0;
+
         // Ensure we have enough data for the basic fields
-        if (offset + 6 > fontData.size()) {
+        if (offset + 6 > table.size()) {
             std::cerr << "Failed to read Single Adjustment Subtable: insufficient data." << std::endl;
             return false;
         }
 
-        subtable.format = swapEndian16(*(uint16_t*)&fontData[offset]);
+        subtable.format = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
-        subtable.coverageOffset = swapEndian16(*(uint16_t*)&fontData[offset]);
+        subtable.coverageOffset = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
-        subtable.valueFormat = swapEndian16(*(uint16_t*)&fontData[offset]);
+        subtable.valueFormat = swapEndian16(*(uint16_t*)&table[offset]);
         offset += 2;
 
         if (subtable.format == 1) {
-            if (!parseValueRecord(offset, subtable.valueFormat, subtable.value)) {
+            subtable.value = ValueRecord{};
+            if (!parseValueRecord(table, offset, subtable.valueFormat, subtable.value)) {
                 return false;
             }
         }
         else if (subtable.format == 2) {
-            uint16_t glyphCount = getCoverageGlyphCount(offset + subtable.coverageOffset - 4);  // Adjust for the relative coverageOffset
-            for (uint16_t i = 0; i < glyphCount; ++i) {
-                ValueRecord value;
-                if (!parseValueRecord(offset, subtable.valueFormat, value)) {
+            uint16_t glyphCount = getCoverageGlyphCount(table.subview(subtable.coverageOffset));  // coverageOffset is relative to the subtable
+            // The records follow valueCount; parseValueRecord advances past each one
+            if (offset + 2 > table.size()) {
+                std::cerr << "Failed to read Single Adjustment valueCount: insufficient data." << std::endl;
+                return false;
+            }
+            uint16_t valueCount = swapEndian16(*(uint16_t*)&table[offset]);
+            offset += 2;
+            if (valueCount != glyphCount) {
+                std::cerr << "Single Adjustment valueCount does not match its Coverage table." << std::endl;
+                return false;
+            }
+            for (uint16_t i = 0; i < valueCount; ++i) {
+                ValueRecord value{};
+                if (!parseValueRecord(table, offset, subtable.valueFormat, value)) {
                     return false;
                 }
                 subtable.values.push_back(value);
-                offset += getValueRecordSize(subtable.valueFormat);
             }
         }
         else {
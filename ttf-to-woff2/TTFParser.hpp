@@ -4,14 +4,16 @@
 #include <cstdint>
 #include <string>
 #include <vector>
-#include <map>
 #include <memory>
-#include <vector>
+#include "FontBuffer.hpp"
+#include "TableDirectory.hpp"
 
 // Define necessary structures for the TTF format
 // See https://docs.microsoft.com/en-us/typography/opentype/spec/otff for more information
 namespace TTFParser {    
 
+    class ThreadPool;
+
 // The ValueRecord struct represents positioning adjustments for a glyph.
     struct ValueRecord {
         int16_t xPlacement;  // Horizontal adjustment for glyph placement.
@@ -40,10 +42,11 @@ namespace TTFParser {
 
     // The LookupTable struct represents a lookup table within GPOS or GSUB.
     struct LookupTable {
+        uint16_t lookupOffset;       // Offset of the lookup, from the start of the LookupList.
         uint16_t lookupType;         // Type of lookup (e.g., 1 for Single Adjustment).
         uint16_t lookupFlag;         // Flags for lookup processing.
         uint16_t subTableCount;      // Number of subtables.
-        std::vector<uint16_t> subTableOffsets; // Offsets to the subtables.
+        std::vector<uint16_t> subTableOffsets; // Offsets to the subtables, from the start of the lookup.
     };
 
     // The SinglePos struct represents a single positioning subtable.
@@ -96,7 +99,7 @@ namespace TTFParser {
     struct KernSubtable {
         uint16_t version;           // Version of the subtable.
         uint16_t length;            // Length of the subtable in bytes.
-        uint16_t coverage;          // Coverage format.
+        uint16_t coverage;          // Format in the high byte, flags (horizontal, minimum, cross-stream, override) in the low byte.
         std::vector<KerningPair> kerningPairs; // Kerning pairs in the subtable.
     };
 
@@ -161,15 +164,15 @@ namespace TTFParser {
         int16_t  sTypoLineGap;      // Typographic line gap.
         uint16_t usWinAscent;       // Windows ascender metric.
         uint16_t usWinDescent;      // Windows descender metric.
-        uint16_t usBreakChar;       // Breaking character (New for version 1).
-        uint16_t usDefaultChar;     // Default character (New for version 1).
+        uint16_t usBreakChar;       // Breaking character (New for version 2).
+        uint16_t usDefaultChar;     // Default character (New for version 2).
         int16_t sCapHeight;         // Height of capital letters.
         uint16_t usMaxContext;      // Maximum context length for contextual lookups.
         uint32_t ulCodePageRange1;  // Code page range bits (0-31).
         uint32_t ulCodePageRange2;  // Code page range bits (32-63).
         uint16_t sxHeight;          // Height of lowercase letters.
-        uint16_t usLowerOpticalPointSize; // Lower optical size (Version 3 and above).
-        uint16_t usUpperOpticalPointSize; // Upper optical size (Version 3 and above).
+        uint16_t usLowerOpticalPointSize; // Lower optical size (Version 5 and above).
+        uint16_t usUpperOpticalPointSize; // Upper optical size (Version 5 and above).
         // Additional fields for higher versions...
     };
 
@@ -253,6 +256,8 @@ namespace TTFParser {
     struct CmapSubtable {
         uint16_t format;
         // ... other common members for all subtables
+
+        virtual ~CmapSubtable() = default; // Subtables are owned through base pointers.
     };
 
     struct CmapFormat0 : public CmapSubtable {
@@ -289,7 +294,6 @@ namespace TTFParser {
     };
 
     struct CmapFormat2 : public CmapSubtable {
-        uint16_t format;             // This should always be 2.
         uint16_t length;             // This is the length in bytes of the subtable.
         uint16_t language;           // This field can be used to specify a language.
         uint8_t subHeaderKeys[256];  // Array that maps high bytes to subHeaders. Value is subHeader index multiplied by 8.
@@ -312,7 +316,6 @@ namespace TTFParser {
     };
 
     struct CmapFormat6 : public CmapSubtable {
-        uint16_t format;       // This should always be 6.
         uint16_t length;       // Length in bytes of the subtable.
         uint16_t language;     // Can be used to specify a language.
         uint16_t firstCode;    // First character code covered.
@@ -321,7 +324,6 @@ namespace TTFParser {
     };
 
     struct CmapFormat8 : public CmapSubtable {
-        uint16_t format;       // This should always be 8.
         uint16_t reserved;     // Set to 0.
         uint32_t length;       // Length in bytes of the subtable.
         uint32_t language;     // Can be used to specify a language.
@@ -331,7 +333,6 @@ namespace TTFParser {
     };
 
     struct CmapFormat10 : public CmapSubtable {
-        uint16_t format;       // This should always be 10.
         uint16_t reserved;     // Set to 0.
         uint32_t length;       // Length in bytes of the subtable.
         uint32_t language;     // Can be used to specify a language.
@@ -341,7 +342,6 @@ namespace TTFParser {
     };
 
     struct CmapFormat12 : public CmapSubtable {
-        uint16_t format;       // This should always be 12.
         uint16_t reserved;     // Set to 0.
         uint32_t length;       // Length in bytes of the subtable.
         uint32_t language;     // Can be used to specify a language.
@@ -352,7 +352,6 @@ namespace TTFParser {
     };
 
     struct CmapFormat13 : public CmapSubtable {
-        uint16_t format;       // This should always be 13.
         uint16_t reserved;     // Set to 0.
         uint32_t length;       // Length in bytes of the subtable.
         uint32_t language;     // Can be used to specify a language.
@@ -364,17 +363,31 @@ namespace TTFParser {
 
     // Represents the cmap format 14 subtable, used for Unicode variation sequences.
     struct CmapFormat14 : public CmapSubtable {
-        uint16_t format;                      // Format identifier (should be 14).
         uint32_t length;                      // Length of the subtable.
         uint32_t numVarSelectorRecords;       // Number of variation selector records.
         std::vector<VarSelectorRecord> varSelectors; // Variation selector records.
     };
 
+    // An encoding record of the cmap table: a platform and encoding, and the subtable serving them.
+    struct CmapEncodingRecord {
+        uint16_t platformID;
+        uint16_t encodingID;
+        uint32_t subtableOffset;   // From the start of the cmap table.
+        int32_t subtableIndex;     // Index into CmapTable::subtables, or -1 if the format is not handled.
+
+        // Unicode platform, or Windows symbol, BMP or full-repertoire Unicode encodings.
+        bool isUnicode() const {
+            return platformID == 0 || (platformID == 3 && (encodingID == 0 || encodingID == 1 || encodingID == 10));
+        }
+    };
+
     // Contains all the subtables for the character mapping (cmap) table.
     struct CmapTable {
         uint16_t version;                     // Version number of the table.
-        uint16_t numTables;                   // Number of subtables.
-        std::vector<std::unique_ptr<CmapSubtable>> subtables; // Subtables.
+        uint16_t numTables;                   // Number of encoding records.
+        std::vector<CmapEncodingRecord> encodingRecords; // Every encoding record, in table order.
+        // Distinct subtables, each decoded once however many records share its offset.
+        std::vector<std::unique_ptr<CmapSubtable>> subtables;
     };
 
     // Represents an axis record in the font variations ('fvar') table.
@@ -399,36 +412,87 @@ namespace TTFParser {
         std::vector<AxisRecord> axes;         // Axis records.
     };
 
-    // Represents a point in a glyph outline.
-    struct Point {
-        int16_t x;                            // X-coordinate.
-        int16_t y;                            // Y-coordinate.
-        bool onCurve;                         // True if the point is on the curve, false if off.
-    };
-
-    // Represents a simple glyph.
+    // Represents a simple glyph. Points are stored as a structure of arrays: point i is
+    // (xCoordinates[i], yCoordinates[i]) in absolute font units, and bit i of onCurve is set
+    // when it lies on the curve.
     struct SimpleGlyph {
-        int16_t numberOfContours;             // Number of contours in the glyph.
+        int16_t numberOfContours = 0;         // Number of contours in the glyph (-1 for compound glyphs).
+        int16_t xMin = 0, yMin = 0;           // Bounding box from the glyph header.
+        int16_t xMax = 0, yMax = 0;
         std::vector<uint16_t> endPointOfContours; // Endpoints for each contour.
-        uint16_t instructionLength;           // Length of the instruction set.
+        uint16_t instructionLength = 0;       // Length of the instruction set.
         std::vector<uint8_t> instructions;    // Instructions for rendering the glyph.
-        std::vector<Point> points;            // Points in the glyph outline.
+        uint16_t numPoints = 0;               // Number of points in the outline.
+        std::vector<int16_t> xCoordinates;    // X-coordinate of each point.
+        std::vector<int16_t> yCoordinates;    // Y-coordinate of each point.
+        std::vector<uint64_t> onCurve;        // On-curve bitset, 64 points per word.
+        bool overlapSimple = false;           // OVERLAP_SIMPLE was set on the first flag.
+
+        bool isOnCurve(size_t point) const {
+            return (onCurve[point >> 6] >> (point & 63)) & 1;
+        }
     };
 
     // Represents a component in a compound glyph.
+    // The component's points are mapped as x' = xScale * x + scale10 * y + dx and
+    // y' = scale01 * x + yScale * y + dy, where (dx, dy) comes from arg1/arg2.
     struct CompoundComponent {
-        uint16_t glyphIndex;                  // Index of the simple glyph.
-        int arg1, arg2;                       // Transformation arguments.
-        // TODO: Add transformation matrices or scaling factors as needed.
+        uint16_t flags;                       // Component flags (ARG_1_AND_2_ARE_WORDS, ARGS_ARE_XY_VALUES, ...).
+        uint16_t glyphIndex;                  // Index of the component glyph (simple or compound).
+        int arg1, arg2;                       // Signed x/y offset if ARGS_ARE_XY_VALUES is set, otherwise the (unsigned) parent and child point numbers to match.
+        int16_t xScale, scale01;              // 2x2 transform as raw F2Dot14 values (0x4000 = 1.0);
+        int16_t scale10, yScale;              // identity unless a scale flag is set.
 
-        CompoundComponent(uint16_t idx) : glyphIndex(idx), arg1(0), arg2(0) {}
+        CompoundComponent(uint16_t idx = 0)
+            : flags(0), glyphIndex(idx), arg1(0), arg2(0), xScale(0x4000), scale01(0), scale10(0), yScale(0x4000) {}
+
+        bool hasTransform() const {
+            return xScale != 0x4000 || scale01 != 0 || scale10 != 0 || yScale != 0x4000;
+        }
     };
 
     // Represents a compound glyph, composed of one or more simple glyphs.
     struct CompoundGlyph {
         std::vector<CompoundComponent> components; // Components of the compound glyph.
+        std::vector<uint8_t> instructions;         // Instructions following the last component, if any.
+
+        // We can add more members here as needed, like transformation data.
+    };
+
+    // One glyph of a GlyfTable. Its outline data lives in the table's shared arrays.
+    struct GlyphRecord {
+        int16_t numberOfContours = 0;  // > 0 simple, < 0 compound, 0 empty.
+        int16_t xMin = 0, yMin = 0;    // Bounding box from the glyph header.
+        int16_t xMax = 0, yMax = 0;
+        bool overlapSimple = false;    // OVERLAP_SIMPLE was set on the first flag.
+        uint32_t firstContour = 0;     // Index into GlyfTable::endPointOfContours (numberOfContours entries).
+        uint32_t firstPoint = 0;       // Index into the coordinate arrays and the on-curve bitset.
+        uint32_t numPoints = 0;
+        uint32_t firstInstruction = 0; // Index into GlyfTable::instructions.
+        uint32_t instructionLength = 0;
+        uint32_t firstComponent = 0;   // Index into GlyfTable::components.
+        uint32_t numComponents = 0;
+    };
 
-        // We can add more members here as needed, like transformation data or instructions.
+    /**
+    * @struct GlyfTable
+    * @brief Every glyph of the 'glyf' table, decoded into flat structure-of-arrays storage.
+    *
+    * Per-glyph data is addressed through GlyphRecord indices, so decoding a whole font costs
+    * a handful of allocations instead of several per glyph.
+    */
+    struct GlyfTable {
+        std::vector<GlyphRecord> glyphs;
+        std::vector<uint16_t> endPointOfContours; // Contour end points, relative to each glyph's first point.
+        std::vector<int16_t> xCoordinates;        // Absolute x-coordinate of every point.
+        std::vector<int16_t> yCoordinates;        // Absolute y-coordinate of every point.
+        std::vector<uint64_t> onCurve;            // On-curve bitset over all points, 64 per word.
+        std::vector<uint8_t> instructions;        // Instructions of every glyph, back to back.
+        std::vector<CompoundComponent> components; // Components of every compound glyph.
+
+        bool isOnCurve(size_t point) const {
+            return (onCurve[point >> 6] >> (point & 63)) & 1;
+        }
     };
 
     // Represents an entry in the table directory.
@@ -449,8 +513,11 @@ namespace TTFParser {
         std::vector<TableDirectoryEntry> tableDirectoryEntries; // Table directory entries.
     };
 
-    // Represents the head table, which contains global information about the font. (used super often, this just makes it easier)
-    static HeadTable headTable;
+    // Selects how loadFromFile brings the font into memory.
+    enum class LoadMode {
+        Mapped,   // Memory-map the file read-only; tables are views into the mapping.
+        Buffered  // Read the whole file into a heap buffer.
+    };
 
     /**
     * @class TTFParser
@@ -464,46 +531,79 @@ namespace TTFParser {
         /**
          * @brief Loads a TTF font from a given file path.
          * @param filename Path to the TTF file.
+         * @param mode Whether to memory-map the file (default) or read it into a heap buffer.
          * @return true if the file was loaded successfully, false otherwise.
          */
-        bool loadFromFile(const std::string& filename);
+        bool loadFromFile(const std::string& filename, LoadMode mode = LoadMode::Mapped);
+
+        /**
+         * @brief Loads a TTF font from a caller-owned buffer without copying it.
+         * @param data Pointer to the font bytes; must stay valid while the parser (or any view it returned) is in use.
+         * @param size Size of the font in bytes.
+         * @return true if the font was loaded successfully, false otherwise.
+         */
+        bool loadFromMemory(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Loads a TTF font from a byte vector, taking ownership of it by move.
+         * @param data The font bytes.
+         * @return true if the font was loaded successfully, false otherwise.
+         */
+        bool loadFromMemory(std::vector<uint8_t>&& data);
 
         /**
          * @brief Retrieves the binary data of a table identified by its tag.
          * @param tag  identifier for the table.
-         * @return Vector of bytes representing the table data.
+         * @return View of the table bytes inside the font data, empty if the table is missing.
+         */
+        ByteView getTableData(Tag tag) const {
+            return tableDirectory.get(tag);
+        }
+
+        // Parsing functions for various tables. Each one takes a view of the table's bytes
+        // (see getTableData) and reads relative to the start of that view.
+        bool parseHeadTable(ByteView table);
+
+        // The parsed 'head' table (filled by parseHeadTable; loca parsing depends on it).
+        const HeadTable& getHeadTable() const { return headTable; }
+
+        // Number of glyphs, from the 'maxp' table (filled by parseMaxpTable).
+        uint16_t getNumGlyphs() const { return numGlyphs; }
+        bool parseHheaTable(ByteView data, HheaTable& table);
+        bool parseHmtxTable(ByteView table, uint16_t numOfLongHorMetrics, std::vector<GlyphMetrics>& metrics);
+        bool parseNameTable(ByteView data, NameTable& table);
+        bool parseOS2Table(ByteView table, OS2Table& os2);
+        bool parsePostTable(ByteView table, PostTable& post);
+        bool parseLocaTable(ByteView table, LocaTable& loca);
+        bool parseKernTable(ByteView data, KernTable& table);
+        bool parseFVarTable(ByteView table, FVarTable& fvar);
+        /**
+         * @brief Parses every encoding record of the 'cmap' table.
+         * Records pointing at the same offset share one decoded subtable.
          */
-        const std::vector<uint8_t>& getTableData(const std::string& tag) const;
-
-        // Parsing functions for various tables:
-        bool parseHeadTable(uint32_t offset);
-        bool parseHheaTable(uint32_t offset, HheaTable& table);
-        bool parseHmtxTable(uint32_t offset, uint16_t numOfLongHorMetrics, std::vector<GlyphMetrics>& metrics);
-        bool parseNameTable(uint32_t offset, NameTable& table);
-        bool parseOS2Table(uint32_t offset, OS2Table& os2);
-        bool parsePostTable(uint32_t offset, PostTable& post);
-        bool parseLocaTable(uint32_t locaOffset, LocaTable& loca);
-        bool parseKernTable(uint32_t offset, KernTable& table);
-        bool parseFVarTable(uint32_t offset, FVarTable& fvar);
-        bool parseCmapTable(uint32_t offset, CmapTable& cmap);
-        bool parseMaxpTable(uint32_t offset);
+        bool parseCmapTable(ByteView table, CmapTable& cmap);
+        bool parseMaxpTable(ByteView table);
         // ... More parsing functions ...
 
-        const std::map<std::string, std::vector<uint8_t>>& getTableDataMap() const {
-            return tableData;
+        /**
+         * @brief Gets the table directory built by readOffsetTable.
+         * @return Directory mapping table tags to views of their data.
+         */
+        const TableDirectory& getTableDirectory() const {
+            return tableDirectory;
         }
 
         // Functions to swap endianness:
-        inline uint16_t swapEndian16(uint16_t value) {
+        static uint16_t swapEndian16(uint16_t value) {
             return (value << 8) | (value >> 8);
         }
-        inline uint32_t swapEndian32(uint32_t value) {
+        static uint32_t swapEndian32(uint32_t value) {
             return ((value << 24) |
                 ((value & 0xFF00) << 8) |
                 ((value & 0xFF0000) >> 8) |
                 (value >> 24));
         }
-        int64_t swapEndian64(int64_t value) {
+        static int64_t swapEndian64(int64_t value) {
             value = ((value << 56) & 0xFF00000000000000) |
                 ((value << 40) & 0x00FF000000000000) |
                 ((value << 24) & 0x0000FF0000000000) |
@@ -517,30 +617,78 @@ namespace TTFParser {
         }
 
         // Functions to convert fixed-point numbers:
-        inline float f2Dot14ToFloat(int16_t value) {
+        static float f2Dot14ToFloat(int16_t value) {
             return static_cast<float>(value) / (1 << 14);
         }
 
-        inline float fixedToFloat(int32_t value) {
+        static float fixedToFloat(int32_t value) {
             return (float)value / (1 << 16);
         }
 
-        float readFixed(uint32_t offset) {
-            int16_t intPart = swapEndian16(*(int16_t*)&fontData[offset]);
-            uint16_t fracPart = swapEndian16(*(uint16_t*)&fontData[offset + 2]);
+        static float readFixed(ByteView data, uint32_t offset) {
+            int16_t intPart = swapEndian16(*(int16_t*)&data[offset]);
+            uint16_t fracPart = swapEndian16(*(uint16_t*)&data[offset + 2]);
             return intPart + (fracPart / 65536.0f);
         }
 
-        bool parseGlyph(uint32_t glyphOffset, SimpleGlyph& glyph);
+        /**
+         * @brief Parses a single glyph.
+         * @param glyphData View of the glyph's bytes in 'glyf' (from loca[i] to loca[i + 1]); empty for glyphs without outlines.
+         * @param glyph Receives the parsed glyph.
+         */
+        bool parseGlyph(ByteView glyphData, SimpleGlyph& glyph);
+
+        bool parseCompoundGlyph(ByteView glyphData, uint32_t& offset, CompoundGlyph& glyph) const;
 
-        bool parseCompoundGlyph(uint32_t& offset, CompoundGlyph& glyph);
+        /**
+         * @brief Decodes every glyph of the 'glyf' table.
+         *
+         * The glyphs are split into chunks of roughly equal byte size (glyph sizes vary a lot,
+         * especially in CJK fonts) which are decoded in parallel into per-chunk arenas and then
+         * merged in glyph order. The result is identical to decoding the glyphs one by one.
+         *
+         * @param glyfData View of the 'glyf' table.
+         * @param loca Parsed 'loca' table (numGlyphs + 1 offsets).
+         * @param table Receives the decoded glyphs.
+         * @param pool Pool to decode on, or nullptr to decode on the calling thread.
+         */
+        bool parseGlyfTable(ByteView glyfData, const LocaTable& loca, GlyfTable& table, ThreadPool* pool = nullptr) const;
+
+        /**
+         * @brief Recomputes every table checksum and head.checkSumAdjustment and compares
+         * them with the stored values.
+         *
+         * Every table is checked, whatever the earlier results. The tables, and the whole
+         * font in 1 MB slices, are summed in parallel when a pool is given.
+         *
+         * @param report Receives the stored and recomputed values.
+         * @param pool Pool to sum on, or nullptr to sum on the calling thread.
+         * @return true if every checksum matches.
+         */
+        bool validateChecksums(ChecksumReport& report, ThreadPool* pool = nullptr) const;
+
+        /**
+         * @brief Decodes the flags and coordinates of a simple glyph.
+         * @param glyphData View of the glyph's bytes.
+         * @param offset Offset of the first flag byte; advanced past the coordinate data on success.
+         * @param numPoints Number of points (last contour end point + 1).
+         * @param flags Receives the expanded flag byte of every point (numPoints entries).
+         * @param x Receives the absolute x-coordinates (numPoints entries).
+         * @param y Receives the absolute y-coordinates (numPoints entries).
+         * @return false if the flags or coordinates run past the end of the glyph.
+         */
+        static bool decodeSimpleGlyphPoints(ByteView glyphData, uint32_t& offset, size_t numPoints,
+            uint8_t* flags, int16_t* x, int16_t* y);
+
+        // Packs the ON_CURVE_POINT bit of each flag into a bitset of (numPoints + 63) / 64 words.
+        static void packOnCurveBits(const uint8_t* flags, size_t numPoints, uint64_t* words);
 
         /**
         * @brief Gets the entire binary data of the TTF file.
-        * @return Vector of bytes representing the TTF file.
+        * @return View of the bytes of the TTF file.
         */
-        const std::vector<uint8_t>& getFontData() const {
-            return fontData;
+        ByteView getFontData() const {
+            return fontData.view();
         }
 
         /*
@@ -551,51 +699,85 @@ namespace TTFParser {
             return fontData.size();
         }
 
-        uint32_t getTableOffset(const std::string& tag) const {
-            uint32_t tagVal = *(uint32_t*)tag.data();
-            for (const auto& entry : offsetTable.tableDirectoryEntries) {
-                if (entry.tag == tagVal) {
-                    return entry.offset;
-                }
-            }
-            return 0;  // Return 0 if the table is not found
+        /**
+         * @brief Gets the offset of a table from the beginning of the font file.
+         * @return The table offset, or 0 if the table is not found.
+         */
+        uint32_t getTableOffset(Tag tag) const {
+            const TableRecord* record = tableDirectory.find(tag);
+            return record ? static_cast<uint32_t>(record->data.data() - fontData.data()) : 0;
+        }
+
+        /**
+         * @brief Gets the length in bytes of a table.
+         * @return The table length, or 0 if the table is not found.
+         */
+        uint32_t getTableLength(Tag tag) const {
+            const TableRecord* record = tableDirectory.find(tag);
+            return record ? static_cast<uint32_t>(record->data.size()) : 0;
+        }
+
+        // The sfnt version of the loaded font (0x00010000 for TrueType outlines, 'OTTO' for CFF).
+        uint32_t getSfntVersion() const {
+            return offsetTable.sfntVersion;
         }
 
         const std::vector<TableDirectoryEntry>& getTableDirectoryEntries() {
             return offsetTable.tableDirectoryEntries;
         }
 
-        bool parseCmapFormat0(uint32_t offset, CmapFormat0& table);
-        bool parseCmapFormat2(uint32_t offset, CmapFormat2& table);
-        bool parseCmapFormat4(uint32_t offset, CmapFormat4& table);
-        bool parseCmapFormat6(uint32_t offset, CmapFormat6& table);
-        bool parseCmapFormat8(uint32_t offset, CmapFormat8& table);
-        bool parseCmapFormat10(uint32_t offset, CmapFormat10& table);
-        bool parseCmapFormat12(uint32_t offset, CmapFormat12& table);
-        bool parseCmapFormat13(uint32_t offset, CmapFormat13& table);
-        bool parseCmapFormat14(uint32_t offset, CmapFormat14& table);
-
-        bool parseGPOSHeader(uint32_t offset, GPOSHeader& header);
-
-        bool parseScriptList(uint32_t offset, std::vector<ScriptRecord>& scripts);
-        bool parseFeatureList(uint32_t offset, std::vector<FeatureRecord>& features);
-        bool parseLookupList(uint32_t offset, std::vector<LookupTable>& lookups);
-        bool parseSinglePos(uint32_t offset, SinglePos& singlePos);
-        bool parseScriptTable(uint32_t offset, ScriptTable& scriptTable);
-        bool parseSingleAdjustmentSubtable(uint32_t offset, SingleAdjustmentSubtable& subtable);
-        bool parseValueRecord(uint32_t& offset, uint16_t valueFormat, ValueRecord& value);
+        // Each cmap subtable parser receives the subtable starting at its format field.
+        bool parseCmapFormat0(ByteView data, CmapFormat0& table);
+        bool parseCmapFormat2(ByteView data, CmapFormat2& table);
+        bool parseCmapFormat4(ByteView data, CmapFormat4& table);
+        bool parseCmapFormat6(ByteView data, CmapFormat6& table);
+        bool parseCmapFormat8(ByteView data, CmapFormat8& table);
+        bool parseCmapFormat10(ByteView data, CmapFormat10& table);
+        bool parseCmapFormat12(ByteView data, CmapFormat12& table);
+        bool parseCmapFormat13(ByteView data, CmapFormat13& table);
+        bool parseCmapFormat14(ByteView data, CmapFormat14& table);
+
+        bool parseGPOSHeader(ByteView table, GPOSHeader& header);
+
+        bool parseScriptList(ByteView table, std::vector<ScriptRecord>& scripts);
+        bool parseFeatureList(ByteView table, std::vector<FeatureRecord>& features);
+        bool parseLookupList(ByteView table, std::vector<LookupTable>& lookups);
+        bool parseSinglePos(ByteView table, SinglePos& singlePos);
+        bool parseScriptTable(ByteView table, ScriptTable& scriptTable);
+        bool parseSingleAdjustmentSubtable(ByteView table, SingleAdjustmentSubtable& subtable);
+        bool parseValueRecord(ByteView table, uint32_t& offset, uint16_t valueFormat, ValueRecord& value);
         uint16_t getValueRecordSize(uint16_t valueFormat);
-        uint16_t getCoverageGlyphCount(uint32_t offset);
-
-        uint32_t getTableLength(const std::string& tableName);
+        uint16_t getCoverageGlyphCount(ByteView table);
 
     private:
+        // Forgets everything parsed from a previously loaded font.
+        void clearParsedState();
+
         // Read the offset table and directory entries
         bool readOffsetTable();
 
+        // Glyphs of one parseGlyfTable chunk, decoded with chunk-local indices (defined in TTFParser.cpp)
+        struct GlyfArena;
+
+        // Decodes one glyph and appends it to an arena
+        bool decodeGlyphInto(ByteView glyphData, GlyfArena& arena) const;
+
+    public:
+        // Simple Glyph Flags
+        // See https://docs.microsoft.com/en-us/typography/opentype/spec/glyf#simple-glyph-description for more information.
+        static const uint8_t ON_CURVE_POINT = 0x01;
+        static const uint8_t X_SHORT_VECTOR = 0x02;
+        static const uint8_t Y_SHORT_VECTOR = 0x04;
+        static const uint8_t REPEAT_FLAG = 0x08;
+        static const uint8_t X_IS_SAME_OR_POSITIVE_X_SHORT_VECTOR = 0x10;
+        static const uint8_t Y_IS_SAME_OR_POSITIVE_Y_SHORT_VECTOR = 0x20;
+        static const uint8_t OVERLAP_SIMPLE = 0x40;
+
         // Compound Glyph Flags
         // These flags are used when parsing compound glyphs, which consist of two or more simple glyphs combined.
         // - ARG_1_AND_2_ARE_WORDS: Indicates that the arguments are words instead of bytes.
+        // - ARGS_ARE_XY_VALUES: Indicates that the arguments are an x/y offset rather than point numbers to match.
+        // - ROUND_XY_TO_GRID: Indicates that the x/y offset should be rounded to the grid when hinting.
         // - MORE_COMPONENTS: Indicates that there are more components to follow.
         // - WE_HAVE_A_SCALE: Indicates that scaling is applied.
         // - WE_HAVE_AN_X_AND_Y_SCALE: Indicates that an X direction scale is applied separately to the horizontal and vertical components of the glyph.
@@ -603,8 +785,11 @@ namespace TTFParser {
         // - WE_HAVE_INSTRUCTIONS: Indicates that there are instructions for the compound glyph.
         // - USE_MY_METRICS: Indicates that the composite is not to be scaled, rotated or translated.
         // - OVERLAP_COMPOUND: Indicates that the composite is designed to have the component glyphs overlap.
+        // - SCALED_COMPONENT_OFFSET / UNSCALED_COMPONENT_OFFSET: Whether the x/y offset is transformed along with the component.
         // See https://docs.microsoft.com/en-us/typography/opentype/spec/glyf#compound-glyph-description for more information.
         static const uint16_t ARG_1_AND_2_ARE_WORDS = 0x0001;
+        static const uint16_t ARGS_ARE_XY_VALUES = 0x0002;
+        static const uint16_t ROUND_XY_TO_GRID = 0x0004;
         static const uint16_t MORE_COMPONENTS = 0x0020;
         static const uint16_t WE_HAVE_A_SCALE = 0x0008;
         static const uint16_t WE_HAVE_AN_X_AND_Y_SCALE = 0x0040;
@@ -612,12 +797,17 @@ namespace TTFParser {
         static const uint16_t WE_HAVE_INSTRUCTIONS = 0x0100;
         static const uint16_t USE_MY_METRICS = 0x0200;
         static const uint16_t OVERLAP_COMPOUND = 0x0400;
+        static const uint16_t SCALED_COMPONENT_OFFSET = 0x0800;
+        static const uint16_t UNSCALED_COMPONENT_OFFSET = 0x1000;
+
+    private:
 
         // Private Data Members
         OffsetTable offsetTable; // Offset table of the TTF file.
-        std::map<std::string, std::vector<uint8_t>> tableData; // Maps table tags to their data.
+        TableDirectory tableDirectory; // Maps table tags to views of their data.
 
-        std::vector<uint8_t> fontData; // Entire TTF font data loaded from file.
+        FontBuffer fontData; // Entire TTF font data, mapped or loaded from file.
+        HeadTable headTable{}; // Global information about the font, used by several other tables.
         uint16_t numGlyphs = 0; // Number of glyphs in the font.
     };
 
@@ -0,0 +1,61 @@
+#include "TableDirectory.hpp"
+#include "BigEndian.hpp"
+
+namespace TTFParser {
+    uint32_t calculateTableChecksum(ByteView table) {
+        const size_t words = table.size() / 4;
+        uint32_t sum = sumU32Array(table.data(), words);
+        for (size_t i = 4 * words; i < table.size(); ++i) {
+            sum += uint32_t(table[i]) << (24 - 8 * (i & 3));
+        }
+        return sum;
+    }
+
+    uint32_t calculateTableChecksum(Tag tag, ByteView table) {
+        uint32_t sum = calculateTableChecksum(table);
+        if (tag == Tag("head") && table.size() >= 12) {
+            // checkSumAdjustment is the word at offset 8
+            sum -= (uint32_t(table[8]) << 24) | (uint32_t(table[9]) << 16) | (uint32_t(table[10]) << 8) | table[11];
+        }
+        return sum;
+    }
+
+    const uint8_t TableDirectory::kEmptySlot; // array::fill binds it to a reference, so it needs a definition.
+
+    void TableDirectory::clear() {
+        slots.fill(kEmptySlot);
+        count = 0;
+    }
+
+    bool TableDirectory::add(uint32_t tag, uint32_t checkSum, ByteView data) {
+        if (count >= kMaxTables) {
+            return false;
+        }
+
+        size_t slot = slotFor(tag);
+        while (slots[slot] != kEmptySlot) {
+            if (records[slots[slot]].tag == tag) {
+                return false; // Duplicate tag
+            }
+            slot = (slot + 1) & (kSlotCount - 1);
+        }
+
+        records[count] = TableRecord{ tag, checkSum, data };
+        slots[slot] = static_cast<uint8_t>(count);
+        ++count;
+        return true;
+    }
+
+    const TableRecord* TableDirectory::find(Tag tag) const {
+        size_t slot = slotFor(tag.value);
+        while (slots[slot] != kEmptySlot) {
+            const TableRecord& record = records[slots[slot]];
+            if (record.tag == tag.value) {
+                return &record;
+            }
+            slot = (slot + 1) & (kSlotCount - 1);
+        }
+        return nullptr;
+    }
+
+} // namespace TTFParser
@@ -0,0 +1,150 @@
+#ifndef TABLE_DIRECTORY_HPP
+#define TABLE_DIRECTORY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FontBuffer.hpp"
+
+namespace TTFParser {
+
+    /**
+    * @struct Tag
+    * @brief A 4-byte OpenType tag held as its big-endian uint32_t value.
+    *
+    * Built from a string literal at compile time, e.g. Tag("head"); literals that are not
+    * exactly four characters long fail to compile.
+    */
+    struct Tag {
+        uint32_t value;
+
+        constexpr explicit Tag(uint32_t tagValue) : value(tagValue) {}
+
+        template <size_t N>
+        constexpr Tag(const char (&name)[N])
+            : value((uint32_t(uint8_t(name[0])) << 24) | (uint32_t(uint8_t(name[1])) << 16) |
+                (uint32_t(uint8_t(name[2])) << 8) | uint32_t(uint8_t(name[3]))) {
+            static_assert(N == 5, "Table tags must be exactly 4 characters long");
+        }
+
+        constexpr bool operator==(Tag other) const { return value == other.value; }
+        constexpr bool operator!=(Tag other) const { return value != other.value; }
+
+        // Returns the tag as a 4-character string, e.g. "OS/2".
+        std::string toString() const {
+            return std::string{ char(value >> 24), char(value >> 16), char(value >> 8), char(value) };
+        }
+    };
+
+    // A table located in the font: its tag (as a big-endian uint32_t), checksum and bytes.
+    struct TableRecord {
+        uint32_t tag;      // 4-byte identifier, e.g. 0x68656164 for 'head'.
+        uint32_t checkSum; // Checksum from the sfnt table directory.
+        ByteView data;     // View of the table bytes inside the font data.
+    };
+
+    /**
+     * @brief Computes an sfnt table checksum: the sum of the table's big-endian uint32 words,
+     * with the last word zero-padded.
+     */
+    uint32_t calculateTableChecksum(ByteView table);
+
+    /**
+     * @brief Computes a table checksum as recorded in the sfnt table directory, where the
+     * checkSumAdjustment field of 'head' counts as zero.
+     */
+    uint32_t calculateTableChecksum(Tag tag, ByteView table);
+
+    // head.checkSumAdjustment makes the checksum of the whole font equal to this value.
+    const uint32_t kFontChecksumMagic = 0xB1B0AFBA;
+
+    // A table directory checksum compared with the one recomputed from the table.
+    struct TableChecksum {
+        uint32_t tag = 0;
+        uint32_t stored = 0;
+        uint32_t computed = 0;
+
+        bool matches() const { return stored == computed; }
+    };
+
+    // Result of TTFParser::validateChecksums.
+    struct ChecksumReport {
+        std::vector<TableChecksum> tables; // In table directory order.
+        bool hasHead = false;
+        uint32_t storedAdjustment = 0;     // head.checkSumAdjustment.
+        uint32_t expectedAdjustment = 0;   // kFontChecksumMagic minus the font checksum with the adjustment zeroed.
+
+        bool adjustmentMatches() const { return !hasHead || storedAdjustment == expectedAdjustment; }
+
+        // Number of table checksums that do not match.
+        size_t tableMismatches() const {
+            size_t mismatches = 0;
+            for (const TableChecksum& table : tables) {
+                mismatches += table.matches() ? 0 : 1;
+            }
+            return mismatches;
+        }
+
+        bool valid() const { return adjustmentMatches() && tableMismatches() == 0; }
+    };
+
+    /**
+    * @class TableDirectory
+    * @brief Maps 4-byte table tags to views of the table data.
+    *
+    * Records are kept in file order in a fixed array and indexed by a small open-addressing
+    * hash keyed by the tag, so building the directory allocates nothing and lookups are O(1).
+    */
+    class TableDirectory {
+    public:
+        static const size_t kMaxTables = 128; // Far more than any real font carries.
+
+        TableDirectory() { clear(); }
+
+        void clear();
+
+        /**
+         * @brief Adds a table to the directory.
+         * @return false if the directory is full or the tag is already present.
+         */
+        bool add(uint32_t tag, uint32_t checkSum, ByteView data);
+
+        /**
+         * @brief Finds the record for a tag.
+         * @return Pointer to the record, or nullptr if the font has no such table.
+         */
+        const TableRecord* find(Tag tag) const;
+
+        // Returns the table bytes for a tag, or an empty view if the table is missing.
+        ByteView get(Tag tag) const {
+            const TableRecord* record = find(tag);
+            return record ? record->data : ByteView();
+        }
+
+        bool contains(Tag tag) const { return find(tag) != nullptr; }
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        // Iteration in table directory (file) order.
+        const TableRecord* begin() const { return records.data(); }
+        const TableRecord* end() const { return records.data() + count; }
+
+    private:
+        static const size_t kSlotCount = 256; // Power of two, keeps the load factor <= 0.5.
+        static const uint8_t kEmptySlot = 0xFF;
+
+        static size_t slotFor(uint32_t tag) {
+            return (tag * 2654435761u) >> 24; // Fibonacci hashing down to 8 bits.
+        }
+
+        std::array<TableRecord, kMaxTables> records;
+        std::array<uint8_t, kSlotCount> slots; // Index into records, or kEmptySlot.
+        size_t count = 0;
+    };
+
+} // namespace TTFParser
+
+#endif // TABLE_DIRECTORY_HPP
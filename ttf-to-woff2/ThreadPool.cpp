@@ -0,0 +1,149 @@
+#include "ThreadPool.hpp"
+
+namespace TTFParser {
+    namespace {
+        inline uint64_t packRange(uint32_t begin, uint32_t end) {
+            return (static_cast<uint64_t>(begin) << 32) | end;
+        }
+
+        inline uint32_t rangeBegin(uint64_t bounds) { return static_cast<uint32_t>(bounds >> 32); }
+        inline uint32_t rangeEnd(uint64_t bounds) { return static_cast<uint32_t>(bounds); }
+    } // namespace
+
+    ThreadPool::ThreadPool(size_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::thread::hardware_concurrency();
+        }
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+
+        ranges.reset(new TaskRange[threadCount]);
+
+        workers.reserve(threadCount - 1);
+        for (size_t i = 1; i < threadCount; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) {
+            return;
+        }
+
+        // Nothing to share: run inline without waking anyone
+        if (workers.empty() || count == 1 || count > UINT32_MAX) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> jobLock(jobMutex);
+
+        // Hand every participant an equal contiguous slice; stealing evens out the rest
+        const size_t participants = concurrency();
+        for (size_t p = 0; p < participants; ++p) {
+            const uint32_t begin = static_cast<uint32_t>(count * p / participants);
+            const uint32_t end = static_cast<uint32_t>(count * (p + 1) / participants);
+            ranges[p].bounds.store(packRange(begin, end), std::memory_order_relaxed);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentTask = &task;
+            activeWorkers = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+
+        runTasks(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return activeWorkers == 0; });
+        currentTask = nullptr;
+    }
+
+    void ThreadPool::workerLoop(size_t participant) {
+        uint64_t seenGeneration = 0;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping) {
+                    return;
+                }
+                seenGeneration = generation;
+            }
+
+            runTasks(participant);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--activeWorkers == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+
+    void ThreadPool::runTasks(size_t participant) {
+        const std::function<void(size_t)>& task = *currentTask;
+
+        uint32_t index;
+        while (takeLocal(participant, index) || steal(participant, index)) {
+            task(index);
+        }
+    }
+
+    bool ThreadPool::takeLocal(size_t participant, uint32_t& task) {
+        std::atomic<uint64_t>& bounds = ranges[participant].bounds;
+        uint64_t current = bounds.load(std::memory_order_acquire);
+
+        while (rangeBegin(current) < rangeEnd(current)) {
+            const uint64_t next = packRange(rangeBegin(current) + 1, rangeEnd(current));
+            if (bounds.compare_exchange_weak(current, next, std::memory_order_acq_rel)) {
+                task = rangeBegin(current);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ThreadPool::steal(size_t participant, uint32_t& task) {
+        const size_t participants = concurrency();
+
+        for (size_t step = 1; step < participants; ++step) {
+            std::atomic<uint64_t>& victim = ranges[(participant + step) % participants].bounds;
+            uint64_t current = victim.load(std::memory_order_acquire);
+
+            while (rangeBegin(current) < rangeEnd(current)) {
+                // Take the back half of the victim's remaining tasks (at least one)
+                const uint32_t begin = rangeBegin(current);
+                const uint32_t end = rangeEnd(current);
+                const uint32_t split = begin + (end - begin) / 2;
+
+                if (victim.compare_exchange_weak(current, packRange(begin, split), std::memory_order_acq_rel)) {
+                    // Run the first stolen task now and publish the rest as our own range.
+                    // Our range is empty here, so no other thread is modifying it.
+                    task = split;
+                    ranges[participant].bounds.store(packRange(split + 1, end), std::memory_order_release);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+} // namespace TTFParser
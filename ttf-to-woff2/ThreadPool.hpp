@@ -0,0 +1,76 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TTFParser {
+
+    /**
+    * @class ThreadPool
+    * @brief A persistent pool of worker threads that runs index-based parallel loops.
+    *
+    * parallelFor splits the task indices into one contiguous range per participant (every
+    * worker plus the calling thread). Each participant takes tasks from the front of its own
+    * range; once it runs dry it steals the back half of another participant's range, so uneven
+    * tasks still keep every core busy. Ranges are single atomic words, so neither taking nor
+    * stealing a task takes a lock.
+    *
+    * Tasks must not throw, and a task must not call parallelFor on the same pool.
+    */
+    class ThreadPool {
+    public:
+        /**
+         * @brief Starts the worker threads.
+         * @param threadCount Total number of threads to run tasks on, including the caller
+         *        of parallelFor; 0 uses std::thread::hardware_concurrency().
+         */
+        explicit ThreadPool(size_t threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Number of threads that run tasks, including the caller of parallelFor.
+        size_t concurrency() const { return workers.size() + 1; }
+
+        /**
+         * @brief Runs task(i) for every i in [0, count) and waits for all of them to finish.
+         * Calls from several threads are serialized.
+         */
+        void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    private:
+        // Task range of one participant, packed as (begin << 32) | end.
+        struct alignas(64) TaskRange {
+            std::atomic<uint64_t> bounds{ 0 };
+        };
+
+        void workerLoop(size_t participant);
+        void runTasks(size_t participant);
+        bool takeLocal(size_t participant, uint32_t& task);
+        bool steal(size_t participant, uint32_t& task);
+
+        std::vector<std::thread> workers;
+        std::unique_ptr<TaskRange[]> ranges; // One per participant; index 0 is the caller.
+
+        std::mutex jobMutex; // Serializes parallelFor calls.
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        const std::function<void(size_t)>* currentTask = nullptr;
+        uint64_t generation = 0;   // Bumped for every job so sleeping workers notice it.
+        size_t activeWorkers = 0;  // Workers still running the current job.
+        bool stopping = false;
+    };
+
+} // namespace TTFParser
+
+#endif // THREAD_POOL_HPP
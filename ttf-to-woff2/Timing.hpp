@@ -0,0 +1,18 @@
+#ifndef TIMING_HPP
+#define TIMING_HPP
+
+#include <chrono>
+
+namespace TTFParser {
+
+    // Clock of every timing statistic; steady, so wall-clock adjustments never show up in a measurement.
+    typedef std::chrono::steady_clock Clock;
+
+    // Milliseconds since `start`.
+    inline double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+} // namespace TTFParser
+
+#endif // TIMING_HPP
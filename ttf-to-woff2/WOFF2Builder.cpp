@@ -0,0 +1,778 @@
+#include "WOFF2Builder.hpp"
+#include "Timing.hpp"
+#include "WOFF2Encoding.hpp"
+#include <algorithm>
+#include <brotli/encode.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace WOFF2Builder {
+    using TTFParser::CompoundComponent;
+    using TTFParser::GlyfTable;
+    using TTFParser::GlyphMetrics;
+    using TTFParser::GlyphRecord;
+    using TTFParser::ByteView;
+    using TTFParser::Tag;
+    typedef TTFParser::TTFParser Parser;
+    using TTFParser::Clock;
+    using TTFParser::elapsedMs;
+
+    namespace {
+        const uint32_t kSignature = 0x774F4632; // 'wOF2'
+        const uint32_t kGlyfTag = Tag("glyf").value;
+        const uint32_t kLocaTag = Tag("loca").value;
+        const uint32_t kHeadTag = Tag("head").value;
+        const uint32_t kHmtxTag = Tag("hmtx").value;
+
+        // Forwards to another sink, counting the bytes and the time spent writing them.
+        class MeteredSink : public OutputSink {
+        public:
+            MeteredSink(OutputSink& target, Clock::time_point start) : target(target), start(start) {}
+
+            bool write(const uint8_t* data, size_t size) override {
+                const Clock::time_point writeStart = Clock::now();
+                if (bytes == 0 && size > 0) {
+                    firstByteMs = std::chrono::duration<double, std::milli>(writeStart - start).count();
+                }
+                const bool written = target.write(data, size);
+                writeMs += elapsedMs(writeStart);
+                bytes += size;
+                return written;
+            }
+
+            uint64_t bytes = 0;
+            double writeMs = 0.0;
+            double firstByteMs = 0.0;
+
+        private:
+            OutputSink& target;
+            Clock::time_point start;
+        };
+
+        // Number of glyph-stream bytes the triplet encoding of (dx, dy) takes.
+        inline size_t tripletSize(int dx, int dy) {
+            const int absX = std::abs(dx);
+            const int absY = std::abs(dy);
+            if ((dx == 0 && absY < 1280) || (dy == 0 && absX < 1280) || (absX < 65 && absY < 65)) {
+                return 1;
+            }
+            if (absX < 769 && absY < 769) {
+                return 2;
+            }
+            return (absX < 4096 && absY < 4096) ? 3 : 4;
+        }
+
+        // Triplet-encodes one point delta (WOFF2 spec, section 5.2): one flag byte, whose top
+        // bit marks an off-curve point, plus 1 to 4 bytes in the glyph stream.
+        inline uint8_t* writeTriplet(bool onCurve, int dx, int dy, uint8_t* flag, uint8_t* glyph) {
+            const int absX = std::abs(dx);
+            const int absY = std::abs(dy);
+            const int onCurveBit = onCurve ? 0 : 128;
+            const int xSignBit = (dx < 0) ? 0 : 1;
+            const int ySignBit = (dy < 0) ? 0 : 1;
+            const int xySignBits = xSignBit + 2 * ySignBit;
+
+            if (dx == 0 && absY < 1280) {
+                *flag = static_cast<uint8_t>(onCurveBit + ((absY & 0xF00) >> 7) + ySignBit);
+                *glyph++ = static_cast<uint8_t>(absY);
+            }
+            else if (dy == 0 && absX < 1280) {
+                *flag = static_cast<uint8_t>(onCurveBit + 10 + ((absX & 0xF00) >> 7) + xSignBit);
+                *glyph++ = static_cast<uint8_t>(absX);
+            }
+            else if (absX < 65 && absY < 65) {
+                *flag = static_cast<uint8_t>(onCurveBit + 20 + ((absX - 1) & 0x30) + (((absY - 1) & 0x30) >> 2) + xySignBits);
+                *glyph++ = static_cast<uint8_t>((((absX - 1) & 0xF) << 4) | ((absY - 1) & 0xF));
+            }
+            else if (absX < 769 && absY < 769) {
+                *flag = static_cast<uint8_t>(onCurveBit + 84 + 12 * (((absX - 1) & 0x300) >> 8) + (((absY - 1) & 0x300) >> 6) + xySignBits);
+                *glyph++ = static_cast<uint8_t>(absX - 1);
+                *glyph++ = static_cast<uint8_t>(absY - 1);
+            }
+            else if (absX < 4096 && absY < 4096) {
+                *flag = static_cast<uint8_t>(onCurveBit + 120 + xySignBits);
+                *glyph++ = static_cast<uint8_t>(absX >> 4);
+                *glyph++ = static_cast<uint8_t>(((absX & 0xF) << 4) | (absY >> 8));
+                *glyph++ = static_cast<uint8_t>(absY);
+            }
+            else {
+                *flag = static_cast<uint8_t>(onCurveBit + 124 + xySignBits);
+                *glyph++ = static_cast<uint8_t>(absX >> 8);
+                *glyph++ = static_cast<uint8_t>(absX);
+                *glyph++ = static_cast<uint8_t>(absY >> 8);
+                *glyph++ = static_cast<uint8_t>(absY);
+            }
+            return glyph;
+        }
+
+        // Size of a component record in the composite stream, exactly as it is stored in 'glyf'.
+        inline size_t componentSize(const CompoundComponent& component) {
+            size_t size = 4 + ((component.flags & Parser::ARG_1_AND_2_ARE_WORDS) ? 4 : 2);
+            if (component.flags & Parser::WE_HAVE_A_SCALE) {
+                size += 2;
+            }
+            else if (component.flags & Parser::WE_HAVE_AN_X_AND_Y_SCALE) {
+                size += 4;
+            }
+            else if (component.flags & Parser::WE_HAVE_A_TWO_BY_TWO) {
+                size += 8;
+            }
+            return size;
+        }
+
+        // Size of the flags and coordinates of a simple glyph as a decoder rebuilds them: each delta
+        // in its shortest form, and runs of up to 256 equal flags folded with REPEAT_FLAG.
+        uint64_t simpleGlyphPointsSize(const GlyfTable& glyf, const GlyphRecord& record) {
+            uint64_t size = 0;
+            int x = 0, y = 0;
+            int runFlag = -1;
+            size_t run = 0;
+            for (uint32_t i = 0; i < record.numPoints; ++i) {
+                const size_t point = record.firstPoint + i;
+                const int dx = glyf.xCoordinates[point] - x;
+                const int dy = glyf.yCoordinates[point] - y;
+                x = glyf.xCoordinates[point];
+                y = glyf.yCoordinates[point];
+
+                int flag = glyf.isOnCurve(point) ? Parser::ON_CURVE_POINT : 0;
+                if (i == 0 && record.overlapSimple) {
+                    flag |= Parser::OVERLAP_SIMPLE;
+                }
+                if (dx == 0) {
+                    flag |= Parser::X_IS_SAME_OR_POSITIVE_X_SHORT_VECTOR;
+                }
+                else {
+                    const bool isShort = dx >= -255 && dx <= 255;
+                    flag |= isShort ? Parser::X_SHORT_VECTOR | (dx > 0 ? Parser::X_IS_SAME_OR_POSITIVE_X_SHORT_VECTOR : 0) : 0;
+                    size += isShort ? 1 : 2;
+                }
+                if (dy == 0) {
+                    flag |= Parser::Y_IS_SAME_OR_POSITIVE_Y_SHORT_VECTOR;
+                }
+                else {
+                    const bool isShort = dy >= -255 && dy <= 255;
+                    flag |= isShort ? Parser::Y_SHORT_VECTOR | (dy > 0 ? Parser::Y_IS_SAME_OR_POSITIVE_Y_SHORT_VECTOR : 0) : 0;
+                    size += isShort ? 1 : 2;
+                }
+
+                if (flag == runFlag && run < 256) {
+                    size += run == 1; // The repeat count byte, once per run
+                    ++run;
+                }
+                else {
+                    ++size;
+                    runFlag = flag;
+                    run = 1;
+                }
+            }
+            return size;
+        }
+
+        inline uint8_t* writeComponent(uint8_t* out, const CompoundComponent& component) {
+            out = writeU16(out, component.flags);
+            out = writeU16(out, component.glyphIndex);
+
+            if (component.flags & Parser::ARG_1_AND_2_ARE_WORDS) {
+                out = writeU16(out, static_cast<uint16_t>(component.arg1));
+                out = writeU16(out, static_cast<uint16_t>(component.arg2));
+            }
+            else {
+                *out++ = static_cast<uint8_t>(component.arg1);
+                *out++ = static_cast<uint8_t>(component.arg2);
+            }
+
+            if (component.flags & Parser::WE_HAVE_A_SCALE) {
+                out = writeU16(out, static_cast<uint16_t>(component.xScale));
+            }
+            else if (component.flags & Parser::WE_HAVE_AN_X_AND_Y_SCALE) {
+                out = writeU16(out, static_cast<uint16_t>(component.xScale));
+                out = writeU16(out, static_cast<uint16_t>(component.yScale));
+            }
+            else if (component.flags & Parser::WE_HAVE_A_TWO_BY_TWO) {
+                out = writeU16(out, static_cast<uint16_t>(component.xScale));
+                out = writeU16(out, static_cast<uint16_t>(component.scale01));
+                out = writeU16(out, static_cast<uint16_t>(component.scale10));
+                out = writeU16(out, static_cast<uint16_t>(component.yScale));
+            }
+            return out;
+        }
+
+        // Size in bytes of a bitmap with one bit per glyph, padded to 4 bytes.
+        inline uint32_t glyphBitmapSize(size_t numGlyphs) {
+            return static_cast<uint32_t>(((numGlyphs + 31) >> 5) << 2);
+        }
+    } // namespace
+
+    WOFF2Builder::WOFF2Builder(const CompressionOptions& options) : compression(options) {
+    }
+
+    void WOFF2Builder::reset(uint32_t newFlavor) {
+        flavor = newFlavor;
+        tables.clear();
+        glyfTable = nullptr;
+        indexToLocFormat = 0;
+        hmtxMetrics = nullptr;
+        numberOfHMetrics = 0;
+        stats = BuildStats();
+    }
+
+    bool WOFF2Builder::addTable(Tag tag, ByteView data) {
+        for (const TableEntry& table : tables) {
+            if (table.tag == tag.value) {
+                std::cerr << "Error: Table '" << tag.toString() << "' was added twice." << std::endl;
+                return false;
+            }
+        }
+
+        TableEntry entry;
+        entry.tag = tag.value;
+        entry.transformVersion = (tag.value == kGlyfTag || tag.value == kLocaTag) ? 3 : 0;
+        entry.origLength = static_cast<uint32_t>(data.size());
+        entry.data = data;
+        tables.push_back(entry);
+        return true;
+    }
+
+    void WOFF2Builder::setGlyfTable(const GlyfTable& glyf, int16_t format) {
+        glyfTable = &glyf;
+        indexToLocFormat = format;
+    }
+
+    void WOFF2Builder::setHmtxMetrics(const std::vector<GlyphMetrics>& metrics, uint16_t count) {
+        hmtxMetrics = &metrics;
+        numberOfHMetrics = count;
+    }
+
+    size_t GlyfStreamSizes::total() const {
+        return WOFF2Builder::kGlyfHeaderSize + size_t(nContour) + nPoints + flag + glyph + composite + bbox + instruction + overlapSimple;
+    }
+
+    bool WOFF2Builder::hasComputedBBox(const GlyfTable& glyf, const GlyphRecord& glyph) {
+        const auto xs = glyf.xCoordinates.begin() + glyph.firstPoint;
+        const auto ys = glyf.yCoordinates.begin() + glyph.firstPoint;
+        const auto xRange = std::minmax_element(xs, xs + glyph.numPoints);
+        const auto yRange = std::minmax_element(ys, ys + glyph.numPoints);
+
+        return *xRange.first == glyph.xMin && *yRange.first == glyph.yMin &&
+            *xRange.second == glyph.xMax && *yRange.second == glyph.yMax;
+    }
+
+    bool WOFF2Builder::compoundHasInstructions(const GlyfTable& glyf, const GlyphRecord& glyph) {
+        for (uint32_t c = 0; c < glyph.numComponents; ++c) {
+            if (glyf.components[glyph.firstComponent + c].flags & Parser::WE_HAVE_INSTRUCTIONS) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool WOFF2Builder::measureGlyf(const GlyfTable& glyf, GlyfStreamSizes& sizes) const {
+        sizes = GlyfStreamSizes();
+
+        const size_t numGlyphs = glyf.glyphs.size();
+        if (numGlyphs > 0xFFFF) {
+            std::cerr << "Error: Too many glyphs for a transformed 'glyf' table." << std::endl;
+            return false;
+        }
+
+        uint64_t nPoints = 0, flag = 0, glyph = 0, composite = 0, bboxValues = 0, instruction = 0;
+        bool anyOverlap = false;
+
+        for (const GlyphRecord& record : glyf.glyphs) {
+            if (record.numberOfContours > 0) {
+                nPoints += sizeContourPointCounts(&glyf.endPointOfContours[record.firstContour], record.numberOfContours);
+
+                flag += record.numPoints;
+
+                int x = 0, y = 0;
+                for (uint32_t i = 0; i < record.numPoints; ++i) {
+                    const int px = glyf.xCoordinates[record.firstPoint + i];
+                    const int py = glyf.yCoordinates[record.firstPoint + i];
+                    glyph += tripletSize(px - x, py - y);
+                    x = px;
+                    y = py;
+                }
+
+                glyph += size255UInt16(record.instructionLength);
+                instruction += record.instructionLength;
+
+                if (!hasComputedBBox(glyf, record)) {
+                    bboxValues += 8;
+                }
+                anyOverlap |= record.overlapSimple;
+            }
+            else if (record.numberOfContours < 0) {
+                for (uint32_t c = 0; c < record.numComponents; ++c) {
+                    composite += componentSize(glyf.components[record.firstComponent + c]);
+                }
+
+                if (compoundHasInstructions(glyf, record)) {
+                    glyph += size255UInt16(record.instructionLength);
+                    instruction += record.instructionLength;
+                }
+
+                bboxValues += 8; // Compound glyphs always carry an explicit bbox
+            }
+        }
+
+        const uint64_t bbox = glyphBitmapSize(numGlyphs) + bboxValues;
+        if (std::max({ nPoints, flag, glyph, composite, bbox, instruction }) > UINT32_MAX) {
+            std::cerr << "Error: Transformed 'glyf' stream exceeds 4 GB." << std::endl;
+            return false;
+        }
+
+        sizes.nContour = static_cast<uint32_t>(2 * numGlyphs);
+        sizes.nPoints = static_cast<uint32_t>(nPoints);
+        sizes.flag = static_cast<uint32_t>(flag);
+        sizes.glyph = static_cast<uint32_t>(glyph);
+        sizes.composite = static_cast<uint32_t>(composite);
+        sizes.bbox = static_cast<uint32_t>(bbox);
+        sizes.instruction = static_cast<uint32_t>(instruction);
+        sizes.overlapSimple = anyOverlap ? glyphBitmapSize(numGlyphs) : 0;
+        return true;
+    }
+
+    bool WOFF2Builder::transformGlyf(const GlyfTable& glyf, int16_t indexToLocFormat,
+        std::vector<uint8_t>& out, GlyfStreamSizes* sizesOut) const {
+        GlyfStreamSizes sizes;
+        if (!measureGlyf(glyf, sizes)) {
+            return false;
+        }
+
+        const size_t numGlyphs = glyf.glyphs.size();
+        out.assign(sizes.total(), 0);
+
+        // Header
+        uint8_t* header = out.data();
+        header = writeU16(header, 0); // reserved
+        header = writeU16(header, sizes.overlapSimple ? 1 : 0); // optionFlags: bit 0 = overlapSimpleBitmap present
+        header = writeU16(header, static_cast<uint16_t>(numGlyphs));
+        header = writeU16(header, static_cast<uint16_t>(indexToLocFormat));
+        header = writeU32(header, sizes.nContour);
+        header = writeU32(header, sizes.nPoints);
+        header = writeU32(header, sizes.flag);
+        header = writeU32(header, sizes.glyph);
+        header = writeU32(header, sizes.composite);
+        header = writeU32(header, sizes.bbox);
+        header = writeU32(header, sizes.instruction);
+
+        // Each stream gets its own write cursor at its final position
+        uint8_t* nContourStream = header;
+        uint8_t* nPointsStream = nContourStream + sizes.nContour;
+        uint8_t* flagStream = nPointsStream + sizes.nPoints;
+        uint8_t* glyphStream = flagStream + sizes.flag;
+        uint8_t* compositeStream = glyphStream + sizes.glyph;
+        uint8_t* bboxBitmap = compositeStream + sizes.composite;
+        uint8_t* bboxStream = bboxBitmap + glyphBitmapSize(numGlyphs);
+        uint8_t* instructionStream = bboxBitmap + sizes.bbox;
+        uint8_t* overlapBitmap = instructionStream + sizes.instruction;
+
+        for (size_t g = 0; g < numGlyphs; ++g) {
+            const GlyphRecord& record = glyf.glyphs[g];
+
+            if (record.numberOfContours > 0) {
+                nContourStream = writeU16(nContourStream, static_cast<uint16_t>(record.numberOfContours));
+
+                nPointsStream = writeContourPointCounts(nPointsStream, &glyf.endPointOfContours[record.firstContour], record.numberOfContours);
+
+                int x = 0, y = 0;
+                for (uint32_t i = 0; i < record.numPoints; ++i) {
+                    const size_t point = record.firstPoint + i;
+                    const int px = glyf.xCoordinates[point];
+                    const int py = glyf.yCoordinates[point];
+                    glyphStream = writeTriplet(glyf.isOnCurve(point), px - x, py - y, flagStream++, glyphStream);
+                    x = px;
+                    y = py;
+                }
+
+                glyphStream = write255UInt16(glyphStream, record.instructionLength);
+                std::memcpy(instructionStream, glyf.instructions.data() + record.firstInstruction, record.instructionLength);
+                instructionStream += record.instructionLength;
+
+                if (!hasComputedBBox(glyf, record)) {
+                    bboxBitmap[g >> 3] |= 0x80 >> (g & 7);
+                    bboxStream = writeU16(bboxStream, static_cast<uint16_t>(record.xMin));
+                    bboxStream = writeU16(bboxStream, static_cast<uint16_t>(record.yMin));
+                    bboxStream = writeU16(bboxStream, static_cast<uint16_t>(record.xMax));
+                    bboxStream = writeU16(bboxStream, static_cast<uint16_t>(record.yMax));
+                }
+
+                if (record.overlapSimple) {
+                    overlapBitmap[g >> 3] |= 0x80 >> (g & 7);
+                }
+            }
+            else if (record.numberOfContours < 0) {
+                nContourStream = writeU16(nContourStream, 0xFFFF); // -1
+
+                for (uint32_t c = 0; c < record.numComponents; ++c) {
+                    compositeStream = writeComponent(compositeStream, glyf.components[record.firstComponent + c]);
+                }
+
+                if (compoundHasInstructions(glyf, record)) {
+                    glyphStream = write255UInt16(glyphStream, record.instructionLength);
+                    std::memcpy(instructionStream, glyf.instructions.data() + record.firstInstruction, record.instructionLength);
+                    instructionStream += record.instructionLength;
+                }
+
+                bboxBitmap[g >> 3] |= 0x80 >> (g & 7);
+                bboxStream = writeU16(bboxStream, static_cast<uint16_t>(record.xMin));
+                bboxStream = writeU16(bboxStream, static_cast<uint16_t>(record.yMin));
+                bboxStream = writeU16(bboxStream, static_cast<uint16_t>(record.xMax));
+                bboxStream = writeU16(bboxStream, static_cast<uint16_t>(record.yMax));
+            }
+            else {
+                nContourStream = writeU16(nContourStream, 0); // Empty glyph: nothing else is stored
+            }
+        }
+
+        if (sizesOut) {
+            *sizesOut = sizes;
+        }
+        return true;
+    }
+
+    bool WOFF2Builder::transformHmtx(const GlyfTable& glyf, const std::vector<GlyphMetrics>& metrics,
+        uint16_t numberOfHMetrics, std::vector<uint8_t>& out) const {
+        const size_t numGlyphs = glyf.glyphs.size();
+        if (metrics.size() != numGlyphs || numberOfHMetrics == 0 || numberOfHMetrics > numGlyphs) {
+            return false;
+        }
+
+        // Decoders take the side bearing of a dropped array from the glyph's xMin (0 when empty)
+        auto bearingsMatch = [&](size_t begin, size_t end) {
+            for (size_t g = begin; g < end; ++g) {
+                const GlyphRecord& record = glyf.glyphs[g];
+                const int16_t xMin = record.numberOfContours != 0 ? record.xMin : 0;
+                if (metrics[g].lsb != xMin) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        const bool dropLsb = bearingsMatch(0, numberOfHMetrics);
+        const bool dropLeftSideBearing = bearingsMatch(numberOfHMetrics, numGlyphs);
+        const size_t numLeftSideBearings = numGlyphs - numberOfHMetrics;
+
+        const size_t originalSize = 4 * size_t(numberOfHMetrics) + 2 * numLeftSideBearings;
+        const size_t transformedSize = 1 + 2 * size_t(numberOfHMetrics) +
+            (dropLsb ? 0 : 2 * size_t(numberOfHMetrics)) + (dropLeftSideBearing ? 0 : 2 * numLeftSideBearings);
+        // A saving of a few bytes tends to cost more than it gains once Brotli has run (it shifts
+        // the advance widths), so the table must shrink by at least an eighth. This also
+        // rejects the case where nothing can be dropped.
+        if (transformedSize > originalSize - originalSize / 8) {
+            return false;
+        }
+
+        out.resize(transformedSize);
+        uint8_t* cursor = out.data();
+        *cursor++ = static_cast<uint8_t>((dropLsb ? 1 : 0) | (dropLeftSideBearing ? 2 : 0));
+
+        for (size_t g = 0; g < numberOfHMetrics; ++g) {
+            cursor = writeU16(cursor, metrics[g].advanceWidth);
+        }
+        if (!dropLsb) {
+            for (size_t g = 0; g < numberOfHMetrics; ++g) {
+                cursor = writeU16(cursor, static_cast<uint16_t>(metrics[g].lsb));
+            }
+        }
+        if (!dropLeftSideBearing) {
+            for (size_t g = numberOfHMetrics; g < numGlyphs; ++g) {
+                cursor = writeU16(cursor, static_cast<uint16_t>(metrics[g].lsb));
+            }
+        }
+        return true;
+    }
+
+    uint64_t WOFF2Builder::reconstructedGlyfSize(const GlyfTable& glyf) {
+        uint64_t total = 0;
+        for (const GlyphRecord& record : glyf.glyphs) {
+            uint64_t size = 0;
+            if (record.numberOfContours > 0) {
+                // Header, endpoints, instructions, then flags and coordinates
+                size = 10 + 2 * uint64_t(record.numberOfContours) + 2 + record.instructionLength + simpleGlyphPointsSize(glyf, record);
+            }
+            else if (record.numberOfContours < 0) {
+                size = 10;
+                for (uint32_t c = 0; c < record.numComponents; ++c) {
+                    size += componentSize(glyf.components[record.firstComponent + c]);
+                }
+                if (compoundHasInstructions(glyf, record)) {
+                    size += 2 + record.instructionLength;
+                }
+            }
+            total += (size + 3) & ~uint64_t(3); // Decoders pad every glyph to 4 bytes
+        }
+        return total;
+    }
+
+    size_t WOFF2Builder::tableDirectorySize(const std::vector<TableEntry>& entries) {
+        size_t size = 0;
+        for (const TableEntry& entry : entries) {
+            size += tableDirectoryEntrySize(entry.tag, entry.origLength, entry.transformed, static_cast<uint32_t>(entry.data.size()));
+        }
+        return size;
+    }
+
+    uint8_t* WOFF2Builder::writeTableDirectory(const std::vector<TableEntry>& entries, uint8_t* out) {
+        for (const TableEntry& entry : entries) {
+            out = writeTableDirectoryEntry(out, entry.tag, entry.transformVersion, entry.origLength,
+                entry.transformed, static_cast<uint32_t>(entry.data.size()));
+        }
+        return out;
+    }
+
+    bool WOFF2Builder::compress(const std::vector<ByteView>& parts, const CompressionOptions& options,
+        std::vector<uint8_t>& out) {
+        VectorSink sink(out);
+        return compress(parts, options, sink);
+    }
+
+    bool WOFF2Builder::compress(const std::vector<ByteView>& parts, const CompressionOptions& options, OutputSink& sink) {
+        BrotliEncoderState* state = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+        if (!state) {
+            std::cerr << "Error: Failed to create the Brotli encoder." << std::endl;
+            return false;
+        }
+
+        size_t totalSize = 0;
+        for (const ByteView& part : parts) {
+            totalSize += part.size();
+        }
+
+        BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY,
+            static_cast<uint32_t>(std::max(BROTLI_MIN_QUALITY, std::min(BROTLI_MAX_QUALITY, options.quality))));
+        BrotliEncoderSetParameter(state, BROTLI_PARAM_LGWIN,
+            static_cast<uint32_t>(std::max(BROTLI_MIN_WINDOW_BITS, std::min(BROTLI_MAX_WINDOW_BITS, options.windowBits))));
+        BrotliEncoderSetParameter(state, BROTLI_PARAM_MODE, options.fontMode ? BROTLI_MODE_FONT : BROTLI_MODE_GENERIC);
+        BrotliEncoderSetParameter(state, BROTLI_PARAM_SIZE_HINT, static_cast<uint32_t>(std::min<size_t>(totalSize, 1u << 30)));
+
+        // Feed every part, then finish the stream; output goes to the sink as the encoder produces it
+        bool ok = true;
+        for (size_t i = 0; i <= parts.size() && ok; ++i) {
+            const bool finish = (i == parts.size());
+            if (!finish && parts[i].empty()) {
+                continue;
+            }
+
+            size_t availableIn = finish ? 0 : parts[i].size();
+            const uint8_t* nextIn = finish ? nullptr : parts[i].data();
+            const BrotliEncoderOperation operation = finish ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_PROCESS;
+
+            for (;;) {
+                size_t availableOut = 0;
+                if (!BrotliEncoderCompressStream(state, operation, &availableIn, &nextIn, &availableOut, nullptr, nullptr)) {
+                    std::cerr << "Error: Brotli compression failed." << std::endl;
+                    ok = false;
+                    break;
+                }
+
+                size_t produced = 0;
+                const uint8_t* output = BrotliEncoderTakeOutput(state, &produced);
+                if (produced > 0 && !sink.write(output, produced)) {
+                    std::cerr << "Error: Failed to write compressed data." << std::endl;
+                    ok = false;
+                    break;
+                }
+
+                const bool done = finish ? BrotliEncoderIsFinished(state) != 0
+                    : (availableIn == 0 && !BrotliEncoderHasMoreOutput(state));
+                if (done) {
+                    break;
+                }
+            }
+        }
+
+        BrotliEncoderDestroyInstance(state);
+        return ok;
+    }
+
+    bool WOFF2Builder::prepareTables(std::vector<TableEntry>& entries, uint64_t& sfntSize) {
+        entries.clear();
+        entries.reserve(tables.size() + 2);
+        for (const TableEntry& table : tables) {
+            if (glyfTable && (table.tag == kGlyfTag || table.tag == kLocaTag)) {
+                continue; // Replaced by the transformed tables
+            }
+            entries.push_back(table);
+        }
+
+        if (glyfTable) {
+            const Clock::time_point transformStart = Clock::now();
+
+            // Decoders rebuild 'loca' in the format given here, so switch to long offsets if the
+            // rebuilt glyphs are not addressable with short ones
+            const uint64_t glyfSize = reconstructedGlyfSize(*glyfTable);
+            if (glyfSize > UINT32_MAX) {
+                std::cerr << "Error: Rebuilt 'glyf' table would exceed 4 GB." << std::endl;
+                return false;
+            }
+            const int16_t locaFormat = (indexToLocFormat == 0 && glyfSize > 0x1FFFE) ? 1 : indexToLocFormat;
+
+            if (!transformGlyf(*glyfTable, locaFormat, transformedGlyf)) {
+                return false;
+            }
+
+            TableEntry glyf;
+            glyf.tag = kGlyfTag;
+            glyf.transformed = true;
+            glyf.origLength = static_cast<uint32_t>(glyfSize);
+            glyf.data = ByteView(transformedGlyf.data(), transformedGlyf.size());
+            entries.push_back(glyf);
+
+            TableEntry loca; // Transformed 'loca' is empty: it is rebuilt from the glyphs
+            loca.tag = kLocaTag;
+            loca.transformed = true;
+            loca.origLength = static_cast<uint32_t>((glyfTable->glyphs.size() + 1) * (locaFormat ? 4 : 2));
+            entries.push_back(loca);
+
+            for (TableEntry& entry : entries) {
+                if (entry.tag != kHeadTag) {
+                    continue;
+                }
+                if (entry.data.size() < 54) {
+                    std::cerr << "Error: 'head' table is too short." << std::endl;
+                    return false;
+                }
+
+                patchedHead.assign(entry.data.begin(), entry.data.end());
+                patchedHead[16] |= 0x08; // flags bit 11: font data went through a lossless transform
+                writeU16(&patchedHead[50], static_cast<uint16_t>(locaFormat));
+                entry.data = ByteView(patchedHead.data(), patchedHead.size());
+            }
+
+            // hmtx is rebuilt from the glyph bboxes, so it can only be transformed along with glyf
+            if (hmtxMetrics && transformHmtx(*glyfTable, *hmtxMetrics, numberOfHMetrics, transformedHmtx)) {
+                for (TableEntry& entry : entries) {
+                    if (entry.tag == kHmtxTag) {
+                        entry.transformVersion = 1;
+                        entry.transformed = true;
+                        entry.origLength = static_cast<uint32_t>(4 * size_t(numberOfHMetrics) + 2 * (hmtxMetrics->size() - numberOfHMetrics));
+                        entry.data = ByteView(transformedHmtx.data(), transformedHmtx.size());
+                    }
+                }
+            }
+
+            stats.transformMs = elapsedMs(transformStart);
+        }
+
+        // Tables in tag order, except that 'loca' must directly follow 'glyf'
+        std::sort(entries.begin(), entries.end(), [](const TableEntry& a, const TableEntry& b) { return a.tag < b.tag; });
+        auto isGlyf = [](const TableEntry& entry) { return entry.tag == kGlyfTag; };
+        auto isLoca = [](const TableEntry& entry) { return entry.tag == kLocaTag; };
+        const auto glyfEntry = std::find_if(entries.begin(), entries.end(), isGlyf);
+        const auto locaEntry = std::find_if(entries.begin(), entries.end(), isLoca);
+        if (glyfEntry != entries.end() && locaEntry != entries.end() && locaEntry > glyfEntry) {
+            std::rotate(glyfEntry + 1, locaEntry, locaEntry + 1);
+        }
+
+        if (entries.size() > 0xFFFF) {
+            std::cerr << "Error: Too many tables for a WOFF2 file." << std::endl;
+            return false;
+        }
+
+        // totalSfntSize is the size of the font a decoder rebuilds: offset table, table records
+        // and every table padded to 4 bytes
+        sfntSize = 12 + 16 * uint64_t(entries.size());
+        for (const TableEntry& entry : entries) {
+            sfntSize += (uint64_t(entry.origLength) + 3) & ~uint64_t(3);
+            stats.rawBytes += entry.data.size();
+        }
+        if (sfntSize > UINT32_MAX) {
+            std::cerr << "Error: Font is too large for a WOFF2 file." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void WOFF2Builder::writeHeader(uint8_t* header, size_t numTables, uint64_t sfntSize, uint64_t compressedSize,
+        uint64_t fileSize) const {
+        header = writeU32(header, kSignature);
+        header = writeU32(header, flavor);
+        header = writeU32(header, static_cast<uint32_t>(fileSize));       // length
+        header = writeU16(header, static_cast<uint16_t>(numTables));      // numTables
+        header = writeU16(header, 0);                                     // reserved
+        header = writeU32(header, static_cast<uint32_t>(sfntSize));       // totalSfntSize
+        header = writeU32(header, static_cast<uint32_t>(compressedSize)); // totalCompressedSize
+        header = writeU16(header, 1);                                     // majorVersion
+        header = writeU16(header, 0);                                     // minorVersion
+        std::memset(header, 0, 20); // metaOffset, metaLength, metaOrigLength, privOffset, privLength
+    }
+
+    bool WOFF2Builder::build(std::vector<uint8_t>& out) {
+        VectorSink sink(out);
+        return build(sink);
+    }
+
+    bool WOFF2Builder::build(OutputSink& sink) {
+        const Clock::time_point start = Clock::now();
+        stats = BuildStats();
+
+        std::vector<TableEntry> entries;
+        uint64_t sfntSize = 0;
+        if (!prepareTables(entries, sfntSize)) {
+            sink.finish(false);
+            return false;
+        }
+
+        std::vector<ByteView> parts;
+        parts.reserve(entries.size());
+        for (const TableEntry& entry : entries) {
+            parts.push_back(entry.data);
+        }
+
+        // Header and table directory; the header's size fields are filled in once Brotli is done
+        std::vector<uint8_t> prefix(kHeaderSize + tableDirectorySize(entries), 0);
+        writeTableDirectory(entries, prefix.data() + kHeaderSize);
+
+        MeteredSink output(sink, start);
+        const uint8_t padding[3] = { 0, 0, 0 };
+        bool ok = true;
+        uint64_t compressedSize = 0;
+        const Clock::time_point compressStart = Clock::now();
+
+        if (sink.canPatch()) {
+            // Send the prefix right away and stream the compressed data behind it, then fix the header
+            ok = output.write(prefix.data(), prefix.size()) && compress(parts, compression, output);
+            compressedSize = output.bytes - prefix.size();
+            stats.compressMs = elapsedMs(compressStart) - output.writeMs;
+
+            const uint64_t fileSize = (output.bytes + 3) & ~uint64_t(3);
+            ok = ok && fileSize <= UINT32_MAX && output.write(padding, static_cast<size_t>(fileSize - output.bytes));
+            if (ok) {
+                writeHeader(prefix.data(), entries.size(), sfntSize, compressedSize, fileSize);
+                ok = sink.patch(0, prefix.data(), kHeaderSize);
+            }
+        }
+        else {
+            // The header has to go first, so the compressed data is held until its size is known
+            std::vector<uint8_t> compressed;
+            ok = compress(parts, compression, compressed);
+            compressedSize = compressed.size();
+            stats.compressMs = elapsedMs(compressStart);
+
+            const uint64_t fileSize = (uint64_t(prefix.size()) + compressedSize + 3) & ~uint64_t(3);
+            ok = ok && fileSize <= UINT32_MAX;
+            if (ok) {
+                writeHeader(prefix.data(), entries.size(), sfntSize, compressedSize, fileSize);
+                ok = output.write(prefix.data(), prefix.size()) &&
+                    output.write(compressed.data(), compressed.size()) &&
+                    output.write(padding, static_cast<size_t>(fileSize - prefix.size() - compressedSize));
+            }
+        }
+
+        if (output.bytes > UINT32_MAX) {
+            std::cerr << "Error: WOFF2 file would exceed 4 GB." << std::endl;
+        }
+        ok = sink.finish(ok);
+
+        stats.compressedBytes = static_cast<size_t>(compressedSize);
+        stats.woff2Bytes = static_cast<size_t>(output.bytes);
+        stats.writeMs = output.writeMs;
+        stats.firstByteMs = output.firstByteMs;
+        stats.totalMs = elapsedMs(start);
+        return ok;
+    }
+
+} // namespace WOFF2Builder
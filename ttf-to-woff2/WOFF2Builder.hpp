@@ -0,0 +1,227 @@
+#ifndef WOFF2_BUILDER_HPP
+#define WOFF2_BUILDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FontBuffer.hpp"
+#include "OutputSink.hpp"
+#include "TableDirectory.hpp"
+#include "TTFParser.hpp"
+
+namespace WOFF2Builder {
+
+    // Sizes in bytes of the parts of a transformed 'glyf' table (WOFF2 spec, section 5.1).
+    struct GlyfStreamSizes {
+        uint32_t nContour = 0;     // int16 numberOfContours per glyph.
+        uint32_t nPoints = 0;      // 255UInt16 point count per contour.
+        uint32_t flag = 0;         // One flag byte per point.
+        uint32_t glyph = 0;        // Triplet coordinate data and 255UInt16 instruction lengths.
+        uint32_t composite = 0;    // Compound glyph component records.
+        uint32_t bbox = 0;         // Explicit-bbox bitmap followed by the explicit bboxes.
+        uint32_t instruction = 0;  // Instruction bytes of every glyph.
+        uint32_t overlapSimple = 0; // Optional overlapSimpleBitmap (0 when absent).
+
+        // Total size of the table, header included.
+        size_t total() const;
+    };
+
+    // Brotli settings for the compressed font data.
+    struct CompressionOptions {
+        int quality = 11;      // 0 (fastest) to 11 (smallest output).
+        int windowBits = 22;   // Base-2 log of the sliding window size (lgwin), 10 to 24.
+        bool fontMode = true;  // Tell Brotli the input is font data (BROTLI_MODE_FONT).
+    };
+
+    // Timings and byte counts of the last WOFF2Builder::build call.
+    struct BuildStats {
+        double transformMs = 0.0;  // Table transforms (glyf, loca and hmtx).
+        double compressMs = 0.0;   // Brotli compression, excluding time spent in the sink.
+        double writeMs = 0.0;      // Time spent in OutputSink::write.
+        double firstByteMs = 0.0;  // From the start of the build until the first byte reached the sink.
+        double totalMs = 0.0;      // Whole build, including the header and table directory.
+        size_t rawBytes = 0;       // Table data fed to Brotli, after the transforms.
+        size_t compressedBytes = 0; // Brotli output.
+        size_t woff2Bytes = 0;     // Size of the finished WOFF2 file.
+    };
+
+    /**
+    * @class WOFF2Builder
+    * @brief Builds the WOFF2 representation of a parsed TrueType font.
+    *
+    * Tables are registered with addTable (stored as-is), setGlyfTable (glyf and loca stored
+    * transformed) and setHmtxMetrics (hmtx transformed when that pays off), then build()
+    * transforms, compresses and assembles the file. The builder
+    * only keeps views of the registered data, so it must stay alive until build() returns.
+    */
+    class WOFF2Builder {
+    public:
+        static const size_t kGlyfHeaderSize = 36; // reserved, optionFlags, numGlyphs, indexFormat and seven stream sizes.
+        static const size_t kHeaderSize = 48;     // WOFF2 file header.
+
+        explicit WOFF2Builder(const CompressionOptions& options = CompressionOptions());
+
+        void setCompressionOptions(const CompressionOptions& options) { compression = options; }
+        const CompressionOptions& getCompressionOptions() const { return compression; }
+
+        /**
+         * @brief Forgets all registered tables and starts a new font.
+         * @param flavor The sfnt version of the input font (0x00010000 for TrueType outlines).
+         */
+        void reset(uint32_t flavor = 0x00010000);
+
+        /**
+         * @brief Registers a table to be stored without a transform.
+         * @param data The table bytes; must stay valid until build() returns.
+         * @return false if a table with this tag is already registered.
+         */
+        bool addTable(TTFParser::Tag tag, TTFParser::ByteView data);
+
+        /**
+         * @brief Registers decoded glyphs to be stored as transformed 'glyf' and 'loca' tables.
+         *
+         * Replaces any 'glyf' or 'loca' given to addTable. The 'head' table is copied and
+         * patched at build time: flags bit 11 is set and, if the rebuilt glyphs overflow short
+         * offsets, indexToLocFormat is switched to long offsets.
+         *
+         * @param glyf Decoded glyphs; must stay valid until build() returns.
+         * @param indexToLocFormat Format of the original 'loca' table, from the 'head' table.
+         */
+        void setGlyfTable(const TTFParser::GlyfTable& glyf, int16_t indexToLocFormat);
+
+        /**
+         * @brief Registers horizontal metrics for the 'hmtx' transform.
+         *
+         * Only used together with setGlyfTable, since a decoder rebuilds the left side bearings
+         * from the glyph bounding boxes. If transformHmtx declines, the 'hmtx' table given to
+         * addTable is stored as-is.
+         *
+         * @param metrics Metrics of every glyph (see TTFParser::parseHmtxTable); must stay valid until build() returns.
+         * @param numberOfHMetrics Number of longHorMetric records, from the 'hhea' table.
+         */
+        void setHmtxMetrics(const std::vector<TTFParser::GlyphMetrics>& metrics, uint16_t numberOfHMetrics);
+
+        /**
+         * @brief Encodes horizontal metrics as a transformed 'hmtx' table (WOFF2 spec, section 5.4).
+         *
+         * The lsb array of the proportional glyphs and the leftSideBearing array of the
+         * monospaced glyphs at the end are each dropped when every value in them equals the
+         * glyph's xMin; flags bits 0 and 1 record which arrays were dropped.
+         *
+         * @return false if the result would not be at least an eighth smaller than the original
+         *         table (in particular when neither array can be dropped); the table should then
+         *         be stored as-is.
+         */
+        bool transformHmtx(const TTFParser::GlyfTable& glyf, const std::vector<TTFParser::GlyphMetrics>& metrics,
+            uint16_t numberOfHMetrics, std::vector<uint8_t>& out) const;
+
+        /**
+         * @brief Transforms and compresses the registered tables and writes the WOFF2 file.
+         * @param out Receives the file.
+         * @return false if a transform or the compression failed.
+         */
+        bool build(std::vector<uint8_t>& out);
+
+        /**
+         * @brief Transforms and compresses the registered tables and writes the WOFF2 file to a sink.
+         *
+         * If the sink can patch, the header and table directory are written first and compressed
+         * data follows as Brotli produces it; the header's size fields are patched at the end.
+         * Otherwise only the compressed data is held in memory until its size is known. Either
+         * way the sink's finish() is called before returning.
+         *
+         * @return false if a transform, the compression or the sink failed.
+         */
+        bool build(OutputSink& sink);
+
+        // Timings and byte counts of the last build.
+        const BuildStats& getStats() const { return stats; }
+
+        /**
+         * @brief Compresses several pieces of data as one Brotli stream, in order.
+         *
+         * The pieces are fed to the encoder one after the other, so they never need to be
+         * concatenated first.
+         *
+         * @param parts Data to compress.
+         * @param options Brotli quality, window size and mode.
+         * @param out Receives the compressed stream (replacing its contents).
+         * @return false if the encoder could not be created or failed.
+         */
+        static bool compress(const std::vector<TTFParser::ByteView>& parts, const CompressionOptions& options,
+            std::vector<uint8_t>& out);
+
+        // Same, but hands compressed data to the sink as soon as the encoder produces it
+        // (without calling its finish()).
+        static bool compress(const std::vector<TTFParser::ByteView>& parts, const CompressionOptions& options,
+            OutputSink& sink);
+
+        /**
+         * @brief Encodes decoded glyphs as a transformed 'glyf' table.
+         *
+         * Coordinates are triplet-encoded, bounding boxes are only stored when they differ from
+         * the one computed from the points (always for compound glyphs), and the transformed
+         * 'loca' table is empty because it can be rebuilt from the glyphs.
+         *
+         * A first pass sizes every stream exactly, so `out` is allocated once and each stream is
+         * written in place with no per-glyph allocation.
+         *
+         * @param glyf Decoded glyphs (see TTFParser::parseGlyfTable).
+         * @param indexToLocFormat Format of the original 'loca' table, from the 'head' table.
+         * @param out Receives the transformed table.
+         * @param sizes Optionally receives the size of each stream.
+         * @return false if the glyphs cannot be represented (e.g. too many glyphs or instructions).
+         */
+        bool transformGlyf(const TTFParser::GlyfTable& glyf, int16_t indexToLocFormat,
+            std::vector<uint8_t>& out, GlyfStreamSizes* sizes = nullptr) const;
+
+    private:
+        // A table as it will appear in the WOFF2 table directory.
+        struct TableEntry {
+            uint32_t tag = 0;
+            uint8_t transformVersion = 0;  // 0 is the null transform except for glyf and loca (3); hmtx uses 1 when transformed.
+            bool transformed = false;      // Whether transformLength is stored.
+            uint32_t origLength = 0;
+            TTFParser::ByteView data;      // Bytes written to the compressed stream.
+        };
+
+        // Runs the transforms and lists the tables in file order, with the totalSfntSize they add up to.
+        bool prepareTables(std::vector<TableEntry>& entries, uint64_t& sfntSize);
+
+        // Writes the 48-byte WOFF2 header.
+        void writeHeader(uint8_t* header, size_t numTables, uint64_t sfntSize, uint64_t compressedSize, uint64_t fileSize) const;
+
+        // Exact size of the 'glyf' table a decoder rebuilds from the transform.
+        static uint64_t reconstructedGlyfSize(const TTFParser::GlyfTable& glyf);
+
+        // Exact size of the WOFF2 table directory for the entries.
+        static size_t tableDirectorySize(const std::vector<TableEntry>& entries);
+
+        // Writes the table directory; `out` must have room for tableDirectorySize(entries) bytes.
+        static uint8_t* writeTableDirectory(const std::vector<TableEntry>& entries, uint8_t* out);
+
+        // Computes the exact size of every stream of the transformed 'glyf' table.
+        bool measureGlyf(const TTFParser::GlyfTable& glyf, GlyfStreamSizes& sizes) const;
+
+        // Checks whether a simple glyph's header bbox matches the bbox of its points.
+        static bool hasComputedBBox(const TTFParser::GlyfTable& glyf, const TTFParser::GlyphRecord& glyph);
+
+        // Whether any component of a compound glyph asks for instructions.
+        static bool compoundHasInstructions(const TTFParser::GlyfTable& glyf, const TTFParser::GlyphRecord& glyph);
+
+        CompressionOptions compression;
+        BuildStats stats;
+        uint32_t flavor = 0x00010000;
+        std::vector<TableEntry> tables;              // Registered with addTable, in call order.
+        const TTFParser::GlyfTable* glyfTable = nullptr; // Set by setGlyfTable.
+        int16_t indexToLocFormat = 0;
+        const std::vector<TTFParser::GlyphMetrics>* hmtxMetrics = nullptr; // Set by setHmtxMetrics.
+        uint16_t numberOfHMetrics = 0;
+        std::vector<uint8_t> transformedGlyf;        // Owned data of the last build.
+        std::vector<uint8_t> transformedHmtx;
+        std::vector<uint8_t> patchedHead;
+    };
+
+} // namespace WOFF2Builder
+
+#endif // WOFF2_BUILDER_HPP
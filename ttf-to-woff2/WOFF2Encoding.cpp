@@ -0,0 +1,89 @@
+#include "WOFF2Encoding.hpp"
+#include "TableDirectory.hpp"
+
+namespace WOFF2Builder {
+    namespace {
+        // Tags with a 6-bit index in the table directory flags (WOFF2 spec, section 4.2).
+        const TTFParser::Tag kKnownTags[] = {
+            "cmap", "head", "hhea", "hmtx", "maxp", "name", "OS/2", "post", "cvt ", "fpgm", "glyf",
+            "loca", "prep", "CFF ", "VORG", "EBDT", "EBLC", "gasp", "hdmx", "kern", "LTSH", "PCLT",
+            "VDMX", "vhea", "vmtx", "BASE", "GDEF", "GPOS", "GSUB", "EBSC", "JSTF", "MATH", "CBDT",
+            "CBLC", "COLR", "CPAL", "SVG ", "sbix", "acnt", "avar", "bdat", "bloc", "bsln", "cvar",
+            "fdsc", "feat", "fmtx", "fvar", "gvar", "hsty", "just", "lcar", "mort", "morx", "opbd",
+            "prop", "trak", "Zapf", "Silf", "Glat", "Gloc", "Feat", "Sill"
+        };
+        static_assert(sizeof(kKnownTags) / sizeof(kKnownTags[0]) == kArbitraryTagIndex, "WOFF2 defines 63 known tags");
+    } // namespace
+
+    size_t size255UInt16Array(const uint16_t* values, size_t count) {
+        // Branch-free so the compiler can vectorize it
+        size_t size = count;
+        for (size_t i = 0; i < count; ++i) {
+            size += size_t(values[i] >= 253) + size_t(values[i] >= 762);
+        }
+        return size;
+    }
+
+    uint8_t* write255UInt16Array(uint8_t* out, const uint16_t* values, size_t count) {
+        size_t i = 0;
+        while (i < count) {
+            // Copy runs of single-byte values without going through the general encoder
+            while (i < count && values[i] < 253) {
+                *out++ = static_cast<uint8_t>(values[i++]);
+            }
+            if (i < count) {
+                out = write255UInt16(out, values[i++]);
+            }
+        }
+        return out;
+    }
+
+    size_t sizeContourPointCounts(const uint16_t* endPoints, size_t count) {
+        size_t size = count;
+        uint32_t previousEnd = 0xFFFF; // endPoints[-1] is -1; unsigned wrap-around gives the same differences
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t points = static_cast<uint16_t>(endPoints[i] - previousEnd);
+            size += size_t(points >= 253) + size_t(points >= 762);
+            previousEnd = endPoints[i];
+        }
+        return size;
+    }
+
+    uint8_t* writeContourPointCounts(uint8_t* out, const uint16_t* endPoints, size_t count) {
+        uint32_t previousEnd = 0xFFFF;
+        for (size_t i = 0; i < count; ++i) {
+            out = write255UInt16(out, static_cast<uint16_t>(endPoints[i] - previousEnd));
+            previousEnd = endPoints[i];
+        }
+        return out;
+    }
+
+    uint8_t knownTagIndex(uint32_t tag) {
+        for (uint8_t i = 0; i < kArbitraryTagIndex; ++i) {
+            if (kKnownTags[i].value == tag) {
+                return i;
+            }
+        }
+        return kArbitraryTagIndex;
+    }
+
+    uint32_t knownTag(uint8_t index) {
+        return index < kArbitraryTagIndex ? kKnownTags[index].value : 0;
+    }
+
+    uint8_t* writeTableDirectoryEntry(uint8_t* out, uint32_t tag, uint8_t transformVersion, uint32_t origLength,
+        bool transformed, uint32_t transformLength) {
+        const uint8_t index = knownTagIndex(tag);
+        *out++ = static_cast<uint8_t>(index | (transformVersion << 6));
+        if (index == kArbitraryTagIndex) {
+            out = writeU32(out, tag);
+        }
+
+        out = writeUIntBase128(out, origLength);
+        if (transformed) {
+            out = writeUIntBase128(out, transformLength);
+        }
+        return out;
+    }
+
+} // namespace WOFF2Builder
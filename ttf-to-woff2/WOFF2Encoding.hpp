@@ -0,0 +1,124 @@
+#ifndef WOFF2_ENCODING_HPP
+#define WOFF2_ENCODING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Encoders for the variable-length integers and tag indices of the WOFF2 format
+// (WOFF2 spec, sections 4.1 and 4.2). Every writer has a matching size function, so callers
+// can size their buffer exactly once and then write into it without bounds checks; writers
+// return the position just past what they wrote.
+namespace WOFF2Builder {
+
+    static const uint8_t kArbitraryTagIndex = 63; // Known-tag index meaning "the tag follows".
+
+    inline uint8_t* writeU16(uint8_t* out, uint16_t value) {
+        out[0] = static_cast<uint8_t>(value >> 8);
+        out[1] = static_cast<uint8_t>(value);
+        return out + 2;
+    }
+
+    inline uint8_t* writeU32(uint8_t* out, uint32_t value) {
+        out[0] = static_cast<uint8_t>(value >> 24);
+        out[1] = static_cast<uint8_t>(value >> 16);
+        out[2] = static_cast<uint8_t>(value >> 8);
+        out[3] = static_cast<uint8_t>(value);
+        return out + 4;
+    }
+
+    // Appends a big-endian value, for output whose size is not known up front.
+    inline void appendU16(std::vector<uint8_t>& out, uint16_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    inline void appendU32(std::vector<uint8_t>& out, uint32_t value) {
+        appendU16(out, static_cast<uint16_t>(value >> 16));
+        appendU16(out, static_cast<uint16_t>(value));
+    }
+
+    // Size of a 255UInt16 value: 1 byte below 253, 2 bytes below 762, 3 bytes otherwise.
+    inline size_t size255UInt16(uint32_t value) {
+        return 1 + size_t(value >= 253) + size_t(value >= 762);
+    }
+
+    // Writes a 255UInt16 value (at most 65535).
+    inline uint8_t* write255UInt16(uint8_t* out, uint32_t value) {
+        if (value < 253) { // By far the most common case in glyph data
+            *out = static_cast<uint8_t>(value);
+            return out + 1;
+        }
+        if (value < 762) {
+            // oneMoreByteCode1 (255) covers 253..505, oneMoreByteCode2 (254) covers 506..761
+            const uint32_t second = value >= 506;
+            out[0] = static_cast<uint8_t>(255 - second);
+            out[1] = static_cast<uint8_t>(value - 253 - 253 * second);
+            return out + 2;
+        }
+        out[0] = 253; // wordCode
+        out[1] = static_cast<uint8_t>(value >> 8);
+        out[2] = static_cast<uint8_t>(value);
+        return out + 3;
+    }
+
+    // Size of a UIntBase128 value: 7 bits per byte, without leading zero bytes.
+    inline size_t sizeUIntBase128(uint32_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            ++size;
+        }
+        return size;
+    }
+
+    inline uint8_t* writeUIntBase128(uint8_t* out, uint32_t value) {
+        const size_t size = sizeUIntBase128(value);
+        for (size_t i = size - 1; i > 0; --i) {
+            out[size - 1 - i] = static_cast<uint8_t>(((value >> (7 * i)) & 0x7F) | 0x80);
+        }
+        out[size - 1] = static_cast<uint8_t>(value & 0x7F);
+        return out + size;
+    }
+
+    // Total size of an array of 255UInt16 values.
+    size_t size255UInt16Array(const uint16_t* values, size_t count);
+
+    // Writes an array of 255UInt16 values.
+    uint8_t* write255UInt16Array(uint8_t* out, const uint16_t* values, size_t count);
+
+    /**
+     * @brief Size of the point count of every contour of a simple glyph, as 255UInt16 values.
+     * @param endPoints The glyph's endPtsOfContours; contour i has endPoints[i] - endPoints[i - 1] points.
+     */
+    size_t sizeContourPointCounts(const uint16_t* endPoints, size_t count);
+
+    // Writes the point count of every contour of a simple glyph (see sizeContourPointCounts).
+    uint8_t* writeContourPointCounts(uint8_t* out, const uint16_t* endPoints, size_t count);
+
+    /**
+     * @brief Returns the index of a tag in the WOFF2 known-tag table.
+     * @return 0-62, or kArbitraryTagIndex if the tag has to be stored in full.
+     */
+    uint8_t knownTagIndex(uint32_t tag);
+
+    // Returns the tag with the given known-tag index (0-62), or 0 for any other index.
+    uint32_t knownTag(uint8_t index);
+
+    // Size of a WOFF2 table directory entry.
+    inline size_t tableDirectoryEntrySize(uint32_t tag, uint32_t origLength, bool transformed, uint32_t transformLength) {
+        return 1 + (knownTagIndex(tag) == kArbitraryTagIndex ? 4 : 0) + sizeUIntBase128(origLength) +
+            (transformed ? sizeUIntBase128(transformLength) : 0);
+    }
+
+    /**
+     * @brief Writes a WOFF2 table directory entry.
+     * @param transformVersion Transform version stored in bits 6-7 of the flags byte.
+     * @param transformed Whether transformLength is stored (the table is not null-transformed).
+     */
+    uint8_t* writeTableDirectoryEntry(uint8_t* out, uint32_t tag, uint8_t transformVersion, uint32_t origLength,
+        bool transformed, uint32_t transformLength);
+
+} // namespace WOFF2Builder
+
+#endif // WOFF2_ENCODING_HPP
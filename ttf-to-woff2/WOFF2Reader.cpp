@@ -0,0 +1,879 @@
+#include "WOFF2Reader.hpp"
+#include "BigEndian.hpp"
+#include "Timing.hpp"
+#include "WOFF2Encoding.hpp"
+#include <algorithm>
+#include <brotli/decode.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace TTFParser {
+    using WOFF2Builder::appendU16;
+    using WOFF2Builder::appendU32;
+
+    namespace {
+        const uint32_t kSignature = 0x774F4632;        // 'wOF2'
+        const uint32_t kCollectionFlavor = 0x74746366; // 'ttcf'
+        const size_t kHeaderSize = 48;
+        const size_t kGlyfHeaderSize = 36;
+        const uint32_t kGlyfTag = Tag("glyf").value;
+        const uint32_t kLocaTag = Tag("loca").value;
+        const uint32_t kHmtxTag = Tag("hmtx").value;
+        const uint32_t kHheaTag = Tag("hhea").value;
+        const uint32_t kHeadTag = Tag("head").value;
+        const uint32_t kDsigTag = Tag("DSIG").value;
+
+        // Sequential, bounds-checked reader over one stream of a transformed table.
+        class StreamReader {
+        public:
+            StreamReader() = default;
+            explicit StreamReader(ByteView data) : data(data) {}
+
+            size_t position() const { return offset; }
+            const uint8_t* at(size_t position) const { return data.data() + position; }
+
+            bool readU8(uint8_t& value) {
+                if (offset >= data.size()) {
+                    return false;
+                }
+                value = data[offset++];
+                return true;
+            }
+
+            bool readU16(uint16_t& value) {
+                if (!data.contains(offset, 2)) {
+                    return false;
+                }
+                value = ::TTFParser::readU16(data.data() + offset);
+                offset += 2;
+                return true;
+            }
+
+            // Reads a 255UInt16 value (WOFF2 spec, section 4.1).
+            bool read255UInt16(uint16_t& value) {
+                uint8_t code = 0;
+                if (!readU8(code)) {
+                    return false;
+                }
+                if (code == 253) { // wordCode
+                    return readU16(value);
+                }
+                if (code == 254 || code == 255) { // oneMoreByteCode2, oneMoreByteCode1
+                    uint8_t next = 0;
+                    if (!readU8(next)) {
+                        return false;
+                    }
+                    value = static_cast<uint16_t>(next + (code == 255 ? 253 : 506));
+                    return true;
+                }
+                value = code;
+                return true;
+            }
+
+            bool readBytes(size_t count, const uint8_t*& bytes) {
+                if (!data.contains(offset, count)) {
+                    return false;
+                }
+                bytes = data.data() + offset;
+                offset += count;
+                return true;
+            }
+
+            bool skip(size_t count) {
+                const uint8_t* ignored = nullptr;
+                return readBytes(count, ignored);
+            }
+
+        private:
+            ByteView data;
+            size_t offset = 0;
+        };
+
+        // Reads a UIntBase128 value (WOFF2 spec, section 4.1).
+        bool readUIntBase128(ByteView data, size_t& offset, uint32_t& value) {
+            uint32_t result = 0;
+            for (int i = 0; i < 5; ++i) {
+                if (offset >= data.size()) {
+                    return false;
+                }
+                const uint8_t byte = data[offset++];
+                if ((i == 0 && byte == 0x80) || (result & 0xFE000000)) {
+                    return false; // Leading zero group or overflow
+                }
+                result = (result << 7) | (byte & 0x7F);
+                if (!(byte & 0x80)) {
+                    value = result;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline int withSign(int flag, int baseValue) {
+            return (flag & 1) ? baseValue : -baseValue;
+        }
+
+        // Decodes the point delta of one triplet (WOFF2 spec, section 5.2).
+        bool readTriplet(uint8_t flag, StreamReader& glyphStream, int& dx, int& dy) {
+            flag &= 0x7F;
+            const size_t dataBytes = flag < 84 ? 1 : (flag < 120 ? 2 : (flag < 124 ? 3 : 4));
+            const uint8_t* b = nullptr;
+            if (!glyphStream.readBytes(dataBytes, b)) {
+                return false;
+            }
+
+            if (flag < 10) {
+                dx = 0;
+                dy = withSign(flag, ((flag & 14) << 7) + b[0]);
+            }
+            else if (flag < 20) {
+                dx = withSign(flag, (((flag - 10) & 14) << 7) + b[0]);
+                dy = 0;
+            }
+            else if (flag < 84) {
+                const int b0 = flag - 20;
+                dx = withSign(flag, 1 + (b0 & 0x30) + (b[0] >> 4));
+                dy = withSign(flag >> 1, 1 + ((b0 & 0x0C) << 2) + (b[0] & 0x0F));
+            }
+            else if (flag < 120) {
+                const int b0 = flag - 84;
+                dx = withSign(flag, 1 + ((b0 / 12) << 8) + b[0]);
+                dy = withSign(flag >> 1, 1 + (((b0 % 12) >> 2) << 8) + b[1]);
+            }
+            else if (flag < 124) {
+                dx = withSign(flag, (b[0] << 4) + (b[1] >> 4));
+                dy = withSign(flag >> 1, ((b[1] & 0x0F) << 8) + b[2]);
+            }
+            else {
+                dx = withSign(flag, (b[0] << 8) + b[1]);
+                dy = withSign(flag >> 1, (b[2] << 8) + b[3]);
+            }
+            return true;
+        }
+
+        // Appends the flags and coordinates of a simple glyph in the compact 'glyf' form: short
+        // vectors where they fit and runs of equal flags merged with REPEAT_FLAG.
+        void appendSimpleGlyphPoints(std::vector<uint8_t>& out, const std::vector<int>& dxs, const std::vector<int>& dys,
+            const std::vector<uint8_t>& onCurve, bool overlap, std::vector<uint8_t>& flags) {
+            const size_t numPoints = dxs.size();
+            flags.resize(numPoints);
+            for (size_t i = 0; i < numPoints; ++i) {
+                uint8_t flag = onCurve[i] ? TTFParser::ON_CURVE_POINT : 0;
+                if (i == 0 && overlap) {
+                    flag |= TTFParser::OVERLAP_SIMPLE;
+                }
+
+                const int dx = dxs[i];
+                if (dx == 0) {
+                    flag |= TTFParser::X_IS_SAME_OR_POSITIVE_X_SHORT_VECTOR;
+                }
+                else if (dx >= -255 && dx <= 255) {
+                    flag |= TTFParser::X_SHORT_VECTOR | (dx > 0 ? TTFParser::X_IS_SAME_OR_POSITIVE_X_SHORT_VECTOR : 0);
+                }
+
+                const int dy = dys[i];
+                if (dy == 0) {
+                    flag |= TTFParser::Y_IS_SAME_OR_POSITIVE_Y_SHORT_VECTOR;
+                }
+                else if (dy >= -255 && dy <= 255) {
+                    flag |= TTFParser::Y_SHORT_VECTOR | (dy > 0 ? TTFParser::Y_IS_SAME_OR_POSITIVE_Y_SHORT_VECTOR : 0);
+                }
+                flags[i] = flag;
+            }
+
+            for (size_t i = 0; i < numPoints;) {
+                size_t run = 1;
+                while (i + run < numPoints && run < 256 && flags[i + run] == flags[i]) {
+                    ++run;
+                }
+                if (run > 1) {
+                    out.push_back(flags[i] | TTFParser::REPEAT_FLAG);
+                    out.push_back(static_cast<uint8_t>(run - 1));
+                }
+                else {
+                    out.push_back(flags[i]);
+                }
+                i += run;
+            }
+
+            for (size_t i = 0; i < numPoints; ++i) {
+                if (flags[i] & TTFParser::X_SHORT_VECTOR) {
+                    out.push_back(static_cast<uint8_t>(std::abs(dxs[i])));
+                }
+                else if (dxs[i] != 0) {
+                    appendU16(out, static_cast<uint16_t>(dxs[i]));
+                }
+            }
+            for (size_t i = 0; i < numPoints; ++i) {
+                if (flags[i] & TTFParser::Y_SHORT_VECTOR) {
+                    out.push_back(static_cast<uint8_t>(std::abs(dys[i])));
+                }
+                else if (dys[i] != 0) {
+                    appendU16(out, static_cast<uint16_t>(dys[i]));
+                }
+            }
+        }
+
+        // Size of the component record starting with `flags`, not counting flags and glyphIndex.
+        inline size_t componentArgumentsSize(uint16_t flags) {
+            size_t size = (flags & TTFParser::ARG_1_AND_2_ARE_WORDS) ? 4 : 2;
+            if (flags & TTFParser::WE_HAVE_A_SCALE) {
+                size += 2;
+            }
+            else if (flags & TTFParser::WE_HAVE_AN_X_AND_Y_SCALE) {
+                size += 4;
+            }
+            else if (flags & TTFParser::WE_HAVE_A_TWO_BY_TWO) {
+                size += 8;
+            }
+            return size;
+        }
+
+        // Serializes decoded glyphs in a fixed layout, so that two encodings of the same
+        // outlines produce the same bytes.
+        void appendCanonicalGlyphs(const GlyfTable& glyf, std::vector<uint8_t>& out) {
+            for (const GlyphRecord& record : glyf.glyphs) {
+                appendU16(out, static_cast<uint16_t>(record.numberOfContours));
+                appendU16(out, static_cast<uint16_t>(record.xMin));
+                appendU16(out, static_cast<uint16_t>(record.yMin));
+                appendU16(out, static_cast<uint16_t>(record.xMax));
+                appendU16(out, static_cast<uint16_t>(record.yMax));
+                out.push_back(record.overlapSimple ? 1 : 0);
+
+                if (record.numberOfContours > 0) {
+                    for (int16_t c = 0; c < record.numberOfContours; ++c) {
+                        appendU16(out, glyf.endPointOfContours[record.firstContour + c]);
+                    }
+                    for (uint32_t i = 0; i < record.numPoints; ++i) {
+                        const size_t point = record.firstPoint + i;
+                        appendU16(out, static_cast<uint16_t>(glyf.xCoordinates[point]));
+                        appendU16(out, static_cast<uint16_t>(glyf.yCoordinates[point]));
+                        out.push_back(glyf.isOnCurve(point) ? 1 : 0);
+                    }
+                }
+                else if (record.numberOfContours < 0) {
+                    for (uint32_t c = 0; c < record.numComponents; ++c) {
+                        const CompoundComponent& component = glyf.components[record.firstComponent + c];
+                        appendU16(out, component.flags);
+                        appendU16(out, component.glyphIndex);
+                        appendU32(out, static_cast<uint32_t>(component.arg1));
+                        appendU32(out, static_cast<uint32_t>(component.arg2));
+                        appendU16(out, static_cast<uint16_t>(component.xScale));
+                        appendU16(out, static_cast<uint16_t>(component.scale01));
+                        appendU16(out, static_cast<uint16_t>(component.scale10));
+                        appendU16(out, static_cast<uint16_t>(component.yScale));
+                    }
+                }
+
+                appendU16(out, record.instructionLength);
+                out.insert(out.end(), glyf.instructions.begin() + record.firstInstruction,
+                    glyf.instructions.begin() + record.firstInstruction + record.instructionLength);
+            }
+        }
+
+        // Decodes the glyphs of a font and returns the checksum of their canonical form.
+        bool canonicalGlyfChecksum(TTFParser& parser, uint32_t& checksum, size_t& numGlyphs) {
+            LocaTable loca;
+            GlyfTable glyf;
+            if (!parser.parseHeadTable(parser.getTableData("head")) ||
+                !parser.parseMaxpTable(parser.getTableData("maxp")) ||
+                !parser.parseLocaTable(parser.getTableData("loca"), loca) ||
+                !parser.parseGlyfTable(parser.getTableData("glyf"), loca, glyf)) {
+                return false;
+            }
+
+            std::vector<uint8_t> canonical;
+            appendCanonicalGlyphs(glyf, canonical);
+            checksum = calculateTableChecksum(ByteView(canonical.data(), canonical.size()));
+            numGlyphs = glyf.glyphs.size();
+            return true;
+        }
+
+        // Checksum of 'head' without the fields a WOFF2 round trip may change.
+        uint32_t canonicalHeadChecksum(ByteView head) {
+            std::vector<uint8_t> copy(head.begin(), head.end());
+            if (copy.size() >= 54) {
+                std::memset(&copy[8], 0, 4); // checkSumAdjustment
+                copy[16] &= ~0x08;           // flags bit 11
+                copy[50] = copy[51] = 0;     // indexToLocFormat
+            }
+            return calculateTableChecksum(ByteView(copy.data(), copy.size()));
+        }
+    } // namespace
+
+    bool WOFF2Reader::readHeader(ByteView woff2, size_t& offset) {
+        if (woff2.size() < kHeaderSize) {
+            std::cerr << "Error: WOFF2 file is shorter than its header." << std::endl;
+            return false;
+        }
+
+        const uint8_t* data = woff2.data();
+        if (readU32(data) != kSignature) {
+            std::cerr << "Error: Not a WOFF2 file." << std::endl;
+            return false;
+        }
+
+        header = WOFF2Header();
+        header.flavor = readU32(data + 4);
+        header.length = readU32(data + 8);
+        header.numTables = readU16(data + 12);
+        header.totalSfntSize = readU32(data + 16);
+        header.totalCompressedSize = readU32(data + 20);
+        header.majorVersion = readU16(data + 24);
+        header.minorVersion = readU16(data + 26);
+
+        if (header.flavor == kCollectionFlavor) {
+            std::cerr << "Error: WOFF2 font collections are not supported." << std::endl;
+            return false;
+        }
+        if (header.length != woff2.size()) {
+            std::cerr << "Error: WOFF2 length field does not match the file size." << std::endl;
+            return false;
+        }
+        if (header.numTables == 0) {
+            std::cerr << "Error: WOFF2 file has no tables." << std::endl;
+            return false;
+        }
+
+        offset = kHeaderSize;
+        return true;
+    }
+
+    bool WOFF2Reader::readTableDirectory(ByteView woff2, size_t& offset) {
+        tables.assign(header.numTables, WOFF2TableEntry());
+
+        uint64_t streamOffset = 0;
+        for (WOFF2TableEntry& entry : tables) {
+            if (offset >= woff2.size()) {
+                std::cerr << "Error: WOFF2 table directory is truncated." << std::endl;
+                return false;
+            }
+
+            const uint8_t flags = woff2[offset++];
+            const uint8_t tagIndex = flags & 0x3F;
+            entry.transformVersion = flags >> 6;
+            if (tagIndex == WOFF2Builder::kArbitraryTagIndex) {
+                if (!woff2.contains(offset, 4)) {
+                    std::cerr << "Error: WOFF2 table directory is truncated." << std::endl;
+                    return false;
+                }
+                entry.tag = readU32(woff2.data() + offset);
+                offset += 4;
+            }
+            else {
+                entry.tag = WOFF2Builder::knownTag(tagIndex);
+            }
+
+            if (!readUIntBase128(woff2, offset, entry.origLength)) {
+                std::cerr << "Error: Bad origLength in WOFF2 table directory." << std::endl;
+                return false;
+            }
+
+            // Version 0 is the glyf/loca transform, and the null transform of every other table
+            const bool glyfOrLoca = entry.tag == kGlyfTag || entry.tag == kLocaTag;
+            entry.transformed = glyfOrLoca ? entry.transformVersion != 3 : entry.transformVersion != 0;
+            entry.streamLength = entry.origLength;
+            if (entry.transformed && !readUIntBase128(woff2, offset, entry.streamLength)) {
+                std::cerr << "Error: Bad transformLength in WOFF2 table directory." << std::endl;
+                return false;
+            }
+
+            if (entry.transformed && !glyfOrLoca && !(entry.tag == kHmtxTag && entry.transformVersion == 1)) {
+                std::cerr << "Error: Unknown transform of table '" << Tag(entry.tag).toString() << "'." << std::endl;
+                return false;
+            }
+
+            entry.streamOffset = static_cast<uint32_t>(streamOffset);
+            streamOffset += entry.streamLength;
+            if (streamOffset > UINT32_MAX) {
+                std::cerr << "Error: WOFF2 table data exceeds 4 GB." << std::endl;
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < tables.size(); ++i) {
+            for (size_t j = i + 1; j < tables.size(); ++j) {
+                if (tables[i].tag == tables[j].tag) {
+                    std::cerr << "Error: WOFF2 file has two '" << Tag(tables[i].tag).toString() << "' tables." << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool WOFF2Reader::reconstructGlyf(ByteView transformed, std::vector<uint8_t>& glyf, std::vector<uint8_t>& loca,
+        int16_t& indexFormat) {
+        if (transformed.size() < kGlyfHeaderSize) {
+            std::cerr << "Error: Transformed 'glyf' table is truncated." << std::endl;
+            return false;
+        }
+
+        const uint8_t* data = transformed.data();
+        const uint16_t optionFlags = readU16(data + 2);
+        const uint16_t numGlyphs = readU16(data + 4);
+        indexFormat = static_cast<int16_t>(readU16(data + 6));
+        if (indexFormat != 0 && indexFormat != 1) {
+            std::cerr << "Error: Bad indexFormat in transformed 'glyf' table." << std::endl;
+            return false;
+        }
+
+        // Split the table into its streams
+        ByteView streams[7];
+        uint64_t streamOffset = kGlyfHeaderSize;
+        for (int i = 0; i < 7; ++i) {
+            const uint32_t size = readU32(data + 8 + 4 * i);
+            if (!transformed.contains(static_cast<size_t>(streamOffset), size)) {
+                std::cerr << "Error: Transformed 'glyf' stream exceeds the table." << std::endl;
+                return false;
+            }
+            streams[i] = transformed.subview(static_cast<size_t>(streamOffset), size);
+            streamOffset += size;
+        }
+
+        const size_t bitmapSize = ((size_t(numGlyphs) + 31) >> 5) << 2;
+        ByteView overlapBitmap;
+        if (optionFlags & 1) {
+            overlapBitmap = transformed.subview(static_cast<size_t>(streamOffset), bitmapSize);
+            if (overlapBitmap.size() != bitmapSize) {
+                std::cerr << "Error: Transformed 'glyf' overlapSimpleBitmap is truncated." << std::endl;
+                return false;
+            }
+        }
+        if (streams[5].size() < bitmapSize) {
+            std::cerr << "Error: Transformed 'glyf' bbox bitmap is truncated." << std::endl;
+            return false;
+        }
+        const ByteView bboxBitmap = streams[5].subview(0, bitmapSize);
+
+        StreamReader nContourStream(streams[0]);
+        StreamReader nPointsStream(streams[1]);
+        StreamReader flagStream(streams[2]);
+        StreamReader glyphStream(streams[3]);
+        StreamReader compositeStream(streams[4]);
+        StreamReader bboxStream(streams[5].subview(bitmapSize));
+        StreamReader instructionStream(streams[6]);
+
+        glyf.clear();
+        loca.clear();
+        xMins.assign(numGlyphs, 0);
+        std::vector<uint32_t> offsets(size_t(numGlyphs) + 1, 0);
+
+        std::vector<uint16_t> endPoints;
+        std::vector<int> dxs, dys;
+        std::vector<uint8_t> onCurve, flags;
+
+        for (uint32_t g = 0; g < numGlyphs; ++g) {
+            offsets[g] = static_cast<uint32_t>(glyf.size());
+
+            uint16_t nContoursValue = 0;
+            if (!nContourStream.readU16(nContoursValue)) {
+                std::cerr << "Error: Transformed 'glyf' nContour stream is truncated." << std::endl;
+                return false;
+            }
+            const int16_t numberOfContours = static_cast<int16_t>(nContoursValue);
+            const bool hasBBox = (bboxBitmap[g >> 3] & (0x80 >> (g & 7))) != 0;
+
+            int16_t bbox[4] = { 0, 0, 0, 0 };
+            if (hasBBox) {
+                for (int16_t& value : bbox) {
+                    uint16_t raw = 0;
+                    if (!bboxStream.readU16(raw)) {
+                        std::cerr << "Error: Transformed 'glyf' bbox stream is truncated." << std::endl;
+                        return false;
+                    }
+                    value = static_cast<int16_t>(raw);
+                }
+            }
+
+            if (numberOfContours == 0) {
+                if (hasBBox) {
+                    std::cerr << "Error: Empty glyph " << g << " has a bounding box." << std::endl;
+                    return false;
+                }
+                continue;
+            }
+
+            const size_t glyphStart = glyf.size();
+            appendU16(glyf, nContoursValue);
+            glyf.resize(glyf.size() + 8); // bbox, written once known
+
+            if (numberOfContours > 0) {
+                // Contour end points from the per-contour point counts
+                endPoints.resize(numberOfContours);
+                uint32_t numPoints = 0;
+                for (int16_t c = 0; c < numberOfContours; ++c) {
+                    uint16_t count = 0;
+                    if (!nPointsStream.read255UInt16(count)) {
+                        std::cerr << "Error: Transformed 'glyf' nPoints stream is truncated." << std::endl;
+                        return false;
+                    }
+                    numPoints += count;
+                    if (numPoints == 0 || numPoints > 0x10000) {
+                        std::cerr << "Error: Bad point count in glyph " << g << "." << std::endl;
+                        return false;
+                    }
+                    endPoints[c] = static_cast<uint16_t>(numPoints - 1);
+                }
+
+                const uint8_t* pointFlags = nullptr;
+                if (!flagStream.readBytes(numPoints, pointFlags)) {
+                    std::cerr << "Error: Transformed 'glyf' flag stream is truncated." << std::endl;
+                    return false;
+                }
+
+                dxs.resize(numPoints);
+                dys.resize(numPoints);
+                onCurve.resize(numPoints);
+                int x = 0, y = 0;
+                int16_t xMin = 0, yMin = 0, xMax = 0, yMax = 0;
+                for (uint32_t i = 0; i < numPoints; ++i) {
+                    if (!readTriplet(pointFlags[i], glyphStream, dxs[i], dys[i])) {
+                        std::cerr << "Error: Transformed 'glyf' glyph stream is truncated." << std::endl;
+                        return false;
+                    }
+                    onCurve[i] = (pointFlags[i] & 0x80) ? 0 : 1;
+
+                    x += dxs[i];
+                    y += dys[i];
+                    const int16_t px = static_cast<int16_t>(x);
+                    const int16_t py = static_cast<int16_t>(y);
+                    xMin = (i == 0 || px < xMin) ? px : xMin;
+                    xMax = (i == 0 || px > xMax) ? px : xMax;
+                    yMin = (i == 0 || py < yMin) ? py : yMin;
+                    yMax = (i == 0 || py > yMax) ? py : yMax;
+                }
+                if (!hasBBox) {
+                    bbox[0] = xMin;
+                    bbox[1] = yMin;
+                    bbox[2] = xMax;
+                    bbox[3] = yMax;
+                }
+
+                uint16_t instructionLength = 0;
+                const uint8_t* instructions = nullptr;
+                if (!glyphStream.read255UInt16(instructionLength) || !instructionStream.readBytes(instructionLength, instructions)) {
+                    std::cerr << "Error: Instructions of glyph " << g << " are truncated." << std::endl;
+                    return false;
+                }
+
+                for (uint16_t endPoint : endPoints) {
+                    appendU16(glyf, endPoint);
+                }
+                appendU16(glyf, instructionLength);
+                glyf.insert(glyf.end(), instructions, instructions + instructionLength);
+
+                const bool overlap = !overlapBitmap.empty() && (overlapBitmap[g >> 3] & (0x80 >> (g & 7)));
+                appendSimpleGlyphPoints(glyf, dxs, dys, onCurve, overlap, flags);
+            }
+            else {
+                if (!hasBBox) {
+                    std::cerr << "Error: Compound glyph " << g << " has no bounding box." << std::endl;
+                    return false;
+                }
+
+                // Component records are stored exactly as in 'glyf'
+                const size_t componentsStart = compositeStream.position();
+                bool haveInstructions = false;
+                uint16_t componentFlags = 0;
+                do {
+                    uint16_t glyphIndex = 0;
+                    if (!compositeStream.readU16(componentFlags) || !compositeStream.readU16(glyphIndex) ||
+                        !compositeStream.skip(componentArgumentsSize(componentFlags))) {
+                        std::cerr << "Error: Transformed 'glyf' composite stream is truncated." << std::endl;
+                        return false;
+                    }
+                    haveInstructions |= (componentFlags & TTFParser::WE_HAVE_INSTRUCTIONS) != 0;
+                } while (componentFlags & TTFParser::MORE_COMPONENTS);
+
+                const uint8_t* components = compositeStream.at(componentsStart);
+                glyf.insert(glyf.end(), components, components + (compositeStream.position() - componentsStart));
+
+                if (haveInstructions) {
+                    uint16_t instructionLength = 0;
+                    const uint8_t* instructions = nullptr;
+                    if (!glyphStream.read255UInt16(instructionLength) || !instructionStream.readBytes(instructionLength, instructions)) {
+                        std::cerr << "Error: Instructions of glyph " << g << " are truncated." << std::endl;
+                        return false;
+                    }
+                    appendU16(glyf, instructionLength);
+                    glyf.insert(glyf.end(), instructions, instructions + instructionLength);
+                }
+            }
+
+            for (int i = 0; i < 4; ++i) {
+                glyf[glyphStart + 2 + 2 * i] = static_cast<uint8_t>(uint16_t(bbox[i]) >> 8);
+                glyf[glyphStart + 3 + 2 * i] = static_cast<uint8_t>(bbox[i]);
+            }
+            xMins[g] = bbox[0];
+
+            glyf.resize((glyf.size() + 3) & ~size_t(3), 0); // Keep every glyph 4-byte aligned
+            if (glyf.size() > UINT32_MAX) {
+                std::cerr << "Error: Rebuilt 'glyf' table exceeds 4 GB." << std::endl;
+                return false;
+            }
+        }
+        offsets[numGlyphs] = static_cast<uint32_t>(glyf.size());
+
+        if (indexFormat == 0 && glyf.size() > 0x1FFFE) {
+            std::cerr << "Error: Rebuilt 'glyf' table is too large for short 'loca' offsets." << std::endl;
+            return false;
+        }
+
+        loca.reserve(offsets.size() * (indexFormat ? 4 : 2));
+        for (uint32_t offset : offsets) {
+            if (indexFormat) {
+                appendU32(loca, offset);
+            }
+            else {
+                appendU16(loca, static_cast<uint16_t>(offset >> 1));
+            }
+        }
+        return true;
+    }
+
+    bool WOFF2Reader::reconstructHmtx(ByteView transformed, uint16_t numberOfHMetrics, std::vector<uint8_t>& hmtx) const {
+        const size_t numGlyphs = xMins.size();
+        if (transformed.empty() || numberOfHMetrics == 0 || numberOfHMetrics > numGlyphs) {
+            std::cerr << "Error: Transformed 'hmtx' table does not fit the font." << std::endl;
+            return false;
+        }
+
+        const uint8_t flags = transformed[0];
+        const bool hasLsb = !(flags & 1);
+        const bool hasLeftSideBearing = !(flags & 2);
+        if ((flags & 0xFC) || (hasLsb && hasLeftSideBearing)) {
+            std::cerr << "Error: Bad flags in transformed 'hmtx' table." << std::endl;
+            return false;
+        }
+
+        const size_t numLeftSideBearings = numGlyphs - numberOfHMetrics;
+        const size_t expectedSize = 1 + 2 * size_t(numberOfHMetrics) + (hasLsb ? 2 * size_t(numberOfHMetrics) : 0) +
+            (hasLeftSideBearing ? 2 * numLeftSideBearings : 0);
+        if (transformed.size() != expectedSize) {
+            std::cerr << "Error: Transformed 'hmtx' table has the wrong size." << std::endl;
+            return false;
+        }
+
+        const uint8_t* advances = transformed.data() + 1;
+        const uint8_t* lsbs = advances + 2 * size_t(numberOfHMetrics);
+        const uint8_t* leftSideBearings = lsbs + (hasLsb ? 2 * size_t(numberOfHMetrics) : 0);
+
+        hmtx.clear();
+        hmtx.reserve(4 * size_t(numberOfHMetrics) + 2 * numLeftSideBearings);
+        for (size_t g = 0; g < numberOfHMetrics; ++g) {
+            appendU16(hmtx, readU16(advances + 2 * g));
+            appendU16(hmtx, hasLsb ? readU16(lsbs + 2 * g) : static_cast<uint16_t>(xMins[g]));
+        }
+        for (size_t i = 0; i < numLeftSideBearings; ++i) {
+            appendU16(hmtx, hasLeftSideBearing ? readU16(leftSideBearings + 2 * i) : static_cast<uint16_t>(xMins[numberOfHMetrics + i]));
+        }
+        return true;
+    }
+
+    bool WOFF2Reader::decode(ByteView woff2, std::vector<uint8_t>& sfnt) {
+        const Clock::time_point start = Clock::now();
+        stats = DecodeStats();
+        xMins.clear();
+
+        size_t offset = 0;
+        if (!readHeader(woff2, offset) || !readTableDirectory(woff2, offset)) {
+            return false;
+        }
+
+        if (!woff2.contains(offset, header.totalCompressedSize)) {
+            std::cerr << "Error: WOFF2 compressed data exceeds the file." << std::endl;
+            return false;
+        }
+
+        // Decompress the table data, which must come out at exactly the size the directory implies
+        const Clock::time_point decompressStart = Clock::now();
+        const size_t streamSize = size_t(tables.back().streamOffset) + tables.back().streamLength;
+        std::vector<uint8_t> stream(streamSize);
+        size_t decodedSize = streamSize;
+        if (BrotliDecoderDecompress(header.totalCompressedSize, woff2.data() + offset, &decodedSize, stream.data()) != BROTLI_DECODER_RESULT_SUCCESS ||
+            decodedSize != streamSize) {
+            std::cerr << "Error: WOFF2 Brotli stream is corrupt or has the wrong size." << std::endl;
+            return false;
+        }
+        stats.decompressMs = elapsedMs(decompressStart);
+        stats.compressedBytes = header.totalCompressedSize;
+        stats.decompressedBytes = streamSize;
+
+        const Clock::time_point reconstructStart = Clock::now();
+        const ByteView streamView(stream.data(), stream.size());
+        auto findTable = [this](uint32_t tag) -> const WOFF2TableEntry* {
+            for (const WOFF2TableEntry& entry : tables) {
+                if (entry.tag == tag) {
+                    return &entry;
+                }
+            }
+            return nullptr;
+        };
+
+        // Rebuild the transformed tables
+        const WOFF2TableEntry* glyfEntry = findTable(kGlyfTag);
+        const WOFF2TableEntry* locaEntry = findTable(kLocaTag);
+        const WOFF2TableEntry* hmtxEntry = findTable(kHmtxTag);
+        std::vector<uint8_t> glyf, loca, hmtx;
+
+        if ((glyfEntry && glyfEntry->transformed) || (locaEntry && locaEntry->transformed)) {
+            if (!glyfEntry || !locaEntry || !glyfEntry->transformed || !locaEntry->transformed || locaEntry->streamLength != 0) {
+                std::cerr << "Error: WOFF2 'glyf' and 'loca' must be transformed together." << std::endl;
+                return false;
+            }
+
+            int16_t indexFormat = 0;
+            if (!reconstructGlyf(streamView.subview(glyfEntry->streamOffset, glyfEntry->streamLength), glyf, loca, indexFormat)) {
+                return false;
+            }
+            if (loca.size() != locaEntry->origLength) {
+                std::cerr << "Error: Rebuilt 'loca' table does not match its original length." << std::endl;
+                return false;
+            }
+        }
+
+        if (hmtxEntry && hmtxEntry->transformed) {
+            const WOFF2TableEntry* hheaEntry = findTable(kHheaTag);
+            if (!glyfEntry || !glyfEntry->transformed || !hheaEntry || hheaEntry->transformed || hheaEntry->streamLength < 36) {
+                std::cerr << "Error: Transformed 'hmtx' needs a transformed 'glyf' and an 'hhea' table." << std::endl;
+                return false;
+            }
+
+            const uint16_t numberOfHMetrics = readU16(stream.data() + hheaEntry->streamOffset + 34);
+            if (!reconstructHmtx(streamView.subview(hmtxEntry->streamOffset, hmtxEntry->streamLength), numberOfHMetrics, hmtx)) {
+                return false;
+            }
+        }
+
+        // Lay out the sfnt: offset table, table records sorted by tag, then the 4-byte aligned tables
+        std::vector<std::pair<uint32_t, ByteView>> decoded;
+        decoded.reserve(tables.size());
+        for (const WOFF2TableEntry& entry : tables) {
+            ByteView data = streamView.subview(entry.streamOffset, entry.streamLength);
+            if (entry.tag == kGlyfTag && entry.transformed) {
+                data = ByteView(glyf.data(), glyf.size());
+            }
+            else if (entry.tag == kLocaTag && entry.transformed) {
+                data = ByteView(loca.data(), loca.size());
+            }
+            else if (entry.tag == kHmtxTag && entry.transformed) {
+                data = ByteView(hmtx.data(), hmtx.size());
+            }
+            decoded.emplace_back(entry.tag, data);
+        }
+        std::sort(decoded.begin(), decoded.end(),
+            [](const std::pair<uint32_t, ByteView>& a, const std::pair<uint32_t, ByteView>& b) { return a.first < b.first; });
+
+        const size_t numTables = decoded.size();
+        uint64_t sfntSize = 12 + 16 * uint64_t(numTables);
+        for (const auto& table : decoded) {
+            sfntSize += (uint64_t(table.second.size()) + 3) & ~uint64_t(3);
+        }
+        if (sfntSize > UINT32_MAX) {
+            std::cerr << "Error: Decoded font would exceed 4 GB." << std::endl;
+            return false;
+        }
+
+        uint16_t entrySelector = 0;
+        while ((2u << entrySelector) <= numTables) {
+            ++entrySelector;
+        }
+        const uint16_t searchRange = static_cast<uint16_t>(16u << entrySelector);
+
+        sfnt.assign(static_cast<size_t>(sfntSize), 0);
+        uint8_t* out = sfnt.data();
+        WOFF2Builder::writeU32(out, header.flavor);
+        WOFF2Builder::writeU16(out + 4, static_cast<uint16_t>(numTables));
+        WOFF2Builder::writeU16(out + 6, searchRange);
+        WOFF2Builder::writeU16(out + 8, entrySelector);
+        WOFF2Builder::writeU16(out + 10, static_cast<uint16_t>(numTables * 16 - searchRange));
+
+        size_t tableOffset = 12 + 16 * numTables;
+        size_t headOffset = 0;
+        bool hasHead = false;
+        for (size_t i = 0; i < numTables; ++i) {
+            const uint32_t tag = decoded[i].first;
+            const ByteView data = decoded[i].second;
+            std::memcpy(out + tableOffset, data.data(), data.size());
+            if (tag == kHeadTag && data.size() >= 12) {
+                std::memset(out + tableOffset + 8, 0, 4); // checkSumAdjustment is recomputed below
+                headOffset = tableOffset;
+                hasHead = true;
+            }
+
+            uint8_t* record = out + 12 + 16 * i;
+            WOFF2Builder::writeU32(record, tag);
+            WOFF2Builder::writeU32(record + 4, calculateTableChecksum(ByteView(out + tableOffset, data.size())));
+            WOFF2Builder::writeU32(record + 8, static_cast<uint32_t>(tableOffset));
+            WOFF2Builder::writeU32(record + 12, static_cast<uint32_t>(data.size()));
+            tableOffset += (data.size() + 3) & ~size_t(3);
+        }
+
+        if (hasHead) {
+            const uint32_t fontChecksum = calculateTableChecksum(ByteView(sfnt.data(), sfnt.size()));
+            WOFF2Builder::writeU32(out + headOffset + 8, kFontChecksumMagic - fontChecksum);
+        }
+
+        stats.reconstructMs = elapsedMs(reconstructStart);
+        stats.sfntBytes = sfnt.size();
+        stats.totalMs = elapsedMs(start);
+        return true;
+    }
+
+    bool compareRoundTrip(TTFParser& original, TTFParser& decoded, std::vector<TableComparison>& results) {
+        results.clear();
+        bool allMatch = true;
+
+        // glyf and loca are compared through the decoded glyphs
+        uint32_t originalGlyf = 0, decodedGlyf = 0;
+        size_t originalGlyphs = 0, decodedGlyphs = 0;
+        const bool glyfDecoded = original.getTableDirectory().contains("glyf") &&
+            canonicalGlyfChecksum(original, originalGlyf, originalGlyphs) &&
+            canonicalGlyfChecksum(decoded, decodedGlyf, decodedGlyphs);
+
+        for (const TableRecord& record : original.getTableDirectory()) {
+            if (record.tag == kDsigTag) {
+                continue;
+            }
+
+            TableComparison comparison;
+            comparison.tag = record.tag;
+            comparison.originalLength = static_cast<uint32_t>(record.data.size());
+
+            const TableRecord* other = decoded.getTableDirectory().find(Tag(record.tag));
+            if (other) {
+                comparison.decodedLength = static_cast<uint32_t>(other->data.size());
+
+                if (record.tag == kGlyfTag) {
+                    comparison.originalChecksum = originalGlyf;
+                    comparison.decodedChecksum = decodedGlyf;
+                    comparison.match = glyfDecoded && originalGlyf == decodedGlyf;
+                }
+                else if (record.tag == kLocaTag) {
+                    comparison.originalChecksum = static_cast<uint32_t>(originalGlyphs);
+                    comparison.decodedChecksum = static_cast<uint32_t>(decodedGlyphs);
+                    comparison.match = glyfDecoded && originalGlyphs == decodedGlyphs;
+                }
+                else if (record.tag == kHeadTag) {
+                    comparison.originalChecksum = canonicalHeadChecksum(record.data);
+                    comparison.decodedChecksum = canonicalHeadChecksum(other->data);
+                    comparison.match = comparison.originalLength == comparison.decodedLength &&
+                        comparison.originalChecksum == comparison.decodedChecksum;
+                }
+                else {
+                    comparison.originalChecksum = calculateTableChecksum(record.data);
+                    comparison.decodedChecksum = calculateTableChecksum(other->data);
+                    comparison.match = comparison.originalLength == comparison.decodedLength &&
+                        comparison.originalChecksum == comparison.decodedChecksum;
+                }
+            }
+
+            allMatch &= comparison.match;
+            results.push_back(comparison);
+        }
+        return allMatch;
+    }
+
+} // namespace TTFParser
@@ -0,0 +1,114 @@
+#ifndef WOFF2_READER_HPP
+#define WOFF2_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FontBuffer.hpp"
+#include "TableDirectory.hpp"
+#include "TTFParser.hpp"
+
+namespace TTFParser {
+
+    // The fixed 48-byte header of a WOFF2 file.
+    struct WOFF2Header {
+        uint32_t flavor = 0;              // sfnt version of the packed font.
+        uint32_t length = 0;              // Size of the WOFF2 file.
+        uint16_t numTables = 0;
+        uint32_t totalSfntSize = 0;       // Size the encoder expects the decoded font to have (a hint).
+        uint32_t totalCompressedSize = 0; // Size of the Brotli stream.
+        uint16_t majorVersion = 0;
+        uint16_t minorVersion = 0;
+    };
+
+    // A table directory entry of a WOFF2 file.
+    struct WOFF2TableEntry {
+        uint32_t tag = 0;
+        uint8_t transformVersion = 0;
+        bool transformed = false;   // Whether the stored data is a transform of the table.
+        uint32_t origLength = 0;    // Length of the decoded table.
+        uint32_t streamOffset = 0;  // Position of the stored data in the decompressed stream.
+        uint32_t streamLength = 0;  // transformLength for transformed tables, origLength otherwise.
+    };
+
+    // Timings and byte counts of the last WOFF2Reader::decode call.
+    struct DecodeStats {
+        double decompressMs = 0.0;   // Brotli decompression.
+        double reconstructMs = 0.0;  // Rebuilding transformed tables and the sfnt.
+        double totalMs = 0.0;
+        size_t compressedBytes = 0;
+        size_t decompressedBytes = 0;
+        size_t sfntBytes = 0;        // Size of the decoded font.
+    };
+
+    /**
+    * @class WOFF2Reader
+    * @brief Decodes a WOFF2 file back into an sfnt font.
+    *
+    * Transformed glyf, loca and hmtx tables are rebuilt (WOFF2 spec, sections 5.1-5.4); all
+    * other tables are copied. The resulting font has its tables sorted by tag, 4-byte aligned
+    * and with fresh checksums, including head.checkSumAdjustment. Font collections are not
+    * supported.
+    */
+    class WOFF2Reader {
+    public:
+        /**
+         * @brief Decodes a WOFF2 file.
+         * @param woff2 The WOFF2 bytes.
+         * @param sfnt Receives the decoded font.
+         * @return false if the file is malformed or uses an unsupported feature.
+         */
+        bool decode(ByteView woff2, std::vector<uint8_t>& sfnt);
+
+        const WOFF2Header& getHeader() const { return header; }
+        const std::vector<WOFF2TableEntry>& getTables() const { return tables; }
+        const DecodeStats& getStats() const { return stats; }
+
+    private:
+        bool readHeader(ByteView woff2, size_t& offset);
+        bool readTableDirectory(ByteView woff2, size_t& offset);
+
+        // Rebuilds 'glyf' and 'loca' from a transformed glyf table, recording each glyph's xMin.
+        bool reconstructGlyf(ByteView transformed, std::vector<uint8_t>& glyf, std::vector<uint8_t>& loca,
+            int16_t& indexFormat);
+
+        // Rebuilds 'hmtx' from a transformed hmtx table and the glyph xMins.
+        bool reconstructHmtx(ByteView transformed, uint16_t numberOfHMetrics, std::vector<uint8_t>& hmtx) const;
+
+        WOFF2Header header;
+        std::vector<WOFF2TableEntry> tables;
+        std::vector<int16_t> xMins; // Per glyph, filled by reconstructGlyf.
+        DecodeStats stats;
+    };
+
+    // Result of comparing one table of a font with its WOFF2 round trip.
+    struct TableComparison {
+        uint32_t tag = 0;
+        uint32_t originalLength = 0;
+        uint32_t decodedLength = 0;     // 0 if the decoded font lacks the table.
+        uint32_t originalChecksum = 0;
+        uint32_t decodedChecksum = 0;
+        bool match = false;
+    };
+
+    /**
+     * @brief Compares every table of a font with the same table after a WOFF2 round trip.
+     *
+     * Tables are compared by length and checksum. Tables that WOFF2 encoding legitimately
+     * rewrites are compared in a canonical form instead:
+     * - 'head' with checkSumAdjustment, flags bit 11 and indexToLocFormat cleared;
+     * - 'glyf' by the checksum of its decoded glyphs (contours, points, instructions and
+     *   components), since the point encoding and padding may change;
+     * - 'loca' by glyph count, since it only holds the glyph offsets.
+     * 'DSIG' is skipped because converters drop it.
+     *
+     * @param original The font before encoding.
+     * @param decoded The font decoded from the WOFF2 file.
+     * @param results Receives one entry per table of the original font, in its directory order.
+     * @return true if every table matches.
+     */
+    bool compareRoundTrip(TTFParser& original, TTFParser& decoded, std::vector<TableComparison>& results);
+
+} // namespace TTFParser
+
+#endif // WOFF2_READER_HPP
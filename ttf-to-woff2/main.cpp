@@ -1,422 +1,624 @@
+#include "BatchConverter.hpp"
+#include "Benchmark.hpp"
+#include "GposTable.hpp"
+#include "KernIndex.hpp"
+#include "SelfTest.hpp"
 #include "TTFParser.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+
+namespace {
+    void printUsage(const char* program) {
+        std::cout << "Usage: " << program << " [options] <font | directory | glob>...\n"
+            << "       " << program << " [options] -          (read inputs from stdin, one per line)\n"
+            << "       " << program << " --dump <font>        (print the parsed tables of a font)\n"
+            << "       " << program << " --self-test <font>... (check that parallel parsing matches serial parsing)\n"
+            << "       " << program << " --bench <font>...     (time the hot paths on each font)\n"
+            << "\n"
+            << "Converts TrueType/OpenType fonts to WOFF2. Directories are searched recursively for\n"
+            << ".ttf and .otf files; globs support '*' and '?' in any path component.\n"
+            << "\n"
+            << "Options:\n"
+            << "  -j, --jobs N         Fonts to convert at once (default: number of cores)\n"
+            << "  -o, --out-dir DIR    Write outputs under DIR instead of next to each input\n"
+            << "  -q, --quality N      Brotli quality, 0-11 (default: 11)\n"
+            << "      --cache DIR      Reuse outputs of unchanged fonts from a cache in DIR\n"
+            << "      --cache-size MB  Evict least recently used cache entries above MB megabytes\n"
+            << "  -u, --unicodes LIST  Keep only the glyphs of these codepoints, e.g. U+0000-00FF,U+20AC\n"
+            << "      --slices SPEC    Split every font into one file per slice of a spec file, whose\n"
+            << "                       lines hold a slice name and its codepoints, e.g. latin U+0000-00FF\n"
+            << "      --kern-to-gpos   Replace 'kern' tables with equivalent, smaller GPOS class kerning\n"
+            << "      --verify         Decode every output and compare it with its input\n"
+            << "      --validate       Only check the table checksums of every input; convert nothing\n"
+            << "      --quiet          Only print failures and the summary\n"
+            << "  -h, --help           Show this message\n";
+    }
+
+    // Parses a non-negative integer option value.
+    bool parseCount(const char* text, size_t maxValue, size_t& value) {
+        char* end = nullptr;
+        const unsigned long long parsed = std::strtoull(text, &end, 10);
+        if (end == text || *end != '\0' || text[0] == '-' || parsed > maxValue) {
+            return false;
+        }
+        value = static_cast<size_t>(parsed);
+        return true;
+    }
 
-int main() {
-    const std::string ttfFilePath = "C:\\Users\\azulx\\Desktop\\Source Files\\Software\\tff-to-woff2\\Debug\\ArimaMadura.ttf"; // Replace with your TTF file path
+    // Prints every table the parser understands; a debugging aid for the parser itself.
+    int dumpFont(const std::string& ttfFilePath) {
+        TTFParser::TTFParser parser;
+        if (!parser.loadFromFile(ttfFilePath)) {
+            std::cerr << "Failed to load TTF file: " << ttfFilePath << std::endl;
+            return 1;
+        }
 
-    TTFParser::TTFParser parser;
-    if (!parser.loadFromFile(ttfFilePath)) {
-        std::cerr << "Failed to load TTF file: " << ttfFilePath << std::endl;
-        return 1;
-    }
+        const auto& tableEntries = parser.getTableDirectoryEntries();
+        for (const auto& entry : tableEntries) {
+            char tagStr[5];
+            std::memcpy(tagStr, &entry.tag, 4);
+            tagStr[4] = '\0';
+            std::cout << "Found table: " << tagStr << std::endl;
+        }
 
-    const auto& tableEntries = parser.getTableDirectoryEntries();
-    for (const auto& entry : tableEntries) {
-        char tagStr[5];
-        std::memcpy(tagStr, &entry.tag, 4);
-        tagStr[4] = '\0';
-        std::cout << "Found table: " << tagStr << std::endl;
-    }
+        std::cout << "Successfully loaded TTF file: " << ttfFilePath << std::endl;
 
-    std::cout << "Successfully loaded TTF file: " << ttfFilePath << std::endl;
+        TTFParser::ByteView headData = parser.getTableData("head");
+        if (!headData.empty()) {
+            if (!parser.parseHeadTable(headData)) {
+                std::cerr << "Failed to parse 'head' table." << std::endl;
+                return 1;
+            }
 
-    const auto& headData = parser.getTableData("head");
-    if (!headData.empty()) {
-        uint32_t headOffset = parser.getTableOffset("head");
+            else {
+                std::cout << "Parsed 'head' table successfully." << std::endl;
+                std::cout << "Font version: " << parser.getHeadTable().fontRevision << std::endl;
+                std::cout << "Created Date: " << parser.getHeadTable().created << std::endl;
+                std::cout << "Modified Date: " << parser.getHeadTable().modified << std::endl;
+            }
+        }
+        else {
+            std::cout << "No 'head' table found in the font." << std::endl;
+        }
+
+        std::cout << std::endl;
+
+        TTFParser::ByteView gposData = parser.getTableData("GPOS");
 
-        if (headOffset == 0) {
-            std::cerr << "Failed to find the 'head' table's offset." << std::endl;
+        if (gposData.empty()) {
+            std::cerr << "Failed to locate 'GPOS' table." << std::endl;
             return 1;
         }
 
-        if (!parser.parseHeadTable(headOffset)) {
-            std::cerr << "Failed to parse 'head' table." << std::endl;
+        TTFParser::GPOSHeader gposHeader;
+        if (!parser.parseGPOSHeader(gposData, gposHeader)) {
+            std::cerr << "Failed to parse 'GPOS' table header." << std::endl;
             return 1;
         }
 
-        else {
-            std::cout << "Parsed 'head' table successfully." << std::endl;
-            std::cout << "Font version: " << TTFParser::headTable.fontRevision << std::endl;
-            std::cout << "Created Date: " << TTFParser::headTable.created << std::endl;
-            std::cout << "Modified Date: " << TTFParser::headTable.modified << std::endl;
-        }
-    }
-    else {
-        std::cout << "No 'head' table found in the font." << std::endl;
-    }
+        std::vector<TTFParser::ScriptRecord> scripts;
 
-    std::cout << std::endl;
+        if (!parser.parseScriptList(gposData.subview(gposHeader.scriptListOffset), scripts)) {
+            std::cerr << "Failed to parse the 'GPOS' table Script List." << std::endl;
+            return 1;
+        }
 
-    uint32_t gposOffset = parser.getTableOffset("GPOS");
+        // If we successfully parsed the Script List, print the details of each ScriptRecord and their ScriptTables
+        for (size_t i = 0; i < scripts.size(); ++i) {
+            const auto& script = scripts[i];
+            std::cout << "Script " << i + 1 << ":\n";
+            std::cout << "\tScript Tag: " << script.scriptTag << "\n"; // This might need formatting
+            std::cout << "\tScript Offset: " << script.scriptOffset << "\n";
+
+            TTFParser::ScriptTable scriptTable;
+            if (!parser.parseScriptTable(gposData.subview(gposHeader.scriptListOffset + script.scriptOffset), scriptTable)) {
+                std::cerr << "Failed to parse the 'GPOS' table Script Table for script " << i + 1 << "." << std::endl;
+                continue; // Move on to the next script
+            }
 
-    if (gposOffset == 0) {
-        std::cerr << "Failed to locate 'GPOS' table." << std::endl;
-        return 1;
-    }
+            std::cout << "\tDefault Language System Offset: " << scriptTable.defaultLangSys << "\n";
+            std::cout << "\tLanguage System Count: " << scriptTable.langSysCount << "\n";
+            for (size_t j = 0; j < scriptTable.langSystems.size(); ++j) {
+                const auto& langSys = scriptTable.langSystems[j];
+                std::cout << "\t\tLanguage System " << j + 1 << " Tag: " << langSys.langSysTag << "\n"; // This might need formatting
+                std::cout << "\t\tLanguage System " << j + 1 << " Offset: " << langSys.langSysOffset << "\n";
+            }
+            std::cout << std::endl;
+        }
 
-    TTFParser::GPOSHeader gposHeader;
-    if (!parser.parseGPOSHeader(gposOffset, gposHeader)) {
-        std::cerr << "Failed to parse 'GPOS' table header." << std::endl;
-        return 1;
-    }
+        std::vector<TTFParser::FeatureRecord> features;
 
-    std::vector<TTFParser::ScriptRecord> scripts;
+        if (!parser.parseFeatureList(gposData.subview(gposHeader.featureListOffset), features)) {
+            std::cerr << "Failed to parse the 'GPOS' table Feature List." << std::endl;
+            return 1;
+        }
 
-    if (!parser.parseScriptList(gposOffset + gposHeader.scriptListOffset, scripts)) {
-        std::cerr << "Failed to parse the 'GPOS' table Script List." << std::endl;
-        return 1;
-    }
+        // If we successfully parsed the Feature List, print the details of each FeatureRecord
+        for (size_t i = 0; i < features.size(); ++i) {
+            const auto& feature = features[i];
+            std::cout << "Feature " << i + 1 << ":\n";
+            std::cout << "\tFeature Tag: " << feature.featureTag << "\n"; // This might need formatting
+            std::cout << "\tFeature Offset: " << feature.featureOffset << "\n";
+            std::cout << std::endl;
+        }
 
-    // If we successfully parsed the Script List, print the details of each ScriptRecord and their ScriptTables
-    for (size_t i = 0; i < scripts.size(); ++i) {
-        const auto& script = scripts[i];
-        std::cout << "Script " << i + 1 << ":\n";
-        std::cout << "\tScript Tag: " << script.scriptTag << "\n"; // This might need formatting
-        std::cout << "\tScript Offset: " << script.scriptOffset << "\n";
+        std::vector<TTFParser::LookupTable> lookups;
 
-        TTFParser::ScriptTable scriptTable;
-        if (!parser.parseScriptTable(gposOffset + gposHeader.scriptListOffset + script.scriptOffset, scriptTable)) {
-            std::cerr << "Failed to parse the 'GPOS' table Script Table for script " << i + 1 << "." << std::endl;
-            continue; // Move on to the next script
+        if (!parser.parseLookupList(gposData.subview(gposHeader.lookupListOffset), lookups)) {
+            std::cerr << "Failed to parse the 'GPOS' table Lookup List." << std::endl;
+            return 1;
         }
 
-        std::cout << "\tDefault Language System Offset: " << scriptTable.defaultLangSys << "\n";
-        std::cout << "\tLanguage System Count: " << scriptTable.langSysCount << "\n";
-        for (size_t j = 0; j < scriptTable.langSystems.size(); ++j) {
-            const auto& langSys = scriptTable.langSystems[j];
-            std::cout << "\t\tLanguage System " << j + 1 << " Tag: " << langSys.langSysTag << "\n"; // This might need formatting
-            std::cout << "\t\tLanguage System " << j + 1 << " Offset: " << langSys.langSysOffset << "\n";
+        // If we successfully parsed the Lookup List, print the details of each LookupTable
+        for (size_t i = 0; i < lookups.size(); ++i) {
+            const auto& lookup = lookups[i];
+            std::cout << "Lookup " << i + 1 << ":\n";
+            std::cout << "\tLookup Offset: " << lookup.lookupOffset << "\n";
+            std::cout << "\tLookup Type: " << lookup.lookupType << "\n";
+            std::cout << "\tLookup Flag: " << lookup.lookupFlag << "\n";
+            std::cout << "\tSubTable Count: " << lookup.subTableCount << "\n";
+            for (size_t j = 0; j < lookup.subTableOffsets.size(); ++j) {
+                std::cout << "\tSubTable " << j + 1 << " Offset: " << lookup.subTableOffsets[j] << "\n";
+            }
+            std::cout << std::endl;
         }
-        std::cout << std::endl;
-    }
-
-    std::vector<TTFParser::FeatureRecord> features;
 
-    if (!parser.parseFeatureList(gposOffset + gposHeader.featureListOffset, features)) {
-        std::cerr << "Failed to parse the 'GPOS' table Feature List." << std::endl;
-        return 1;
-    }
-
-    // If we successfully parsed the Feature List, print the details of each FeatureRecord
-    for (size_t i = 0; i < features.size(); ++i) {
-        const auto& feature = features[i];
-        std::cout << "Feature " << i + 1 << ":\n";
-        std::cout << "\tFeature Tag: " << feature.featureTag << "\n"; // This might need formatting
-        std::cout << "\tFeature Offset: " << feature.featureOffset << "\n";
+        // Decode every lookup, following Extension subtables, and report what each subtable covers
+        TTFParser::GposTable gpos;
+        if (!gpos.decode(gposData)) {
+            std::cerr << "Failed to decode the 'GPOS' table lookups." << std::endl;
+            return 1;
+        }
+        std::cout << "Decoded GPOS: " << gpos.getLookups().size() << " lookups, " << gpos.getSubtables().size()
+            << " subtables, " << gpos.getCoverages().size() - 1 << " shared coverages, " << gpos.getClassDefs().size() - 1
+            << " shared class definitions in " << gpos.getMemoryBytes() << " bytes\n";
+        for (size_t i = 0; i < gpos.getLookups().size(); ++i) {
+            const TTFParser::GposLookup& lookup = gpos.getLookups()[i];
+            std::cout << "Lookup " << i + 1 << " (type " << lookup.type << (lookup.extension ? ", via Extension" : "") << "):\n";
+            for (uint32_t j = 0; j < lookup.subtableCount; ++j) {
+                const TTFParser::GposSubtable& subtable = gpos.getSubtables()[lookup.subtableStart + j];
+                std::cout << "\tSubtable at offset " << subtable.offset << ", format " << subtable.format
+                    << ": " << gpos.getCoverageGlyphCount(subtable.coverage) << " glyphs in Coverage table\n";
+            }
+        }
         std::cout << std::endl;
-    }
-
-    system("pause");
 
-    std::vector<TTFParser::LookupTable> lookups;
+        TTFParser::KernTable kern;
+        TTFParser::ByteView kernData = parser.getTableData("kern");
+        if (kernData.empty()) {
+            std::cerr << "Failed to locate 'kern' table." << std::endl;
+            return 1;
+        }
 
-    if (!parser.parseLookupList(gposOffset + gposHeader.lookupListOffset, lookups)) {
-        std::cerr << "Failed to parse the 'GPOS' table Lookup List." << std::endl;
-        return 1;
-    }
+        if (!parser.parseKernTable(kernData, kern)) {
+            std::cerr << "Failed to parse 'kern' table." << std::endl;
+            return 1;
+        }
 
-    // If we successfully parsed the Lookup List, print the details of each LookupTable
-    for (size_t i = 0; i < lookups.size(); ++i) {
-        const auto& lookup = lookups[i];
-        std::cout << "Lookup " << i + 1 << ":\n";
-        std::cout << "\tLookup Type: " << lookup.lookupType << "\n";
-        std::cout << "\tLookup Flag: " << lookup.lookupFlag << "\n";
-        std::cout << "\tSubTable Count: " << lookup.subTableCount << "\n";
-        for (size_t j = 0; j < lookup.subTableOffsets.size(); ++j) {
-            std::cout << "\tSubTable " << j + 1 << " Offset: " << lookup.subTableOffsets[j] << "\n";
+        std::cout << "Parsed 'kern' table successfully." << std::endl;
+        std::cout << "Number of subtables: " << kern.subtables.size() << std::endl;
+        TTFParser::KernIndex kernIndex;
+        kernIndex.build(kern);
+        std::cout << "Kerning index: " << kernIndex.getPairCount() << " pairs in " << kernIndex.getMemoryBytes() << " bytes" << std::endl;
+        for (const auto& subtable : kern.subtables) {
+            std::cout << "Subtable with " << subtable.kerningPairs.size() << " kerning pairs:" << std::endl;
+            for (const auto& pair : subtable.kerningPairs) {
+                std::cout << "Left Glyph ID: " << pair.left << ", Right Glyph ID: " << pair.right << ", Value: " << pair.value << std::endl;
+            }
         }
-        std::cout << std::endl;
-    }
 
-    for (const auto& lookup : lookups) {
-        std::cout << "Testing getCoverageGlyphCount for Lookup Type: " << lookup.lookupType << "\n";
-        for (const auto& subTableOffset : lookup.subTableOffsets) {
-            uint32_t currentOffset = gposOffset + subTableOffset;
+        // Parsing the 'post' table
+        TTFParser::PostTable post;
+        TTFParser::ByteView postData = parser.getTableData("post");
+        if (postData.empty()) {
+            std::cerr << "Failed to locate 'post' table." << std::endl;
+            return 1;
+        }
 
-            // We assume that the Coverage table is at the start of the subtable for simplicity.
-            // This assumption might not always be the case, depending on the lookupType.
-            int glyphCount = parser.getCoverageGlyphCount(currentOffset);
+        if (!parser.parsePostTable(postData, post)) {
+            std::cerr << "Failed to parse 'post' table." << std::endl;
+            return 1;
+        }
 
-            if (glyphCount < 0) {
-                std::cerr << "Failed to get glyph count for subtable at offset: " << subTableOffset
-                    << ". Error code: " << glyphCount << std::endl;
+        std::cout << "Parsed 'post' table successfully." << std::endl;
+        std::cout << "Format: " << post.format << std::endl;
+        std::cout << "Italic Angle: " << post.italicAngle << std::endl;
+        std::cout << "Underline Position: " << post.underlinePosition << std::endl;
+        std::cout << "Underline Thickness: " << post.underlineThickness << std::endl;
+        std::cout << "Is Fixed Pitch: " << post.isFixedPitch << std::endl;
+        std::cout << "Minimum Memory Type 42: " << post.minMemType42 << std::endl;
+        std::cout << "Maximum Memory Type 42: " << post.maxMemType42 << std::endl;
+        std::cout << "Minimum Memory Type 1: " << post.minMemType1 << std::endl;
+        std::cout << "Maximum Memory Type 1: " << post.maxMemType1 << std::endl;
+
+        if (post.format == 2.0) {
+            std::cout << "Number of Glyphs: " << post.numberOfGlyphs << std::endl;
+            for (size_t i = 0; i < post.glyphNameIndex.size(); ++i) {
+                std::cout << "Glyph " << i << " Name Index: " << post.glyphNameIndex[i] << std::endl;
             }
-            else {
-                std::cout << "Glyph count in Coverage table at subtable offset " << subTableOffset << ": " << glyphCount << "\n";
+            for (size_t i = 0; i < post.names.size(); ++i) {
+                std::cout << "Additional Name " << i << ": " << post.names[i] << std::endl;
             }
         }
-        std::cout << std::endl;
-    }
-
 
-    system("pause");
+        TTFParser::OS2Table os2;
+        TTFParser::ByteView os2Data = parser.getTableData("OS/2");
+        if (os2Data.empty()) {
+            std::cerr << "Failed to locate 'OS/2' table." << std::endl;
+            return 1;
+        }
 
-    TTFParser::KernTable kern;
-    uint32_t kernOffset = parser.getTableOffset("kern");
-    if (kernOffset == 0) {
-        std::cerr << "Failed to locate 'kern' table." << std::endl;
-        return 1;
-    }
+        if (!parser.parseOS2Table(os2Data, os2)) {
+            std::cerr << "Failed to parse 'OS/2' table." << std::endl;
+            return 1;
+        }
 
-    if (!parser.parseKernTable(kernOffset, kern)) {
-        std::cerr << "Failed to parse 'kern' table." << std::endl;
-        return 1;
-    }
+        std::cout << "Parsed 'OS/2' table successfully." << std::endl;
+        std::cout << "Version: " << os2.version << std::endl;
+        std::cout << "xAvgCharWidth: " << os2.xAvgCharWidth << std::endl;
+        std::cout << "usWeightClass: " << os2.usWeightClass << std::endl;
+        std::cout << "usWidthClass: " << os2.usWidthClass << std::endl;
+        std::cout << "fsType: " << os2.fsType << std::endl;
+        std::cout << "ySubscriptXSize: " << os2.ySubscriptXSize << std::endl;
+        std::cout << "ySubscriptYSize: " << os2.ySubscriptYSize << std::endl;
+        std::cout << "ySubscriptXOffset: " << os2.ySubscriptXOffset << std::endl;
+        std::cout << "ySubscriptYOffset: " << os2.ySubscriptYOffset << std::endl;
+        std::cout << "ySuperscriptXSize: " << os2.ySuperscriptXSize << std::endl;
+        std::cout << "ySuperscriptYSize: " << os2.ySuperscriptYSize << std::endl;
+        std::cout << "ySuperscriptXOffset: " << os2.ySuperscriptXOffset << std::endl;
+        std::cout << "ySuperscriptYOffset: " << os2.ySuperscriptYOffset << std::endl;
+        std::cout << "yStrikeoutSize: " << os2.yStrikeoutSize << std::endl;
+        std::cout << "yStrikeoutPosition: " << os2.yStrikeoutPosition << std::endl;
+        std::cout << "sFamilyClass: " << os2.sFamilyClass << std::endl;
+
+        std::cout << "panose: ";
+        for (int i = 0; i < 10; ++i) {
+            std::cout << (int)os2.panose[i] << " ";
+        }
 
-    std::cout << "Parsed 'kern' table successfully." << std::endl;
-    std::cout << "Number of subtables: " << kern.subtables.size() << std::endl;
-    for (const auto& subtable : kern.subtables) {
-        std::cout << "Subtable with " << subtable.kerningPairs.size() << " kerning pairs:" << std::endl;
-        for (const auto& pair : subtable.kerningPairs) {
-            std::cout << "Left Glyph ID: " << pair.left << ", Right Glyph ID: " << pair.right << ", Value: " << pair.value << std::endl;
+        std::cout << std::endl;
+        std::cout << "ulUnicodeRange1: " << os2.ulUnicodeRange1 << std::endl;
+        std::cout << "ulUnicodeRange2: " << os2.ulUnicodeRange2 << std::endl;
+        std::cout << "ulUnicodeRange3: " << os2.ulUnicodeRange3 << std::endl;
+        std::cout << "ulUnicodeRange4: " << os2.ulUnicodeRange4 << std::endl;
+        std::cout << "achVendID: " << std::string(os2.achVendID, 4) << std::endl; // Display the vendor ID as a string
+        std::cout << "fsSelection: " << os2.fsSelection << std::endl;
+        std::cout << "usFirstCharIndex: " << os2.usFirstCharIndex << std::endl;
+        std::cout << "usLastCharIndex: " << os2.usLastCharIndex << std::endl;
+        std::cout << "sTypoAscender: " << os2.sTypoAscender << std::endl;
+        std::cout << "sTypoDescender: " << os2.sTypoDescender << std::endl;
+        std::cout << "sTypoLineGap: " << os2.sTypoLineGap << std::endl;
+        std::cout << "usWinAscent: " << os2.usWinAscent << std::endl;
+        std::cout << "usWinDescent: " << os2.usWinDescent << std::endl;
+
+        if (os2.version >= 1) {
+            std::cout << "ulCodePageRange1: " << os2.ulCodePageRange1 << std::endl;
+            std::cout << "ulCodePageRange2: " << os2.ulCodePageRange2 << std::endl;
         }
-    }
 
-    system("pause");
+        if (os2.version >= 2) {
+            std::cout << "sxHeight: " << os2.sxHeight << std::endl;
+            std::cout << "sCapHeight: " << os2.sCapHeight << std::endl;
+            std::cout << "usDefaultChar: " << os2.usDefaultChar << std::endl;
+            std::cout << "usBreakChar: " << os2.usBreakChar << std::endl;
+            std::cout << "usMaxContext: " << os2.usMaxContext << std::endl;
+        }
 
-    // Parsing the 'post' table
-    TTFParser::PostTable post;
-    uint32_t postOffset = parser.getTableOffset("post");
-    if (postOffset == 0) {
-        std::cerr << "Failed to locate 'post' table." << std::endl;
-        return 1;
-    }
+        if (os2.version >= 5) {
+            std::cout << "usLowerOpticalPointSize: " << os2.usLowerOpticalPointSize << std::endl;
+            std::cout << "usUpperOpticalPointSize: " << os2.usUpperOpticalPointSize << std::endl;
+            // sCapHeight, usDefaultChar, usBreakChar, and usMaxContext are already printed in the previous blocks
+        }
 
-    if (!parser.parsePostTable(postOffset, post)) {
-        std::cerr << "Failed to parse 'post' table." << std::endl;
-        return 1;
-    }
 
-    std::cout << "Parsed 'post' table successfully." << std::endl;
-    std::cout << "Format: " << post.format << std::endl;
-    std::cout << "Italic Angle: " << post.italicAngle << std::endl;
-    std::cout << "Underline Position: " << post.underlinePosition << std::endl;
-    std::cout << "Underline Thickness: " << post.underlineThickness << std::endl;
-    std::cout << "Is Fixed Pitch: " << post.isFixedPitch << std::endl;
-    std::cout << "Minimum Memory Type 42: " << post.minMemType42 << std::endl;
-    std::cout << "Maximum Memory Type 42: " << post.maxMemType42 << std::endl;
-    std::cout << "Minimum Memory Type 1: " << post.minMemType1 << std::endl;
-    std::cout << "Maximum Memory Type 1: " << post.maxMemType1 << std::endl;
-
-    if (post.format == 2.0) {
-        std::cout << "Number of Glyphs: " << post.numberOfGlyphs << std::endl;
-        for (size_t i = 0; i < post.glyphNameIndex.size(); ++i) {
-            std::cout << "Glyph " << i << " Name Index: " << post.glyphNameIndex[i] << std::endl;
-        }
-        for (size_t i = 0; i < post.names.size(); ++i) {
-            std::cout << "Additional Name " << i << ": " << post.names[i] << std::endl;
+        // Test the 'name' table parsing
+        TTFParser::NameTable nameTable;
+        TTFParser::ByteView nameTableData = parser.getTableData("name");
+        if (nameTableData.empty()) {
+            std::cerr << "Failed to find 'name' table." << std::endl;
+            return 1;
         }
-    }
 
-    system("pause");
-
-    TTFParser::OS2Table os2;
-    uint32_t os2Offset = parser.getTableOffset("OS/2");
-    if (os2Offset == 0) {
-        std::cerr << "Failed to locate 'OS/2' table." << std::endl;
-        return 1;
-    }
+        if (!parser.parseNameTable(nameTableData, nameTable)) {
+            std::cerr << "Failed to parse 'name' table." << std::endl;
+            return 1;
+        }
 
-    if (!parser.parseOS2Table(os2Offset, os2)) {
-        std::cerr << "Failed to parse 'OS/2' table." << std::endl;
-        return 1;
-    }
+        // Print out the parsed 'name' table details
+        std::cout << "\nName Table:" << std::endl;
+        std::cout << "Format: " << nameTable.format << std::endl;
+        std::cout << "Count: " << nameTable.count << std::endl;
+
+        for (const auto& record : nameTable.nameRecords) {
+            std::cout << "----------------------------------" << std::endl;
+            std::cout << "Platform ID: " << record.platformID << std::endl;
+            std::cout << "Encoding ID: " << record.encodingID << std::endl;
+            std::cout << "Language ID: " << record.languageID << std::endl;
+            std::cout << "Name ID: " << record.nameID << std::endl;
+            std::cout << "Length: " << record.length << std::endl;
+            std::cout << "Offset: " << record.offset << std::endl;
+            std::cout << "Name String: " << record.nameString << std::endl;
+        }
+        std::cout << "----------------------------------" << std::endl;
 
-    std::cout << "Parsed 'OS/2' table successfully." << std::endl;
-    std::cout << "Version: " << os2.version << std::endl;
-    std::cout << "xAvgCharWidth: " << os2.xAvgCharWidth << std::endl;
-    std::cout << "usWeightClass: " << os2.usWeightClass << std::endl;
-    std::cout << "usWidthClass: " << os2.usWidthClass << std::endl;
-    std::cout << "fsType: " << os2.fsType << std::endl;
-    std::cout << "ySubscriptXSize: " << os2.ySubscriptXSize << std::endl;
-    std::cout << "ySubscriptYSize: " << os2.ySubscriptYSize << std::endl;
-    std::cout << "ySubscriptXOffset: " << os2.ySubscriptXOffset << std::endl;
-    std::cout << "ySubscriptYOffset: " << os2.ySubscriptYOffset << std::endl;
-    std::cout << "ySuperscriptXSize: " << os2.ySuperscriptXSize << std::endl;
-    std::cout << "ySuperscriptYSize: " << os2.ySuperscriptYSize << std::endl;
-    std::cout << "ySuperscriptXOffset: " << os2.ySuperscriptXOffset << std::endl;
-    std::cout << "ySuperscriptYOffset: " << os2.ySuperscriptYOffset << std::endl;
-    std::cout << "yStrikeoutSize: " << os2.yStrikeoutSize << std::endl;
-    std::cout << "yStrikeoutPosition: " << os2.yStrikeoutPosition << std::endl;
-    std::cout << "sFamilyClass: " << os2.sFamilyClass << std::endl;
-
-    std::cout << "panose: ";
-    for (int i = 0; i < 10; ++i) {
-        std::cout << (int)os2.panose[i] << " ";
-    }
 
-    std::cout << std::endl;
-    std::cout << "ulUnicodeRange1: " << os2.ulUnicodeRange1 << std::endl;
-    std::cout << "ulUnicodeRange2: " << os2.ulUnicodeRange2 << std::endl;
-    std::cout << "ulUnicodeRange3: " << os2.ulUnicodeRange3 << std::endl;
-    std::cout << "ulUnicodeRange4: " << os2.ulUnicodeRange4 << std::endl;
-    std::cout << "achVendID: " << std::string(os2.achVendID, 4) << std::endl; // Display the vendor ID as a string
-    std::cout << "fsSelection: " << os2.fsSelection << std::endl;
-    std::cout << "usFirstCharIndex: " << os2.usFirstCharIndex << std::endl;
-    std::cout << "usLastCharIndex: " << os2.usLastCharIndex << std::endl;
-    std::cout << "sTypoAscender: " << os2.sTypoAscender << std::endl;
-    std::cout << "sTypoDescender: " << os2.sTypoDescender << std::endl;
-    std::cout << "sTypoLineGap: " << os2.sTypoLineGap << std::endl;
-    std::cout << "usWinAscent: " << os2.usWinAscent << std::endl;
-    std::cout << "usWinDescent: " << os2.usWinDescent << std::endl;
-
-    if (os2.version >= 1) {
-        std::cout << "usBreakChar: " << os2.usBreakChar << std::endl;
-        std::cout << "usDefaultChar: " << os2.usDefaultChar << std::endl;
-    }
 
-    if (os2.version >= 2) {
-        std::cout << "sCapHeight: " << os2.sCapHeight << std::endl;
-        std::cout << "usMaxContext: " << os2.usMaxContext << std::endl;
-        std::cout << "ulCodePageRange1: " << os2.ulCodePageRange1 << std::endl;
-        std::cout << "sxHeight: " << os2.sxHeight << std::endl;
-        std::cout << "ulCodePageRange2: " << os2.ulCodePageRange2 << std::endl;
-    }
+        TTFParser::ByteView maxpData = parser.getTableData("maxp");
+        if (maxpData.empty()) {
+            std::cerr << "Failed to locate 'maxp' table." << std::endl;
+            return 1;
+        }
 
-    if (os2.version >= 3) {
-        std::cout << "usLowerOpticalPointSize: " << os2.usLowerOpticalPointSize << std::endl;
-        std::cout << "usUpperOpticalPointSize: " << os2.usUpperOpticalPointSize << std::endl;
-        // sCapHeight, usDefaultChar, usBreakChar, and usMaxContext are already printed in the previous blocks
-    }
+        if (!parser.parseMaxpTable(maxpData)) {
+            std::cerr << "Failed to parse 'maxp' table." << std::endl;
+            return 1;
+        }
 
-    system("pause");
+            // Parsing the 'hhea' table
+        TTFParser::HheaTable hhea;
+        TTFParser::ByteView hheaData = parser.getTableData("hhea");
+        if (hheaData.empty()) {
+            std::cerr << "Failed to locate 'hhea' table." << std::endl;
+            return 1;
+        }
 
+        if (!parser.parseHheaTable(hheaData, hhea)) {
+            std::cerr << "Failed to parse 'hhea' table." << std::endl;
+            return 1;
+        }
 
-    // Test the 'name' table parsing
-    TTFParser::NameTable nameTable;
-    uint32_t nameTableOffset = parser.getTableOffset("name");
-    if (nameTableOffset == 0) {
-        std::cerr << "Failed to find 'name' table." << std::endl;
-        return 1;
-    }
+        std::cout << "Parsed 'hhea' table successfully." << std::endl;
+        std::cout << "Ascent: " << hhea.ascent << std::endl;
+        std::cout << "Descent: " << hhea.descent << std::endl;
+        std::cout << "Line Gap: " << hhea.lineGap << std::endl;
+        std::cout << "Max Advance Width: " << hhea.advanceWidthMax << std::endl;
+        std::cout << "Number of Long Horizontal Metrics: " << hhea.numOfLongHorMetrics << std::endl;
+
+        std::vector<TTFParser::GlyphMetrics> metrics;
+        TTFParser::ByteView hmtxData = parser.getTableData("hmtx");
+        if (hmtxData.empty()) {
+            std::cerr << "Failed to locate 'hmtx' table." << std::endl;
+            return 1;
+        }
 
-    if (!parser.parseNameTable(nameTableOffset, nameTable)) {
-        std::cerr << "Failed to parse 'name' table." << std::endl;
-        return 1;
-    }
+        if (!parser.parseHmtxTable(hmtxData, hhea.numOfLongHorMetrics, metrics)) {
+            std::cerr << "Failed to parse 'hmtx' table." << std::endl;
+            return 1;
+        }
 
-    // Print out the parsed 'name' table details
-    std::cout << "\nName Table:" << std::endl;
-    std::cout << "Format: " << nameTable.format << std::endl;
-    std::cout << "Count: " << nameTable.count << std::endl;
+        std::cout << "Parsed 'hmtx' table successfully." << std::endl;
 
-    for (const auto& record : nameTable.nameRecords) {
-        std::cout << "----------------------------------" << std::endl;
-        std::cout << "Platform ID: " << record.platformID << std::endl;
-        std::cout << "Encoding ID: " << record.encodingID << std::endl;
-        std::cout << "Language ID: " << record.languageID << std::endl;
-        std::cout << "Name ID: " << record.nameID << std::endl;
-        std::cout << "Length: " << record.length << std::endl;
-        std::cout << "Offset: " << record.offset << std::endl;
-        std::cout << "Name String: " << record.nameString << std::endl;
-    }
-    std::cout << "----------------------------------" << std::endl;
+        // Let's print the advance width and left side bearing of the first few glyphs for demonstration:
+        int numMetricsToDisplay = std::min(10, static_cast<int>(metrics.size())); // Displaying up to 10 metrics or less if there are fewer than 10
+        for (int i = 0; i < numMetricsToDisplay; ++i) {
+            std::cout << "Glyph " << i << ": Advance Width = " << metrics[i].advanceWidth
+                << ", Left Side Bearing = " << metrics[i].lsb << std::endl;
+        }
 
+        // Test the cmap table parsing
+        TTFParser::CmapTable cmap;
+        TTFParser::ByteView cmapData = parser.getTableData("cmap");
+        if (!cmapData.empty()) {
+            if (!parser.parseCmapTable(cmapData, cmap)) {
+                std::cerr << "Failed to parse 'cmap' table." << std::endl;
+                return 1;
+            }
 
+            else {
+                std::cout << "Parsed 'cmap' table successfully." << std::endl;
+                std::cout << "Number of subtables: " << cmap.subtables.size() << std::endl;
+                for (const auto& record : cmap.encodingRecords) {
+                    std::cout << "Encoding record " << record.platformID << "/" << record.encodingID << ": ";
+                    if (record.subtableIndex < 0) {
+                        std::cout << "unhandled format" << std::endl;
+                    }
+                    else {
+                        std::cout << "subtable " << record.subtableIndex << ", format " << cmap.subtables[record.subtableIndex]->format << std::endl;
+                    }
+                }
+            }
+        }
+        else {
+            std::cout << "No 'cmap' table found in the font." << std::endl;
+        }
 
-    uint32_t maxpOffset = parser.getTableOffset("maxp");
-    if (maxpOffset == 0) {
-        std::cerr << "Failed to locate 'maxp' table." << std::endl;
-        return 1;
-    }
 
-    if (!parser.parseMaxpTable(maxpOffset)) {
-        std::cerr << "Failed to parse 'maxp' table." << std::endl;
-        return 1;
-    }
+        // Parsing the 'loca' table
+        TTFParser::LocaTable loca;
+        TTFParser::ByteView locaData = parser.getTableData("loca");
+        if (locaData.empty()) {
+            std::cerr << "Failed to locate 'loca' table." << std::endl;
+            return 1;
+        }
 
-        // Parsing the 'hhea' table
-    TTFParser::HheaTable hhea;
-    uint32_t hheaOffset = parser.getTableOffset("hhea");
-    if (hheaOffset == 0) {
-        std::cerr << "Failed to locate 'hhea' table." << std::endl;
-        return 1;
-    }
+        if (!parser.parseLocaTable(locaData, loca)) {
+            std::cerr << "Failed to parse 'loca' table." << std::endl;
+            return 1;
+        }
 
-    if (!parser.parseHheaTable(hheaOffset, hhea)) {
-        std::cerr << "Failed to parse 'hhea' table." << std::endl;
-        return 1;
-    }
+        std::cout << "Parsed 'loca' table successfully." << std::endl;
 
-    std::cout << "Parsed 'hhea' table successfully." << std::endl;
-    std::cout << "Ascent: " << hhea.ascent << std::endl;
-    std::cout << "Descent: " << hhea.descent << std::endl;
-    std::cout << "Line Gap: " << hhea.lineGap << std::endl;
-    std::cout << "Max Advance Width: " << hhea.advanceWidthMax << std::endl;
-    std::cout << "Number of Long Horizontal Metrics: " << hhea.numOfLongHorMetrics << std::endl;
-
-    std::vector<TTFParser::GlyphMetrics> metrics;
-    uint32_t hmtxOffset = parser.getTableOffset("hmtx");
-    if (hmtxOffset == 0) {
-        std::cerr << "Failed to locate 'hmtx' table." << std::endl;
-        return 1;
-    }
+        // Displaying up to the first 10 offsets or less if there are fewer than 10.
+        int numOffsetsToDisplay = std::min(10, static_cast<int>(loca.offsets.size()));
+        for (int i = 0; i < numOffsetsToDisplay; ++i) {
+            std::cout << "Glyph " << i << " Offset: " << loca.offsets[i] << std::endl;
+        }
 
-    if (!parser.parseHmtxTable(hmtxOffset, hhea.numOfLongHorMetrics, metrics)) {
-        std::cerr << "Failed to parse 'hmtx' table." << std::endl;
-        return 1;
-    }
+        // Decode every glyph of the 'glyf' table on all cores
+        TTFParser::GlyfTable glyf;
+        TTFParser::ThreadPool pool;
+        if (!parser.parseGlyfTable(parser.getTableData("glyf"), loca, glyf, &pool)) {
+            std::cerr << "Failed to parse 'glyf' table." << std::endl;
+            return 1;
+        }
 
-    std::cout << "Parsed 'hmtx' table successfully." << std::endl;
+        std::cout << "Parsed 'glyf' table successfully using " << pool.concurrency() << " threads." << std::endl;
+        std::cout << "Glyphs: " << glyf.glyphs.size() << ", Points: " << glyf.xCoordinates.size()
+            << ", Components: " << glyf.components.size() << std::endl;
 
-    // Let's print the advance width and left side bearing of the first few glyphs for demonstration:
-    int numMetricsToDisplay = std::min(10, static_cast<int>(metrics.size())); // Displaying up to 10 metrics or less if there are fewer than 10
-    for (int i = 0; i < numMetricsToDisplay; ++i) {
-        std::cout << "Glyph " << i << ": Advance Width = " << metrics[i].advanceWidth
-            << ", Left Side Bearing = " << metrics[i].lsb << std::endl;
+        return 0;
     }
 
-    // Test the cmap table parsing
-    TTFParser::CmapTable cmap;
-    const auto& cmapData = parser.getTableData("cmap");
-    if (!cmapData.empty()) {
-        uint32_t cmapOffset = parser.getTableOffset("cmap");
-
-        if (cmapOffset == 0) {
-            std::cerr << "Failed to find the 'cmap' table's offset." << std::endl;
-            return 1;
+    void printSummary(const FontConverter::BatchSummary& summary, bool validated) {
+        const double seconds = summary.wallMs / 1000.0;
+        std::cout << "\n" << (validated ? "Validated " : "Converted ") << summary.converted << " of " << summary.fonts
+            << " fonts with " << summary.jobs << " jobs in " << seconds << " s" << std::endl;
+        if (seconds > 0.0) {
+            std::cout << "Throughput: " << summary.inputBytes / seconds / 1e6 << " MB/s in, "
+                << summary.converted / seconds << " fonts/s" << std::endl;
         }
-
-        if (!parser.parseCmapTable(cmapOffset, cmap)) {
-            std::cerr << "Failed to parse 'cmap' table." << std::endl;
-            return 1;
+        if (summary.inputBytes > 0 && !validated) {
+            std::cout << "Size: " << summary.inputBytes << " -> " << summary.outputBytes << " bytes ("
+                << 100.0 * summary.outputBytes / summary.inputBytes << "%)";
+            if (summary.slices > 0) {
+                std::cout << " in " << summary.slices << " slices";
+            }
+            std::cout << std::endl;
         }
-
-        else {
-            std::cout << "Parsed 'cmap' table successfully." << std::endl;
-            std::cout << "Number of subtables: " << cmap.subtables.size() << std::endl;
-            for (const auto& subtable : cmap.subtables) {
-                std::cout << "Subtable format: " << subtable->format << std::endl;
-                // You can add more detailed printouts for each subtable format if needed
+        if (summary.kernReplaced > 0) {
+            std::cout << "Kerning: " << summary.kernReplaced << " 'kern' tables replaced by GPOS, "
+                << summary.kernBytes << " -> " << summary.gposBytes << " bytes" << std::endl;
+        }
+        if (summary.decoded > 0) {
+            const TTFParser::DecodeStats& decode = summary.decode;
+            std::cout << "WOFF2 decode: " << summary.decoded << " files, " << decode.sfntBytes << " bytes in " << decode.totalMs
+                << " ms (Brotli: " << decode.decompressMs << " ms, Reconstruct: " << decode.reconstructMs << " ms, "
+                << (decode.totalMs > 0.0 ? decode.sfntBytes / (decode.totalMs * 1000.0) : 0.0) << " MB/s)" << std::endl;
+        }
+        if (summary.cacheUsed) {
+            std::cout << "Cache: " << summary.cache.hits << " hits, " << summary.cache.misses << " misses, "
+                << summary.cache.evictions << " evictions, " << summary.cache.sizeBytes << " bytes stored" << std::endl;
+        }
+        if (summary.failed > 0) {
+            std::cout << "Failed (" << summary.failed << "):" << std::endl;
+            for (const std::string& path : summary.failures) {
+                std::cout << "  " << path << std::endl;
             }
         }
     }
-    else {
-        std::cout << "No 'cmap' table found in the font." << std::endl;
+} // namespace
+
+int main(int argc, char** argv) {
+    FontConverter::BatchOptions options;
+    std::vector<std::string> inputs;
+    bool readStdin = false;
+    bool selfTest = false;
+    bool bench = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if (arg == "--dump" && hasValue) {
+            return dumpFont(argv[++i]);
+        }
+        else if ((arg == "-j" || arg == "--jobs") && hasValue) {
+            if (!parseCount(argv[++i], 4096, options.jobs) || options.jobs == 0) {
+                std::cerr << "Error: --jobs needs a number from 1 to 4096." << std::endl;
+                return 2;
+            }
+        }
+        else if ((arg == "-o" || arg == "--out-dir") && hasValue) {
+            options.outputDirectory = argv[++i];
+        }
+        else if ((arg == "-q" || arg == "--quality") && hasValue) {
+            size_t quality = 0;
+            if (!parseCount(argv[++i], 11, quality)) {
+                std::cerr << "Error: --quality needs a number from 0 to 11." << std::endl;
+                return 2;
+            }
+            options.compression.quality = static_cast<int>(quality);
+        }
+        else if (arg == "--cache" && hasValue) {
+            options.cacheDirectory = argv[++i];
+        }
+        else if (arg == "--cache-size" && hasValue) {
+            size_t megabytes = 0;
+            if (!parseCount(argv[++i], SIZE_MAX / (1024 * 1024), megabytes)) {
+                std::cerr << "Error: --cache-size needs a size in megabytes." << std::endl;
+                return 2;
+            }
+            options.cacheMaxBytes = static_cast<uint64_t>(megabytes) * 1024 * 1024;
+        }
+        else if ((arg == "-u" || arg == "--unicodes") && hasValue) {
+            if (!FontConverter::parseUnicodeRanges(argv[++i], options.unicodes)) {
+                return 2;
+            }
+            options.subset = true;
+        }
+        else if (arg == "--slices" && hasValue) {
+            if (!FontConverter::readSliceSpec(argv[++i], options.slices)) {
+                return 2;
+            }
+        }
+        else if (arg == "--kern-to-gpos") {
+            options.kernToGpos = true;
+        }
+        else if (arg == "--verify") {
+            options.verify = true;
+        }
+        else if (arg == "--validate") {
+            options.validateOnly = true;
+        }
+        else if (arg == "--self-test") {
+            selfTest = true;
+        }
+        else if (arg == "--bench") {
+            bench = true;
+        }
+        else if (arg == "--quiet") {
+            options.quiet = true;
+        }
+        else if (arg == "-") {
+            readStdin = true;
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Error: Unknown or incomplete option " << arg << std::endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+        else {
+            inputs.push_back(arg);
+        }
     }
 
-
-    // Parsing the 'loca' table
-    TTFParser::LocaTable loca;
-    uint32_t locaOffset = parser.getTableOffset("loca");
-    if (locaOffset == 0) {
-        std::cerr << "Failed to locate 'loca' table." << std::endl;
-        return 1;
+    if (inputs.empty() && !readStdin) {
+        printUsage(argv[0]);
+        return 2;
     }
 
-    if (!parser.parseLocaTable(locaOffset, loca)) {
-        std::cerr << "Failed to parse 'loca' table." << std::endl;
-        return 1;
+    FontConverter::BatchConverter batch(options);
+    bool inputsOk = true;
+    for (const std::string& input : inputs) {
+        inputsOk &= batch.addInput(input);
     }
-
-    std::cout << "Parsed 'loca' table successfully." << std::endl;
-
-    // Displaying up to the first 10 offsets or less if there are fewer than 10.
-    int numOffsetsToDisplay = std::min(10, static_cast<int>(loca.offsets.size()));
-    for (int i = 0; i < numOffsetsToDisplay; ++i) {
-        std::cout << "Glyph " << i << " Offset: " << loca.offsets[i] << std::endl;
+    if (readStdin) {
+        inputsOk &= batch.addInputList(std::cin);
     }
 
+    if (selfTest || bench) {
+        std::vector<std::string> fonts;
+        for (const FontConverter::BatchJob& job : batch.getJobs()) {
+            fonts.push_back(job.inputPath);
+        }
+        bool passed = false;
+        if (selfTest) {
+            passed = FontConverter::runSelfTest(fonts, options.jobs);
+        }
+        else {
+            passed = FontConverter::runBenchmark(fonts, options.jobs, options.compression);
+        }
+        return passed && inputsOk ? 0 : 1;
+    }
 
-    return 0;
+    const bool converted = batch.run();
+    printSummary(batch.getSummary(), options.validateOnly);
+    return converted && inputsOk ? 0 : 1;
 }